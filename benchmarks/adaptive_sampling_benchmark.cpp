@@ -0,0 +1,98 @@
+#include "benchmark_window.hpp"
+#include "gpu_timer.hpp"
+#include "renderer.hpp"
+#include "vulkan_context.hpp"
+#include <array>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t REFERENCE_FRAME_COUNT = 4096;
+// Sample budget of the uniform render and the per pixel limit of the adaptive ones
+constexpr uint32_t MAX_SAMPLES = 256;
+constexpr std::array<float, 3> ERROR_THRESHOLDS { 0.05f, 0.02f, 0.01f };
+
+double RootMeanSquaredError(const std::vector<glm::vec4>& image, const std::vector<glm::vec4>& reference)
+{
+    double squaredError = 0.0;
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        for (glm::length_t channel = 0; channel < 3; ++channel)
+        {
+            const double difference = static_cast<double>(image[i][channel]) - static_cast<double>(reference[i][channel]);
+            squaredError += difference * difference;
+        }
+    }
+    return std::sqrt(squaredError / static_cast<double>(image.size() * 3));
+}
+
+std::vector<glm::vec4> RenderReference(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+    for (uint32_t i = 0; i < REFERENCE_FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+    }
+    return renderer.ReadAccumulation();
+}
+
+// Renders like an offline render would, until no pixel is above the error threshold or the sample limit is reached everywhere
+void RunBenchmark(std::string_view name, const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings,
+    const std::vector<glm::vec4>& reference)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+
+    // Timings are resolved a few frames late, the last frames are left out of the total but cost next to nothing once converged
+    double pathTracingMs = 0.0;
+    uint32_t frameCount = 0;
+    while (frameCount < MAX_SAMPLES && !renderer.Converged())
+    {
+        renderer.Render();
+        pathTracingMs += renderer.GpuTimings().SectionDurationMs("Path Tracing") + renderer.GpuTimings().SectionDurationMs("Adaptive Mask");
+        ++frameCount;
+    }
+
+    const uint64_t uniformSamples = static_cast<uint64_t>(initInfo.width) * initInfo.height * MAX_SAMPLES;
+    const uint64_t tracedSamples = renderer.TracedSamples();
+    const double savedPercentage = 100.0 * static_cast<double>(uniformSamples - tracedSamples) / static_cast<double>(uniformSamples);
+
+    spdlog::info("[VULKAN] {:<16} {}x{} | {:>4} frames | {:>6.1f} average spp | {:>5.1f}% samples saved | {:>8.2f} ms | RMSE {:.6f}",
+        name, initInfo.width, initInfo.height, frameCount, static_cast<double>(tracedSamples) / (static_cast<double>(initInfo.width) * initInfo.height),
+        savedPercentage, pathTracingMs, RootMeanSquaredError(renderer.ReadAccumulation(), reference));
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RendererSettings settings {};
+    if (argc > 1)
+    {
+        settings.scene.assign(argv + 1, argv + argc);
+    }
+    settings.adaptiveMaxSamples = MAX_SAMPLES;
+
+    return RunGpuBenchmark("Adaptive Sampling Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            if (!vulkanContext->RayTracingIndirectSupported())
+            {
+                spdlog::warn("[VULKAN] No indirect trace rays support, the adaptive renders below sample every pixel");
+            }
+
+            // The reference uses its own sequences, so its remaining noise doesn't correlate with the measured images
+            settings.samplerSeed = 1;
+            const std::vector<glm::vec4> reference = RenderReference(vulkanInfo, vulkanContext, settings);
+
+            settings.samplerSeed = 0;
+            RunBenchmark("Uniform", vulkanInfo, vulkanContext, settings, reference);
+
+            settings.adaptiveSampling = true;
+            for (const float threshold : ERROR_THRESHOLDS)
+            {
+                settings.adaptiveErrorThreshold = threshold;
+                RunBenchmark(fmt::format("Adaptive {:.0f}%", threshold * 100.0f), vulkanInfo, vulkanContext, settings, reference);
+            }
+        });
+}
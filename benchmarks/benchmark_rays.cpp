@@ -0,0 +1,29 @@
+#include "benchmark_rays.hpp"
+#include <glm/geometric.hpp>
+
+std::vector<Ray> GeneratePrimaryRays(const AABB& bounds, uint32_t gridSize)
+{
+    const glm::vec3 target = bounds.Center();
+    const glm::vec3 origin = target + bounds.Extent() * glm::vec3(0.9f, 0.4f, 1.1f);
+
+    const glm::vec3 forward = glm::normalize(target - origin);
+    const glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
+    const glm::vec3 up = glm::cross(right, forward);
+
+    std::vector<Ray> rays {};
+    rays.reserve(static_cast<size_t>(gridSize) * gridSize);
+    for (uint32_t y = 0; y < gridSize; ++y)
+    {
+        for (uint32_t x = 0; x < gridSize; ++x)
+        {
+            const float u = (static_cast<float>(x) + 0.5f) / static_cast<float>(gridSize) * 2.0f - 1.0f;
+            const float v = (static_cast<float>(y) + 0.5f) / static_cast<float>(gridSize) * 2.0f - 1.0f;
+
+            Ray& ray = rays.emplace_back();
+            ray.origin = origin;
+            ray.direction = glm::normalize(forward + right * u * 0.6f + up * v * 0.6f);
+        }
+    }
+
+    return rays;
+}
@@ -0,0 +1,6 @@
+#pragma once
+#include <vector>
+#include "bvh/bvh.hpp"
+
+// Primary rays from a pinhole camera looking at the center of the bounds along their diagonal, one per cell of a square grid
+[[nodiscard]] std::vector<Ray> GeneratePrimaryRays(const AABB& bounds, uint32_t gridSize);
@@ -0,0 +1,60 @@
+// SDL throws some weird errors when parsed with clang-analyzer (used in clang-tidy checks)
+// This definition fixes the issues and does not change the final build output
+#define SDL_DISABLE_ANALYZE_MACROS
+
+#include "benchmark_window.hpp"
+#include <SDL3/SDL.h>
+#include <SDL3/SDL_vulkan.h>
+#include <spdlog/spdlog.h>
+#include <string>
+
+int RunGpuBenchmark(std::string_view title, uint32_t width, uint32_t height, const GpuBenchmarkFunction& benchmark)
+{
+    if (!SDL_Init(SDL_INIT_VIDEO))
+    {
+        spdlog::error("[SDL] Failed initializing SDL: {0}", SDL_GetError());
+        return 1;
+    }
+
+    SDL_Window* window = SDL_CreateWindow(std::string { title }.c_str(), static_cast<int>(width), static_cast<int>(height), SDL_WINDOW_VULKAN);
+    if (window == nullptr)
+    {
+        spdlog::error("[SDL] Failed creating SDL window: {}", SDL_GetError());
+        SDL_Quit();
+        return 1;
+    }
+
+    VulkanInitInfo vulkanInfo {};
+    uint32_t sdlExtensionsCount = 0;
+    vulkanInfo.extensions = SDL_Vulkan_GetInstanceExtensions(&sdlExtensionsCount);
+    vulkanInfo.extensionCount = sdlExtensionsCount;
+    vulkanInfo.width = width;
+    vulkanInfo.height = height;
+    vulkanInfo.retrieveSurface = [window](vk::Instance instance)
+    {
+        VkSurfaceKHR surface {};
+        if (!SDL_Vulkan_CreateSurface(window, instance, nullptr, &surface))
+        {
+            spdlog::error("[SDL] Failed creating SDL vk::Surface: {}", SDL_GetError());
+        }
+        return vk::SurfaceKHR(surface);
+    };
+
+    int result = 0;
+    {
+        auto vulkanContext = std::make_shared<VulkanContext>(vulkanInfo);
+        if (vulkanContext->HasRayTracingDevice())
+        {
+            benchmark(vulkanInfo, vulkanContext);
+        }
+        else
+        {
+            spdlog::error("[VULKAN] The {} needs a ray tracing capable GPU", title);
+            result = 1;
+        }
+    }
+
+    SDL_DestroyWindow(window);
+    SDL_Quit();
+    return result;
+}
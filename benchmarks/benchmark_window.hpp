@@ -0,0 +1,11 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string_view>
+#include "vulkan_context.hpp"
+
+using GpuBenchmarkFunction = std::function<void(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext)>;
+
+// Opens a window of the given size whose surface the renderers present to, creates the Vulkan context for it and runs the benchmark
+// when the device supports ray tracing. Returns the process exit code
+int RunGpuBenchmark(std::string_view title, uint32_t width, uint32_t height, const GpuBenchmarkFunction& benchmark);
@@ -0,0 +1,63 @@
+#include "benchmark_rays.hpp"
+#include "bvh/bvh_builder.hpp"
+#include "gltf_loader.hpp"
+#include "thread_pool.hpp"
+#include <chrono>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t RAY_GRID_SIZE = 512;
+
+void RunBenchmark(std::string_view name, const std::vector<BVHTriangle>& triangles, const BVHBuildSettings& settings)
+{
+    const BVH bvh = BVHBuilder { settings }.Build(triangles);
+    const BVHMetrics& metrics = bvh.metrics;
+
+    const std::vector<Ray> rays = GeneratePrimaryRays({ bvh.nodes[0].min, bvh.nodes[0].max }, RAY_GRID_SIZE);
+    uint32_t hits = 0;
+
+    const auto traceStart = std::chrono::high_resolution_clock::now();
+    for (const Ray& ray : rays)
+    {
+        RayHit hit {};
+        hits += bvh.Intersect(ray, hit) ? 1 : 0;
+    }
+    const std::chrono::duration<double> traceDuration = std::chrono::high_resolution_clock::now() - traceStart;
+
+    spdlog::info("[BVH] {:<16} build {:>9.2f} ms | SAH {:>8.2f} | nodes {:>8} | leaves {:>8} | depth {:>3} | references {:>8} | {:>6.2f} Mrays/s ({} hits)",
+        name, metrics.buildTimeMs, metrics.sahCost, metrics.nodeCount, metrics.leafCount, metrics.maxDepth, metrics.primitiveReferences,
+        static_cast<double>(rays.size()) / traceDuration.count() / 1e6, hits);
+}
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+    GLTFLoader loader { nullptr, nullptr };
+    auto threadPool = std::make_shared<ThreadPool>();
+
+    for (const std::string_view path : { "assets/dragon/DragonAttenuation.gltf", "assets/helmet/FlightHelmet.gltf" })
+    {
+        const std::shared_ptr<Model> model = loader.LoadFromFile(path);
+        if (model == nullptr)
+        {
+            spdlog::error("[BVH] Failed loading {}, benchmarks need to run from the repository root", path);
+            return 1;
+        }
+
+        std::vector<BVHTriangle> triangles {};
+        ExtractTriangles(*model, triangles);
+        spdlog::info("[BVH] {} - {} triangles, {} worker threads", path, triangles.size(), threadPool->ThreadCount());
+
+        BVHBuildSettings settings {};
+        RunBenchmark("Binned SAH", triangles, settings);
+
+        settings.threadPool = threadPool;
+        RunBenchmark("Parallel SAH", triangles, settings);
+
+        settings.spatialSplits = true;
+        RunBenchmark("Parallel SBVH", triangles, settings);
+    }
+
+    return 0;
+}
@@ -0,0 +1,63 @@
+#include "benchmark_window.hpp"
+#include "camera.hpp"
+#include "gpu_timer.hpp"
+#include "renderer.hpp"
+#include "vulkan_context.hpp"
+#include <chrono>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t FRAME_COUNT = 512;
+// Orbits like the reprojection benchmark, alternating between still and moving frames exercises both recorded variants
+constexpr float DEGREES_PER_FRAME = 0.5f;
+
+// Reports the CPU time spent recording command buffers and in Render as a whole, the camera moves every other frame when orbiting
+void RunBenchmark(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings, bool orbit)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+    double recordingMs = 0.0;
+    double pathTracingMs = 0.0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+    {
+        if (orbit)
+        {
+            const float angle = glm::radians(DEGREES_PER_FRAME * static_cast<float>(i / 2));
+            renderer.SetCameraView(OrbitView(angle));
+        }
+        renderer.Render();
+        recordingMs += renderer.CommandRecordingMs();
+        pathTracingMs += renderer.GpuTimings().SectionDurationMs("Path Tracing");
+    }
+    const std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+
+    spdlog::info("[VULKAN] {:<6} reuse {:<3} | CPU {:>7.4f} ms recording {:>7.3f} ms render per frame | GPU {:.3f} ms tracing per frame",
+        orbit ? "orbit" : "static", settings.reuseCommandBuffers ? "on" : "off", recordingMs / FRAME_COUNT, duration.count() / FRAME_COUNT,
+        pathTracingMs / FRAME_COUNT);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RendererSettings settings {};
+    if (argc > 1)
+    {
+        settings.scene.assign(argv + 1, argv + argc);
+    }
+
+    return RunGpuBenchmark("Command Reuse Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            for (const bool orbit : { false, true })
+            {
+                for (const bool reuse : { false, true })
+                {
+                    settings.reuseCommandBuffers = reuse;
+                    RunBenchmark(vulkanInfo, vulkanContext, settings, orbit);
+                }
+            }
+        });
+}
@@ -0,0 +1,62 @@
+#include "cpu_renderer.hpp"
+#include "renderer.hpp"
+#include "thread_pool.hpp"
+#include "bvh/simd.hpp"
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include <spdlog/spdlog.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+constexpr uint32_t FRAME_COUNT = 8;
+
+// Returns the framebuffer after all frames, both traversal modes trace the same samples and should end up with the same image
+std::vector<uint32_t> RunBenchmark(std::string_view name, std::string_view imagePath, const std::shared_ptr<ThreadPool>& threadPool, const CpuRendererSettings& settings)
+{
+    CpuRenderer renderer { RendererSettings {}, threadPool, settings };
+
+    // The first frame warms up caches and is not measured
+    renderer.Render();
+
+    double totalMegaRays = 0.0;
+    double bestMegaRays = 0.0;
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+        const double megaRays = renderer.LastFrameStatistics().MegaRaysPerSecond();
+        totalMegaRays += megaRays;
+        bestMegaRays = std::max(bestMegaRays, megaRays);
+    }
+
+    spdlog::info("[CPU] {:<14} {}x{} | average {:>7.2f} Mrays/s | best {:>7.2f} Mrays/s",
+        name, settings.width, settings.height, totalMegaRays / FRAME_COUNT, bestMegaRays);
+
+    static_cast<void>(renderer.SaveImage(std::string { imagePath }));
+    return renderer.Framebuffer();
+}
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+    auto threadPool = std::make_shared<ThreadPool>();
+    spdlog::info("[CPU] {} worker threads, {} wide SIMD packets", threadPool->ThreadCount(), SIMD_WIDTH);
+
+    CpuRendererSettings settings {};
+    settings.packetTraversal = false;
+    const std::vector<uint32_t> singleRayImage = RunBenchmark("Single rays", "output/cpu_tracer/single_rays.png", threadPool, settings);
+
+    settings.packetTraversal = true;
+    const std::vector<uint32_t> packetImage = RunBenchmark("Ray packets", "output/cpu_tracer/ray_packets.png", threadPool, settings);
+
+    // Packets only change how camera rays are traversed, differing pixels point at a traversal bug rather than noise
+    const size_t differingPixels = std::inner_product(singleRayImage.begin(), singleRayImage.end(), packetImage.begin(), size_t { 0 }, std::plus<> {}, std::not_equal_to<> {});
+    if (differingPixels > 0)
+    {
+        spdlog::warn("[CPU] {} pixels differ between single rays and ray packets", differingPixels);
+    }
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "benchmark_window.hpp"
+#include "gpu_timer.hpp"
+#include "renderer.hpp"
+#include "svgf_denoiser.hpp"
+#include "vulkan_context.hpp"
+#include <map>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t WARMUP_FRAME_COUNT = 16;
+constexpr uint32_t FRAME_COUNT = 256;
+
+// Averages every GPU section over the measured frames, the denoiser records one section per pass
+void RunBenchmark(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+    for (uint32_t i = 0; i < WARMUP_FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+    }
+
+    std::map<std::string, double> sectionTotalsMs {};
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+        for (const GpuTimer::Section& section : renderer.GpuTimings().Sections())
+        {
+            sectionTotalsMs[section.name] += section.durationMs;
+        }
+    }
+
+    double denoiserMs = 0.0;
+    for (const auto& [name, totalMs] : sectionTotalsMs)
+    {
+        const double averageMs = totalMs / FRAME_COUNT;
+        if (name.starts_with("SVGF"))
+        {
+            denoiserMs += averageMs;
+        }
+        spdlog::info("[VULKAN]   {:<16} {:>7.3f} ms", name, averageMs);
+    }
+    spdlog::info("[VULKAN] {} filter iterations {}x{} | denoiser {:.3f} ms per frame", settings.denoiserFilterIterations, initInfo.width, initInfo.height, denoiserMs);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RendererSettings settings {};
+    if (argc > 1)
+    {
+        settings.scene.assign(argv + 1, argv + argc);
+    }
+    settings.denoising = true;
+
+    return RunGpuBenchmark("Denoiser Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            for (uint32_t iterations = 1; iterations <= SvgfDenoiser::MAX_FILTER_ITERATIONS; ++iterations)
+            {
+                settings.denoiserFilterIterations = iterations;
+                RunBenchmark(vulkanInfo, vulkanContext, settings);
+            }
+        });
+}
@@ -0,0 +1,67 @@
+#include "benchmark_window.hpp"
+#include "gpu_timer.hpp"
+#include "renderer.hpp"
+#include "vulkan_context.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1920;
+constexpr uint32_t HEIGHT = 1080;
+constexpr uint32_t FRAME_COUNT = 512;
+// Frames the controller gets to settle before the frame times are measured
+constexpr uint32_t SETTLE_FRAME_COUNT = 256;
+
+// Reports the scale the controller settles at and how closely the GPU frame time then follows the target
+void RunBenchmark(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+    uint32_t scaleChanges = 0;
+    float previousScale = renderer.ResolutionScale();
+    double frameTimeTotalMs = 0.0;
+    double upscaleTotalMs = 0.0;
+    double worstFrameTimeMs = 0.0;
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+        if (renderer.ResolutionScale() != previousScale)
+        {
+            previousScale = renderer.ResolutionScale();
+            ++scaleChanges;
+        }
+
+        if (i >= SETTLE_FRAME_COUNT)
+        {
+            const double frameTimeMs = renderer.GpuTimings().TotalDurationMs();
+            frameTimeTotalMs += frameTimeMs;
+            upscaleTotalMs += renderer.GpuTimings().SectionDurationMs("Upscale");
+            worstFrameTimeMs = std::max(worstFrameTimeMs, frameTimeMs);
+        }
+    }
+
+    const double measuredFrames = FRAME_COUNT - SETTLE_FRAME_COUNT;
+    spdlog::info("[VULKAN] target {:>6.2f} ms | scale {:.3f} after {:>2} changes | GPU {:>6.2f} ms average {:>6.2f} ms worst | upscale {:.3f} ms",
+        settings.targetFrameTimeMs, renderer.ResolutionScale(), scaleChanges, frameTimeTotalMs / measuredFrames, worstFrameTimeMs,
+        upscaleTotalMs / measuredFrames);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RendererSettings settings {};
+    if (argc > 1)
+    {
+        settings.scene.assign(argv + 1, argv + argc);
+    }
+    settings.dynamicResolution = true;
+
+    return RunGpuBenchmark("Dynamic Resolution Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            for (const float targetFrameTimeMs : { 33.3f, 16.6f, 8.3f, 4.0f })
+            {
+                settings.targetFrameTimeMs = targetFrameTimeMs;
+                RunBenchmark(vulkanInfo, vulkanContext, settings);
+            }
+        });
+}
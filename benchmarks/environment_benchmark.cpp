@@ -0,0 +1,79 @@
+#include "environment_map.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t REPETITIONS = 3;
+
+// Dim sky with noise and a small, very bright sun, the kind of distribution importance sampling is for
+EnvironmentMap GenerateEnvironmentMap(uint32_t width, uint32_t height)
+{
+    EnvironmentMap environmentMap {};
+    environmentMap.width = width;
+    environmentMap.height = height;
+    environmentMap.texels.resize(static_cast<size_t>(width) * height);
+
+    std::mt19937 generator { 7 };
+    std::uniform_real_distribution<float> distribution { 0.0f, 1.0f };
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const float dx = static_cast<float>(x) / static_cast<float>(width) - 0.3f;
+            const float dy = static_cast<float>(y) / static_cast<float>(height) - 0.25f;
+            const float sun = dx * dx + dy * dy < 1e-4f ? 50000.0f : 0.0f;
+            const float sky = 0.5f + 0.1f * distribution(generator);
+            environmentMap.texels[static_cast<size_t>(y) * width + x] = glm::vec4 { sky + sun, sky + sun, sky * 1.3f + sun, 1.0f };
+        }
+    }
+
+    return environmentMap;
+}
+
+void RunBenchmark(std::string_view name, uint32_t width, uint32_t height)
+{
+    EnvironmentMap environmentMap = GenerateEnvironmentMap(width, height);
+
+    double bestMs = std::numeric_limits<double>::max();
+    for (uint32_t i = 0; i < REPETITIONS; ++i)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        BuildEnvironmentSampling(environmentMap);
+        const std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+        bestMs = std::min(bestMs, duration.count());
+    }
+
+    spdlog::info("[ENVIRONMENT] {:<3} {}x{} | sampling table {:>8.2f} ms | {:>7.1f} MB", name, width, height, bestMs,
+        static_cast<double>(environmentMap.aliasTable.size() * sizeof(AliasTableEntry)) / (1024.0 * 1024.0));
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RunBenchmark("4K", 4096, 2048);
+    RunBenchmark("8K", 8192, 4096);
+
+    // Real maps are passed on the command line, their load time is reported separately
+    for (int i = 1; i < argc; ++i)
+    {
+        const auto loadStart = std::chrono::high_resolution_clock::now();
+        std::optional<EnvironmentMap> environmentMap = LoadEnvironmentMap(argv[i]);
+        const std::chrono::duration<double, std::milli> loadDuration = std::chrono::high_resolution_clock::now() - loadStart;
+        if (!environmentMap.has_value())
+        {
+            return 1;
+        }
+
+        const auto start = std::chrono::high_resolution_clock::now();
+        BuildEnvironmentSampling(*environmentMap);
+        const std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+        spdlog::info("[ENVIRONMENT] {} {}x{} | load {:.2f} ms | sampling table {:.2f} ms", argv[i], environmentMap->width, environmentMap->height, loadDuration.count(), duration.count());
+    }
+
+    return 0;
+}
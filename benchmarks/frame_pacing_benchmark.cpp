@@ -0,0 +1,61 @@
+#include "benchmark_window.hpp"
+#include "renderer.hpp"
+#include "vulkan_context.hpp"
+#include <algorithm>
+#include <chrono>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t FRAME_COUNT = 512;
+// Pacing settles once every frame slot has been used, earlier frames have nothing to wait on
+constexpr uint32_t WARMUP_FRAME_COUNT = 16;
+
+// Reports how long the CPU waits on the GPU, how long the GPU idles between frames and the latch to completion latency
+void RunBenchmark(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+    for (uint32_t i = 0; i < WARMUP_FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+    }
+
+    Renderer::FramePacing total {};
+    double worstLatencyMs = 0.0;
+    const auto start = std::chrono::high_resolution_clock::now();
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+        const Renderer::FramePacing& pacing = renderer.LastFramePacing();
+        total.cpuWaitMs += pacing.cpuWaitMs;
+        total.gpuIdleMs += pacing.gpuIdleMs;
+        total.latencyMs += pacing.latencyMs;
+        worstLatencyMs = std::max(worstLatencyMs, pacing.latencyMs);
+    }
+    const std::chrono::duration<double, std::milli> duration = std::chrono::high_resolution_clock::now() - start;
+
+    spdlog::info("[VULKAN] {} frames in flight | {:>7.3f} ms per frame | CPU wait {:>7.3f} ms | GPU idle {:>7.3f} ms | latency {:>7.3f} ms, worst {:>7.3f} ms",
+        settings.framesInFlight, duration.count() / FRAME_COUNT, total.cpuWaitMs / FRAME_COUNT, total.gpuIdleMs / FRAME_COUNT,
+        total.latencyMs / FRAME_COUNT, worstLatencyMs);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RendererSettings settings {};
+    if (argc > 1)
+    {
+        settings.scene.assign(argv + 1, argv + argc);
+    }
+
+    return RunGpuBenchmark("Frame Pacing Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            for (uint32_t framesInFlight = 1; framesInFlight <= MAX_FRAMES_IN_FLIGHT; ++framesInFlight)
+            {
+                settings.framesInFlight = framesInFlight;
+                RunBenchmark(vulkanInfo, vulkanContext, settings);
+            }
+        });
+}
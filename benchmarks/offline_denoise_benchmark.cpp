@@ -0,0 +1,86 @@
+#include "benchmark_window.hpp"
+#include "gpu_timer.hpp"
+#include "offline_denoiser.hpp"
+#include "renderer.hpp"
+#include "thread_pool.hpp"
+#include "vulkan_context.hpp"
+#include <chrono>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t REFERENCE_FRAME_COUNT = 4096;
+constexpr uint32_t DENOISED_FRAME_COUNT = 16;
+// The sample count the denoised render should stand in for
+constexpr uint32_t TARGET_FRAME_COUNT = 1024;
+
+double RootMeanSquaredError(const std::vector<glm::vec4>& image, const std::vector<glm::vec4>& reference)
+{
+    double squaredError = 0.0;
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        for (glm::length_t channel = 0; channel < 3; ++channel)
+        {
+            const double difference = static_cast<double>(image[i][channel]) - static_cast<double>(reference[i][channel]);
+            squaredError += difference * difference;
+        }
+    }
+    return std::sqrt(squaredError / static_cast<double>(image.size() * 3));
+}
+
+// Renders frameCount samples per pixel and returns their outputs together with the GPU time spent path tracing
+RenderOutputs Render(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings,
+    uint32_t frameCount, double& pathTracingMs)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+    pathTracingMs = 0.0;
+    for (uint32_t i = 0; i < frameCount; ++i)
+    {
+        renderer.Render();
+        pathTracingMs += renderer.GpuTimings().SectionDurationMs("Path Tracing");
+    }
+    return renderer.ReadOutputs();
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RendererSettings settings {};
+    if (argc > 1)
+    {
+        settings.scene.assign(argv + 1, argv + argc);
+    }
+
+    return RunGpuBenchmark("Offline Denoise Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            ThreadPool threadPool {};
+            double pathTracingMs = 0.0;
+
+            // The reference uses its own sequences, so its remaining noise doesn't correlate with the measured images
+            settings.samplerSeed = 1;
+            const std::vector<glm::vec4> reference = Render(vulkanInfo, vulkanContext, settings, REFERENCE_FRAME_COUNT, pathTracingMs).color;
+
+            settings.samplerSeed = 0;
+            const RenderOutputs target = Render(vulkanInfo, vulkanContext, settings, TARGET_FRAME_COUNT, pathTracingMs);
+            spdlog::info("[VULKAN] {:>4} spp            | GPU {:>9.2f} ms |                  | RMSE {:.6f}", TARGET_FRAME_COUNT, pathTracingMs,
+                RootMeanSquaredError(target.color, reference));
+            WriteRenderImage("output/offline_denoise/target.png", target.color, WIDTH, HEIGHT);
+
+            settings.auxiliaryOutputs = true;
+            const RenderOutputs outputs = Render(vulkanInfo, vulkanContext, settings, DENOISED_FRAME_COUNT, pathTracingMs);
+            spdlog::info("[VULKAN] {:>4} spp            | GPU {:>9.2f} ms |                  | RMSE {:.6f}", DENOISED_FRAME_COUNT, pathTracingMs,
+                RootMeanSquaredError(outputs.color, reference));
+
+            const auto denoiseStart = std::chrono::high_resolution_clock::now();
+            const std::vector<glm::vec4> denoised = DenoiseRender(outputs, threadPool);
+            const std::chrono::duration<double, std::milli> denoiseDuration = std::chrono::high_resolution_clock::now() - denoiseStart;
+            spdlog::info("[VULKAN] {:>4} spp + denoise  | GPU {:>9.2f} ms | CPU {:>9.2f} ms | RMSE {:.6f}", DENOISED_FRAME_COUNT, pathTracingMs,
+                denoiseDuration.count(), RootMeanSquaredError(denoised, reference));
+
+            WriteRenderImage("output/offline_denoise/noisy.png", outputs.color, WIDTH, HEIGHT);
+            WriteRenderImage("output/offline_denoise/denoised.png", denoised, WIDTH, HEIGHT);
+        });
+}
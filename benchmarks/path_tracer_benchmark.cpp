@@ -0,0 +1,65 @@
+#include "benchmark_window.hpp"
+#include "gpu_timer.hpp"
+#include "renderer.hpp"
+#include "vulkan_context.hpp"
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t WARMUP_FRAME_COUNT = 16;
+constexpr uint32_t FRAME_COUNT = 128;
+
+void RunBenchmark(std::string_view name, const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings)
+{
+    double totalMs = 0.0;
+    uint64_t totalAnyHitInvocations = 0;
+    vk::DeviceSize stackSize {};
+    {
+        Renderer renderer { initInfo, vulkanContext, settings };
+        stackSize = renderer.PipelineStackSize();
+
+        for (uint32_t i = 0; i < WARMUP_FRAME_COUNT; ++i)
+        {
+            renderer.Render();
+        }
+
+        // Timings are resolved MAX_FRAMES_IN_FLIGHT frames after recording, so each frame reads an earlier, completed one
+        for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+        {
+            renderer.Render();
+            totalMs += renderer.GpuTimings().SectionDurationMs("Path Tracing");
+            totalAnyHitInvocations += renderer.LastFrameAnyHitInvocations();
+        }
+
+        vulkanContext->Device().waitIdle();
+    }
+
+    // Opaque geometry never invokes the alpha test, so anything above zero comes from masked materials
+    spdlog::info("[VULKAN] {:<18} {}x{} depth {} | stack {:>6} bytes per ray | path tracing {:>7.3f} ms | {:>10} any-hit invocations per frame",
+        name, initInfo.width, initInfo.height, settings.maxPathDepth, stackSize, totalMs / FRAME_COUNT, totalAnyHitInvocations / FRAME_COUNT);
+}
+}
+
+int main()
+{
+    return RunGpuBenchmark("Path Tracer Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            // Shader occupancy is not exposed by Vulkan, the per ray stack size that limits it is reported instead
+            RendererSettings settings {};
+            settings.boundedRayRecursion = false;
+            RunBenchmark("Device recursion", vulkanInfo, vulkanContext, settings);
+
+            settings.boundedRayRecursion = true;
+            RunBenchmark("Bounded recursion", vulkanInfo, vulkanContext, settings);
+
+            // The helmet mixes textured, untextured and emissive materials next to the plain dragon and cube
+            settings.scene = { "assets/helmet/FlightHelmet.gltf", "assets/dragon/DragonAttenuation.gltf", "assets/cube/Cube.gltf" };
+            settings.specializedHitGroups = false;
+            RunBenchmark("Mixed, uber shader", vulkanInfo, vulkanContext, settings);
+
+            settings.specializedHitGroups = true;
+            RunBenchmark("Mixed, specialized", vulkanInfo, vulkanContext, settings);
+        });
+}
@@ -0,0 +1,79 @@
+#include "benchmark_window.hpp"
+#include "gpu_timer.hpp"
+#include "render_graph.hpp"
+#include "renderer.hpp"
+#include "vulkan_context.hpp"
+#include <map>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t WARMUP_FRAME_COUNT = 16;
+constexpr uint32_t FRAME_COUNT = 256;
+
+struct Configuration
+{
+    const char* name {};
+    bool denoising {};
+    bool dynamicResolution {};
+};
+
+// Averages every pass's GPU section and the CPU time spent describing, compiling and recording the frame, which happens every frame
+// as command buffers aren't reused here
+void RunBenchmark(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, RendererSettings settings, const Configuration& configuration)
+{
+    settings.denoising = configuration.denoising;
+    settings.dynamicResolution = configuration.dynamicResolution;
+    settings.reuseCommandBuffers = false;
+
+    Renderer renderer { initInfo, vulkanContext, settings };
+    for (uint32_t i = 0; i < WARMUP_FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+    }
+
+    std::map<std::string, double> sectionTotalsMs {};
+    double recordingTotalMs = 0.0;
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+        recordingTotalMs += renderer.CommandRecordingMs();
+        for (const GpuTimer::Section& section : renderer.GpuTimings().Sections())
+        {
+            sectionTotalsMs[section.name] += section.durationMs;
+        }
+    }
+
+    const RenderGraph& graph = renderer.FrameGraph();
+    spdlog::info("[VULKAN] {:<28} | {:>2} barriers | recording {:>6.3f} ms | transient memory {:>7.2f} MiB, {:>7.2f} MiB saved by aliasing",
+        configuration.name, graph.BarrierCount(), recordingTotalMs / FRAME_COUNT, static_cast<double>(graph.TransientMemorySize()) / (1024.0 * 1024.0),
+        static_cast<double>(graph.TransientMemorySaved()) / (1024.0 * 1024.0));
+    for (const auto& [name, totalMs] : sectionTotalsMs)
+    {
+        spdlog::info("[VULKAN]   {:<20} {:>7.3f} ms", name, totalMs / FRAME_COUNT);
+    }
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RendererSettings settings {};
+    if (argc > 1)
+    {
+        settings.scene.assign(argv + 1, argv + argc);
+    }
+
+    return RunGpuBenchmark("Render Graph Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            for (const Configuration& configuration : {
+                     Configuration { "Accumulation", false, false },
+                     Configuration { "Denoising", true, false },
+                     Configuration { "Denoising, dynamic resolution", true, true },
+                 })
+            {
+                RunBenchmark(vulkanInfo, vulkanContext, settings, configuration);
+            }
+        });
+}
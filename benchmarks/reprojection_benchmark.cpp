@@ -0,0 +1,66 @@
+#include "benchmark_window.hpp"
+#include "camera.hpp"
+#include "gpu_timer.hpp"
+#include "renderer.hpp"
+#include "vulkan_context.hpp"
+#include <array>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t FRAME_COUNT = 256;
+constexpr std::array<float, 3> DEGREES_PER_FRAME { 0.1f, 0.5f, 2.0f };
+
+// Orbits the camera and reports how many samples the final frame's pixels hold, and how many pixels had to restart at one sample
+void RunBenchmark(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings, float degreesPerFrame)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+    double pathTracingMs = 0.0;
+    double historyMs = 0.0;
+    for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+    {
+        const float angle = glm::radians(degreesPerFrame * static_cast<float>(i));
+        renderer.SetCameraView(OrbitView(angle));
+        renderer.Render();
+        pathTracingMs += renderer.GpuTimings().SectionDurationMs("Path Tracing");
+        historyMs += renderer.GpuTimings().SectionDurationMs("Reprojection History");
+    }
+
+    const std::vector<glm::vec4> accumulation = renderer.ReadAccumulation();
+    double sampleCount = 0.0;
+    size_t restartedPixels = 0;
+    for (const glm::vec4& pixel : accumulation)
+    {
+        sampleCount += pixel.a;
+        restartedPixels += pixel.a <= 1.0f ? 1 : 0;
+    }
+
+    spdlog::info("[VULKAN] {:>4.1f} deg/frame reprojection {:<3} | {:>6.2f} spp | {:>5.1f}% restarted | GPU {:.3f} ms tracing {:.3f} ms history per frame",
+        degreesPerFrame, settings.temporalReprojection ? "on" : "off", sampleCount / static_cast<double>(accumulation.size()),
+        100.0 * static_cast<double>(restartedPixels) / static_cast<double>(accumulation.size()), pathTracingMs / FRAME_COUNT, historyMs / FRAME_COUNT);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RendererSettings settings {};
+    if (argc > 1)
+    {
+        settings.scene.assign(argv + 1, argv + argc);
+    }
+
+    return RunGpuBenchmark("Reprojection Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            for (const float degreesPerFrame : DEGREES_PER_FRAME)
+            {
+                for (const bool reprojection : { false, true })
+                {
+                    settings.temporalReprojection = reprojection;
+                    RunBenchmark(vulkanInfo, vulkanContext, settings, degreesPerFrame);
+                }
+            }
+        });
+}
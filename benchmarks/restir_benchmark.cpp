@@ -0,0 +1,98 @@
+#include "benchmark_window.hpp"
+#include "gpu_timer.hpp"
+#include "renderer.hpp"
+#include "vulkan_context.hpp"
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t REFERENCE_FRAME_COUNT = 4096;
+constexpr uint32_t MAX_FRAME_COUNT = 1024;
+constexpr double TIME_BUDGET_MS = 250.0;
+
+double FrameDurationMs(const GpuTimer& timer)
+{
+    double durationMs = 0.0;
+    for (const GpuTimer::Section& section : timer.Sections())
+    {
+        durationMs += section.durationMs;
+    }
+    return durationMs;
+}
+
+double RootMeanSquaredError(const std::vector<glm::vec4>& image, const std::vector<glm::vec4>& reference)
+{
+    double squaredError = 0.0;
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        for (glm::length_t channel = 0; channel < 3; ++channel)
+        {
+            const double difference = static_cast<double>(image[i][channel]) - static_cast<double>(reference[i][channel]);
+            squaredError += difference * difference;
+        }
+    }
+    return std::sqrt(squaredError / static_cast<double>(image.size() * 3));
+}
+
+std::vector<glm::vec4> RenderReference(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+    for (uint32_t i = 0; i < REFERENCE_FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+    }
+    return renderer.ReadAccumulation();
+}
+
+// Accumulates frames until their summed GPU time reaches the budget, then compares the average against the reference
+void RunBenchmark(std::string_view name, const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings,
+    const std::vector<glm::vec4>& reference)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+
+    // Timings are resolved MAX_FRAMES_IN_FLIGHT frames after recording, so the budget is spent on the durations of earlier frames
+    double totalMs = 0.0;
+    uint32_t frameCount = 0;
+    while (totalMs < TIME_BUDGET_MS && frameCount < MAX_FRAME_COUNT)
+    {
+        renderer.Render();
+        totalMs += FrameDurationMs(renderer.GpuTimings());
+        ++frameCount;
+    }
+
+    const double restirMs = renderer.GpuTimings().SectionDurationMs("ReSTIR Candidates") + renderer.GpuTimings().SectionDurationMs("ReSTIR Spatial");
+    const double rmse = RootMeanSquaredError(renderer.ReadAccumulation(), reference);
+
+    spdlog::info("[VULKAN] {:<14} {}x{} | {:>4} frames in {:>7.2f} ms | ReSTIR {:>6.3f} ms per frame | RMSE {:.6f}",
+        name, initInfo.width, initInfo.height, frameCount, totalMs, restirMs, rmse);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    // The bundled scenes have no emissive geometry, many light scenes are passed as glTF paths on the command line
+    RendererSettings settings {};
+    if (argc > 1)
+    {
+        settings.scene.assign(argv + 1, argv + argc);
+    }
+    // Only emissive triangles are resampled, the sun would hide most of the difference
+    settings.sunIrradiance = glm::vec3 { 0.0f };
+
+    return RunGpuBenchmark("ReSTIR Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            const std::vector<glm::vec4> reference = RenderReference(vulkanInfo, vulkanContext, settings);
+
+            settings.restirDirectLighting = false;
+            RunBenchmark("Light sampling", vulkanInfo, vulkanContext, settings, reference);
+
+            settings.restirDirectLighting = true;
+            RunBenchmark("ReSTIR", vulkanInfo, vulkanContext, settings, reference);
+
+            settings.restirSpatialSampleCount = 0;
+            RunBenchmark("ReSTIR temporal", vulkanInfo, vulkanContext, settings, reference);
+        });
+}
@@ -0,0 +1,83 @@
+#include "benchmark_window.hpp"
+#include "renderer.hpp"
+#include "vulkan_context.hpp"
+#include <array>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t WIDTH = 1280;
+constexpr uint32_t HEIGHT = 720;
+constexpr uint32_t REFERENCE_FRAME_COUNT = 4096;
+// One sample per pixel is traced every frame, the error is measured once each of these counts is reached
+constexpr std::array<uint32_t, 5> SAMPLE_COUNTS { 1, 4, 16, 64, 256 };
+
+double RootMeanSquaredError(const std::vector<glm::vec4>& image, const std::vector<glm::vec4>& reference)
+{
+    double squaredError = 0.0;
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        for (glm::length_t channel = 0; channel < 3; ++channel)
+        {
+            const double difference = static_cast<double>(image[i][channel]) - static_cast<double>(reference[i][channel]);
+            squaredError += difference * difference;
+        }
+    }
+    return std::sqrt(squaredError / static_cast<double>(image.size() * 3));
+}
+
+std::vector<glm::vec4> RenderReference(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+    for (uint32_t i = 0; i < REFERENCE_FRAME_COUNT; ++i)
+    {
+        renderer.Render();
+    }
+    return renderer.ReadAccumulation();
+}
+
+void RunBenchmark(std::string_view name, const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings,
+    const std::vector<glm::vec4>& reference)
+{
+    Renderer renderer { initInfo, vulkanContext, settings };
+
+    uint32_t frameCount = 0;
+    for (const uint32_t sampleCount : SAMPLE_COUNTS)
+    {
+        for (; frameCount < sampleCount; ++frameCount)
+        {
+            renderer.Render();
+        }
+
+        spdlog::info("[VULKAN] {:<16} {}x{} | {:>4} spp | RMSE {:.6f}", name, initInfo.width, initInfo.height, sampleCount,
+            RootMeanSquaredError(renderer.ReadAccumulation(), reference));
+    }
+}
+}
+
+int main(int argc, char* argv[])
+{
+    // The sun is a delta light and sampled exactly, the sky and bounces are where sequences make a difference
+    RendererSettings settings {};
+    if (argc > 1)
+    {
+        settings.scene.assign(argv + 1, argv + argc);
+    }
+
+    return RunGpuBenchmark("Sampler Benchmark", WIDTH, HEIGHT, [&](const VulkanInitInfo& vulkanInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
+        {
+            settings.sampler = SamplerType::eRandom;
+            settings.samplerSeed = 1;
+            const std::vector<glm::vec4> reference = RenderReference(vulkanInfo, vulkanContext, settings);
+
+            settings.samplerSeed = 0;
+            RunBenchmark("Random", vulkanInfo, vulkanContext, settings, reference);
+
+            settings.sampler = SamplerType::eSobol;
+            RunBenchmark("Owen Sobol", vulkanInfo, vulkanContext, settings, reference);
+
+            settings.sampler = SamplerType::eSobolBlueNoise;
+            RunBenchmark("Owen Sobol, blue", vulkanInfo, vulkanContext, settings, reference);
+        });
+}
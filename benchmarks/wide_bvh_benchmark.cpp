@@ -0,0 +1,109 @@
+#include "benchmark_rays.hpp"
+#include "bvh/bvh_builder.hpp"
+#include "bvh/wide_bvh.hpp"
+#include "gltf_loader.hpp"
+#include <chrono>
+#include <glm/geometric.hpp>
+#include <random>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr uint32_t RAY_GRID_SIZE = 512;
+constexpr uint32_t RANDOM_RAY_COUNT = RAY_GRID_SIZE * RAY_GRID_SIZE;
+
+// Incoherent rays between random points inside the model bounds, similar to diffuse bounces
+std::vector<Ray> GenerateRandomRays(const AABB& bounds)
+{
+    std::mt19937 generator { 1337 };
+    std::uniform_real_distribution<float> distribution { 0.0f, 1.0f };
+    const auto randomPoint = [&]() { return bounds.min + (bounds.max - bounds.min) * glm::vec3(distribution(generator), distribution(generator), distribution(generator)); };
+
+    std::vector<Ray> rays {};
+    rays.reserve(RANDOM_RAY_COUNT);
+    for (uint32_t i = 0; i < RANDOM_RAY_COUNT; ++i)
+    {
+        const glm::vec3 origin = randomPoint();
+        glm::vec3 direction = randomPoint() - origin;
+        if (glm::dot(direction, direction) < 1e-12f)
+        {
+            direction = glm::vec3(0.0f, 1.0f, 0.0f);
+        }
+
+        Ray& ray = rays.emplace_back();
+        ray.origin = origin;
+        ray.direction = glm::normalize(direction);
+    }
+
+    return rays;
+}
+
+template <typename T>
+void Trace(std::string_view layout, std::string_view rayType, const T& bvh, const std::vector<Ray>& rays)
+{
+    uint32_t hits = 0;
+
+    const auto traceStart = std::chrono::high_resolution_clock::now();
+    for (const Ray& ray : rays)
+    {
+        RayHit hit {};
+        hits += bvh.Intersect(ray, hit) ? 1 : 0;
+    }
+    const std::chrono::duration<double> traceDuration = std::chrono::high_resolution_clock::now() - traceStart;
+
+    spdlog::info("[BVH] {:<10} {:<10} {:>6.2f} Mrays/s ({} hits)", layout, rayType, static_cast<double>(rays.size()) / traceDuration.count() / 1e6, hits);
+}
+}
+
+int main([[maybe_unused]] int argc, [[maybe_unused]] char* argv[])
+{
+    GLTFLoader loader { nullptr, nullptr };
+
+    constexpr std::string_view path = "assets/dragon/DragonAttenuation.gltf";
+    const std::shared_ptr<Model> model = loader.LoadFromFile(path);
+    if (model == nullptr)
+    {
+        spdlog::error("[BVH] Failed loading {}, benchmarks need to run from the repository root", path);
+        return 1;
+    }
+
+    std::vector<BVHTriangle> triangles {};
+    ExtractTriangles(*model, triangles);
+    spdlog::info("[BVH] {} - {} triangles, {}-wide nodes", path, triangles.size(), WIDE_BVH_WIDTH);
+
+    // Leaves as large as a triangle block keep the collapsed blocks full
+    BVHBuildSettings settings {};
+    settings.maxLeafSize = WIDE_BVH_WIDTH;
+    const BVH bvh = BVHBuilder { settings }.Build(triangles);
+
+    const auto collapseStart = std::chrono::high_resolution_clock::now();
+    const std::optional<WideBVH> collapsed = CollapseBVH(bvh);
+    const std::chrono::duration<double, std::milli> collapseDuration = std::chrono::high_resolution_clock::now() - collapseStart;
+    if (!collapsed)
+    {
+        return 1;
+    }
+    const WideBVH& wideBVH = *collapsed;
+
+    const size_t binaryNodeBytes = bvh.nodes.size() * sizeof(BVHNode);
+    const size_t binaryPrimitiveBytes = bvh.primitiveIndices.size() * sizeof(uint32_t) + bvh.triangles.size() * sizeof(BVHTriangle);
+    const size_t wideNodeBytes = wideBVH.nodes.size() * sizeof(WideBVHNode);
+    const size_t widePrimitiveBytes = wideBVH.triangleBlocks.size() * sizeof(TriangleBlock);
+
+    spdlog::info("[BVH] Collapsed in {:.2f} ms", collapseDuration.count());
+    spdlog::info("[BVH] binary     {:>8} nodes | node memory {:>8.2f} KiB | primitive memory {:>8.2f} KiB",
+        bvh.nodes.size(), binaryNodeBytes / 1024.0, binaryPrimitiveBytes / 1024.0);
+    spdlog::info("[BVH] wide       {:>8} nodes | node memory {:>8.2f} KiB | primitive memory {:>8.2f} KiB ({} blocks)",
+        wideBVH.nodes.size(), wideNodeBytes / 1024.0, widePrimitiveBytes / 1024.0, wideBVH.triangleBlocks.size());
+
+    const AABB bounds { bvh.nodes[0].min, bvh.nodes[0].max };
+    const std::vector<Ray> primaryRays = GeneratePrimaryRays(bounds, RAY_GRID_SIZE);
+    const std::vector<Ray> randomRays = GenerateRandomRays(bounds);
+
+    Trace("binary", "coherent", bvh, primaryRays);
+    Trace("wide", "coherent", wideBVH, primaryRays);
+    Trace("binary", "incoherent", bvh, randomRays);
+    Trace("wide", "incoherent", wideBVH, randomRays);
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "common.hpp"
+
+class VulkanContext;
+
+// Stores serialized acceleration structures on disk, keyed by the geometry content hash and the device that produced them
+class AccelerationStructureCache
+{
+public:
+    AccelerationStructureCache(const std::shared_ptr<VulkanContext>& vulkanContext, const std::filesystem::path& directory);
+    ~AccelerationStructureCache() = default;
+    NON_COPYABLE(AccelerationStructureCache);
+    NON_MOVABLE(AccelerationStructureCache);
+
+    // Returns the serialized structure if it exists and the current device is able to deserialize it
+    [[nodiscard]] std::optional<std::vector<std::byte>> Load(uint64_t contentHash) const;
+    void Store(uint64_t contentHash, const std::vector<std::byte>& serializedData) const;
+
+    // Size of the structure once it is deserialized, read from the header written by the driver
+    [[nodiscard]] static uint64_t DeserializedSize(const std::vector<std::byte>& serializedData);
+
+private:
+    struct FileHeader
+    {
+        uint32_t magic {};
+        uint32_t version {};
+        uint64_t contentHash {};
+        uint64_t deviceHash {};
+        uint64_t dataSize {};
+    };
+
+    static constexpr uint32_t FILE_MAGIC = 0x53414C42; // "BLAS"
+    static constexpr uint32_t FILE_VERSION = 1;
+
+    [[nodiscard]] std::filesystem::path FilePath(uint64_t contentHash) const;
+    [[nodiscard]] bool IsCompatible(const std::vector<std::byte>& serializedData) const;
+
+    std::shared_ptr<VulkanContext> _vulkanContext;
+    std::filesystem::path _directory;
+    uint64_t _deviceHash {};
+};
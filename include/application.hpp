@@ -1,9 +1,15 @@
 #pragma once
+#include <cstdint>
 #include <memory>
+#include <glm/mat4x4.hpp>
 #include "common.hpp"
 
 class VulkanContext;
 class Renderer;
+class CpuRenderer;
+class ThreadPool;
+class Camera;
+class CameraController;
 class SDL_Window;
 
 class Application
@@ -18,9 +24,26 @@ public:
 
 private:
     void MainLoopOnce();
+    void ProcessEvents();
+    // Handed to the renderer, which calls it right before recording a frame
+    glm::mat4 LatchCamera();
+    void ReportInputLatency();
+    void InitializeCpuFallback(uint32_t width, uint32_t height);
+    void PresentCpuFrame();
 
     std::shared_ptr<VulkanContext> _vulkanContext;
     std::unique_ptr<Renderer> _renderer;
+    std::unique_ptr<CpuRenderer> _cpuRenderer;
+    std::shared_ptr<ThreadPool> _threadPool;
+    std::unique_ptr<Camera> _camera;
+    std::unique_ptr<CameraController> _cameraController;
+    // Age of the input applied by the latest camera latch, negative when it applied none
+    double _latchedInputAgeMs = -1.0;
+    // Input to submit latency over the current reporting interval
+    double _latencyTotalMs = 0.0;
+    double _latencyWorstMs = 0.0;
+    uint32_t _latencySamples = 0;
+    uint64_t _latencyIntervalStartNs = 0;
     SDL_Window* _window = nullptr;
     bool _exitRequested = false;
 };
\ No newline at end of file
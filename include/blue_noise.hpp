@@ -0,0 +1,7 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// Square, tileable blue noise threshold map generated with void and cluster (Ulichney 1993).
+// Every texel holds its rank in the fill order, remapped to (0, 1) so the values are uniformly distributed
+[[nodiscard]] std::vector<float> GenerateBlueNoise(uint32_t size, uint32_t seed);
@@ -2,16 +2,29 @@
 #include "acceleration_structure.hpp"
 #include "common.hpp"
 #include <glm/mat4x4.hpp>
+#include <vector>
 
 class VulkanContext;
 class BindlessResources;
+class AccelerationStructureCache;
+class ThreadPool;
 struct Model;
 struct Buffer;
 
+struct BLASBuildOptions
+{
+    std::shared_ptr<AccelerationStructureCache> cache {};
+
+    // Builds on the host through a deferred operation joined by the thread pool, requires accelerationStructureHostCommands
+    bool preferHostBuild = false;
+    std::shared_ptr<ThreadPool> threadPool {};
+};
+
 class BottomLevelAccelerationStructure : public AccelerationStructure
 {
 public:
-    BottomLevelAccelerationStructure(const std::shared_ptr<Model>& model, const std::shared_ptr<BindlessResources>& resources, const std::shared_ptr<VulkanContext>& vulkanContext, const glm::mat4& transform = glm::mat4(1.0f));
+    BottomLevelAccelerationStructure(const std::shared_ptr<Model>& model, const std::shared_ptr<BindlessResources>& resources, const std::shared_ptr<VulkanContext>& vulkanContext,
+        const BLASBuildOptions& options = {}, const glm::mat4& transform = glm::mat4(1.0f));
     ~BottomLevelAccelerationStructure();
     BottomLevelAccelerationStructure(BottomLevelAccelerationStructure&& other) noexcept;
     BottomLevelAccelerationStructure& operator=(BottomLevelAccelerationStructure&& other) = delete;
@@ -20,16 +33,29 @@ public:
     [[nodiscard]] vk::AccelerationStructureKHR Structure() const { return _vkStructure; }
     [[nodiscard]] const glm::mat4& Transform() const { return _transform; }
     [[nodiscard]] uint32_t GeometryCount() const { return _geometryCount; }
+    [[nodiscard]] uint32_t LightCount() const { return _lightCount; }
+    [[nodiscard]] bool LoadedFromCache() const { return _loadedFromCache; }
 
 private:
     void InitializeTransformBuffer();
-    void InitializeStructure(const std::shared_ptr<BindlessResources>& resources);
+    void InitializeStructure(const std::shared_ptr<BindlessResources>& resources, const BLASBuildOptions& options);
+    void CreateStructure(vk::DeviceSize size, std::string_view name, bool hostVisible = false);
+    void Build(vk::AccelerationStructureBuildGeometryInfoKHR& buildGeometryInfo, const std::vector<uint32_t>& maxPrimitiveCounts, const std::vector<vk::AccelerationStructureBuildRangeInfoKHR>& buildRangeInfos);
+    void BuildOnHost(vk::AccelerationStructureBuildGeometryInfoKHR& buildGeometryInfo, const std::vector<uint32_t>& maxPrimitiveCounts, const std::vector<vk::AccelerationStructureBuildRangeInfoKHR>& buildRangeInfos, ThreadPool& threadPool);
+    void Compact();
+    [[nodiscard]] std::vector<std::byte> Serialize() const;
+    void Deserialize(const std::vector<std::byte>& serializedData);
+    [[nodiscard]] uint64_t QueryStructureProperty(vk::QueryType queryType) const;
 
     glm::mat4 _transform {};
     uint32_t _geometryCount {};
+    uint32_t _lightCount {};
+    vk::DeviceSize _structureSize {};
+    bool _loadedFromCache = false;
 
     std::shared_ptr<Model> _model;
     std::unique_ptr<Buffer> _transformBuffer;
+    std::vector<vk::TransformMatrixKHR> _transformMatrices {};
 
     std::shared_ptr<VulkanContext> _vulkanContext;
 };
@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <glm/common.hpp>
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+#include <limits>
+#include <vector>
+
+struct Model;
+
+constexpr uint32_t BVH_INVALID_INDEX = std::numeric_limits<uint32_t>::max();
+
+struct AABB
+{
+    glm::vec3 min { std::numeric_limits<float>::max() };
+    glm::vec3 max { std::numeric_limits<float>::lowest() };
+
+    void Grow(const glm::vec3& point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void Grow(const AABB& other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    [[nodiscard]] bool IsValid() const { return min.x <= max.x && min.y <= max.y && min.z <= max.z; }
+    [[nodiscard]] glm::vec3 Center() const { return (min + max) * 0.5f; }
+    [[nodiscard]] glm::vec3 Extent() const { return max - min; }
+
+    [[nodiscard]] float SurfaceArea() const
+    {
+        if (!IsValid())
+        {
+            return 0.0f;
+        }
+
+        const glm::vec3 extent = Extent();
+        return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+    }
+
+    [[nodiscard]] static AABB Intersection(const AABB& a, const AABB& b) { return { glm::max(a.min, b.min), glm::min(a.max, b.max) }; }
+};
+
+struct BVHTriangle
+{
+    glm::vec3 v0 {};
+    glm::vec3 v1 {};
+    glm::vec3 v2 {};
+
+    // Index of the geometry in the same order the BLAS and the geometry nodes use, and the triangle within it
+    uint32_t geometryIndex {};
+    uint32_t primitiveIndex {};
+
+    [[nodiscard]] AABB Bounds() const
+    {
+        AABB bounds {};
+        bounds.Grow(v0);
+        bounds.Grow(v1);
+        bounds.Grow(v2);
+        return bounds;
+    }
+};
+
+// 32 bytes, nodes are stored depth first so the first child directly follows its parent
+struct BVHNode
+{
+    glm::vec3 min {};
+    uint32_t offset {}; // First primitive for leaves, second child for interior nodes
+    glm::vec3 max {};
+    uint32_t primitiveCount {}; // Zero for interior nodes
+
+    [[nodiscard]] bool IsLeaf() const { return primitiveCount > 0; }
+};
+
+static_assert(sizeof(BVHNode) == 32);
+
+struct BVHMetrics
+{
+    float sahCost {};
+    uint32_t nodeCount {};
+    uint32_t leafCount {};
+    uint32_t maxDepth {};
+    uint32_t maxLeafSize {};
+    uint64_t primitiveReferences {};
+    double buildTimeMs {};
+};
+
+struct Ray
+{
+    glm::vec3 origin {};
+    float tMin = 0.0f;
+    glm::vec3 direction {};
+    float tMax = std::numeric_limits<float>::max();
+};
+
+struct RayHit
+{
+    float t = std::numeric_limits<float>::max();
+    float u {};
+    float v {};
+    uint32_t triangleIndex = BVH_INVALID_INDEX;
+
+    [[nodiscard]] bool IsHit() const { return triangleIndex != BVH_INVALID_INDEX; }
+};
+
+struct BVH
+{
+    std::vector<BVHNode> nodes {};
+    // Leaves reference ranges of this array, which indexes into triangles. Spatial splits can reference a triangle more than once
+    std::vector<uint32_t> primitiveIndices {};
+    std::vector<BVHTriangle> triangles {};
+    BVHMetrics metrics {};
+
+    [[nodiscard]] bool Intersect(const Ray& ray, RayHit& hit) const;
+    [[nodiscard]] bool Occluded(const Ray& ray) const;
+};
+
+// Appends the world space triangles of every mesh node, geometry indices start at firstGeometryIndex
+void ExtractTriangles(const Model& model, std::vector<BVHTriangle>& triangles, const glm::mat4& transform = glm::mat4(1.0f), uint32_t firstGeometryIndex = 0);
+
+bool IntersectTriangle(const Ray& ray, const BVHTriangle& triangle, float& t, float& u, float& v);
@@ -0,0 +1,42 @@
+#pragma once
+#include "bvh/bvh.hpp"
+#include "common.hpp"
+#include <memory>
+
+class ThreadPool;
+
+struct BVHBuildSettings
+{
+    uint32_t binCount = 16;
+    uint32_t maxLeafSize = 4;
+    float traversalCost = 1.0f;
+    float intersectionCost = 1.0f;
+
+    // SBVH, spatial splits are only considered when the child overlap relative to the root area exceeds the threshold
+    bool spatialSplits = false;
+    float spatialSplitOverlapThreshold = 1e-5f;
+    float maxReferenceGrowth = 2.0f;
+
+    // Subtrees above the threshold are split in parallel when a thread pool is set
+    std::shared_ptr<ThreadPool> threadPool {};
+    uint32_t parallelThreshold = 4096;
+};
+
+class BVHBuilder
+{
+public:
+    static constexpr uint32_t MAX_DEPTH = 64;
+
+    explicit BVHBuilder(const BVHBuildSettings& settings = {});
+    ~BVHBuilder() = default;
+    NON_COPYABLE(BVHBuilder);
+    NON_MOVABLE(BVHBuilder);
+
+    [[nodiscard]] BVH Build(std::vector<BVHTriangle> triangles) const;
+
+    // Recomputes the metrics of a flattened BVH, the build time is left untouched
+    static void ComputeMetrics(BVH& bvh, float traversalCost, float intersectionCost);
+
+private:
+    BVHBuildSettings _settings;
+};
@@ -0,0 +1,29 @@
+#pragma once
+#include "bvh/bvh.hpp"
+#include "bvh/simd.hpp"
+
+// Coherent rays traced together through the binary BVH, one ray per SIMD lane
+struct alignas(SIMD_ALIGNMENT) RayPacket
+{
+    float originX[SIMD_WIDTH] {};
+    float originY[SIMD_WIDTH] {};
+    float originZ[SIMD_WIDTH] {};
+    float directionX[SIMD_WIDTH] {};
+    float directionY[SIMD_WIDTH] {};
+    float directionZ[SIMD_WIDTH] {};
+    float tMin = 0.0f;
+    float tMax = std::numeric_limits<float>::max();
+
+    void SetRay(uint32_t lane, const glm::vec3& origin, const glm::vec3& direction);
+};
+
+struct alignas(SIMD_ALIGNMENT) RayPacketHit
+{
+    float t[SIMD_WIDTH] {};
+    float u[SIMD_WIDTH] {};
+    float v[SIMD_WIDTH] {};
+    uint32_t triangleIndex[SIMD_WIDTH] {};
+};
+
+// Closest hit for every lane, lanes that miss keep BVH_INVALID_INDEX as their triangle index
+void IntersectPacket(const BVH& bvh, const RayPacket& packet, RayPacketHit& hit);
@@ -0,0 +1,232 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <glm/vec3.hpp>
+
+// Thin wrapper over the widest float vector available at compile time, AVX2 is opt in through ENABLE_AVX2
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_AVX2
+constexpr uint32_t SIMD_WIDTH = 8;
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SIMD_SSE
+constexpr uint32_t SIMD_WIDTH = 4;
+#else
+constexpr uint32_t SIMD_WIDTH = 4;
+#endif
+
+constexpr uint32_t SIMD_ALIGNMENT = SIMD_WIDTH * sizeof(float);
+
+struct SimdFloat
+{
+#if defined(SIMD_AVX2)
+    __m256 value;
+#elif defined(SIMD_SSE)
+    __m128 value;
+#else
+    std::array<float, SIMD_WIDTH> value;
+#endif
+
+    [[nodiscard]] static SimdFloat Broadcast(float scalar);
+    [[nodiscard]] static SimdFloat Load(const float* data);
+    // Converts SIMD_WIDTH unsigned bytes to floats
+    [[nodiscard]] static SimdFloat LoadBytes(const uint8_t* data);
+    void Store(float* data) const;
+};
+
+// Comparisons return all bits set in the lanes where they hold
+SimdFloat operator+(SimdFloat a, SimdFloat b);
+SimdFloat operator-(SimdFloat a, SimdFloat b);
+SimdFloat operator*(SimdFloat a, SimdFloat b);
+SimdFloat operator/(SimdFloat a, SimdFloat b);
+SimdFloat operator<(SimdFloat a, SimdFloat b);
+SimdFloat operator>(SimdFloat a, SimdFloat b);
+SimdFloat operator<=(SimdFloat a, SimdFloat b);
+SimdFloat operator&(SimdFloat a, SimdFloat b);
+SimdFloat operator|(SimdFloat a, SimdFloat b);
+SimdFloat Min(SimdFloat a, SimdFloat b);
+SimdFloat Max(SimdFloat a, SimdFloat b);
+SimdFloat Abs(SimdFloat a);
+SimdFloat Select(SimdFloat mask, SimdFloat a, SimdFloat b);
+// One bit per lane
+uint32_t MoveMask(SimdFloat mask);
+float HorizontalMin(SimdFloat a);
+
+#if defined(SIMD_AVX2)
+
+inline SimdFloat SimdFloat::Broadcast(float scalar) { return { _mm256_set1_ps(scalar) }; }
+inline SimdFloat SimdFloat::Load(const float* data) { return { _mm256_load_ps(data) }; }
+inline SimdFloat SimdFloat::LoadBytes(const uint8_t* data) { return { _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)))) }; }
+inline void SimdFloat::Store(float* data) const { _mm256_store_ps(data, value); }
+
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { return { _mm256_add_ps(a.value, b.value) }; }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { return { _mm256_sub_ps(a.value, b.value) }; }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { return { _mm256_mul_ps(a.value, b.value) }; }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { return { _mm256_div_ps(a.value, b.value) }; }
+inline SimdFloat operator<(SimdFloat a, SimdFloat b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_LT_OQ) }; }
+inline SimdFloat operator>(SimdFloat a, SimdFloat b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_GT_OQ) }; }
+inline SimdFloat operator<=(SimdFloat a, SimdFloat b) { return { _mm256_cmp_ps(a.value, b.value, _CMP_LE_OQ) }; }
+inline SimdFloat operator&(SimdFloat a, SimdFloat b) { return { _mm256_and_ps(a.value, b.value) }; }
+inline SimdFloat operator|(SimdFloat a, SimdFloat b) { return { _mm256_or_ps(a.value, b.value) }; }
+inline SimdFloat Min(SimdFloat a, SimdFloat b) { return { _mm256_min_ps(a.value, b.value) }; }
+inline SimdFloat Max(SimdFloat a, SimdFloat b) { return { _mm256_max_ps(a.value, b.value) }; }
+inline SimdFloat Abs(SimdFloat a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.value) }; }
+inline SimdFloat Select(SimdFloat mask, SimdFloat a, SimdFloat b) { return { _mm256_blendv_ps(b.value, a.value, mask.value) }; }
+inline uint32_t MoveMask(SimdFloat mask) { return static_cast<uint32_t>(_mm256_movemask_ps(mask.value)); }
+
+inline float HorizontalMin(SimdFloat a)
+{
+    __m128 result = _mm_min_ps(_mm256_castps256_ps128(a.value), _mm256_extractf128_ps(a.value, 1));
+    result = _mm_min_ps(result, _mm_movehl_ps(result, result));
+    result = _mm_min_ss(result, _mm_shuffle_ps(result, result, 1));
+    return _mm_cvtss_f32(result);
+}
+
+#elif defined(SIMD_SSE)
+
+inline SimdFloat SimdFloat::Broadcast(float scalar) { return { _mm_set1_ps(scalar) }; }
+inline SimdFloat SimdFloat::Load(const float* data) { return { _mm_load_ps(data) }; }
+
+inline SimdFloat SimdFloat::LoadBytes(const uint8_t* data)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i bytes = _mm_cvtsi32_si128(static_cast<int32_t>(data[0] | (data[1] << 8) | (data[2] << 16) | (static_cast<uint32_t>(data[3]) << 24)));
+    return { _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero)) };
+}
+
+inline void SimdFloat::Store(float* data) const { _mm_store_ps(data, value); }
+
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { return { _mm_add_ps(a.value, b.value) }; }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { return { _mm_sub_ps(a.value, b.value) }; }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { return { _mm_mul_ps(a.value, b.value) }; }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { return { _mm_div_ps(a.value, b.value) }; }
+inline SimdFloat operator<(SimdFloat a, SimdFloat b) { return { _mm_cmplt_ps(a.value, b.value) }; }
+inline SimdFloat operator>(SimdFloat a, SimdFloat b) { return { _mm_cmpgt_ps(a.value, b.value) }; }
+inline SimdFloat operator<=(SimdFloat a, SimdFloat b) { return { _mm_cmple_ps(a.value, b.value) }; }
+inline SimdFloat operator&(SimdFloat a, SimdFloat b) { return { _mm_and_ps(a.value, b.value) }; }
+inline SimdFloat operator|(SimdFloat a, SimdFloat b) { return { _mm_or_ps(a.value, b.value) }; }
+inline SimdFloat Min(SimdFloat a, SimdFloat b) { return { _mm_min_ps(a.value, b.value) }; }
+inline SimdFloat Max(SimdFloat a, SimdFloat b) { return { _mm_max_ps(a.value, b.value) }; }
+inline SimdFloat Abs(SimdFloat a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.value) }; }
+inline SimdFloat Select(SimdFloat mask, SimdFloat a, SimdFloat b) { return { _mm_or_ps(_mm_and_ps(mask.value, a.value), _mm_andnot_ps(mask.value, b.value)) }; }
+inline uint32_t MoveMask(SimdFloat mask) { return static_cast<uint32_t>(_mm_movemask_ps(mask.value)); }
+
+inline float HorizontalMin(SimdFloat a)
+{
+    __m128 result = _mm_min_ps(a.value, _mm_movehl_ps(a.value, a.value));
+    result = _mm_min_ss(result, _mm_shuffle_ps(result, result, 1));
+    return _mm_cvtss_f32(result);
+}
+
+#else
+
+namespace detail
+{
+template <typename Operation>
+SimdFloat PerLane(SimdFloat a, SimdFloat b, Operation operation)
+{
+    SimdFloat result {};
+    for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+    {
+        result.value[i] = operation(a.value[i], b.value[i]);
+    }
+    return result;
+}
+
+inline float Mask(bool condition) { return std::bit_cast<float>(condition ? 0xFFFFFFFFu : 0u); }
+inline uint32_t Bits(float value) { return std::bit_cast<uint32_t>(value); }
+}
+
+inline SimdFloat SimdFloat::Broadcast(float scalar)
+{
+    SimdFloat result {};
+    result.value.fill(scalar);
+    return result;
+}
+
+inline SimdFloat SimdFloat::Load(const float* data)
+{
+    SimdFloat result {};
+    for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+    {
+        result.value[i] = data[i];
+    }
+    return result;
+}
+
+inline SimdFloat SimdFloat::LoadBytes(const uint8_t* data)
+{
+    SimdFloat result {};
+    for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+    {
+        result.value[i] = static_cast<float>(data[i]);
+    }
+    return result;
+}
+
+inline void SimdFloat::Store(float* data) const
+{
+    for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+    {
+        data[i] = value[i];
+    }
+}
+
+inline SimdFloat operator+(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return x + y; }); }
+inline SimdFloat operator-(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return x - y; }); }
+inline SimdFloat operator*(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return x * y; }); }
+inline SimdFloat operator/(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return x / y; }); }
+inline SimdFloat operator<(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return detail::Mask(x < y); }); }
+inline SimdFloat operator>(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return detail::Mask(x > y); }); }
+inline SimdFloat operator<=(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return detail::Mask(x <= y); }); }
+inline SimdFloat operator&(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return std::bit_cast<float>(detail::Bits(x) & detail::Bits(y)); }); }
+inline SimdFloat operator|(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return std::bit_cast<float>(detail::Bits(x) | detail::Bits(y)); }); }
+inline SimdFloat Min(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return y < x ? y : x; }); }
+inline SimdFloat Max(SimdFloat a, SimdFloat b) { return detail::PerLane(a, b, [](float x, float y) { return y > x ? y : x; }); }
+inline SimdFloat Abs(SimdFloat a) { return detail::PerLane(a, a, [](float x, float) { return x < 0.0f ? -x : x; }); }
+
+inline SimdFloat Select(SimdFloat mask, SimdFloat a, SimdFloat b)
+{
+    SimdFloat result {};
+    for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+    {
+        result.value[i] = detail::Bits(mask.value[i]) != 0 ? a.value[i] : b.value[i];
+    }
+    return result;
+}
+
+inline uint32_t MoveMask(SimdFloat mask)
+{
+    uint32_t result = 0;
+    for (uint32_t i = 0; i < SIMD_WIDTH; ++i)
+    {
+        result |= (detail::Bits(mask.value[i]) >> 31) << i;
+    }
+    return result;
+}
+
+inline float HorizontalMin(SimdFloat a)
+{
+    float result = a.value[0];
+    for (uint32_t i = 1; i < SIMD_WIDTH; ++i)
+    {
+        result = a.value[i] < result ? a.value[i] : result;
+    }
+    return result;
+}
+
+#endif
+
+struct SimdVector
+{
+    SimdFloat x, y, z;
+
+    [[nodiscard]] static SimdVector Broadcast(const glm::vec3& vector) { return { SimdFloat::Broadcast(vector.x), SimdFloat::Broadcast(vector.y), SimdFloat::Broadcast(vector.z) }; }
+    [[nodiscard]] static SimdVector Load(const float* x, const float* y, const float* z) { return { SimdFloat::Load(x), SimdFloat::Load(y), SimdFloat::Load(z) }; }
+};
+
+inline SimdVector operator-(const SimdVector& a, const SimdVector& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+inline SimdFloat Dot(const SimdVector& a, const SimdVector& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline SimdVector Cross(const SimdVector& a, const SimdVector& b) { return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
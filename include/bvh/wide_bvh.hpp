@@ -0,0 +1,59 @@
+#pragma once
+#include "bvh/bvh.hpp"
+#include "bvh/simd.hpp"
+#include <optional>
+
+// Branching factor of the wide BVH follows the SIMD width, so one node is tested against a ray in a single pass
+constexpr uint32_t WIDE_BVH_WIDTH = SIMD_WIDTH;
+
+// Child bounds are stored as 8-bit offsets from the parent box origin, scaled by a power of two per axis.
+// Decoding rounds outwards, so quantized boxes always contain the exact ones
+struct alignas(SIMD_ALIGNMENT) WideBVHNode
+{
+    static constexpr uint32_t LEAF_FLAG = 1u << 31;
+    static constexpr uint32_t LEAF_BLOCK_COUNT_SHIFT = 24;
+    static constexpr uint32_t LEAF_FIRST_BLOCK_MASK = (1u << LEAF_BLOCK_COUNT_SHIFT) - 1;
+    static constexpr uint32_t MAX_LEAF_BLOCKS = 1u << (31 - LEAF_BLOCK_COUNT_SHIFT);
+
+    glm::vec3 origin {};
+    int8_t exponent[3] {};
+    uint8_t childCount {};
+
+    // Interior children hold a node index, leaves the flag, their block count minus one and their first triangle block
+    uint32_t children[WIDE_BVH_WIDTH] {};
+
+    uint8_t minX[WIDE_BVH_WIDTH] {};
+    uint8_t minY[WIDE_BVH_WIDTH] {};
+    uint8_t minZ[WIDE_BVH_WIDTH] {};
+    uint8_t maxX[WIDE_BVH_WIDTH] {};
+    uint8_t maxY[WIDE_BVH_WIDTH] {};
+    uint8_t maxZ[WIDE_BVH_WIDTH] {};
+};
+
+// Triangles of a leaf stored as structure of arrays, unused lanes are degenerate and never hit
+struct alignas(SIMD_ALIGNMENT) TriangleBlock
+{
+    float v0X[WIDE_BVH_WIDTH] {};
+    float v0Y[WIDE_BVH_WIDTH] {};
+    float v0Z[WIDE_BVH_WIDTH] {};
+    float edge1X[WIDE_BVH_WIDTH] {};
+    float edge1Y[WIDE_BVH_WIDTH] {};
+    float edge1Z[WIDE_BVH_WIDTH] {};
+    float edge2X[WIDE_BVH_WIDTH] {};
+    float edge2Y[WIDE_BVH_WIDTH] {};
+    float edge2Z[WIDE_BVH_WIDTH] {};
+    uint32_t triangleIndex[WIDE_BVH_WIDTH] {};
+};
+
+struct WideBVH
+{
+    std::vector<WideBVHNode> nodes {};
+    std::vector<TriangleBlock> triangleBlocks {};
+
+    // Hits report triangle indices of the binary BVH the wide one was collapsed from
+    [[nodiscard]] bool Intersect(const Ray& ray, RayHit& hit) const;
+    [[nodiscard]] size_t MemoryFootprint() const { return nodes.size() * sizeof(WideBVHNode) + triangleBlocks.size() * sizeof(TriangleBlock); }
+};
+
+// Fails when the triangle blocks outgrow what leaves can address
+[[nodiscard]] std::optional<WideBVH> CollapseBVH(const BVH& bvh);
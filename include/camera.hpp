@@ -0,0 +1,36 @@
+#pragma once
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+// The scenes are set up with negative y pointing up
+inline const glm::vec3 WORLD_UP { 0.0f, -1.0f, 0.0f };
+// Position of the default view, which looks at the origin the bundled scenes are centered on
+inline const glm::vec3 DEFAULT_CAMERA_POSITION { -8.0f, 3.2f, 1.5f };
+
+// First person camera. Its orientation is kept as yaw and pitch around the scene's up axis, so it never rolls
+class Camera
+{
+public:
+    // Takes over the position and viewing direction of a world to view transform
+    explicit Camera(const glm::mat4& view);
+
+    // Where the GPU and CPU renderers look from until the camera is moved
+    [[nodiscard]] static glm::mat4 DefaultView();
+    // Default view turned around the up axis through the origin, angle in radians
+    [[nodiscard]] static glm::mat4 OrbitView(float angle);
+
+    // Offset along the camera's right, up and forward axes
+    void Move(const glm::vec3& localOffset);
+    // Angles in radians, positive yaw turns left and positive pitch looks up. Pitch stops short of straight up and down
+    void Rotate(float yawDelta, float pitchDelta);
+
+    [[nodiscard]] glm::mat4 View() const;
+    [[nodiscard]] glm::vec3 Position() const { return _position; }
+    [[nodiscard]] glm::vec3 Forward() const;
+    [[nodiscard]] glm::vec3 Right() const;
+
+private:
+    glm::vec3 _position {};
+    float _yaw = 0.0f;
+    float _pitch = 0.0f;
+};
@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include <glm/vec2.hpp>
+#include "common.hpp"
+
+class Camera;
+union SDL_Event;
+struct SDL_Gamepad;
+
+// Drives a camera from SDL input. WASD moves, Q and E descend and ascend, shift moves faster and the mouse looks around while its right
+// button is held. Gamepads move with the left stick, look with the right one and descend and ascend with the triggers
+class CameraController
+{
+public:
+    explicit CameraController(Camera& camera);
+    ~CameraController();
+    NON_COPYABLE(CameraController);
+    NON_MOVABLE(CameraController);
+
+    void ProcessEvent(const SDL_Event& event);
+    // Applies the mouse motion received since the previous update and the keys and sticks held over that time
+    void Update();
+
+    // SDL_GetTicksNS time of the oldest input the last update applied, zero when it didn't change the camera
+    [[nodiscard]] uint64_t LastUpdateInputTimestampNs() const { return _lastUpdateInputTimestampNs; }
+
+private:
+    void RecordInputTimestamp(uint64_t timestampNs);
+
+    Camera& _camera;
+    SDL_Gamepad* _gamepad = nullptr;
+    bool _looking = false;
+    glm::vec2 _pendingMouseMotion {};
+    uint64_t _pendingInputTimestampNs = 0;
+    uint64_t _lastUpdateInputTimestampNs = 0;
+    uint64_t _lastUpdateNs = 0;
+};
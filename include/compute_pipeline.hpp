@@ -0,0 +1,61 @@
+#pragma once
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "common.hpp"
+
+class VulkanContext;
+
+struct ComputePipelineCreation
+{
+    std::string shaderPath {};
+    // Bindings of the pipeline's only descriptor set, their stage flags are set to compute
+    std::vector<vk::DescriptorSetLayoutBinding> bindings {};
+    uint32_t pushConstantSize {};
+    std::string name {};
+
+    ComputePipelineCreation& SetShaderPath(std::string_view shaderPath);
+    ComputePipelineCreation& AddBinding(uint32_t binding, vk::DescriptorType type, uint32_t count = 1);
+    ComputePipelineCreation& SetPushConstantSize(uint32_t pushConstantSize);
+    ComputePipelineCreation& SetName(std::string_view name);
+};
+
+// Compute shader with a single descriptor set allocated from its own pool, callers fill the set with WriteDescriptor
+class ComputePipeline
+{
+public:
+    ComputePipeline(const ComputePipelineCreation& creation, const std::shared_ptr<VulkanContext>& vulkanContext);
+    ~ComputePipeline();
+    NON_COPYABLE(ComputePipeline);
+    NON_MOVABLE(ComputePipeline);
+
+    void WriteDescriptor(uint32_t binding, vk::ImageView imageView, uint32_t arrayElement = 0, vk::ImageLayout layout = vk::ImageLayout::eGeneral, vk::Sampler sampler = nullptr) const;
+    void WriteDescriptor(uint32_t binding, vk::Buffer buffer, vk::DeviceSize range = vk::WholeSize) const;
+
+    // Binds the pipeline and its set, then dispatches enough workgroups to cover width by height with the given workgroup size
+    void Dispatch(vk::CommandBuffer commandBuffer, uint32_t width, uint32_t height, std::span<const std::byte> pushConstants = {}, uint32_t workgroupSize = 8) const;
+    template <typename T>
+    void Dispatch(vk::CommandBuffer commandBuffer, uint32_t width, uint32_t height, const T& pushConstants, uint32_t workgroupSize = 8) const
+    {
+        Dispatch(commandBuffer, width, height, std::as_bytes(std::span { &pushConstants, 1 }), workgroupSize);
+    }
+
+    [[nodiscard]] vk::Pipeline Pipeline() const { return _pipeline; }
+    [[nodiscard]] vk::PipelineLayout Layout() const { return _pipelineLayout; }
+    [[nodiscard]] vk::DescriptorSet DescriptorSet() const { return _descriptorSet; }
+
+private:
+    std::shared_ptr<VulkanContext> _vulkanContext;
+    std::vector<vk::DescriptorSetLayoutBinding> _bindings {};
+    uint32_t _pushConstantSize {};
+
+    vk::DescriptorPool _descriptorPool;
+    vk::DescriptorSetLayout _descriptorSetLayout;
+    vk::DescriptorSet _descriptorSet;
+    vk::PipelineLayout _pipelineLayout;
+    vk::Pipeline _pipeline;
+
+    [[nodiscard]] vk::DescriptorType BindingType(uint32_t binding) const;
+};
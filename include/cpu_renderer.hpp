@@ -0,0 +1,127 @@
+#pragma once
+#include "bvh/bvh.hpp"
+#include "common.hpp"
+#include "environment_map.hpp"
+#include "light_sampling.hpp"
+#include "renderer.hpp"
+#include <atomic>
+#include <glm/mat4x4.hpp>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+struct Material;
+struct ImageCreation;
+
+struct CpuRendererSettings
+{
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    uint32_t tileSize = 16;
+
+    // Traces coherent SIMD packets instead of single rays for the camera rays, bounces and shadow rays are always traced one by one
+    bool packetTraversal = true;
+};
+
+// Reference path tracer that renders the same models and materials as the GPU renderer on the CPU. Paths follow shaders/ray_gen.rgen
+// with the random sampler: Lambertian bounces, Russian roulette and next event estimation towards the sun, the emissive triangles
+// and the environment, weighted against bounce hits with the power heuristic. ReSTIR, adaptive sampling and the denoisers have no
+// counterpart, the renderer settings enabling them are ignored
+class CpuRenderer
+{
+public:
+    struct FrameStatistics
+    {
+        // Camera, bounce and shadow rays
+        uint64_t rayCount {};
+        double durationMs {};
+
+        [[nodiscard]] double MegaRaysPerSecond() const { return durationMs > 0.0 ? static_cast<double>(rayCount) / (durationMs * 1000.0) : 0.0; }
+    };
+
+    // Scene, lighting, path depth and display transform come from the renderer settings, so both renderers can be compared
+    CpuRenderer(const RendererSettings& rendererSettings, const std::shared_ptr<ThreadPool>& threadPool, const CpuRendererSettings& settings = {});
+    ~CpuRenderer();
+    NON_COPYABLE(CpuRenderer);
+    NON_MOVABLE(CpuRenderer);
+
+    // Starts out at the same default view as the GPU renderer, takes effect on the next Render and restarts accumulation
+    void SetCameraView(const glm::mat4& view);
+
+    // Traces one sample per pixel, averages it into the accumulation and updates the framebuffer
+    void Render();
+    bool SaveImage(const std::string& path) const;
+
+    // RGBA8 display values after exposure, tonemapping and sRGB encoding, same layout as the GPU render target
+    [[nodiscard]] const std::vector<uint32_t>& Framebuffer() const { return _framebuffer; }
+    // Linear radiance averaged over all samples so far, with the sample count in alpha
+    [[nodiscard]] const std::vector<glm::vec4>& Accumulation() const { return _accumulation; }
+    [[nodiscard]] uint32_t AccumulatedSamples() const { return _accumulatedSamples; }
+    [[nodiscard]] uint32_t Width() const { return _settings.width; }
+    [[nodiscard]] uint32_t Height() const { return _settings.height; }
+    [[nodiscard]] const FrameStatistics& LastFrameStatistics() const { return _lastFrameStatistics; }
+    [[nodiscard]] const BVHMetrics& SceneMetrics() const { return _bvh.metrics; }
+
+private:
+    struct Geometry
+    {
+        std::shared_ptr<Model> model;
+        uint32_t firstIndex {};
+        uint32_t materialIndex {};
+        // Light of the geometry's first triangle, NO_LIGHT when it doesn't emit
+        uint32_t firstLightIndex {};
+    };
+
+    // What the closest hit and miss shaders report to the path tracing loop
+    struct Surface
+    {
+        glm::vec3 albedo { 1.0f };
+        glm::vec3 emission {};
+        glm::vec3 normal {};
+        uint32_t lightIndex {};
+    };
+
+    void LoadScene(const std::vector<std::string>& scene);
+    void LoadEnvironment(const std::string& path);
+    void RenderTile(uint32_t tileIndex);
+    uint64_t RenderTilePackets(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY);
+    uint64_t RenderTileSingleRays(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY);
+
+    [[nodiscard]] uint32_t InitSampler(uint32_t x, uint32_t y) const;
+    [[nodiscard]] Ray GenerateCameraRay(uint32_t x, uint32_t y, glm::vec2 jitter) const;
+    // Continues the path after its camera ray, which was traced already. Returns the radiance and counts the rays it traces
+    [[nodiscard]] glm::vec3 TracePath(Ray ray, RayHit hit, uint32_t& sampleState, uint64_t& rayCount) const;
+    [[nodiscard]] Surface ShadeHit(const RayHit& hit, const glm::vec3& direction) const;
+    [[nodiscard]] glm::vec3 SampleTriangleLights(const glm::vec3& position, const glm::vec3& normal, bool bounceFollows, uint32_t& sampleState, uint64_t& rayCount) const;
+    [[nodiscard]] glm::vec3 SampleEnvironmentLight(const glm::vec3& position, const glm::vec3& normal, bool bounceFollows, uint32_t& sampleState, uint64_t& rayCount) const;
+    [[nodiscard]] glm::vec3 LightEmission(const TriangleLight& light, const glm::vec3& barycentrics) const;
+    [[nodiscard]] glm::vec3 EnvironmentRadiance(const glm::vec3& direction) const;
+    [[nodiscard]] float EnvironmentPdf(const glm::vec3& direction) const;
+    [[nodiscard]] glm::vec4 SampleTexture(uint32_t textureIndex, glm::vec2 texCoord) const;
+    void AccumulatePixel(uint32_t x, uint32_t y, const glm::vec3& radiance);
+
+    CpuRendererSettings _settings {};
+    RendererSettings _rendererSettings {};
+    std::shared_ptr<ThreadPool> _threadPool;
+
+    std::vector<std::shared_ptr<Model>> _models {};
+    std::vector<Geometry> _geometries {};
+    std::vector<Material> _materials {};
+    std::vector<ImageCreation> _textures {};
+    std::vector<TriangleLight> _lights {};
+    std::optional<EnvironmentMap> _environmentMap {};
+    // Zero when the environment is not importance sampled, like the GPU renderer's push constant
+    float _environmentPdfScale {};
+    BVH _bvh {};
+
+    glm::mat4 _viewInverse {};
+    glm::mat4 _projInverse {};
+
+    std::vector<glm::vec4> _accumulation {};
+    uint32_t _accumulatedSamples {};
+    std::vector<uint32_t> _framebuffer {};
+    std::atomic<uint64_t> _rayCount {};
+    FrameStatistics _lastFrameStatistics {};
+};
@@ -0,0 +1,24 @@
+#pragma once
+#include "light_sampling.hpp"
+#include <glm/vec4.hpp>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+// Equirectangular environment holding linear radiance, rows run from the +Y pole to the -Y pole
+struct EnvironmentMap
+{
+    uint32_t width {};
+    uint32_t height {};
+    std::vector<glm::vec4> texels {};
+
+    // Texels are sampled proportional to their luminance times the solid angle they cover, see shaders/environment.glsl
+    std::vector<AliasTableEntry> aliasTable {};
+    // Turns luminance times the sine of a texel row into the solid angle density of sampling a direction, 0 for a black environment
+    float pdfScale {};
+};
+
+// Loads Radiance .hdr files, OpenEXR is not supported by stb_image
+[[nodiscard]] std::optional<EnvironmentMap> LoadEnvironmentMap(std::string_view path);
+
+void BuildEnvironmentSampling(EnvironmentMap& environmentMap);
@@ -1,5 +1,7 @@
 #pragma once
 #include "common.hpp"
+#include "light_sampling.hpp"
+#include "resources/gpu_resources.hpp"
 #include "resources/resource_manager.hpp"
 #include <fastgltf/core.hpp>
 #include <glm/vec3.hpp>
@@ -8,9 +10,6 @@
 
 class VulkanContext;
 class BindlessResources;
-struct Buffer;
-struct Image;
-struct Material;
 
 struct Node
 {
@@ -26,6 +25,8 @@ struct Mesh
     uint32_t indexCount {};
     uint32_t firstIndex {};
     ResourceHandle<Material> material {};
+    MaterialFeatures materialFeatures = MaterialFeatures::eNone;
+    bool emissive = false;
 };
 
 struct Model
@@ -39,18 +40,33 @@ struct Model
 
     std::unique_ptr<Buffer> vertexBuffer;
     std::unique_ptr<Buffer> indexBuffer;
+    // Host copies of the geometry, used by host acceleration structure builds and CPU side processing. Empty once a renderer built its BLAS
+    std::vector<Vertex> vertices {};
+    std::vector<uint32_t> indices {};
     uint32_t verticesCount {};
     uint32_t indexCount {};
+    // Transfer timeline value of the vertex and index buffer upload, consumers on other queues wait on it
+    uint64_t uploadTimelineValue {};
+
+    // Hash of the geometry that ends up in the BLAS, used as a key for cached acceleration structures
+    uint64_t contentHash {};
 
     std::vector<Node> nodes {};
     std::vector<Mesh> meshes {};
+    // Triangles of all emissive meshes in model space, in the order of the nodes referencing them
+    std::vector<EmissiveTriangle> emissiveTriangles {};
     std::vector<ResourceHandle<Image>> textures {};
     std::vector<ResourceHandle<Material>> materials {};
+
+    // Only filled for models loaded without a device, the image and material handles then index into these
+    std::vector<ImageCreation> hostImages {};
+    std::vector<Material> hostMaterials {};
 };
 
 class GLTFLoader
 {
 public:
+    // Passing no device loads models into host memory only, for CPU side processing and rendering
     GLTFLoader(const std::shared_ptr<BindlessResources>& bindlessResources, const std::shared_ptr<VulkanContext>& vulkanContext);
     ~GLTFLoader() = default;
     NON_COPYABLE(GLTFLoader);
@@ -0,0 +1,60 @@
+#pragma once
+#include <array>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "common.hpp"
+#include "vk_common.hpp"
+
+// Measures GPU durations of command buffer sections with timestamp queries, with one query range per frame in flight
+class GpuTimer
+{
+public:
+    struct Section
+    {
+        std::string name {};
+        double durationMs {};
+    };
+
+    GpuTimer(const std::shared_ptr<VulkanContext>& vulkanContext, uint32_t maxSectionsPerFrame = 16);
+    ~GpuTimer();
+    NON_COPYABLE(GpuTimer);
+    NON_MOVABLE(GpuTimer);
+
+    // Resolves the sections submitted the last time this frame slot was used, so its timeline value has to be waited on first
+    void ResolveFrame(uint32_t frameIndex);
+    // Resets the frame slot's queries and starts recording its sections, EndFrame marks the end of the frame's work
+    void BeginFrame(vk::CommandBuffer commandBuffer, uint32_t frameIndex);
+    void EndFrame(vk::CommandBuffer commandBuffer);
+    void BeginSection(vk::CommandBuffer commandBuffer, std::string_view name);
+    void EndSection(vk::CommandBuffer commandBuffer);
+
+    // Sections recorded since the frame slot's BeginFrame. Command buffers submitted again hand theirs back with SetFrameSections,
+    // so they resolve under the right names
+    [[nodiscard]] const std::vector<std::string>& FrameSections(uint32_t frameIndex) const { return _frameSections.at(frameIndex); }
+    void SetFrameSections(uint32_t frameIndex, const std::vector<std::string>& sections) { _frameSections.at(frameIndex) = sections; }
+
+    // Durations of the most recently resolved frame, 0 when timestamps are not supported by the graphics queue
+    [[nodiscard]] const std::vector<Section>& Sections() const { return _resolvedSections; }
+    [[nodiscard]] double SectionDurationMs(std::string_view name) const;
+    // Sum of all sections of the most recently resolved frame, work outside of sections isn't counted
+    [[nodiscard]] double TotalDurationMs() const;
+    // Time the queue spent on other work or idle between the previous resolved frame's end and this one's start
+    [[nodiscard]] double IdleBeforeFrameMs() const { return _idleBeforeFrameMs; }
+
+private:
+    std::shared_ptr<VulkanContext> _vulkanContext;
+    vk::QueryPool _queryPool;
+    uint32_t _maxSectionsPerFrame {};
+    float _timestampPeriod {};
+    bool _supported = false;
+
+    // Every frame slot holds two queries per section, followed by the start and end of the whole frame
+    [[nodiscard]] uint32_t QueriesPerFrame() const { return (_maxSectionsPerFrame + 1) * 2; }
+
+    uint32_t _currentFrame {};
+    std::array<std::vector<std::string>, MAX_FRAMES_IN_FLIGHT> _frameSections {};
+    std::vector<Section> _resolvedSections {};
+    uint64_t _previousFrameEndTicks = 0;
+    double _idleBeforeFrameMs = 0.0;
+};
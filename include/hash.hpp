@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+constexpr uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+constexpr uint64_t FNV_PRIME = 0x100000001b3ull;
+
+// FNV-1a, pass the previous result as the seed to hash multiple ranges together
+inline uint64_t HashBytes(const void* data, size_t size, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+template <typename T>
+uint64_t HashValue(const T& value, uint64_t seed = FNV_OFFSET_BASIS)
+{
+    return HashBytes(&value, sizeof(T), seed);
+}
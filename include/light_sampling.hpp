@@ -0,0 +1,50 @@
+#pragma once
+#include "resources/resource_manager.hpp"
+#include <array>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+#include <span>
+#include <vector>
+
+struct Material;
+
+// Triangle of an emissive mesh, emission holds the emissive factor of its material
+struct EmissiveTriangle
+{
+    std::array<glm::vec3, 3> positions {};
+    std::array<glm::vec2, 3> texCoords {};
+    ResourceHandle<Material> material {};
+    glm::vec3 emission {};
+};
+
+// Alias method (Walker 1977, Vose 1991), samples an index proportional to its weight in constant time from a single random number
+struct AliasTableEntry
+{
+    // Chance of keeping the sampled index instead of jumping to its alias
+    float probability = 1.0f;
+    uint32_t alias {};
+};
+
+[[nodiscard]] std::vector<AliasTableEntry> BuildAliasTable(std::span<const float> weights);
+
+// GPU representation of an emissive triangle with its alias table entry, matches TriangleLight in shaders/lights.glsl
+struct TriangleLight
+{
+    glm::vec3 p0 {};
+    uint32_t materialIndex = NULL_RESOURCE_INDEX_VALUE;
+    glm::vec3 p1 {};
+    float selectionPdf {};
+    glm::vec3 p2 {};
+    float area {};
+
+    glm::vec2 uv0 {};
+    glm::vec2 uv1 {};
+    glm::vec2 uv2 {};
+    uint32_t alias {};
+    float aliasProbability = 1.0f;
+};
+static_assert(sizeof(TriangleLight) == 80, "TriangleLight has to match the std430 layout of the shader");
+
+// Lights are selected proportional to their power, approximated by the luminance of the emissive factor times the area.
+// Emissive maps are only evaluated when shading, so strongly textured emitters are sampled less efficiently, but still without bias
+[[nodiscard]] std::vector<TriangleLight> BuildTriangleLights(std::span<const EmissiveTriangle> triangles);
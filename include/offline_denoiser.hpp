@@ -0,0 +1,39 @@
+#pragma once
+#include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
+#include <span>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+// Accumulated render and its auxiliary outputs as read back by Renderer::ReadOutputs, every image stored row by row
+struct RenderOutputs
+{
+    uint32_t width {};
+    uint32_t height {};
+    // Linear radiance averaged over all samples, alpha holds the sample count
+    std::vector<glm::vec4> color {};
+    // Mean squared luminance of the samples, together with the color it gives the variance of every pixel
+    std::vector<float> luminanceMoment {};
+    // Average first hit albedo, alpha is the fraction of samples that hit geometry at all
+    std::vector<glm::vec4> albedo {};
+    // Sum of the first hit normals divided by the sample count in xyz, the same for the hit distance in w.
+    // Samples that escaped the scene add nothing, divide the distance by the albedo's alpha to get the average over the hits
+    std::vector<glm::vec4> normalDepth {};
+    // BLAS instance and material index of the pixel's first sample, both -1 where it escaped the scene
+    std::vector<glm::vec2> objectIds {};
+};
+
+struct OfflineDenoiserSettings
+{
+    // Passes of the built-in filter, every pass doubles its footprint
+    uint32_t filterIterations = 5;
+};
+
+// Filters the accumulated color guided by the auxiliary outputs and returns the linear result, alpha is kept.
+// Uses Open Image Denoise when built with ENABLE_OIDN, otherwise an edge-avoiding a-trous filter split over the thread pool
+[[nodiscard]] std::vector<glm::vec4> DenoiseRender(const RenderOutputs& outputs, ThreadPool& threadPool, const OfflineDenoiserSettings& settings = {});
+
+// Radiance .hdr paths keep the linear values, anything else is written as a gamma corrected PNG
+bool WriteRenderImage(const std::string& path, std::span<const glm::vec4> pixels, uint32_t width, uint32_t height);
@@ -0,0 +1,32 @@
+#pragma once
+#include <span>
+#include <vulkan/vulkan.hpp>
+#include "common.hpp"
+
+// Timeline semaphore owned by a single queue. Every submission through it signals the next value, so frames, uploads and
+// acceleration structure builds can all be waited on by the value they were given
+class QueueTimeline
+{
+public:
+    QueueTimeline(vk::Device device, vk::Queue queue);
+    ~QueueTimeline();
+    NON_COPYABLE(QueueTimeline);
+    NON_MOVABLE(QueueTimeline);
+
+    // Submits the command buffer after the given waits and returns the timeline value it signals once done.
+    // Binary semaphores, like the ones swap chains use, can be waited on and signaled alongside
+    uint64_t Submit(vk::CommandBuffer commandBuffer, std::span<const vk::SemaphoreSubmitInfo> waits = {}, std::span<const vk::SemaphoreSubmitInfo> signals = {});
+    // Blocks until the queue reached the value, values that were never submitted would wait forever
+    void Wait(uint64_t value) const;
+
+    [[nodiscard]] vk::Queue Queue() const { return _queue; }
+    [[nodiscard]] vk::Semaphore Semaphore() const { return _semaphore; }
+    [[nodiscard]] uint64_t CompletedValue() const;
+    [[nodiscard]] uint64_t LastSubmittedValue() const { return _lastSubmittedValue; }
+
+private:
+    vk::Device _device;
+    vk::Queue _queue;
+    vk::Semaphore _semaphore;
+    uint64_t _lastSubmittedValue = 0;
+};
@@ -0,0 +1,160 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.hpp>
+#include "common.hpp"
+
+class VulkanContext;
+class GpuTimer;
+
+// Frame described as passes that declare which images and buffers they access and how. Compiling the frame places the fewest
+// synchronization2 barriers that order those accesses, including the layout changes images need between passes and from the end of
+// the previous frame. Transient images only live within a frame, the ones whose passes never overlap share the same memory
+class RenderGraph
+{
+public:
+    // Index of an image or buffer, imports are only valid until the next Reset while transient images stay for the graph's lifetime
+    using ResourceId = uint32_t;
+    using RecordFunction = std::function<void(vk::CommandBuffer)>;
+
+    struct Access
+    {
+        ResourceId resource {};
+        vk::PipelineStageFlags2 stages {};
+        vk::AccessFlags2 access {};
+        // Ignored for buffers
+        vk::ImageLayout layout = vk::ImageLayout::eGeneral;
+    };
+
+    struct TransientImageCreation
+    {
+        std::string name {};
+        uint32_t width {};
+        uint32_t height {};
+        vk::Format format = vk::Format::eUndefined;
+        vk::ImageUsageFlags usage {};
+    };
+
+    // Storage or transfer accesses, depending on the stages
+    [[nodiscard]] static Access Read(ResourceId resource, vk::PipelineStageFlags2 stages, vk::ImageLayout layout = vk::ImageLayout::eGeneral);
+    [[nodiscard]] static Access Write(ResourceId resource, vk::PipelineStageFlags2 stages, vk::ImageLayout layout = vk::ImageLayout::eGeneral);
+    [[nodiscard]] static Access ReadWrite(ResourceId resource, vk::PipelineStageFlags2 stages, vk::ImageLayout layout = vk::ImageLayout::eGeneral);
+
+    RenderGraph(const std::shared_ptr<VulkanContext>& vulkanContext);
+    ~RenderGraph();
+    NON_COPYABLE(RenderGraph);
+    NON_MOVABLE(RenderGraph);
+
+    // Declared once, before the first Compile. The image and its view exist from that Compile on, its contents are undefined at
+    // the start of every frame
+    ResourceId CreateTransientImage(const TransientImageCreation& creation);
+    [[nodiscard]] vk::Image Image(ResourceId resource) const;
+    [[nodiscard]] vk::ImageView View(ResourceId resource) const;
+
+    // Drops the imports and passes of the previous frame description
+    void Reset();
+    // Images that keep their contents across frames start every frame in the layout and from the access the same description left
+    // them in. Images whose previous contents don't matter, like swap chain images, start from the initial layout instead, written by
+    // the initial stages, which is where the semaphore that hands them over has to be waited on. Both end the frame in the final layout
+    ResourceId ImportImage(std::string_view name, vk::Image image, vk::Format format);
+    ResourceId ImportImage(std::string_view name, vk::Image image, vk::Format format, vk::ImageLayout initialLayout, vk::PipelineStageFlags2 initialStages,
+        vk::ImageLayout finalLayout);
+    ResourceId ImportBuffer(std::string_view name, vk::Buffer buffer);
+    // The buffer's last writes are made visible to the final stages and accesses at the end of the frame, host reads for example
+    ResourceId ImportBuffer(std::string_view name, vk::Buffer buffer, vk::PipelineStageFlags2 finalStages, vk::AccessFlags2 finalAccess);
+
+    // Timed passes record into a GPU timer section named after the pass
+    void AddPass(std::string_view name, std::vector<Access> accesses, RecordFunction record, bool timed = true);
+
+    // Places the barriers of the current description. The first Compile also allocates the transient images, so its description has to
+    // contain every pass that will ever use them, later descriptions may leave passes out
+    void Compile();
+    void Execute(vk::CommandBuffer commandBuffer, GpuTimer& gpuTimer) const;
+
+    // Memory backing the transient images, and how much more they would need without aliasing
+    [[nodiscard]] vk::DeviceSize TransientMemorySize() const { return _transientMemorySize; }
+    [[nodiscard]] vk::DeviceSize TransientMemorySaved() const { return _transientMemorySaved; }
+    // Barriers of the most recent Compile, the final ones included
+    [[nodiscard]] uint32_t BarrierCount() const { return _barrierCount; }
+
+private:
+    struct Resource
+    {
+        std::string name {};
+        vk::Image image {};
+        vk::ImageView view {};
+        vk::Buffer buffer {};
+        vk::Format format = vk::Format::eUndefined;
+
+        std::optional<TransientImageCreation> transient {};
+        uint32_t memorySlot {};
+
+        std::optional<vk::ImageLayout> initialLayout {};
+        vk::PipelineStageFlags2 initialStages {};
+        std::optional<Access> finalAccess {};
+    };
+
+    // What the previous accesses left for the next one to wait on
+    struct ResourceState
+    {
+        vk::PipelineStageFlags2 writeStages {};
+        vk::AccessFlags2 writeAccess {};
+        // Reads since the last write, a write has to wait for them as well
+        vk::PipelineStageFlags2 readStages {};
+        // Where the last write is already visible, reads there need no barrier
+        vk::PipelineStageFlags2 visibleStages {};
+        vk::AccessFlags2 visibleAccess {};
+        // Unset until the first access of images that carry their layout over from the previous frame
+        std::optional<vk::ImageLayout> layout {};
+        bool used = false;
+    };
+
+    // Stages of the transient image that used a memory slot last, the next one has to wait for them before reusing the memory
+    struct MemorySlot
+    {
+        VmaAllocation allocation {};
+        vk::PipelineStageFlags2 lastStages {};
+        vk::AccessFlags2 lastWriteAccess {};
+    };
+
+    struct Barriers
+    {
+        vk::MemoryBarrier2 memoryBarrier {};
+        std::vector<vk::ImageMemoryBarrier2> imageBarriers {};
+
+        [[nodiscard]] uint32_t Count() const { return (memoryBarrier.srcStageMask ? 1 : 0) + static_cast<uint32_t>(imageBarriers.size()); }
+        void Record(vk::CommandBuffer commandBuffer) const;
+    };
+
+    struct Pass
+    {
+        std::string name {};
+        std::vector<Access> accesses {};
+        RecordFunction record {};
+        bool timed = true;
+        Barriers barriers {};
+    };
+
+    // Walks the passes once, states and slots carry what the walk ends with. Barriers are only placed when requested
+    void PlaceBarriers(std::vector<ResourceState>& states, std::vector<MemorySlot>& slots, bool placeBarriers);
+    void Synchronize(ResourceId resourceId, ResourceState& state, std::vector<MemorySlot>& slots, const Access& access, Barriers* barriers) const;
+    void AllocateTransientImages();
+    [[nodiscard]] ResourceId AddResource(Resource resource);
+
+    std::shared_ptr<VulkanContext> _vulkanContext;
+    // Transient images first, imports after them
+    std::vector<Resource> _resources {};
+    uint32_t _transientCount = 0;
+    std::vector<Pass> _passes {};
+    Barriers _finalBarriers {};
+    uint32_t _barrierCount = 0;
+
+    std::vector<MemorySlot> _memorySlots {};
+    vk::DeviceSize _transientMemorySize = 0;
+    vk::DeviceSize _transientMemorySaved = 0;
+};
@@ -1,11 +1,20 @@
 #pragma once
+#include <chrono>
+#include <functional>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
 #include <vulkan/vulkan.hpp>
 #include <glm/vec3.hpp>
 #include <glm/vec2.hpp>
+#include <glm/vec4.hpp>
 #include <glm/mat4x4.hpp>
 #include "vk_common.hpp"
 #include "common.hpp"
+#include "render_graph.hpp"
+#include "resources/resource_manager.hpp"
 
 struct VulkanInitInfo;
 struct Buffer;
@@ -16,16 +25,187 @@ class GLTFLoader;
 class BottomLevelAccelerationStructure;
 class TopLevelAccelerationStructure;
 class BindlessResources;
+class AccelerationStructureCache;
+class ThreadPool;
+class GpuTimer;
+class ShaderBindingTable;
+class ComputePipeline;
+class SvgfDenoiser;
+struct EmissiveTriangle;
+struct RenderOutputs;
+
+// Matches the SAMPLER_* constants in shaders/sampling.glsl
+enum class SamplerType : uint32_t
+{
+    // Independent hashed random numbers
+    eRandom,
+    // Owen scrambled Sobol sequence, scrambled per pixel
+    eSobol,
+    // Owen scrambled Sobol sequence shared by all pixels, shifted per pixel by blue noise
+    eSobolBlueNoise,
+};
+
+// Matches the TONEMAP_* constants in shaders/tonemap.comp
+enum class TonemapOperator : uint32_t
+{
+    // Clips everything above one
+    eClamp,
+    // Compresses by luminance, keeps hues
+    eReinhard,
+    // Filmic curve fitted to the ACES transforms
+    eAces,
+};
+
+struct RendererSettings
+{
+    std::vector<std::string> scene {
+        // "assets/helmet/FlightHelmet.gltf",
+        "assets/dragon/DragonAttenuation.gltf",
+        "assets/cube/Cube.gltf",
+    };
+
+    // Builds BLASes on the host with deferred operations when the device supports it
+    bool hostAccelerationStructureBuilds = false;
+
+    // Number of path segments traced per sample, Russian roulette terminates paths from russianRouletteDepth on
+    uint32_t maxPathDepth = 6;
+    uint32_t russianRouletteDepth = 3;
+
+    // Direction towards the sun and its irradiance, sampled with shadow rays at every path vertex
+    glm::vec3 sunDirection { 0.3f, 1.0f, 0.4f };
+    glm::vec3 sunIrradiance { 3.0f };
+
+    // Limits the pipeline to a single level of recursion and sets its stack size from the shader groups.
+    // When disabled the pipeline uses the device maximum recursion depth and the default, worst case, stack size
+    bool boundedRayRecursion = true;
+
+    // Shades every geometry with a closest hit variant specialized for its material features instead of a single uber shader
+    bool specializedHitGroups = true;
+
+    // Samples emissive triangles at every path vertex, combined with hits found by bounces through multiple importance sampling.
+    // When disabled emissive geometry only contributes when a bounce happens to hit it
+    bool emissiveLightSampling = true;
+
+    // Resolves direct lighting from emissive triangles at the primary hit with spatiotemporal reservoir resampling (ReSTIR DI).
+    // Candidates are resampled per pixel, merged with the previous frame's reservoir and then with nearby pixels'
+    bool restirDirectLighting = false;
+    uint32_t restirCandidateCount = 32;
+    uint32_t restirSpatialSampleCount = 5;
+    float restirSpatialRadius = 30.0f;
+    // Temporal history is capped at this many times the candidates of a single frame
+    uint32_t restirHistoryLimit = 20;
+
+    // Equirectangular Radiance .hdr lighting the scene, a constant grey sky is used when empty
+    std::string environmentMap {};
+    // Samples the environment proportional to its luminance at every path vertex, combined with bounces through multiple importance sampling.
+    // When disabled the environment only contributes when a bounce escapes the scene
+    bool environmentImportanceSampling = true;
+
+    // Source of the numbers every path draws its camera jitter, light samples and bounces from
+    SamplerType sampler = SamplerType::eSobolBlueNoise;
+    // Selects a different, independent, set of sequences, for example to render a reference that shares no samples with a test image
+    uint32_t samplerSeed = 0;
+
+    // Traces new samples only for pixels whose estimated error is still above the threshold, through a compacted pixel list.
+    // The error is the standard error of a pixel's mean luminance relative to that mean. Needs indirect trace rays support
+    bool adaptiveSampling = false;
+    uint32_t adaptiveMinSamples = 16;
+    uint32_t adaptiveMaxSamples = 4096;
+    float adaptiveErrorThreshold = 0.01f;
+
+    // Presents every frame's sample filtered by SVGF compute passes instead of the accumulated average, for interactive use.
+    // Every filter iteration doubles the footprint at the cost of one more full screen pass, up to SvgfDenoiser::MAX_FILTER_ITERATIONS.
+    // Takes precedence over adaptive sampling, which only suits accumulation
+    bool denoising = false;
+    uint32_t denoiserFilterIterations = 4;
+
+    // Accumulates the first hit albedo, normal, depth and instance and material ids next to the radiance, in float images.
+    // They guide DenoiseRender in offline_denoiser.hpp after ReadOutputs, so few samples per pixel can stand in for many
+    bool auxiliaryOutputs = false;
+
+    // Display transform of the linear render target, exposure is in stops
+    float exposure = 0.0f;
+    TonemapOperator tonemapOperator = TonemapOperator::eAces;
+
+    // Traces fewer pixels while the GPU frame time is above the target and upscales them to the display resolution with an edge-aware
+    // filter. Both axes are scaled alike, down to minResolutionScale, and every change restarts accumulation. Targets keep their display
+    // size, so scaling never reallocates. Adaptive sampling is disabled with it, it needs a fixed set of pixels to converge
+    bool dynamicResolution = false;
+    float targetFrameTimeMs = 16.6f;
+    float minResolutionScale = 0.5f;
+
+    // Keeps the accumulated samples while the camera moves by reprojecting last frame's accumulation along per pixel motion vectors.
+    // History whose depth shows a different surface is rejected, the rest carries over at most reprojectionHistoryLimit samples so the
+    // blur of repeated resampling fades out. Without it, and always with adaptive sampling, camera motion restarts accumulation
+    bool temporalReprojection = true;
+    uint32_t reprojectionHistoryLimit = 32;
+
+    // Records every combination of frame in flight, swap chain image and camera motion once and submits those command buffers again,
+    // until the resolution, pipeline or TLAS changes. Denoising and adaptive sampling still record every frame
+    bool reuseCommandBuffers = true;
+
+    // Frames the CPU may record ahead of the GPU, from 1 up to MAX_FRAMES_IN_FLIGHT. Fewer frames shorten the time from input to
+    // display, more keep the GPU fed when CPU frame times vary
+    uint32_t framesInFlight = MAX_FRAMES_IN_FLIGHT;
+};
 
 class Renderer
 {
 public:
-    Renderer(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext);
+    Renderer(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings = {});
     ~Renderer();
     NON_COPYABLE(Renderer);
     NON_MOVABLE(Renderer);
 
+    // Returns the world to view transform a frame is rendered with
+    using CameraLatch = std::function<glm::mat4()>;
+
+    struct FramePacing
+    {
+        // CPU time the most recent Render call spent blocked on its frame slot's previous submission and on acquiring a swap chain image
+        double cpuWaitMs {};
+        // GPU time between the end of a frame's commands and the start of the next frame's, for the most recently resolved frame
+        double gpuIdleMs {};
+        // From latching the camera to the CPU seeing the frame's timeline value reached, for the most recently completed frame.
+        // Completion is checked when Render starts, so frames that finish while the CPU is busy elsewhere count until that check
+        double latencyMs {};
+    };
+
     void Render();
+    // World to view transform of the camera, takes effect with the next frame
+    void SetCameraView(const glm::mat4& view) { _view = view; }
+    [[nodiscard]] const glm::mat4& CameraView() const { return _view; }
+    // Render calls the latch once the frame's resources are free and its swap chain image is acquired, right before the frame is recorded
+    // and submitted. Input sampled in there reaches the GPU without waiting through the frames still in flight
+    void SetCameraLatch(CameraLatch latch) { _cameraLatch = std::move(latch); }
+    // CPU time from calling the camera latch to submitting the frame, for the most recent frame
+    [[nodiscard]] double LatchToSubmitMs() const { return _latchToSubmitMs; }
+    // CPU time spent recording, or picking a recorded command buffer, for the most recent frame
+    [[nodiscard]] double CommandRecordingMs() const { return _commandRecordingMs; }
+    [[nodiscard]] const FramePacing& LastFramePacing() const { return _framePacing; }
+
+    [[nodiscard]] const GpuTimer& GpuTimings() const { return *_gpuTimer; }
+    // Passes and barriers of the most recently recorded frame, and the memory its transient images share
+    [[nodiscard]] const RenderGraph& FrameGraph() const { return *_renderGraph; }
+    [[nodiscard]] vk::DeviceSize PipelineStackSize() const { return _pipelineStackSize; }
+    // Alpha test invocations of the most recently completed frame
+    [[nodiscard]] uint32_t LastFrameAnyHitInvocations() const { return _lastFrameAnyHitInvocations; }
+    // Waits for the device and copies back the linear radiance averaged over all frames rendered so far, row by row.
+    // Alpha holds the number of samples of each pixel. Covers the AccumulationExtent, which dynamic resolution keeps below the display size
+    [[nodiscard]] std::vector<glm::vec4> ReadAccumulation() const;
+    // Waits for the device and copies back the accumulation with its luminance moments, and the auxiliary outputs when enabled.
+    // Their size is the AccumulationExtent as well
+    [[nodiscard]] RenderOutputs ReadOutputs() const;
+    // Pixels traced by the most recently completed frame
+    [[nodiscard]] uint32_t LastFrameActivePixels() const { return _lastFrameActivePixels; }
+    // Waits for the device and returns the number of camera paths traced since the renderer was created
+    [[nodiscard]] uint64_t TracedSamples() const;
+    // Fraction of the display resolution traced along each axis, 1 without dynamic resolution
+    [[nodiscard]] float ResolutionScale() const { return _resolutionScale; }
+    // Pixels the accumulated targets were traced at by the latest frame, the rest of them holds stale pixels of earlier scales
+    [[nodiscard]] vk::Extent2D AccumulationExtent() const { return _accumulationExtent; }
+    // True once adaptive sampling left no pixel to trace, further frames don't change the image
+    [[nodiscard]] bool Converged() const { return AdaptiveSamplingEnabled() && _accumulatedFrames > _settings.framesInFlight && _lastFrameActivePixels == 0; }
 
 private:
     struct Vertex
@@ -33,34 +213,165 @@ private:
         glm::vec3 position;
     };
 
-    struct CameraUniformData
+    struct FrameUniformData
     {
         glm::mat4 viewInverse {};
         glm::mat4 projInverse {};
+        glm::mat4 viewProjection {};
+        glm::mat4 previousViewProjection {};
+        uint32_t frameIndex {};
+        uint32_t cameraMoved {};
+    };
+
+    // Handles the recorded command buffers bake in, any change makes them record again
+    struct RecordedCommandsKey
+    {
+        uint32_t renderWidth {};
+        uint32_t renderHeight {};
+        vk::Pipeline pipeline {};
+        vk::AccelerationStructureKHR tlas {};
+
+        bool operator==(const RecordedCommandsKey&) const = default;
+    };
+
+    struct RecordedCommands
+    {
+        vk::CommandBuffer commandBuffer {};
+        // GPU timer sections the command buffer writes
+        std::vector<std::string> sections {};
+        bool recorded = false;
+    };
+
+    struct PathTracingPushConstants
+    {
+        glm::vec4 sunDirection {};
+        glm::vec4 sunIrradiance {};
+        uint32_t maxPathDepth {};
+        uint32_t russianRouletteDepth {};
+        uint32_t resourcesFrame {};
+        uint32_t lightCount {};
+        uint32_t restirCandidateCount {};
+        uint32_t restirSpatialSampleCount {};
+        float restirSpatialRadius {};
+        uint32_t restirHistoryLimit {};
+        uint32_t environmentMapIndex {};
+        float environmentPdfScale {};
+        uint32_t samplerType {};
+        uint32_t samplerSeed {};
+        uint32_t adaptiveSampling {};
+        uint32_t denoising {};
+        uint32_t auxiliaryOutputs {};
+        uint32_t renderWidth {};
+        uint32_t renderHeight {};
+        uint32_t reprojectionHistoryLimit {};
+    };
+
+    struct TonemapPushConstants
+    {
+        float exposure {};
+        uint32_t tonemapOperator {};
+        uint32_t encodeSrgb {};
+        uint32_t outputIndex {};
     };
 
-    void RecordCommands(const vk::CommandBuffer& commandBuffer, uint32_t swapChainImageIndex);
+    struct UpscalePushConstants
+    {
+        uint32_t sourceWidth {};
+        uint32_t sourceHeight {};
+    };
+
+    struct AdaptiveSamplingPushConstants
+    {
+        uint32_t frameIndex {};
+        uint32_t minSamples {};
+        uint32_t maxSamples {};
+        float errorThreshold {};
+    };
+
+    // Returns the command buffer to submit this frame, recorded now or earlier
+    vk::CommandBuffer FrameCommandBuffer(uint32_t swapChainImageIndex, bool cameraMoved);
+    void RecordCommandBuffer(vk::CommandBuffer commandBuffer, uint32_t swapChainImageIndex, bool cameraMoved);
+    void RecordCommands(const vk::CommandBuffer& commandBuffer, uint32_t swapChainImageIndex, bool cameraMoved);
+    // Resets the render graph to the passes of a frame, their record functions read the renderer's state when executed
+    void DescribeFrame(uint32_t swapChainImageIndex, bool cameraMoved);
+    void BindRayTracingState(vk::CommandBuffer commandBuffer) const;
+    [[nodiscard]] bool CommandReuseEnabled() const { return _settings.reuseCommandBuffers && !_denoiser && !AdaptiveSamplingEnabled(); }
+    void RecordHistoryCopies(const vk::CommandBuffer& commandBuffer);
+    [[nodiscard]] FrameUniformData FrameData() const;
     void InitializeCommandBuffers();
     void InitializeSynchronizationObjects();
+    void InitializeStatistics();
     void InitializeRenderTarget();
+    void InitializeLights(std::span<const EmissiveTriangle> emissiveTriangles);
+    void InitializeRestirResources();
+    void InitializeEnvironment();
+    void InitializeBlueNoise();
+    void InitializeAdaptiveSampling();
+    [[nodiscard]] bool AdaptiveSamplingEnabled() const { return _settings.adaptiveSampling; }
+    void InitializeDenoiser();
+    void InitializeUpscaler();
+    void InitializeTonemap();
+    // Allocates the transient images and binds them, every pass that uses one has to be declared by then
+    void InitializeRenderGraph();
+    void UpdateResolutionScale();
+    // Reports the latency of frames whose timeline value has been reached since the last check
+    void UpdateFrameLatency();
+    // Copies the AccumulationExtent from the top left of the target
+    void ReadTarget(const Image& target, std::span<std::byte> pixels) const;
+    [[nodiscard]] bool RestirEnabled() const { return _settings.restirDirectLighting && _settings.emissiveLightSampling && _lightCount > 0; }
 
     void InitializeDescriptorSets();
     void InitializePipeline();
-    void InitializeShaderBindingTable();
+    void InitializeShaderBindingTable(const vk::RayTracingPipelineCreateInfoKHR& pipelineCreateInfo);
+    void InitializePipelineStackSize();
 
+    RendererSettings _settings {};
     std::shared_ptr<VulkanContext> _vulkanContext;
+    std::shared_ptr<ThreadPool> _threadPool;
     std::unique_ptr<SwapChain> _swapChain;
     std::array<vk::CommandBuffer, MAX_FRAMES_IN_FLIGHT> _commandBuffers;
+    // Indexed by frame in flight, then swap chain image, then whether the camera moved
+    std::vector<RecordedCommands> _recordedCommands {};
+    RecordedCommandsKey _recordedCommandsKey {};
+    double _commandRecordingMs = 0.0;
     std::array<vk::Semaphore, MAX_FRAMES_IN_FLIGHT> _imageAvailableSemaphores;
     std::array<vk::Semaphore, MAX_FRAMES_IN_FLIGHT> _renderFinishedSemaphores;
-    std::array<vk::Fence, MAX_FRAMES_IN_FLIGHT> _inFlightFences;
+    // Graphics timeline value the last submission of every frame slot signals, zero for slots never submitted
+    std::array<uint64_t, MAX_FRAMES_IN_FLIGHT> _frameTimelineValues {};
+    // Uploads and builds on the other queues that the next frame consumes, cleared once it was submitted
+    std::vector<vk::SemaphoreSubmitInfo> _pendingFrameWaits {};
+    // When the frame in each slot latched the camera, cleared once its completion is seen
+    std::array<std::optional<std::chrono::steady_clock::time_point>, MAX_FRAMES_IN_FLIGHT> _frameLatchTimes {};
+    FramePacing _framePacing {};
+    // Linear radiance of the displayed frame, tonemapped into the swap chain
     std::unique_ptr<Image> _renderTarget;
+    std::unique_ptr<Image> _accumulationTarget;
+    std::unique_ptr<Image> _directLightingTarget;
+    std::unique_ptr<Image> _luminanceMomentTarget;
+    // Denoiser inputs, only allocated in full when denoising. Transient images, they are written and read within a frame
+    RenderGraph::ResourceId _illuminationTarget {};
+    RenderGraph::ResourceId _albedoTarget {};
+    RenderGraph::ResourceId _normalDepthTarget {};
+    RenderGraph::ResourceId _motionTarget {};
+    // Offline denoiser guides, only allocated in full with auxiliary outputs
+    std::unique_ptr<Image> _albedoOutputTarget;
+    std::unique_ptr<Image> _normalDepthOutputTarget;
+    std::unique_ptr<Image> _objectIdOutputTarget;
+    // First hit depth and the copies reprojection reads last frame from, only allocated in full with temporal reprojection
+    std::unique_ptr<Image> _depthTarget;
+    std::unique_ptr<Image> _depthHistory;
+    std::unique_ptr<Image> _accumulationHistory;
+    std::unique_ptr<Image> _luminanceMomentHistory;
+    std::unique_ptr<GpuTimer> _gpuTimer;
+    std::unique_ptr<RenderGraph> _renderGraph;
 
     uint32_t _currentResourcesFrame = 0;
+    uint32_t _accumulatedFrames = 0;
 
     std::unique_ptr<GLTFLoader> _gltfLoader;
     std::shared_ptr<BindlessResources> _bindlessResources;
 
+    std::shared_ptr<AccelerationStructureCache> _accelerationStructureCache;
     std::vector<BottomLevelAccelerationStructure> _blases {};
     std::unique_ptr<TopLevelAccelerationStructure> _tlas;
 
@@ -68,17 +379,59 @@ private:
     vk::DescriptorSetLayout _descriptorSetLayout;
     vk::DescriptorSet _descriptorSet;
 
+    // One camera uniform slice per frame in flight, bound with a dynamic offset
     std::unique_ptr<Buffer> _uniformBuffer;
+    vk::DeviceSize _uniformBufferStride = 0;
+    CameraLatch _cameraLatch {};
+    double _latchToSubmitMs = 0.0;
+    glm::mat4 _view {};
+    glm::mat4 _projection {};
+    glm::mat4 _previousViewProjection {};
+    // One any-hit invocation counter per frame in flight, read back once the frame's timeline value is reached
+    std::unique_ptr<Buffer> _statisticsBuffer;
+    uint32_t _lastFrameAnyHitInvocations = 0;
+
+    std::unique_ptr<Buffer> _lightBuffer;
+    uint32_t _lightCount = 0;
+
+    std::unique_ptr<Buffer> _restirSurfaceBuffer;
+    std::unique_ptr<Buffer> _restirReservoirBuffer;
+
+    ResourceHandle<Image> _environmentMap = ResourceHandle<Image>::Null();
+    std::unique_ptr<Buffer> _environmentAliasTableBuffer;
+    float _environmentPdfScale = 0.0f;
+
+    std::unique_ptr<Buffer> _blueNoiseBuffer;
+
+    // Trace rays indirect command followed by the packed coordinates of every pixel that still needs samples
+    std::unique_ptr<Buffer> _activePixelBuffer;
+    // Active pixel count of every frame in flight, read back once the frame's timeline value is reached
+    std::unique_ptr<Buffer> _activePixelReadbackBuffer;
+    std::unique_ptr<ComputePipeline> _adaptiveMaskPipeline;
+    uint32_t _lastFrameActivePixels = 0;
+    uint64_t _tracedSamples = 0;
+
+    std::unique_ptr<SvgfDenoiser> _denoiser;
+
+    // Only created with dynamic resolution, the tonemap pass reads the upscaled target instead of the render target then
+    std::unique_ptr<ComputePipeline> _upscalePipeline;
+    std::optional<RenderGraph::ResourceId> _upscaledTarget {};
+    float _resolutionScale = 1.0f;
+    uint32_t _renderWidth = 0;
+    uint32_t _renderHeight = 0;
+    vk::Extent2D _accumulationExtent {};
+    double _smoothedFrameTimeMs = 0.0;
+    uint32_t _framesSinceResolutionChange = 0;
+
+    std::unique_ptr<ComputePipeline> _tonemapPipeline;
+    // Tonemapped frame blitted to the swap chain, only created when the swap chain images can't be storage images
+    std::optional<RenderGraph::ResourceId> _displayTarget {};
 
-    std::unique_ptr<Buffer> _raygenSBT;
-    std::unique_ptr<Buffer> _missSBT;
-    std::unique_ptr<Buffer> _hitSBT;
-    vk::StridedDeviceAddressRegionKHR _raygenAddressRegion {};
-    vk::StridedDeviceAddressRegionKHR _missAddressRegion {};
-    vk::StridedDeviceAddressRegionKHR _hitAddressRegion {};
+    std::unique_ptr<ShaderBindingTable> _shaderBindingTable;
 
     vk::PipelineLayout _pipelineLayout;
     vk::Pipeline _pipeline;
+    vk::DeviceSize _pipelineStackSize {};
 
     uint32_t _windowWidth = 0;
     uint32_t _windowHeight = 0;
@@ -52,6 +52,8 @@ public:
     [[nodiscard]] BLASInstanceResources& BLASInstances() { return _blasInstanceResources; }
     [[nodiscard]] const vk::DescriptorSetLayout& DescriptorSetLayout() const { return _bindlessLayout; }
     [[nodiscard]] const vk::DescriptorSet& DescriptorSet() const { return _bindlessSet; }
+    // Transfer timeline value of the latest buffer upload, the first frame reading the set waits on it
+    [[nodiscard]] uint64_t UploadTimelineValue() const { return _uploadTimelineValue; }
 
 private:
     enum class BindlessBinding : uint8_t
@@ -78,6 +80,7 @@ private:
     vk::DescriptorPool _bindlessPool;
     vk::DescriptorSetLayout _bindlessLayout;
     vk::DescriptorSet _bindlessSet;
+    uint64_t _uploadTimelineValue {};
 
     ResourceHandle<Image> _fallbackImage;
     std::unique_ptr<Sampler> _fallbackSampler;
@@ -15,13 +15,18 @@ struct BufferCreation
     vk::DeviceSize size {};
     vk::BufferUsageFlags usage {};
     bool isMappable = true;
+    // Mapped memory the host reads back, rather than only writes to
+    bool isReadback = false;
     VmaMemoryUsage memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY;
+    vk::DeviceSize alignment = 0;
     std::string name {};
 
     BufferCreation& SetSize(vk::DeviceSize size);
     BufferCreation& SetUsageFlags(vk::BufferUsageFlags usage);
     BufferCreation& SetIsMappable(bool isMappable);
+    BufferCreation& SetIsReadback(bool isReadback);
     BufferCreation& SetMemoryUsage(VmaMemoryUsage memoryUsage);
+    BufferCreation& SetAlignment(vk::DeviceSize alignment);
     BufferCreation& SetName(std::string_view name);
 };
 
@@ -109,6 +114,27 @@ private:
     std::shared_ptr<VulkanContext> _vulkanContext;
 };
 
+// Texture maps sampled by a material, every combination is shaded by its own specialized closest hit shader
+enum class MaterialFeatures : uint32_t
+{
+    eNone = 0,
+    eAlbedoMap = 1 << 0,
+    eEmissiveMap = 1 << 1,
+    // glTF alpha mode MASK, geometry using it is not opaque and runs the alpha test any-hit shader
+    eAlphaMask = 1 << 2,
+};
+constexpr uint32_t MATERIAL_FEATURE_COMBINATIONS = 1 << 3;
+
+constexpr MaterialFeatures operator|(MaterialFeatures lhs, MaterialFeatures rhs)
+{
+    return static_cast<MaterialFeatures>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+}
+
+constexpr bool HasMaterialFeature(MaterialFeatures features, MaterialFeatures feature)
+{
+    return (static_cast<uint32_t>(features) & static_cast<uint32_t>(feature)) != 0;
+}
+
 struct MaterialCreation
 {
     ResourceHandle<Image> albedoMap = ResourceHandle<Image>::Null();
@@ -132,6 +158,9 @@ struct MaterialCreation
     glm::vec3 emissiveFactor { 0.0f };
     uint32_t emissiveUVChannel = 0;
 
+    bool alphaMask = false;
+    float alphaCutoff = 0.5f;
+
     MaterialCreation& SetAlbedoMap(ResourceHandle<Image> albedoMap);
     MaterialCreation& SetAlbedoFactor(const glm::vec4& albedoFactor);
     MaterialCreation& SetAlbedoUVChannel(uint32_t albedoUVChannel);
@@ -152,6 +181,11 @@ struct MaterialCreation
     MaterialCreation& SetEmissiveMap(ResourceHandle<Image> emissiveMap);
     MaterialCreation& SetEmissiveFactor(const glm::vec3& emissiveFactor);
     MaterialCreation& SetEmissiveUVChannel(uint32_t emissiveUVChannel);
+
+    MaterialCreation& SetAlphaMask(bool alphaMask);
+    MaterialCreation& SetAlphaCutoff(float alphaCutoff);
+
+    [[nodiscard]] MaterialFeatures Features() const;
 };
 
 struct Material
@@ -179,7 +213,8 @@ struct Material
     uint32_t occlusionMapIndex = NULL_RESOURCE_INDEX_VALUE;
 
     uint32_t emissiveMapIndex = NULL_RESOURCE_INDEX_VALUE;
-    glm::vec3 _PADDING_{};
+    float alphaCutoff = 0.5f;
+    glm::vec2 _PADDING_{};
 };
 
 struct GeometryNodeCreation
@@ -187,6 +222,8 @@ struct GeometryNodeCreation
     vk::DeviceAddress vertexBufferDeviceAddress = 0;
     vk::DeviceAddress indexBufferDeviceAddress = 0;
     ResourceHandle<Material> material = ResourceHandle<Material>::Null();
+    MaterialFeatures materialFeatures = MaterialFeatures::eNone;
+    uint32_t lightOffset = 0;
 };
 
 struct GeometryNode
@@ -196,12 +233,16 @@ struct GeometryNode
     uint64_t vertexBufferDeviceAddress = 0;
     uint64_t indexBufferDeviceAddress = 0;
     uint32_t materialIndex = NULL_RESOURCE_INDEX_VALUE;
-    glm::vec3 _PADDING_{};
+    MaterialFeatures materialFeatures = MaterialFeatures::eNone;
+    // First triangle light of an emissive geometry, relative to the first light of its BLAS instance
+    uint32_t lightOffset = 0;
+    float _PADDING_ {};
 };
 
 struct BLASInstance
 {
     uint32_t firstGeometryIndex = 0;
+    uint32_t firstLightIndex = 0;
 };
 
 using BLASInstanceCreation = BLASInstance;
@@ -0,0 +1,65 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.hpp>
+#include "common.hpp"
+
+class VulkanContext;
+struct Buffer;
+
+enum class ShaderGroupRegion : uint8_t
+{
+    eRaygen,
+    eMiss,
+    eHit,
+    eCallable,
+};
+
+struct ShaderBindingTableCreation
+{
+    struct Record
+    {
+        uint32_t groupIndex {};
+        std::vector<std::byte> data {};
+    };
+
+    std::vector<ShaderGroupRegion> groupRegions {};
+    std::vector<Record> hitRecords {};
+    std::string name {};
+
+    // Classifies the shader groups of the pipeline, every group gets one record in its region unless hit records are added
+    ShaderBindingTableCreation& SetShaderGroups(const vk::RayTracingPipelineCreateInfoKHR& pipelineCreateInfo);
+
+    // Hit records are laid out in call order, so the index of a record is the instance record offset plus the geometry index.
+    // The data is readable through shaderRecordEXT in the shaders of that group
+    ShaderBindingTableCreation& AddHitRecord(uint32_t groupIndex, std::span<const std::byte> data = {});
+    template <typename T>
+    ShaderBindingTableCreation& AddHitRecord(uint32_t groupIndex, const T& data) { return AddHitRecord(groupIndex, std::as_bytes(std::span { &data, 1 })); }
+    ShaderBindingTableCreation& SetName(std::string_view name);
+};
+
+// All regions of the table share one buffer, each starting at the shader group base alignment.
+// Ray gen records are spaced by that alignment as well, so every one of them can be traced on its own
+class ShaderBindingTable
+{
+public:
+    ShaderBindingTable(const ShaderBindingTableCreation& creation, vk::Pipeline pipeline, const std::shared_ptr<VulkanContext>& vulkanContext);
+    ~ShaderBindingTable();
+    NON_COPYABLE(ShaderBindingTable);
+    NON_MOVABLE(ShaderBindingTable);
+
+    [[nodiscard]] const vk::StridedDeviceAddressRegionKHR& Region(ShaderGroupRegion region) const { return _regions.at(static_cast<size_t>(region)); }
+    // Ray gen groups are indexed in pipeline group order
+    [[nodiscard]] vk::StridedDeviceAddressRegionKHR RaygenRegion(uint32_t raygenIndex = 0) const;
+    [[nodiscard]] const vk::StridedDeviceAddressRegionKHR& MissRegion() const { return Region(ShaderGroupRegion::eMiss); }
+    [[nodiscard]] const vk::StridedDeviceAddressRegionKHR& HitRegion() const { return Region(ShaderGroupRegion::eHit); }
+    [[nodiscard]] const vk::StridedDeviceAddressRegionKHR& CallableRegion() const { return Region(ShaderGroupRegion::eCallable); }
+
+private:
+    std::shared_ptr<VulkanContext> _vulkanContext;
+    std::unique_ptr<Buffer> _buffer;
+    std::array<vk::StridedDeviceAddressRegionKHR, 4> _regions {};
+};
@@ -1,25 +1,32 @@
 #pragma once
 
 #include <functional>
+#include <optional>
+#include <span>
 #include <vulkan/vulkan.hpp>
 #include "common.hpp"
 
 class VulkanContext;
+enum class QueueType;
 
+// Records commands for one submission and blocks until they are done. Work of other queues it consumes has to be passed as waits,
+// submissions on other queues that consume its results wait on the returned timeline value in turn
 class SingleTimeCommands
 {
 public:
+    SingleTimeCommands(std::shared_ptr<VulkanContext> context, QueueType queueType);
     SingleTimeCommands(std::shared_ptr<VulkanContext> context);
     ~SingleTimeCommands();
     NON_MOVABLE(SingleTimeCommands);
     NON_COPYABLE(SingleTimeCommands);
 
     void Record(const std::function<void(vk::CommandBuffer)>& commands) const;
-    void Submit();
+    // Submitting again returns the value of the first submission
+    uint64_t Submit(std::span<const vk::SemaphoreSubmitInfo> waits = {});
 
 private:
     std::shared_ptr<VulkanContext> _vulkanContext;
+    QueueType _queueType;
     vk::CommandBuffer _commandBuffer;
-    vk::Fence _fence;
-    bool _submitted = false;
+    std::optional<uint64_t> _signalValue {};
 };
\ No newline at end of file
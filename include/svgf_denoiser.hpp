@@ -0,0 +1,66 @@
+#pragma once
+#include <array>
+#include <memory>
+#include <vulkan/vulkan.hpp>
+#include "common.hpp"
+#include "render_graph.hpp"
+
+class VulkanContext;
+class ComputePipeline;
+struct Image;
+
+// Per frame images written by the ray generation shader, transient images of the render graph read in the general layout
+struct SvgfInputs
+{
+    // Lighting of the current sample divided by the first hit albedo, rgba16f
+    RenderGraph::ResourceId illumination {};
+    // First hit albedo, rgba16f
+    RenderGraph::ResourceId albedo {};
+    // First hit normal and distance along the camera ray, negative for the background, rgba32f
+    RenderGraph::ResourceId normalDepth {};
+    // Offset in pixels to where the first hit was in the previous frame, rg32f
+    RenderGraph::ResourceId motion {};
+};
+
+// Spatiotemporal variance-guided filtering (Schied et al., 2017) as compute passes: temporal accumulation, variance estimation
+// for short histories and a number of edge-aware a-trous iterations. The last iteration writes the remodulated lighting to the output
+class SvgfDenoiser
+{
+public:
+    static constexpr uint32_t MAX_FILTER_ITERATIONS = 5;
+
+    // Declares the ping-pong images of the spatial passes as transient images of the render graph
+    SvgfDenoiser(const SvgfInputs& inputs, uint32_t width, uint32_t height, uint32_t filterIterations, RenderGraph& renderGraph, const std::shared_ptr<VulkanContext>& vulkanContext);
+    ~SvgfDenoiser();
+    NON_COPYABLE(SvgfDenoiser);
+    NON_MOVABLE(SvgfDenoiser);
+
+    // Binds the transient images once the render graph's first Compile created them
+    void WriteDescriptors(const RenderGraph& renderGraph, const Image& output);
+    // Adds one pass per dispatch, after the ray tracing pass that writes the inputs, and advances to the next frame.
+    // Only the extent's top left corner of the images is filtered, it must not exceed the size they were created with
+    void AddPasses(RenderGraph& renderGraph, RenderGraph::ResourceId output, vk::Extent2D extent);
+
+private:
+    std::shared_ptr<VulkanContext> _vulkanContext;
+    uint32_t _width {};
+    uint32_t _height {};
+    uint32_t _filterIterations {};
+    SvgfInputs _inputs {};
+    // Counted separately from accumulation, which restarts on camera moves the history is reprojected across
+    uint32_t _frameIndex {};
+    // History is only reprojected once a frame of the same extent wrote it, pixels of another extent don't line up
+    bool _historyValid = false;
+    vk::Extent2D _historyExtent {};
+
+    // Indexed by frame parity, one holds the previous frame's history while the other is written
+    std::array<std::unique_ptr<Image>, 2> _normalDepthHistory {};
+    std::array<std::unique_ptr<Image>, 2> _colorHistory {};
+    std::array<std::unique_ptr<Image>, 2> _momentsHistory {};
+    // Ping-pong targets of the spatial passes, lighting with its variance in alpha
+    std::array<RenderGraph::ResourceId, 2> _filterImages {};
+
+    std::unique_ptr<ComputePipeline> _temporalPipeline;
+    std::unique_ptr<ComputePipeline> _variancePipeline;
+    std::unique_ptr<ComputePipeline> _atrousPipeline;
+};
@@ -22,7 +22,11 @@ public:
 
     [[nodiscard]] vk::SwapchainKHR GetSwapChain() const { return _swapChain; }
     [[nodiscard]] vk::Image GetImage(uint32_t index) const { return _images[index]; }
+    [[nodiscard]] vk::ImageView GetImageView(uint32_t index) const { return _imageViews[index]; }
+    [[nodiscard]] uint32_t GetImageCount() const { return static_cast<uint32_t>(_images.size()); }
     [[nodiscard]] vk::Format GetFormat() const { return _format; }
+    // Whether compute shaders can write the images directly, otherwise they can only be blitted to
+    [[nodiscard]] bool StorageSupported() const { return _storageSupported; }
 
     static SupportDetails QuerySupport(vk::PhysicalDevice device, vk::SurfaceKHR surface);
 
@@ -40,4 +44,5 @@ private:
     std::vector<vk::ImageView> _imageViews;
     vk::Format _format;
     vk::Extent2D _extent;
+    bool _storageSupported = false;
 };
\ No newline at end of file
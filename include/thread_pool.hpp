@@ -0,0 +1,33 @@
+#pragma once
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+#include "common.hpp"
+
+class ThreadPool
+{
+public:
+    explicit ThreadPool(uint32_t threadCount = std::thread::hardware_concurrency());
+    ~ThreadPool();
+    NON_COPYABLE(ThreadPool);
+    NON_MOVABLE(ThreadPool);
+
+    std::future<void> Submit(std::function<void()> task);
+    // Runs queued tasks on the calling thread until the future is ready, allows tasks to wait on tasks they submitted
+    void Wait(const std::future<void>& future);
+    [[nodiscard]] uint32_t ThreadCount() const { return static_cast<uint32_t>(_workers.size()); }
+
+private:
+    void WorkerLoop();
+    bool TryRunPendingTask();
+
+    std::vector<std::thread> _workers {};
+    std::queue<std::packaged_task<void()>> _tasks {};
+    std::mutex _mutex {};
+    std::condition_variable _condition {};
+    bool _stopping = false;
+};
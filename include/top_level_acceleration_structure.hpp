@@ -15,9 +15,12 @@ public:
     NON_MOVABLE(TopLevelAccelerationStructure);
 
     [[nodiscard]] vk::AccelerationStructureKHR Structure() const { return _vkStructure; }
+    // Compute timeline value of the build, the first frame tracing the structure waits on it
+    [[nodiscard]] uint64_t BuildTimelineValue() const { return _buildTimelineValue; }
 
 private:
     void InitializeStructure(const std::vector<BottomLevelAccelerationStructure>& blases, const std::shared_ptr<BindlessResources>& resources);
 
     std::shared_ptr<VulkanContext> _vulkanContext;
+    uint64_t _buildTimelineValue {};
 };
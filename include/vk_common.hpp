@@ -20,6 +20,15 @@ void VkInitializeImageMemoryBarrier(vk::ImageMemoryBarrier2& barrier, vk::Image
 void VkTransitionImageLayout(vk::CommandBuffer commandBuffer, vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t numLayers = 1, uint32_t mipLevel = 0, uint32_t mipCount = 1, vk::ImageAspectFlagBits imageAspect = vk::ImageAspectFlagBits::eColor);
 void VkCopyImageToImage(vk::CommandBuffer commandBuffer, vk::Image srcImage, vk::Image dstImage, vk::Extent2D srcSize, vk::Extent2D dstSize);
 void VkCopyBufferToImage(vk::CommandBuffer commandBuffer, vk::Buffer buffer, vk::Image image, uint32_t width, uint32_t height);
+void VkCopyImageToBuffer(vk::CommandBuffer commandBuffer, vk::Image image, vk::Buffer buffer, uint32_t width, uint32_t height, vk::ImageLayout layout = vk::ImageLayout::eTransferSrcOptimal);
+void VkAccelerationStructureBuildBarrier(vk::CommandBuffer commandBuffer);
+// Makes storage writes of earlier ray tracing dispatches visible to later ones
+void VkRayTracingShaderBarrier(vk::CommandBuffer commandBuffer);
+// Orders a memory dependency between any two stages, for passes that mix compute, transfer and ray tracing work
+void VkMemoryBarrier(vk::CommandBuffer commandBuffer, vk::PipelineStageFlags2 srcStage, vk::AccessFlags2 srcAccess, vk::PipelineStageFlags2 dstStage, vk::AccessFlags2 dstAccess);
+// Records the release, or the acquire, half of moving an image between queue families and changing its layout on the way.
+// Within a single family the release is a plain layout transition and the acquire records nothing
+void VkTransferImageOwnership(vk::CommandBuffer commandBuffer, vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t srcFamily, uint32_t dstFamily, bool release);
 void VkCopyBufferToBuffer(vk::CommandBuffer commandBuffer, vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size, uint32_t offset = 0);
 
 template <typename T>
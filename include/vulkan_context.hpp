@@ -1,9 +1,11 @@
 #pragma once
 #include <functional>
+#include <memory>
 #include <optional>
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.hpp>
 #include "common.hpp"
+#include "queue_timeline.hpp"
 
 struct VulkanInitInfo
 {
@@ -14,10 +16,21 @@ struct VulkanInitInfo
     std::function<vk::SurfaceKHR(vk::Instance)> retrieveSurface;
 };
 
+enum class QueueType
+{
+    eGraphics,
+    eCompute,
+    eTransfer,
+};
+
 struct QueueFamilyIndices
 {
     std::optional<uint32_t> graphicsFamily;
     std::optional<uint32_t> presentFamily;
+    // Families without graphics support, whose queues run alongside the graphics queue. Unset when the device has none,
+    // their work then goes to the graphics queue
+    std::optional<uint32_t> computeFamily;
+    std::optional<uint32_t> transferFamily;
 
    [[nodiscard]] bool IsComplete() const;
 
@@ -37,12 +50,28 @@ public:
     [[nodiscard]] vk::Device Device() const { return _device; }
     [[nodiscard]] vk::Queue GraphicsQueue() const { return _graphicsQueue; }
     [[nodiscard]] vk::Queue PresentQueue() const { return _presentQueue; }
+    // All submissions go through the timeline of their queue, the present queue only presents and has none.
+    // Queue types without a dedicated family share the graphics queue and its timeline
+    [[nodiscard]] QueueTimeline& Timeline(QueueType type) const;
+    // Wait on a value of the timeline of a queue, for the submission that consumes the work which signaled it
+    [[nodiscard]] vk::SemaphoreSubmitInfo TimelineWait(QueueType type, uint64_t value) const;
+    [[nodiscard]] uint32_t QueueFamily(QueueType type) const;
+    // Families buffers are shared between, so buffers written on one queue need no ownership transfer to be used on another
+    [[nodiscard]] const std::vector<uint32_t>& BufferQueueFamilies() const { return _bufferQueueFamilies; }
     [[nodiscard]] vk::SurfaceKHR Surface() const { return _surface; }
-    [[nodiscard]] vk::CommandPool CommandPool() const { return _commandPool; }
+    [[nodiscard]] vk::CommandPool CommandPool(QueueType type = QueueType::eGraphics) const;
     [[nodiscard]] VmaAllocator MemoryAllocator() const { return _vmaAllocator; }
     [[nodiscard]] const QueueFamilyIndices& QueueFamilies() const { return _queueFamilyIndices; }
+    // False when no device supports the required ray tracing extensions, no logical device is created in that case
+    [[nodiscard]] bool HasRayTracingDevice() const { return static_cast<bool>(_physicalDevice); }
+    [[nodiscard]] bool AccelerationStructureHostCommandsSupported() const { return _accelerationStructureHostCommandsSupported; }
+    // Whether trace rays dimensions can be read from a device buffer
+    [[nodiscard]] bool RayTracingIndirectSupported() const { return _rayTracingIndirectSupported; }
+    // Whether shaders can store to storage images declared without a format qualifier, like swap chain images of any format
+    [[nodiscard]] bool StorageImageWriteWithoutFormatSupported() const { return _storageImageWriteWithoutFormatSupported; }
 
     [[nodiscard]] vk::PhysicalDeviceRayTracingPipelinePropertiesKHR RayTracingPipelineProperties() const;
+    [[nodiscard]] vk::PhysicalDeviceLimits Limits() const;
     [[nodiscard]] uint64_t GetBufferDeviceAddress(vk::Buffer buffer) const;
 
 private:
@@ -52,9 +81,21 @@ private:
     vk::Device _device;
     vk::Queue _graphicsQueue;
     vk::Queue _presentQueue;
+    vk::Queue _computeQueue;
+    vk::Queue _transferQueue;
+    std::unique_ptr<QueueTimeline> _graphicsTimeline;
+    // Null without a dedicated family
+    std::unique_ptr<QueueTimeline> _computeTimeline;
+    std::unique_ptr<QueueTimeline> _transferTimeline;
     vk::CommandPool _commandPool;
+    vk::CommandPool _computeCommandPool;
+    vk::CommandPool _transferCommandPool;
     QueueFamilyIndices _queueFamilyIndices;
-    VmaAllocator _vmaAllocator;
+    std::vector<uint32_t> _bufferQueueFamilies {};
+    VmaAllocator _vmaAllocator {};
+    bool _accelerationStructureHostCommandsSupported = false;
+    bool _rayTracingIndirectSupported = false;
+    bool _storageImageWriteWithoutFormatSupported = false;
 
     vk::SurfaceKHR _surface;
 
@@ -83,7 +124,7 @@ private:
     void InizializeValidationLayers();
     void InitializePhysicalDevice();
     void InitializeDevice();
-    void InitializeCommandPool();
+    void InitializeCommandPools();
     void InitializeVMA();
     [[nodiscard]] bool AreValidationLayersSupported() const;
     [[nodiscard]] std::vector<const char*> GetRequiredInstanceExtensions(const VulkanInitInfo& initInfo) const;
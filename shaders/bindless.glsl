@@ -24,6 +24,7 @@ struct Material
     uint occlusionMapIndex;
 
     uint emissiveMapIndex;
+    float alphaCutoff;
 };
 layout (std140, set = 0, binding = 1) uniform Materials
 {
@@ -35,6 +36,8 @@ struct GeometryNode
     uint64_t vertexBufferDeviceAddress;
     uint64_t indexBufferDeviceAddress;
     uint materialIndex;
+    uint materialFeatures;
+    uint lightOffset;
 };
 layout (std140, set = 0, binding = 2) buffer GeometryNodes
 {
@@ -44,6 +47,7 @@ layout (std140, set = 0, binding = 2) buffer GeometryNodes
 struct BLASInstance
 {
     uint firstGeometryIndex;
+    uint firstLightIndex;
 };
 layout (set = 0, binding = 3) buffer BLASInstances
 {
@@ -0,0 +1,17 @@
+// Color helpers shared by the ray tracing and compute shaders
+
+float Luminance(vec3 color)
+{
+    return dot(color, vec3(0.2126, 0.7152, 0.0722));
+}
+
+// Piecewise sRGB transfer function, for targets that store display values in a linear format
+vec3 LinearToSrgb(vec3 color)
+{
+    return mix(color * 12.92, 1.055 * pow(color, vec3(1.0 / 2.4)) - 0.055, greaterThan(color, vec3(0.0031308)));
+}
+
+vec3 SrgbToLinear(vec3 color)
+{
+    return mix(color / 12.92, pow((color + 0.055) / 1.055, vec3(2.4)), greaterThan(color, vec3(0.04045)));
+}
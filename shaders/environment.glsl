@@ -0,0 +1,82 @@
+// Equirectangular environment lighting, importance sampled per texel with the alias table built in source/environment_map.cpp.
+// Radiance is piecewise constant over texels, so sampled and looked up values always agree. Needs bindless.glsl, push_constants.glsl and lights.glsl
+
+struct EnvironmentAliasEntry
+{
+    float probability;
+    uint alias;
+};
+layout(set = 1, binding = 9, std430) readonly buffer EnvironmentAliasTable
+{
+    EnvironmentAliasEntry environmentAliasTable[];
+};
+
+const uint NO_ENVIRONMENT_MAP = 0xFFFFu;
+// Sky radiance when no environment map is loaded
+const vec3 DEFAULT_ENVIRONMENT_RADIANCE = vec3(0.25);
+
+vec2 DirectionToEquirectangular(vec3 direction)
+{
+    return vec2(atan(direction.z, direction.x) / (2.0 * PI) + 0.5, acos(clamp(direction.y, -1.0, 1.0)) / PI);
+}
+
+vec3 EquirectangularToDirection(vec2 uv)
+{
+    const float phi = (uv.x - 0.5) * 2.0 * PI;
+    const float theta = uv.y * PI;
+    return vec3(sin(theta) * cos(phi), cos(theta), sin(theta) * sin(phi));
+}
+
+ivec2 EnvironmentSize()
+{
+    return textureSize(textures[nonuniformEXT(pc.environmentMapIndex)], 0);
+}
+
+ivec2 EnvironmentTexel(vec2 uv)
+{
+    const ivec2 size = EnvironmentSize();
+    return clamp(ivec2(uv * vec2(size)), ivec2(0), size - 1);
+}
+
+vec3 EnvironmentTexelRadiance(ivec2 texel)
+{
+    return texelFetch(textures[nonuniformEXT(pc.environmentMapIndex)], texel, 0).rgb;
+}
+
+vec3 EnvironmentRadiance(vec3 direction)
+{
+    if (pc.environmentMapIndex == NO_ENVIRONMENT_MAP)
+    {
+        return DEFAULT_ENVIRONMENT_RADIANCE;
+    }
+    return EnvironmentTexelRadiance(EnvironmentTexel(DirectionToEquirectangular(direction)));
+}
+
+// Solid angle density of a direction in a texel, the texel was picked proportional to its luminance times the sine of its row center
+float EnvironmentTexelPdf(ivec2 texel, vec3 radiance, float sinTheta)
+{
+    const float rowSinTheta = sin(PI * (float(texel.y) + 0.5) / float(EnvironmentSize().y));
+    return sinTheta > 0.0 ? max(Luminance(radiance), 0.0) * rowSinTheta * pc.environmentPdfScale / sinTheta : 0.0;
+}
+
+float EnvironmentPdf(vec3 direction)
+{
+    const ivec2 texel = EnvironmentTexel(DirectionToEquirectangular(direction));
+    return EnvironmentTexelPdf(texel, EnvironmentTexelRadiance(texel), sqrt(max(1.0 - direction.y * direction.y, 0.0)));
+}
+
+// Picks a texel with the alias table and a uniformly distributed point in it. The texel index comes from a full 32 bit
+// random number, floats can't address every texel of large maps. Returns the solid angle density, 0 when nothing was sampled
+float SampleEnvironment(uint random, vec3 u, out vec3 direction, out vec3 radiance)
+{
+    const ivec2 size = EnvironmentSize();
+    const uint index = random % uint(size.x * size.y);
+    const EnvironmentAliasEntry entry = environmentAliasTable[index];
+    const uint texelIndex = u.x < entry.probability ? index : entry.alias;
+
+    const ivec2 texel = ivec2(texelIndex % uint(size.x), texelIndex / uint(size.x));
+    const vec2 uv = (vec2(texel) + u.yz) / vec2(size);
+    direction = EquirectangularToDirection(uv);
+    radiance = EnvironmentTexelRadiance(texel);
+    return EnvironmentTexelPdf(texel, radiance, sin(uv.y * PI));
+}
@@ -0,0 +1,39 @@
+struct Vertex
+{
+    vec3 position;
+    vec3 normal;
+    vec2 texCoord;
+};
+
+struct Triangle
+{
+	Vertex vertices[3];
+	vec3 normal;
+	vec2 texCoord;
+};
+
+layout(buffer_reference, scalar, buffer_reference_align = 4) readonly buffer Vertices { Vertex vertices[]; };
+layout(buffer_reference, scalar) readonly buffer Indices { uint indices[]; };
+
+// Hit record data of the geometry, written per geometry into the shader binding table
+layout(shaderRecordEXT, std430) buffer ShaderRecord
+{
+    uint64_t vertexBufferDeviceAddress;
+    uint64_t indexBufferDeviceAddress;
+    uint materialIndex;
+    uint materialFeatures;
+    uint lightOffset;
+} geometry;
+
+vec2 InterpolateTexCoord(vec2 barycentrics)
+{
+    Vertices vertices = Vertices(geometry.vertexBufferDeviceAddress);
+    Indices indices = Indices(geometry.indexBufferDeviceAddress);
+
+    const uint indexOffset = gl_PrimitiveID * 3;
+    const vec2 texCoord0 = vertices.vertices[indices.indices[indexOffset]].texCoord;
+    const vec2 texCoord1 = vertices.vertices[indices.indices[indexOffset + 1]].texCoord;
+    const vec2 texCoord2 = vertices.vertices[indices.indices[indexOffset + 2]].texCoord;
+
+    return texCoord0 * (1.0 - barycentrics.x - barycentrics.y) + texCoord1 * barycentrics.x + texCoord2 * barycentrics.y;
+}
@@ -0,0 +1,73 @@
+// Emissive triangles, each with its entry of the power weighted alias table. Needs bindless.glsl, push_constants.glsl and color.glsl
+struct TriangleLight
+{
+    vec3 p0;
+    uint materialIndex;
+    vec3 p1;
+    float selectionPdf;
+    vec3 p2;
+    float area;
+
+    vec2 uv0;
+    vec2 uv1;
+    vec2 uv2;
+    uint alias;
+    float aliasProbability;
+};
+layout(set = 1, binding = 5, std430) readonly buffer TriangleLights
+{
+    TriangleLight lights[];
+};
+
+const float PI = 3.14159265;
+
+uint SampleLightIndex(float u)
+{
+    const float scaled = u * float(pc.lightCount);
+    const uint index = min(uint(scaled), pc.lightCount - 1);
+    return scaled - float(index) < lights[index].aliasProbability ? index : lights[index].alias;
+}
+
+// Uniformly distributed point on a triangle, see "Shape Distributions" (Osada et al., 2002)
+vec3 SampleTriangleBarycentrics(vec2 u)
+{
+    const float root = sqrt(u.x);
+    return vec3(1.0 - root, root * (1.0 - u.y), root * u.y);
+}
+
+vec3 LightPosition(TriangleLight light, vec3 barycentrics)
+{
+    return light.p0 * barycentrics.x + light.p1 * barycentrics.y + light.p2 * barycentrics.z;
+}
+
+vec3 LightNormal(TriangleLight light)
+{
+    return normalize(cross(light.p1 - light.p0, light.p2 - light.p0));
+}
+
+// Density of sampling the light at a point it sees the shading point from, converted from area to solid angle.
+// Emissive triangles are two sided, like the hit shaders treat them
+float LightPdf(TriangleLight light, float distanceSquared, float lightCosine)
+{
+    return light.selectionPdf * distanceSquared / (light.area * max(lightCosine, 1e-6));
+}
+
+vec3 LightEmission(TriangleLight light, vec3 barycentrics)
+{
+    const Material material = materials[nonuniformEXT(light.materialIndex)];
+    const vec2 texCoord = light.uv0 * barycentrics.x + light.uv1 * barycentrics.y + light.uv2 * barycentrics.z;
+
+    vec3 emission = material.emissiveFactor;
+    if (material.useEmissiveMap)
+    {
+        emission *= pow(textureLod(textures[nonuniformEXT(material.emissiveMapIndex)], texCoord, 0.0).rgb, vec3(2.2));
+    }
+    return emission;
+}
+
+float PowerHeuristic(float pdf, float otherPdf)
+{
+    const float pdfSquared = pdf * pdf;
+    const float sum = pdfSquared + otherPdf * otherPdf;
+    return sum > 0.0 ? pdfSquared / sum : 0.0;
+}
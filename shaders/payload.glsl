@@ -0,0 +1,36 @@
+// Compact result of a closest hit or miss, the path tracing loop in the ray generation shader does all the shading.
+// A negative hitT marks a miss, emission then holds the environment radiance. Emissive hits report their triangle light.
+// Hits also report their BLAS instance in the upper and their material in the lower 16 bits of objectId
+struct HitPayload
+{
+    vec3 albedo;
+    float hitT;
+    vec3 emission;
+    uint packedNormal;
+    uint lightIndex;
+    uint objectId;
+};
+
+const uint NO_LIGHT = 0xFFFFFFFFu;
+
+vec2 OctahedronWrap(vec2 value)
+{
+    return (1.0 - abs(value.yx)) * vec2(value.x >= 0.0 ? 1.0 : -1.0, value.y >= 0.0 ? 1.0 : -1.0);
+}
+
+uint PackNormal(vec3 normal)
+{
+    normal /= abs(normal.x) + abs(normal.y) + abs(normal.z);
+    const vec2 encoded = normal.z >= 0.0 ? normal.xy : OctahedronWrap(normal.xy);
+    return packSnorm2x16(encoded);
+}
+
+vec3 UnpackNormal(uint packedNormal)
+{
+    const vec2 encoded = unpackSnorm2x16(packedNormal);
+    vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+    const float t = max(-normal.z, 0.0);
+    normal.x += normal.x >= 0.0 ? -t : t;
+    normal.y += normal.y >= 0.0 ? -t : t;
+    return normalize(normal);
+}
@@ -0,0 +1,33 @@
+layout(push_constant) uniform PushConstants
+{
+    vec4 sunDirection;
+    vec4 sunIrradiance;
+    uint maxPathDepth;
+    uint russianRouletteDepth;
+    // Frame in flight being recorded, selects the per frame statistics counters
+    uint resourcesFrame;
+    // Zero when emissive triangles are not sampled
+    uint lightCount;
+    // ReSTIR direct lighting, disabled when no candidates are generated
+    uint restirCandidateCount;
+    uint restirSpatialSampleCount;
+    float restirSpatialRadius;
+    uint restirHistoryLimit;
+    // Bindless index of the environment map, its pdf scale is zero when the environment is not importance sampled
+    uint environmentMapIndex;
+    float environmentPdfScale;
+    // SAMPLER_* in sampling.glsl
+    uint samplerType;
+    uint samplerSeed;
+    // Non-zero when the path tracing launch covers only the pixels in the adaptive sampling list
+    uint adaptiveSampling;
+    // Non-zero when the ray generation shader writes the denoiser inputs instead of the render target
+    uint denoising;
+    // Non-zero when the ray generation shader accumulates the first hit features the offline denoiser is guided by
+    uint auxiliaryOutputs;
+    // Traced region of the images, smaller than their size when dynamic resolution scales it down
+    uint renderWidth;
+    uint renderHeight;
+    // Samples carried over by reprojection, zero without temporal reprojection
+    uint reprojectionHistoryLimit;
+} pc;
@@ -0,0 +1,18 @@
+// PCG hash, see "Hash Functions for GPU Rendering" (Jarzynski and Olano, 2020)
+uint PcgHash(uint value)
+{
+    const uint state = value * 747796405u + 2891336453u;
+    const uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+uint InitRandom(uvec2 pixel, uint width, uint frameIndex)
+{
+    return PcgHash(PcgHash(pixel.y * width + pixel.x) ^ PcgHash(frameIndex));
+}
+
+float RandomFloat(inout uint state)
+{
+    state = PcgHash(state);
+    return float(state >> 8u) * (1.0 / 16777216.0);
+}
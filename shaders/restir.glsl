@@ -0,0 +1,158 @@
+// Reservoir based spatiotemporal importance resampling of emissive triangles, see
+// "Spatiotemporal reservoir resampling for real-time ray tracing with dynamic direct lighting" (Bitterli et al., 2020).
+// Needs color.glsl, lights.glsl and scene.glsl
+
+// Primary hit of a pixel, kept for two frames so the next one can validate its temporal neighbour
+struct Surface
+{
+    vec3 position;
+    uint packedNormal;
+    uint packedAlbedo;
+    // Negative when the primary ray missed
+    float hitT;
+    vec2 _padding;
+};
+
+// Sample is a point on a triangle light, stored as light index and the last two barycentrics
+struct Reservoir
+{
+    vec2 barycentrics;
+    uint lightIndex;
+    float weightSum;
+    // Target function of the selected sample at the pixel owning the reservoir
+    float targetPdf;
+    float sampleCount;
+    // Contribution weight of the selected sample, zero when it is occluded or there is none
+    float weight;
+    float _padding;
+};
+
+// Surfaces hold the current and the previous frame, alternating every frame.
+// Reservoirs hold the result of temporal reuse followed by the final, spatially reused, ones the next frame starts from
+layout(set = 1, binding = 6, std430) buffer Surfaces
+{
+    Surface surfaces[];
+};
+layout(set = 1, binding = 7, std430) buffer Reservoirs
+{
+    Reservoir reservoirs[];
+};
+
+uint PixelIndex(ivec2 pixel)
+{
+    return pixel.y * gl_LaunchSizeEXT.x + pixel.x;
+}
+
+uint PixelCount()
+{
+    return gl_LaunchSizeEXT.x * gl_LaunchSizeEXT.y;
+}
+
+uint CurrentSurfaceIndex(ivec2 pixel)
+{
+    return (frame.frameIndex & 1) * PixelCount() + PixelIndex(pixel);
+}
+
+uint PreviousSurfaceIndex(ivec2 pixel)
+{
+    return ((frame.frameIndex + 1) & 1) * PixelCount() + PixelIndex(pixel);
+}
+
+uint TemporalReservoirIndex(ivec2 pixel)
+{
+    return PixelIndex(pixel);
+}
+
+uint FinalReservoirIndex(ivec2 pixel)
+{
+    return PixelCount() + PixelIndex(pixel);
+}
+
+Reservoir EmptyReservoir()
+{
+    Reservoir reservoir;
+    reservoir.barycentrics = vec2(0.0);
+    reservoir.lightIndex = NO_LIGHT;
+    reservoir.weightSum = 0.0;
+    reservoir.targetPdf = 0.0;
+    reservoir.sampleCount = 0.0;
+    reservoir.weight = 0.0;
+    reservoir._padding = 0.0;
+    return reservoir;
+}
+
+vec3 ReservoirBarycentrics(Reservoir reservoir)
+{
+    return vec3(1.0 - reservoir.barycentrics.x - reservoir.barycentrics.y, reservoir.barycentrics);
+}
+
+bool UpdateReservoir(inout Reservoir reservoir, uint lightIndex, vec2 barycentrics, float weight, float targetPdf, float u)
+{
+    reservoir.weightSum += weight;
+    if (weight > 0.0 && u * reservoir.weightSum < weight)
+    {
+        reservoir.lightIndex = lightIndex;
+        reservoir.barycentrics = barycentrics;
+        reservoir.targetPdf = targetPdf;
+        return true;
+    }
+    return false;
+}
+
+// Albedo is stored sRGB encoded, 8 linear bits would band dark surfaces
+uint PackAlbedo(vec3 albedo)
+{
+    return packUnorm4x8(vec4(LinearToSrgb(clamp(albedo, 0.0, 1.0)), 1.0));
+}
+
+vec3 UnpackAlbedo(uint packedAlbedo)
+{
+    return SrgbToLinear(unpackUnorm4x8(packedAlbedo).rgb);
+}
+
+void FinalizeReservoir(inout Reservoir reservoir)
+{
+    reservoir.weight = reservoir.targetPdf > 0.0 ? reservoir.weightSum / (reservoir.sampleCount * reservoir.targetPdf) : 0.0;
+}
+
+// Unshadowed reflected radiance of a Lambertian surface, toLight is normalized and distanceSquared returned for the visibility ray
+vec3 UnshadowedContribution(Surface surface, vec3 normal, uint lightIndex, vec3 barycentrics, out vec3 toLight, out float distanceSquared)
+{
+    const TriangleLight light = lights[lightIndex];
+    toLight = LightPosition(light, barycentrics) - surface.position;
+    distanceSquared = max(dot(toLight, toLight), 1e-8);
+    toLight *= inversesqrt(distanceSquared);
+
+    const float surfaceCosine = dot(normal, toLight);
+    const float lightCosine = abs(dot(LightNormal(light), toLight));
+    if (surfaceCosine <= 0.0)
+    {
+        return vec3(0.0);
+    }
+
+    const vec3 albedo = UnpackAlbedo(surface.packedAlbedo);
+    return albedo / PI * LightEmission(light, barycentrics) * surfaceCosine * lightCosine / distanceSquared;
+}
+
+float TargetPdf(Surface surface, vec3 normal, uint lightIndex, vec3 barycentrics)
+{
+    if (lightIndex == NO_LIGHT)
+    {
+        return 0.0;
+    }
+
+    vec3 toLight;
+    float distanceSquared;
+    return Luminance(UnshadowedContribution(surface, normal, lightIndex, barycentrics, toLight, distanceSquared));
+}
+
+bool IsSampleVisible(Surface surface, vec3 toLight, float distanceSquared)
+{
+    return TraceShadowRay(surface.position, toLight, sqrt(distanceSquared) * 0.999);
+}
+
+// Neighbours only share samples with surfaces that face the same way at a similar distance from the camera
+bool AreSurfacesSimilar(Surface surface, vec3 normal, Surface neighbour)
+{
+    return neighbour.hitT > 0.0 && dot(normal, UnpackNormal(neighbour.packedNormal)) > 0.9 && abs(neighbour.hitT - surface.hitT) < 0.1 * surface.hitT;
+}
@@ -0,0 +1,104 @@
+// Sample sequences for the path tracer. Owen scrambled Sobol points follow "Practical Hash-based Owen Scrambling" (Burley, 2020):
+// every call draws the next padded 2D Sobol pattern, so dimensions of different bounces never correlate.
+// With blue noise all pixels share one sequence, shifted by a blue noise tile, which spreads the error as blue noise over the screen.
+// Needs push_constants.glsl and random.glsl
+
+const uint SAMPLER_RANDOM = 0;
+const uint SAMPLER_SOBOL = 1;
+const uint SAMPLER_SOBOL_BLUE_NOISE = 2;
+
+const uint BLUE_NOISE_SIZE = 64;
+
+// Two independent blue noise tiles, one per dimension of a 2D sample
+layout(set = 1, binding = 10, std430) readonly buffer BlueNoise
+{
+    vec2 blueNoise[];
+};
+
+struct SampleState
+{
+    uvec2 pixel;
+    uint seed;
+    uint sampleIndex;
+    uint dimension;
+    // Only used by the random sampler
+    uint rngState;
+};
+
+SampleState InitSampler(uvec2 pixel, uint width, uint frameIndex)
+{
+    SampleState state;
+    state.pixel = pixel;
+    state.seed = PcgHash(pc.samplerSeed ^ (pc.samplerType == SAMPLER_SOBOL_BLUE_NOISE ? 0x68E31DA4u : PcgHash(pixel.y * width + pixel.x)));
+    state.sampleIndex = frameIndex;
+    state.dimension = 0;
+    state.rngState = PcgHash(InitRandom(pixel, width, frameIndex) ^ pc.samplerSeed);
+    return state;
+}
+
+uint LaineKarrasPermutation(uint value, uint seed)
+{
+    value += seed;
+    value ^= value * 0x6C50B47Cu;
+    value ^= value * 0xB82F1E52u;
+    value ^= value * 0xC7AFE638u;
+    value ^= value * 0x8D22F6E6u;
+    return value;
+}
+
+uint NestedUniformScramble(uint value, uint seed)
+{
+    return bitfieldReverse(LaineKarrasPermutation(bitfieldReverse(value), seed));
+}
+
+// First two Sobol dimensions as 0.32 fixed point, the second one from the direction numbers of the polynomial x + 1
+uvec2 Sobol2D(uint index)
+{
+    const uint first = bitfieldReverse(index);
+    uint second = 0;
+    for (uint direction = 1u << 31; index != 0; index >>= 1, direction ^= direction >> 1)
+    {
+        second ^= (index & 1u) != 0 ? direction : 0;
+    }
+    return uvec2(first, second);
+}
+
+uvec2 ShuffledScrambledSobol2D(uint index, uint seed)
+{
+    const uvec2 point = Sobol2D(NestedUniformScramble(index, seed));
+    return uvec2(NestedUniformScramble(point.x, PcgHash(seed ^ 0xA511E9B3u)), NestedUniformScramble(point.y, PcgHash(seed ^ 0x63D83595u)));
+}
+
+// Full 32 bit precision for indexing large tables, like the texels of an environment map
+uvec2 SampleUint2D(inout SampleState state)
+{
+    if (pc.samplerType == SAMPLER_RANDOM)
+    {
+        state.rngState = PcgHash(state.rngState);
+        const uint first = state.rngState;
+        state.rngState = PcgHash(state.rngState);
+        return uvec2(first, state.rngState);
+    }
+
+    const uint dimensionSeed = PcgHash(state.seed ^ PcgHash(state.dimension));
+    uvec2 point = ShuffledScrambledSobol2D(state.sampleIndex, dimensionSeed);
+    if (pc.samplerType == SAMPLER_SOBOL_BLUE_NOISE)
+    {
+        // Every dimension reads the tile at its own toroidal offset, a Cranley-Patterson rotation keeps the points stratified
+        const uvec2 offset = uvec2(dimensionSeed, dimensionSeed >> 16) % BLUE_NOISE_SIZE;
+        const uvec2 texel = (state.pixel + offset) % BLUE_NOISE_SIZE;
+        point += uvec2(blueNoise[texel.y * BLUE_NOISE_SIZE + texel.x] * 4294967296.0);
+    }
+    ++state.dimension;
+    return point;
+}
+
+vec2 Sample2D(inout SampleState state)
+{
+    return vec2(SampleUint2D(state) >> 8) * (1.0 / 16777216.0);
+}
+
+float Sample1D(inout SampleState state)
+{
+    return Sample2D(state).x;
+}
@@ -0,0 +1,43 @@
+// Scene bindings and ray helpers shared by the ray generation shaders
+layout(set = 1, binding = 1) uniform accelerationStructureEXT topLevelAS;
+// Everything that changes from frame to frame, written to the frame in flight's slice right before submission.
+// Push constants stay the same for every frame, so recorded command buffers can be submitted again
+layout(set = 1, binding = 2) uniform FrameProperties
+{
+    mat4 viewInverse;
+    mat4 projInverse;
+    mat4 viewProjection;
+    // Camera of the previous frame, used to find where a surface was visible before
+    mat4 previousViewProjection;
+    // Frames accumulated so far, zero when there's no history to build on
+    uint frameIndex;
+    // Non-zero when the camera moved since the previous frame, the accumulation then has to be reprojected
+    uint cameraMoved;
+} frame;
+
+layout(location = 1) rayPayloadEXT uint visible;
+
+const uint MISS_INDEX = 0;
+const uint SHADOW_MISS_INDEX = 1;
+
+// Every pass starts its sample sequence the same way, so the first 2D sample always jitters the primary ray identically
+void GenerateCameraRay(uvec2 pixel, uvec2 size, vec2 jitter, out vec3 origin, out vec3 direction)
+{
+    const vec2 pixelCenter = vec2(pixel) + jitter;
+    const vec2 inUV = pixelCenter / vec2(size);
+    const vec2 d = inUV * 2.0 - 1.0;
+
+    const vec4 target = frame.projInverse * vec4(d.x, d.y, 1, 1);
+    origin = (frame.viewInverse * vec4(0, 0, 0, 1)).xyz;
+    direction = (frame.viewInverse * vec4(normalize(target.xyz), 0)).xyz;
+}
+
+// Visibility only query, it stops at the first hit found and never runs the material closest hit shader
+bool TraceShadowRay(vec3 origin, vec3 direction, float tmax)
+{
+    const uint flags = gl_RayFlagsTerminateOnFirstHitEXT | gl_RayFlagsSkipClosestHitShaderEXT;
+
+    visible = 0;
+    traceRayEXT(topLevelAS, flags, 0xff, 0, 1, SHADOW_MISS_INDEX, origin, 0.001, direction, tmax, 1);
+    return visible == 1;
+}
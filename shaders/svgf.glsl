@@ -0,0 +1,36 @@
+// Shared parts of the spatiotemporal variance-guided filter, "Spatiotemporal Variance-Guided Filtering" (Schied et al., 2017).
+// Lighting is filtered divided by the first hit albedo, so texture detail is never blurred. Needs color.glsl
+
+// Dark albedo would amplify noise when dividing, demodulation and remodulation both use the clamped value so they cancel exactly
+const float MIN_DEMODULATION_ALBEDO = 0.01;
+
+// Normal and depth images store a negative depth where the camera ray escaped the scene
+const float BACKGROUND_DEPTH = -1.0;
+
+const float NORMAL_PHI = 128.0;
+// Depth tolerance per pixel of distance, relative to the depth of the filtered pixel
+const float DEPTH_PHI = 0.05;
+const float LUMINANCE_PHI = 4.0;
+
+vec3 DemodulationAlbedo(vec3 albedo)
+{
+    return max(albedo, vec3(MIN_DEMODULATION_ALBEDO));
+}
+
+bool IsBackground(vec4 normalDepth)
+{
+    return normalDepth.w < 0.0;
+}
+
+// Edge-stopping weight of a sample pixelDistance pixels away, the background is never filtered
+float GeometryWeight(vec4 normalDepth, vec4 sampleNormalDepth, float pixelDistance)
+{
+    if (IsBackground(normalDepth) || IsBackground(sampleNormalDepth))
+    {
+        return 0.0;
+    }
+
+    const float normalWeight = pow(max(dot(normalDepth.xyz, sampleNormalDepth.xyz), 0.0), NORMAL_PHI);
+    const float depthWeight = exp(-abs(normalDepth.w - sampleNormalDepth.w) / (DEPTH_PHI * normalDepth.w * pixelDistance + 1e-4));
+    return normalWeight * depthWeight;
+}
@@ -0,0 +1,146 @@
+#include "acceleration_structure_cache.hpp"
+#include "hash.hpp"
+#include "vk_common.hpp"
+#include "vulkan_context.hpp"
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <spdlog/fmt/fmt.h>
+#include <spdlog/spdlog.h>
+#include <thread>
+
+// Layout of the header the driver writes in front of every serialized acceleration structure
+constexpr size_t SERIALIZED_DESERIALIZED_SIZE_OFFSET = 2 * VK_UUID_SIZE + sizeof(uint64_t);
+constexpr size_t SERIALIZED_HEADER_SIZE = 2 * VK_UUID_SIZE + 3 * sizeof(uint64_t);
+
+AccelerationStructureCache::AccelerationStructureCache(const std::shared_ptr<VulkanContext>& vulkanContext, const std::filesystem::path& directory)
+    : _vulkanContext(vulkanContext)
+    , _directory(directory)
+{
+    const vk::PhysicalDeviceProperties properties = _vulkanContext->PhysicalDevice().getProperties();
+    _deviceHash = HashValue(properties.vendorID);
+    _deviceHash = HashValue(properties.deviceID, _deviceHash);
+    _deviceHash = HashValue(properties.driverVersion, _deviceHash);
+    _deviceHash = HashBytes(properties.pipelineCacheUUID.data(), properties.pipelineCacheUUID.size(), _deviceHash);
+
+    std::error_code error {};
+    std::filesystem::create_directories(_directory, error);
+    if (error)
+    {
+        spdlog::error("[CACHE] Failed creating acceleration structure cache directory {}: {}", _directory.string(), error.message());
+    }
+}
+
+std::optional<std::vector<std::byte>> AccelerationStructureCache::Load(uint64_t contentHash) const
+{
+    const std::filesystem::path path = FilePath(contentHash);
+    std::ifstream file { path, std::ios::binary };
+    if (!file.is_open())
+    {
+        return std::nullopt;
+    }
+
+    FileHeader header {};
+    file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader));
+    if (!file || header.magic != FILE_MAGIC || header.version != FILE_VERSION || header.contentHash != contentHash || header.deviceHash != _deviceHash)
+    {
+        spdlog::warn("[CACHE] Ignoring stale acceleration structure cache entry {}", path.string());
+        return std::nullopt;
+    }
+
+    // The size is checked against the file before allocating, a corrupt header must not decide how much memory is taken
+    std::error_code error {};
+    const uintmax_t fileSize = std::filesystem::file_size(path, error);
+    if (error || fileSize < sizeof(FileHeader) || header.dataSize != fileSize - sizeof(FileHeader) || header.dataSize < SERIALIZED_HEADER_SIZE)
+    {
+        spdlog::warn("[CACHE] Acceleration structure cache entry {} doesn't match its recorded size", path.string());
+        return std::nullopt;
+    }
+
+    std::vector<std::byte> data(header.dataSize);
+    file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file)
+    {
+        spdlog::warn("[CACHE] Acceleration structure cache entry {} is truncated", path.string());
+        return std::nullopt;
+    }
+
+    if (!IsCompatible(data))
+    {
+        spdlog::info("[CACHE] Acceleration structure cache entry {} is incompatible with the current driver, falling back to a rebuild", path.string());
+        return std::nullopt;
+    }
+
+    return data;
+}
+
+void AccelerationStructureCache::Store(uint64_t contentHash, const std::vector<std::byte>& serializedData) const
+{
+    // Written next to the entry and renamed into place once complete, so a crash or a full disk never leaves a partial entry behind.
+    // Naming the temporary file after the thread keeps concurrent builds of the same geometry from sharing it
+    const std::filesystem::path path = FilePath(contentHash);
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += fmt::format(".{:x}.tmp", std::hash<std::thread::id> {}(std::this_thread::get_id()));
+
+    std::ofstream file { temporaryPath, std::ios::binary | std::ios::trunc };
+    if (!file.is_open())
+    {
+        spdlog::error("[CACHE] Failed to open {} for writing", temporaryPath.string());
+        return;
+    }
+
+    FileHeader header {};
+    header.magic = FILE_MAGIC;
+    header.version = FILE_VERSION;
+    header.contentHash = contentHash;
+    header.deviceHash = _deviceHash;
+    header.dataSize = serializedData.size();
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    if (file)
+    {
+        file.write(reinterpret_cast<const char*>(serializedData.data()), static_cast<std::streamsize>(serializedData.size()));
+    }
+    if (file)
+    {
+        file.close();
+    }
+
+    std::error_code error {};
+    if (!file)
+    {
+        spdlog::error("[CACHE] Failed writing acceleration structure cache entry {}", temporaryPath.string());
+        file.close();
+        std::filesystem::remove(temporaryPath, error);
+        return;
+    }
+
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error)
+    {
+        spdlog::error("[CACHE] Failed moving acceleration structure cache entry into place at {}: {}", path.string(), error.message());
+        std::filesystem::remove(temporaryPath, error);
+    }
+}
+
+uint64_t AccelerationStructureCache::DeserializedSize(const std::vector<std::byte>& serializedData)
+{
+    uint64_t size {};
+    std::memcpy(&size, serializedData.data() + SERIALIZED_DESERIALIZED_SIZE_OFFSET, sizeof(uint64_t));
+    return size;
+}
+
+std::filesystem::path AccelerationStructureCache::FilePath(uint64_t contentHash) const
+{
+    return _directory / fmt::format("{:016x}_{:016x}.blas", contentHash, _deviceHash);
+}
+
+bool AccelerationStructureCache::IsCompatible(const std::vector<std::byte>& serializedData) const
+{
+    // The version data is the driver and compatibility UUID at the start of the serialized header
+    vk::AccelerationStructureVersionInfoKHR versionInfo {};
+    versionInfo.pVersionData = reinterpret_cast<const uint8_t*>(serializedData.data());
+
+    const vk::AccelerationStructureCompatibilityKHR compatibility = _vulkanContext->Device().getAccelerationStructureCompatibilityKHR(versionInfo, _vulkanContext->Dldi());
+    return compatibility == vk::AccelerationStructureCompatibilityKHR::eCompatible;
+}
@@ -4,12 +4,23 @@
 // This definition fixes the issues and does not change the final build output
 #define SDL_DISABLE_ANALYZE_MACROS
 
+#include "camera.hpp"
+#include "camera_controller.hpp"
+#include "cpu_renderer.hpp"
 #include "renderer.hpp"
+#include "thread_pool.hpp"
 #include "vulkan_context.hpp"
 #include <SDL3/SDL.h>
 #include <SDL3/SDL_vulkan.h>
+#include <algorithm>
 #include <spdlog/spdlog.h>
 
+namespace
+{
+// Input latency is logged once per interval
+constexpr uint64_t LATENCY_REPORT_INTERVAL_NS = 2'000'000'000;
+}
+
 Application::Application()
 {
     if (!SDL_Init(SDL_INIT_VIDEO | SDL_INIT_GAMEPAD))
@@ -55,11 +66,23 @@ Application::Application()
     };
 
     _vulkanContext = std::make_shared<VulkanContext>(vulkanInfo);
+    if (!_vulkanContext->HasRayTracingDevice())
+    {
+        InitializeCpuFallback(displayMode->w, displayMode->h);
+        return;
+    }
+
     _renderer = std::make_unique<Renderer>(vulkanInfo, _vulkanContext);
+    _camera = std::make_unique<Camera>(_renderer->CameraView());
+    _cameraController = std::make_unique<CameraController>(*_camera);
+    _renderer->SetCameraLatch([this] { return LatchCamera(); });
 }
 
 Application::~Application()
 {
+    // The renderer latches the camera through this application, and the controller owns SDL gamepad handles
+    _renderer.reset();
+    _cameraController.reset();
     SDL_DestroyWindow(_window);
     SDL_Quit();
 }
@@ -75,6 +98,28 @@ int Application::Run()
 }
 
 void Application::MainLoopOnce()
+{
+    // The renderer processes events itself through the camera latch, as late in the frame as it can
+    if (_renderer)
+    {
+        _renderer->Render();
+        ReportInputLatency();
+        return;
+    }
+
+    ProcessEvents();
+    if (_cpuRenderer)
+    {
+        _cameraController->Update();
+        if (_cameraController->LastUpdateInputTimestampNs() != 0)
+        {
+            _cpuRenderer->SetCameraView(_camera->View());
+        }
+        PresentCpuFrame();
+    }
+}
+
+void Application::ProcessEvents()
 {
     SDL_Event event;
     while (SDL_PollEvent(&event))
@@ -84,7 +129,106 @@ void Application::MainLoopOnce()
             _exitRequested = true;
             break;
         }
+
+        if (_cameraController)
+        {
+            _cameraController->ProcessEvent(event);
+        }
+    }
+}
+
+glm::mat4 Application::LatchCamera()
+{
+    ProcessEvents();
+    _cameraController->Update();
+
+    const uint64_t inputTimestampNs = _cameraController->LastUpdateInputTimestampNs();
+    _latchedInputAgeMs = inputTimestampNs == 0 ? -1.0 : static_cast<double>(SDL_GetTicksNS() - inputTimestampNs) * 1e-6;
+    return _camera->View();
+}
+
+void Application::ReportInputLatency()
+{
+    if (_latchedInputAgeMs >= 0.0)
+    {
+        // Input waits in the event queue until the latch, then for the frame to be recorded and submitted
+        const double latencyMs = _latchedInputAgeMs + _renderer->LatchToSubmitMs();
+        _latencyTotalMs += latencyMs;
+        _latencyWorstMs = std::max(_latencyWorstMs, latencyMs);
+        ++_latencySamples;
+    }
+
+    const uint64_t nowNs = SDL_GetTicksNS();
+    if (_latencyIntervalStartNs == 0)
+    {
+        _latencyIntervalStartNs = nowNs;
+    }
+    if (nowNs - _latencyIntervalStartNs < LATENCY_REPORT_INTERVAL_NS)
+    {
+        return;
+    }
+
+    if (_latencySamples > 0)
+    {
+        spdlog::info("[APPLICATION] Input to submit latency {:.2f} ms average, {:.2f} ms worst over {} frames with camera input",
+            _latencyTotalMs / _latencySamples, _latencyWorstMs, _latencySamples);
+    }
+    _latencyTotalMs = 0.0;
+    _latencyWorstMs = 0.0;
+    _latencySamples = 0;
+    _latencyIntervalStartNs = nowNs;
+}
+
+void Application::InitializeCpuFallback(uint32_t width, uint32_t height)
+{
+    spdlog::warn("[APPLICATION] No ray tracing capable GPU available, falling back to the CPU renderer");
+
+    // The surface belongs to the Vulkan window, so both are recreated for software presentation
+    _vulkanContext.reset();
+    SDL_DestroyWindow(_window);
+    _window = SDL_CreateWindow("RayTracer", static_cast<int32_t>(width), static_cast<int32_t>(height), SDL_WINDOW_FULLSCREEN);
+
+    if (_window == nullptr)
+    {
+        spdlog::error("[SDL] Failed creating SDL window: {}", SDL_GetError());
+        return;
+    }
+
+    CpuRendererSettings settings {};
+    settings.width = width;
+    settings.height = height;
+
+    _threadPool = std::make_shared<ThreadPool>();
+    _cpuRenderer = std::make_unique<CpuRenderer>(RendererSettings {}, _threadPool, settings);
+
+    // Driven by the same camera and controls as the GPU renderer
+    _camera = std::make_unique<Camera>(Camera::DefaultView());
+    _cameraController = std::make_unique<CameraController>(*_camera);
+    _cpuRenderer->SetCameraView(_camera->View());
+}
+
+void Application::PresentCpuFrame()
+{
+    // Every frame adds a sample to the accumulation, which restarts when the camera moves
+    _cpuRenderer->Render();
+    if (_cpuRenderer->AccumulatedSamples() == 1)
+    {
+        const CpuRenderer::FrameStatistics& statistics = _cpuRenderer->LastFrameStatistics();
+        spdlog::info("[CPU] Traced {} rays in {:.2f} ms, {:.2f} Mrays/s", statistics.rayCount, statistics.durationMs, statistics.MegaRaysPerSecond());
+    }
+
+    SDL_Surface* windowSurface = SDL_GetWindowSurface(_window);
+    SDL_Surface* frameSurface = SDL_CreateSurfaceFrom(static_cast<int32_t>(_cpuRenderer->Width()), static_cast<int32_t>(_cpuRenderer->Height()), SDL_PIXELFORMAT_RGBA32,
+        const_cast<uint32_t*>(_cpuRenderer->Framebuffer().data()), static_cast<int32_t>(_cpuRenderer->Width() * sizeof(uint32_t)));
+
+    if (windowSurface == nullptr || frameSurface == nullptr)
+    {
+        spdlog::error("[SDL] Failed presenting CPU frame: {}", SDL_GetError());
+        SDL_DestroySurface(frameSurface);
+        return;
     }
 
-    _renderer->Render();
+    SDL_BlitSurface(frameSurface, nullptr, windowSurface, nullptr);
+    SDL_UpdateWindowSurface(_window);
+    SDL_DestroySurface(frameSurface);
 }
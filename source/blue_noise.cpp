@@ -0,0 +1,143 @@
+#include "blue_noise.hpp"
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+namespace
+{
+constexpr float GAUSSIAN_SIGMA = 1.5f;
+// Share of texels set in the initial binary pattern
+constexpr float INITIAL_DENSITY = 0.1f;
+
+// Energy of a binary pattern at every texel, the sum of a toroidally wrapped Gaussian around each set texel
+class EnergyField
+{
+public:
+    explicit EnergyField(uint32_t size)
+        : _size(size)
+        , _kernel(static_cast<size_t>(size) * size)
+        , _energy(static_cast<size_t>(size) * size, 0.0f)
+        , _pattern(static_cast<size_t>(size) * size, false)
+    {
+        for (uint32_t y = 0; y < size; ++y)
+        {
+            for (uint32_t x = 0; x < size; ++x)
+            {
+                const float dx = static_cast<float>(std::min(x, size - x));
+                const float dy = static_cast<float>(std::min(y, size - y));
+                _kernel[static_cast<size_t>(y) * size + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * GAUSSIAN_SIGMA * GAUSSIAN_SIGMA));
+            }
+        }
+    }
+
+    [[nodiscard]] bool IsSet(uint32_t index) const { return _pattern[index]; }
+    [[nodiscard]] const std::vector<bool>& Pattern() const { return _pattern; }
+
+    void Set(uint32_t index, bool value)
+    {
+        if (_pattern[index] == value)
+        {
+            return;
+        }
+        _pattern[index] = value;
+
+        const float sign = value ? 1.0f : -1.0f;
+        const uint32_t px = index % _size;
+        const uint32_t py = index / _size;
+        for (uint32_t y = 0; y < _size; ++y)
+        {
+            const size_t kernelRow = static_cast<size_t>((y + _size - py) % _size) * _size;
+            for (uint32_t x = 0; x < _size; ++x)
+            {
+                _energy[static_cast<size_t>(y) * _size + x] += sign * _kernel[kernelRow + (x + _size - px) % _size];
+            }
+        }
+    }
+
+    // Set texel with the highest energy
+    [[nodiscard]] uint32_t TightestCluster() const { return Find(true, std::greater<float> {}); }
+    // Unset texel with the lowest energy
+    [[nodiscard]] uint32_t LargestVoid() const { return Find(false, std::less<float> {}); }
+
+private:
+    template <typename Compare>
+    [[nodiscard]] uint32_t Find(bool set, Compare compare) const
+    {
+        uint32_t best = 0;
+        bool found = false;
+        for (uint32_t i = 0; i < _energy.size(); ++i)
+        {
+            if (_pattern[i] == set && (!found || compare(_energy[i], _energy[best])))
+            {
+                best = i;
+                found = true;
+            }
+        }
+        return best;
+    }
+
+    uint32_t _size {};
+    std::vector<float> _kernel {};
+    std::vector<float> _energy {};
+    std::vector<bool> _pattern {};
+};
+}
+
+std::vector<float> GenerateBlueNoise(uint32_t size, uint32_t seed)
+{
+    const uint32_t texelCount = size * size;
+    const uint32_t initialCount = std::max(1u, static_cast<uint32_t>(static_cast<float>(texelCount) * INITIAL_DENSITY));
+
+    // Random initial pattern, relaxed by moving the tightest cluster into the largest void until that no longer changes anything
+    EnergyField prototype { size };
+    std::mt19937 generator { seed };
+    std::uniform_int_distribution<uint32_t> distribution { 0, texelCount - 1 };
+    for (uint32_t count = 0; count < initialCount;)
+    {
+        const uint32_t index = distribution(generator);
+        if (!prototype.IsSet(index))
+        {
+            prototype.Set(index, true);
+            ++count;
+        }
+    }
+
+    while (true)
+    {
+        const uint32_t cluster = prototype.TightestCluster();
+        prototype.Set(cluster, false);
+        const uint32_t largestVoid = prototype.LargestVoid();
+        prototype.Set(largestVoid, true);
+        if (largestVoid == cluster)
+        {
+            break;
+        }
+    }
+
+    std::vector<uint32_t> ranks(texelCount);
+
+    // Ranks below the initial count come from taking the prototype apart, cluster by cluster
+    EnergyField field = prototype;
+    for (uint32_t rank = initialCount; rank-- > 0;)
+    {
+        const uint32_t cluster = field.TightestCluster();
+        field.Set(cluster, false);
+        ranks[cluster] = rank;
+    }
+
+    // The rest fill the prototype up, void by void
+    field = prototype;
+    for (uint32_t rank = initialCount; rank < texelCount; ++rank)
+    {
+        const uint32_t largestVoid = field.LargestVoid();
+        field.Set(largestVoid, true);
+        ranks[largestVoid] = rank;
+    }
+
+    std::vector<float> noise(texelCount);
+    for (uint32_t i = 0; i < texelCount; ++i)
+    {
+        noise[i] = (static_cast<float>(ranks[i]) + 0.5f) / static_cast<float>(texelCount);
+    }
+    return noise;
+}
@@ -1,17 +1,27 @@
 #include "bottom_level_acceleration_structure.hpp"
+#include "acceleration_structure_cache.hpp"
 #include "gltf_loader.hpp"
 #include "resources/bindless_resources.hpp"
 #include "single_time_commands.hpp"
+#include "thread_pool.hpp"
+#include "vk_common.hpp"
 #include "vulkan_context.hpp"
+#include <chrono>
 #include <glm/glm.hpp>
+#include <numeric>
+#include <spdlog/spdlog.h>
 
-BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(const std::shared_ptr<Model>& model, const std::shared_ptr<BindlessResources>& resources, const std::shared_ptr<VulkanContext>& vulkanContext, const glm::mat4& transform)
+// Serialized acceleration structures must be copied to and from 256 byte aligned addresses
+constexpr vk::DeviceSize SERIALIZATION_ALIGNMENT = 256;
+
+BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(const std::shared_ptr<Model>& model, const std::shared_ptr<BindlessResources>& resources, const std::shared_ptr<VulkanContext>& vulkanContext,
+    const BLASBuildOptions& options, const glm::mat4& transform)
     : _transform(transform)
     , _model(model)
     , _vulkanContext(vulkanContext)
 {
     InitializeTransformBuffer();
-    InitializeStructure(resources);
+    InitializeStructure(resources, options);
 }
 
 BottomLevelAccelerationStructure::~BottomLevelAccelerationStructure()
@@ -21,11 +31,17 @@ BottomLevelAccelerationStructure::~BottomLevelAccelerationStructure()
 
 BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(BottomLevelAccelerationStructure&& other) noexcept
     : _transform(other._transform)
+    , _geometryCount(other._geometryCount)
+    , _lightCount(other._lightCount)
+    , _structureSize(other._structureSize)
+    , _loadedFromCache(other._loadedFromCache)
     , _model(other._model)
     , _transformBuffer(std::move(other._transformBuffer))
+    , _transformMatrices(std::move(other._transformMatrices))
     , _vulkanContext(other._vulkanContext)
 {
     _vkStructure = other._vkStructure;
+    other._vkStructure = nullptr;
     _structureBuffer = std::move(other._structureBuffer);
     _scratchBuffer = std::move(other._scratchBuffer);
     _instancesBuffer = std::move(other._instancesBuffer);
@@ -33,7 +49,7 @@ BottomLevelAccelerationStructure::BottomLevelAccelerationStructure(BottomLevelAc
 
 void BottomLevelAccelerationStructure::InitializeTransformBuffer()
 {
-    std::vector<vk::TransformMatrixKHR> transformMatrices {};
+    std::vector<vk::TransformMatrixKHR>& transformMatrices = _transformMatrices;
     for (const auto& node : _model->nodes)
     {
         if (!node.meshIndex.has_value())
@@ -58,8 +74,19 @@ void BottomLevelAccelerationStructure::InitializeTransformBuffer()
     memcpy(_transformBuffer->mappedPtr, transformMatrices.data(), transformMatrices.size() * sizeof(VkTransformMatrixKHR));
 }
 
-void BottomLevelAccelerationStructure::InitializeStructure(const std::shared_ptr<BindlessResources>& resources)
+void BottomLevelAccelerationStructure::InitializeStructure(const std::shared_ptr<BindlessResources>& resources, const BLASBuildOptions& options)
 {
+    const std::shared_ptr<AccelerationStructureCache>& cache = options.cache;
+    const bool hostBuild = options.preferHostBuild && options.threadPool && _vulkanContext->AccelerationStructureHostCommandsSupported();
+    if (options.preferHostBuild && !_vulkanContext->AccelerationStructureHostCommandsSupported())
+    {
+        spdlog::warn("[BLAS] Host builds are not supported on this device, falling back to a device build");
+    }
+    else if (options.preferHostBuild && !options.threadPool)
+    {
+        spdlog::warn("[BLAS] Host builds need a thread pool in the build options, falling back to a device build");
+    }
+
     uint32_t maxPrimitiveCount = 0;
     std::vector<uint32_t> maxPrimitiveCounts {};
     std::vector<vk::AccelerationStructureGeometryKHR> geometries {};
@@ -91,8 +118,18 @@ void BottomLevelAccelerationStructure::InitializeStructure(const std::shared_ptr
         trianglesData.indexData = indexBufferDeviceAddress;
         trianglesData.transformData = transformBufferDeviceAddress;
 
+        if (hostBuild)
+        {
+            trianglesData.vertexData.hostAddress = _model->vertices.data();
+            trianglesData.indexData.hostAddress = _model->indices.data() + mesh.firstIndex;
+            trianglesData.transformData.hostAddress = &_transformMatrices[geometries.size()];
+        }
+
         vk::AccelerationStructureGeometryKHR& accelerationStructureGeometry = geometries.emplace_back();
-        accelerationStructureGeometry.flags = vk::GeometryFlagBitsKHR::eOpaque;
+        // Only alpha masked geometry invokes any-hit shaders, and at most once per triangle so counts and tests stay cheap
+        accelerationStructureGeometry.flags = HasMaterialFeature(mesh.materialFeatures, MaterialFeatures::eAlphaMask)
+            ? vk::GeometryFlagBitsKHR::eNoDuplicateAnyHitInvocation
+            : vk::GeometryFlagBitsKHR::eOpaque;
         accelerationStructureGeometry.geometryType = vk::GeometryTypeKHR::eTriangles;
         accelerationStructureGeometry.geometry.triangles = trianglesData;
 
@@ -110,11 +147,29 @@ void BottomLevelAccelerationStructure::InitializeStructure(const std::shared_ptr
         geometryNodeCreation.vertexBufferDeviceAddress = vertexBufferDeviceAddress.deviceAddress;
         geometryNodeCreation.indexBufferDeviceAddress = indexBufferDeviceAddress.deviceAddress;
         geometryNodeCreation.material = mesh.material;
+        geometryNodeCreation.materialFeatures = mesh.materialFeatures;
+        geometryNodeCreation.lightOffset = _lightCount;
         resources->GeometryNodes().Create(geometryNodeCreation);
+
+        // Emissive triangles were collected by the loader in this same node order
+        if (mesh.emissive)
+        {
+            _lightCount += primitiveCount;
+        }
     }
 
     _geometryCount = geometries.size();
 
+    if (cache)
+    {
+        if (std::optional<std::vector<std::byte>> serializedData = cache->Load(_model->contentHash))
+        {
+            Deserialize(serializedData.value());
+            _loadedFromCache = true;
+            return;
+        }
+    }
+
     vk::AccelerationStructureBuildGeometryInfoKHR buildGeometryInfo {};
     buildGeometryInfo.type = vk::AccelerationStructureTypeKHR::eBottomLevel;
     buildGeometryInfo.flags = vk::BuildAccelerationStructureFlagBitsKHR::ePreferFastTrace;
@@ -122,22 +177,52 @@ void BottomLevelAccelerationStructure::InitializeStructure(const std::shared_ptr
     buildGeometryInfo.geometryCount = static_cast<uint32_t>(geometries.size());
     buildGeometryInfo.pGeometries = geometries.data();
 
-    vk::AccelerationStructureBuildSizesInfoKHR buildSizesInfo = _vulkanContext->Device().getAccelerationStructureBuildSizesKHR(
-        vk::AccelerationStructureBuildTypeKHR::eDevice, buildGeometryInfo, maxPrimitiveCounts, _vulkanContext->Dldi());
+    if (cache)
+    {
+        buildGeometryInfo.flags |= vk::BuildAccelerationStructureFlagBitsKHR::eAllowCompaction;
+    }
 
+    if (hostBuild)
+    {
+        BuildOnHost(buildGeometryInfo, maxPrimitiveCounts, buildRangeInfos, *options.threadPool);
+    }
+    else
+    {
+        Build(buildGeometryInfo, maxPrimitiveCounts, buildRangeInfos);
+    }
+
+    if (cache)
+    {
+        Compact();
+        cache->Store(_model->contentHash, Serialize());
+    }
+}
+
+void BottomLevelAccelerationStructure::CreateStructure(vk::DeviceSize size, std::string_view name, bool hostVisible)
+{
+    // Host builds write the structure from the CPU, so its memory has to be host visible
     BufferCreation structureBufferCreation {};
-    structureBufferCreation.SetName("BLAS Structure Buffer")
+    structureBufferCreation.SetName(name)
         .SetUsageFlags(vk::BufferUsageFlagBits::eAccelerationStructureStorageKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress)
-        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
-        .SetIsMappable(false)
-        .SetSize(buildSizesInfo.accelerationStructureSize);
+        .SetMemoryUsage(hostVisible ? VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE : VMA_MEMORY_USAGE_GPU_ONLY)
+        .SetIsMappable(hostVisible)
+        .SetSize(size);
     _structureBuffer = std::make_unique<Buffer>(structureBufferCreation, _vulkanContext);
 
     vk::AccelerationStructureCreateInfoKHR createInfo {};
     createInfo.type = vk::AccelerationStructureTypeKHR::eBottomLevel;
     createInfo.buffer = _structureBuffer->buffer;
-    createInfo.size = buildSizesInfo.accelerationStructureSize;
+    createInfo.size = size;
     _vkStructure = _vulkanContext->Device().createAccelerationStructureKHR(createInfo, nullptr, _vulkanContext->Dldi());
+    _structureSize = size;
+}
+
+void BottomLevelAccelerationStructure::Build(vk::AccelerationStructureBuildGeometryInfoKHR& buildGeometryInfo, const std::vector<uint32_t>& maxPrimitiveCounts, const std::vector<vk::AccelerationStructureBuildRangeInfoKHR>& buildRangeInfos)
+{
+    vk::AccelerationStructureBuildSizesInfoKHR buildSizesInfo = _vulkanContext->Device().getAccelerationStructureBuildSizesKHR(
+        vk::AccelerationStructureBuildTypeKHR::eDevice, buildGeometryInfo, maxPrimitiveCounts, _vulkanContext->Dldi());
+
+    CreateStructure(buildSizesInfo.accelerationStructureSize, "BLAS Structure Buffer");
 
     BufferCreation scratchBufferCreation {};
     scratchBufferCreation.SetName("BLAS Scratch Buffer")
@@ -151,14 +236,192 @@ void BottomLevelAccelerationStructure::InitializeStructure(const std::shared_ptr
     buildGeometryInfo.dstAccelerationStructure = _vkStructure;
     buildGeometryInfo.scratchData.deviceAddress = _vulkanContext->GetBufferDeviceAddress(_scratchBuffer->buffer);
 
-    std::vector<vk::AccelerationStructureBuildRangeInfoKHR*> pBuildRangeInfos(buildRangeInfos.size());
+    std::vector<const vk::AccelerationStructureBuildRangeInfoKHR*> pBuildRangeInfos(buildRangeInfos.size());
     for (uint32_t i = 0; i < buildRangeInfos.size(); i++)
     {
         pBuildRangeInfos[i] = &buildRangeInfos[i];
     }
 
-    SingleTimeCommands singleTimeCommands { _vulkanContext };
+    const auto buildStart = std::chrono::high_resolution_clock::now();
+
+    // The build reads the vertex and index buffers the transfer queue uploaded
+    const vk::SemaphoreSubmitInfo uploadWait = _vulkanContext->TimelineWait(QueueType::eTransfer, _model->uploadTimelineValue);
+    SingleTimeCommands singleTimeCommands { _vulkanContext, QueueType::eCompute };
     singleTimeCommands.Record([&](vk::CommandBuffer commandBuffer)
         { commandBuffer.buildAccelerationStructuresKHR(1, &buildGeometryInfo, pBuildRangeInfos.data(), _vulkanContext->Dldi()); });
+    singleTimeCommands.Submit({ &uploadWait, 1 });
+
+    const std::chrono::duration<double> buildDuration = std::chrono::high_resolution_clock::now() - buildStart;
+    const uint64_t triangleCount = std::accumulate(maxPrimitiveCounts.begin(), maxPrimitiveCounts.end(), uint64_t { 0 });
+    spdlog::info("[BLAS] Device build of {} triangles took {:.2f} ms ({:.2f} Mtris/s)",
+        triangleCount, buildDuration.count() * 1000.0, static_cast<double>(triangleCount) / buildDuration.count() / 1e6);
+}
+
+void BottomLevelAccelerationStructure::BuildOnHost(vk::AccelerationStructureBuildGeometryInfoKHR& buildGeometryInfo, const std::vector<uint32_t>& maxPrimitiveCounts, const std::vector<vk::AccelerationStructureBuildRangeInfoKHR>& buildRangeInfos, ThreadPool& threadPool)
+{
+    const vk::Device device = _vulkanContext->Device();
+    const vk::detail::DispatchLoaderDynamic dldi = _vulkanContext->Dldi();
+
+    vk::AccelerationStructureBuildSizesInfoKHR buildSizesInfo = device.getAccelerationStructureBuildSizesKHR(
+        vk::AccelerationStructureBuildTypeKHR::eHost, buildGeometryInfo, maxPrimitiveCounts, dldi);
+
+    CreateStructure(buildSizesInfo.accelerationStructureSize, "BLAS Host Structure Buffer", true);
+    std::vector<std::byte> scratchMemory(buildSizesInfo.buildScratchSize);
+
+    buildGeometryInfo.dstAccelerationStructure = _vkStructure;
+    buildGeometryInfo.scratchData.hostAddress = scratchMemory.data();
+
+    std::vector<const vk::AccelerationStructureBuildRangeInfoKHR*> pBuildRangeInfos(buildRangeInfos.size());
+    for (uint32_t i = 0; i < buildRangeInfos.size(); i++)
+    {
+        pBuildRangeInfos[i] = &buildRangeInfos[i];
+    }
+
+    const auto buildStart = std::chrono::high_resolution_clock::now();
+
+    const vk::DeferredOperationKHR deferredOperation = device.createDeferredOperationKHR(nullptr, dldi);
+    const vk::Result buildResult = device.buildAccelerationStructuresKHR(deferredOperation, 1, &buildGeometryInfo, pBuildRangeInfos.data(), dldi);
+
+    uint32_t joinedThreads = 0;
+    if (buildResult == vk::Result::eOperationDeferredKHR)
+    {
+        const uint32_t maxConcurrency = device.getDeferredOperationMaxConcurrencyKHR(deferredOperation, dldi);
+        joinedThreads = std::min(maxConcurrency, threadPool.ThreadCount());
+
+        std::vector<std::future<void>> joins {};
+        for (uint32_t i = 0; i < joinedThreads; ++i)
+        {
+            joins.push_back(threadPool.Submit([&]()
+                {
+                    // Idle means the operation has no work for this thread right now, but is not finished yet
+                    vk::Result joinResult = device.deferredOperationJoinKHR(deferredOperation, dldi);
+                    while (joinResult == vk::Result::eThreadIdleKHR)
+                    {
+                        std::this_thread::yield();
+                        joinResult = device.deferredOperationJoinKHR(deferredOperation, dldi);
+                    } }));
+        }
+
+        for (auto& join : joins)
+        {
+            join.wait();
+        }
+
+        VkCheckResult(device.getDeferredOperationResultKHR(deferredOperation, dldi), "[VULKAN] Failed building BLAS on the host!");
+    }
+    else
+    {
+        VkCheckResult(buildResult == vk::Result::eOperationNotDeferredKHR ? vk::Result::eSuccess : buildResult, "[VULKAN] Failed building BLAS on the host!");
+    }
+
+    device.destroyDeferredOperationKHR(deferredOperation, nullptr, dldi);
+
+    const std::chrono::duration<double> buildDuration = std::chrono::high_resolution_clock::now() - buildStart;
+    const uint64_t triangleCount = std::accumulate(maxPrimitiveCounts.begin(), maxPrimitiveCounts.end(), uint64_t { 0 });
+    spdlog::info("[BLAS] Host build of {} triangles on {} threads took {:.2f} ms ({:.2f} Mtris/s)",
+        triangleCount, std::max(joinedThreads, 1u), buildDuration.count() * 1000.0, static_cast<double>(triangleCount) / buildDuration.count() / 1e6);
+}
+
+void BottomLevelAccelerationStructure::Compact()
+{
+    const uint64_t compactedSize = QueryStructureProperty(vk::QueryType::eAccelerationStructureCompactedSizeKHR);
+    const vk::DeviceSize originalSize = _structureSize;
+
+    const vk::AccelerationStructureKHR sourceStructure = _vkStructure;
+    const std::unique_ptr<Buffer> sourceBuffer = std::move(_structureBuffer);
+    CreateStructure(compactedSize, "BLAS Compacted Structure Buffer");
+
+    vk::CopyAccelerationStructureInfoKHR copyInfo {};
+    copyInfo.src = sourceStructure;
+    copyInfo.dst = _vkStructure;
+    copyInfo.mode = vk::CopyAccelerationStructureModeKHR::eCompact;
+
+    SingleTimeCommands singleTimeCommands { _vulkanContext, QueueType::eCompute };
+    singleTimeCommands.Record([&](vk::CommandBuffer commandBuffer)
+        { commandBuffer.copyAccelerationStructureKHR(copyInfo, _vulkanContext->Dldi()); });
+    singleTimeCommands.Submit();
+
+    _vulkanContext->Device().destroyAccelerationStructureKHR(sourceStructure, nullptr, _vulkanContext->Dldi());
+    _scratchBuffer.reset();
+
+    spdlog::info("[BLAS] Compacted structure from {} to {} bytes", originalSize, compactedSize);
+}
+
+std::vector<std::byte> BottomLevelAccelerationStructure::Serialize() const
+{
+    const uint64_t serializedSize = QueryStructureProperty(vk::QueryType::eAccelerationStructureSerializationSizeKHR);
+
+    BufferCreation serializationBufferCreation {};
+    serializationBufferCreation.SetName("BLAS Serialization Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_TO_CPU)
+        .SetIsMappable(true)
+        .SetAlignment(SERIALIZATION_ALIGNMENT)
+        .SetSize(serializedSize);
+    Buffer serializationBuffer(serializationBufferCreation, _vulkanContext);
+
+    vk::CopyAccelerationStructureToMemoryInfoKHR copyInfo {};
+    copyInfo.src = _vkStructure;
+    copyInfo.dst.deviceAddress = _vulkanContext->GetBufferDeviceAddress(serializationBuffer.buffer);
+    copyInfo.mode = vk::CopyAccelerationStructureModeKHR::eSerialize;
+
+    SingleTimeCommands singleTimeCommands { _vulkanContext, QueueType::eCompute };
+    singleTimeCommands.Record([&](vk::CommandBuffer commandBuffer)
+        { commandBuffer.copyAccelerationStructureToMemoryKHR(copyInfo, _vulkanContext->Dldi()); });
     singleTimeCommands.Submit();
+
+    VkCheckResult(vmaInvalidateAllocation(_vulkanContext->MemoryAllocator(), serializationBuffer.allocation, 0, VK_WHOLE_SIZE), "[VULKAN] Failed invalidating serialization buffer!");
+
+    std::vector<std::byte> serializedData(serializedSize);
+    std::memcpy(serializedData.data(), serializationBuffer.mappedPtr, serializedSize);
+    return serializedData;
+}
+
+void BottomLevelAccelerationStructure::Deserialize(const std::vector<std::byte>& serializedData)
+{
+    CreateStructure(AccelerationStructureCache::DeserializedSize(serializedData), "BLAS Structure Buffer");
+
+    BufferCreation serializationBufferCreation {};
+    serializationBufferCreation.SetName("BLAS Deserialization Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_TO_GPU)
+        .SetIsMappable(true)
+        .SetAlignment(SERIALIZATION_ALIGNMENT)
+        .SetSize(serializedData.size());
+    Buffer serializationBuffer(serializationBufferCreation, _vulkanContext);
+    std::memcpy(serializationBuffer.mappedPtr, serializedData.data(), serializedData.size());
+    VkCheckResult(vmaFlushAllocation(_vulkanContext->MemoryAllocator(), serializationBuffer.allocation, 0, VK_WHOLE_SIZE), "[VULKAN] Failed flushing deserialization buffer!");
+
+    vk::CopyMemoryToAccelerationStructureInfoKHR copyInfo {};
+    copyInfo.src.deviceAddress = _vulkanContext->GetBufferDeviceAddress(serializationBuffer.buffer);
+    copyInfo.dst = _vkStructure;
+    copyInfo.mode = vk::CopyAccelerationStructureModeKHR::eDeserialize;
+
+    SingleTimeCommands singleTimeCommands { _vulkanContext, QueueType::eCompute };
+    singleTimeCommands.Record([&](vk::CommandBuffer commandBuffer)
+        { commandBuffer.copyMemoryToAccelerationStructureKHR(copyInfo, _vulkanContext->Dldi()); });
+    singleTimeCommands.Submit();
+}
+
+uint64_t BottomLevelAccelerationStructure::QueryStructureProperty(vk::QueryType queryType) const
+{
+    vk::QueryPoolCreateInfo queryPoolCreateInfo {};
+    queryPoolCreateInfo.queryType = queryType;
+    queryPoolCreateInfo.queryCount = 1;
+    const vk::QueryPool queryPool = _vulkanContext->Device().createQueryPool(queryPoolCreateInfo);
+
+    SingleTimeCommands singleTimeCommands { _vulkanContext, QueueType::eCompute };
+    singleTimeCommands.Record([&](vk::CommandBuffer commandBuffer)
+        {
+            commandBuffer.resetQueryPool(queryPool, 0, 1);
+            VkAccelerationStructureBuildBarrier(commandBuffer);
+            commandBuffer.writeAccelerationStructuresPropertiesKHR(_vkStructure, queryType, queryPool, 0, _vulkanContext->Dldi()); });
+    singleTimeCommands.Submit();
+
+    uint64_t value {};
+    VkCheckResult(_vulkanContext->Device().getQueryPoolResults(queryPool, 0, 1, sizeof(uint64_t), &value, sizeof(uint64_t), vk::QueryResultFlagBits::e64 | vk::QueryResultFlagBits::eWait),
+        "[VULKAN] Failed reading acceleration structure query results!");
+    _vulkanContext->Device().destroyQueryPool(queryPool);
+
+    return value;
 }
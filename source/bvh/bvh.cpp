@@ -0,0 +1,196 @@
+#include "bvh/bvh.hpp"
+#include "gltf_loader.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glm/geometric.hpp>
+
+namespace
+{
+constexpr uint32_t TRAVERSAL_STACK_SIZE = 64;
+
+// Returns the entry distance or infinity when the ray misses the box within [tMin, tMax]
+float IntersectAABB(const glm::vec3& origin, const glm::vec3& inverseDirection, float tMin, float tMax, const BVHNode& node)
+{
+    const glm::vec3 t0 = (node.min - origin) * inverseDirection;
+    const glm::vec3 t1 = (node.max - origin) * inverseDirection;
+    const glm::vec3 tNear = glm::min(t0, t1);
+    const glm::vec3 tFar = glm::max(t0, t1);
+
+    const float entry = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, tMin));
+    const float exit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, tMax));
+
+    return entry <= exit ? entry : std::numeric_limits<float>::infinity();
+}
+
+glm::vec3 SafeInverse(const glm::vec3& direction)
+{
+    constexpr float EPSILON = 1e-20f;
+    const auto inverse = [](float value)
+    { return 1.0f / (std::abs(value) > EPSILON ? value : std::copysign(EPSILON, value)); };
+
+    return { inverse(direction.x), inverse(direction.y), inverse(direction.z) };
+}
+
+template <bool ANY_HIT>
+bool Traverse(const BVH& bvh, const Ray& ray, RayHit& hit)
+{
+    if (bvh.nodes.empty())
+    {
+        return false;
+    }
+
+    const glm::vec3 inverseDirection = SafeInverse(ray.direction);
+    float tMax = std::min(ray.tMax, hit.t);
+    bool found = false;
+
+    std::array<uint32_t, TRAVERSAL_STACK_SIZE> stack {};
+    uint32_t stackSize = 0;
+
+    if (IntersectAABB(ray.origin, inverseDirection, ray.tMin, tMax, bvh.nodes[0]) == std::numeric_limits<float>::infinity())
+    {
+        return false;
+    }
+
+    uint32_t nodeIndex = 0;
+    while (true)
+    {
+        const BVHNode& node = bvh.nodes[nodeIndex];
+
+        if (node.IsLeaf())
+        {
+            for (uint32_t i = node.offset; i < node.offset + node.primitiveCount; ++i)
+            {
+                const uint32_t triangleIndex = bvh.primitiveIndices[i];
+                float t, u, v;
+                if (IntersectTriangle(ray, bvh.triangles[triangleIndex], t, u, v) && t < tMax)
+                {
+                    tMax = t;
+                    hit.t = t;
+                    hit.u = u;
+                    hit.v = v;
+                    hit.triangleIndex = triangleIndex;
+                    found = true;
+
+                    if constexpr (ANY_HIT)
+                    {
+                        return true;
+                    }
+                }
+            }
+
+            if (stackSize == 0)
+            {
+                break;
+            }
+            nodeIndex = stack[--stackSize];
+            continue;
+        }
+
+        uint32_t nearIndex = nodeIndex + 1;
+        uint32_t farIndex = node.offset;
+        float nearDistance = IntersectAABB(ray.origin, inverseDirection, ray.tMin, tMax, bvh.nodes[nearIndex]);
+        float farDistance = IntersectAABB(ray.origin, inverseDirection, ray.tMin, tMax, bvh.nodes[farIndex]);
+
+        if (farDistance < nearDistance)
+        {
+            std::swap(nearIndex, farIndex);
+            std::swap(nearDistance, farDistance);
+        }
+
+        if (nearDistance == std::numeric_limits<float>::infinity())
+        {
+            if (stackSize == 0)
+            {
+                break;
+            }
+            nodeIndex = stack[--stackSize];
+            continue;
+        }
+
+        nodeIndex = nearIndex;
+        if (farDistance != std::numeric_limits<float>::infinity() && stackSize < TRAVERSAL_STACK_SIZE)
+        {
+            stack[stackSize++] = farIndex;
+        }
+    }
+
+    return found;
+}
+}
+
+bool BVH::Intersect(const Ray& ray, RayHit& hit) const
+{
+    return Traverse<false>(*this, ray, hit);
+}
+
+bool BVH::Occluded(const Ray& ray) const
+{
+    RayHit hit {};
+    return Traverse<true>(*this, ray, hit);
+}
+
+void ExtractTriangles(const Model& model, std::vector<BVHTriangle>& triangles, const glm::mat4& transform, uint32_t firstGeometryIndex)
+{
+    triangles.reserve(triangles.size() + model.indices.size() / 3);
+
+    uint32_t geometryIndex = firstGeometryIndex;
+    for (const auto& node : model.nodes)
+    {
+        if (!node.meshIndex.has_value())
+        {
+            continue;
+        }
+
+        const Mesh& mesh = model.meshes[node.meshIndex.value()];
+        const glm::mat4 worldMatrix = transform * node.GetWorldMatrix();
+
+        for (uint32_t i = 0; i < mesh.indexCount / 3; ++i)
+        {
+            const uint32_t* index = model.indices.data() + mesh.firstIndex + i * 3;
+
+            BVHTriangle& triangle = triangles.emplace_back();
+            triangle.v0 = glm::vec3(worldMatrix * glm::vec4(model.vertices[index[0]].position, 1.0f));
+            triangle.v1 = glm::vec3(worldMatrix * glm::vec4(model.vertices[index[1]].position, 1.0f));
+            triangle.v2 = glm::vec3(worldMatrix * glm::vec4(model.vertices[index[2]].position, 1.0f));
+            triangle.geometryIndex = geometryIndex;
+            triangle.primitiveIndex = i;
+        }
+
+        ++geometryIndex;
+    }
+}
+
+bool IntersectTriangle(const Ray& ray, const BVHTriangle& triangle, float& t, float& u, float& v)
+{
+    // Möller-Trumbore
+    constexpr float EPSILON = 1e-9f;
+
+    const glm::vec3 edge1 = triangle.v1 - triangle.v0;
+    const glm::vec3 edge2 = triangle.v2 - triangle.v0;
+    const glm::vec3 p = glm::cross(ray.direction, edge2);
+    const float determinant = glm::dot(edge1, p);
+
+    if (std::abs(determinant) < EPSILON)
+    {
+        return false;
+    }
+
+    const float inverseDeterminant = 1.0f / determinant;
+    const glm::vec3 s = ray.origin - triangle.v0;
+    u = glm::dot(s, p) * inverseDeterminant;
+    if (u < 0.0f || u > 1.0f)
+    {
+        return false;
+    }
+
+    const glm::vec3 q = glm::cross(s, edge1);
+    v = glm::dot(ray.direction, q) * inverseDeterminant;
+    if (v < 0.0f || u + v > 1.0f)
+    {
+        return false;
+    }
+
+    t = glm::dot(edge2, q) * inverseDeterminant;
+    return t > ray.tMin && t < ray.tMax;
+}
@@ -0,0 +1,541 @@
+#include "bvh/bvh_builder.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <glm/common.hpp>
+
+namespace
+{
+struct Reference
+{
+    AABB bounds {};
+    uint32_t triangleIndex {};
+};
+
+struct BuildNode
+{
+    AABB bounds {};
+    std::unique_ptr<BuildNode> children[2] {};
+    std::vector<uint32_t> triangleIndices {};
+};
+
+struct Split
+{
+    float cost = std::numeric_limits<float>::max();
+    uint32_t axis {};
+    bool spatial = false;
+
+    // Object splits, references whose centroid falls in a bin up to and including this one go left
+    uint32_t bin {};
+    float binMin {};
+    float binScale {};
+
+    // Spatial splits
+    float position {};
+
+    AABB leftBounds {};
+    AABB rightBounds {};
+
+    [[nodiscard]] bool IsValid() const { return cost < std::numeric_limits<float>::max(); }
+};
+
+struct BuildContext
+{
+    const BVHBuildSettings& settings;
+    const std::vector<BVHTriangle>& triangles;
+    float rootSurfaceArea {};
+    std::atomic<size_t> referenceCount {};
+    size_t maxReferences {};
+};
+
+uint32_t ObjectBin(const Reference& reference, const Split& split, uint32_t binCount)
+{
+    const float position = reference.bounds.Center()[split.axis];
+    return std::min(binCount - 1, static_cast<uint32_t>(std::max(0.0f, (position - split.binMin) * split.binScale)));
+}
+
+// Bounds of the part of the triangle that lies between the two planes along the axis
+AABB ClipTriangle(const BVHTriangle& triangle, uint32_t axis, float planeMin, float planeMax)
+{
+    const glm::vec3 vertices[3] = { triangle.v0, triangle.v1, triangle.v2 };
+
+    AABB bounds {};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        const glm::vec3& a = vertices[i];
+        const glm::vec3& b = vertices[(i + 1) % 3];
+
+        if (a[axis] >= planeMin && a[axis] <= planeMax)
+        {
+            bounds.Grow(a);
+        }
+
+        for (const float plane : { planeMin, planeMax })
+        {
+            if ((a[axis] < plane && b[axis] > plane) || (a[axis] > plane && b[axis] < plane))
+            {
+                const float t = (plane - a[axis]) / (b[axis] - a[axis]);
+                glm::vec3 intersection = glm::mix(a, b, t);
+                intersection[axis] = plane;
+                bounds.Grow(intersection);
+            }
+        }
+    }
+
+    return bounds;
+}
+
+Split FindObjectSplit(const BuildContext& context, const std::vector<Reference>& references, const AABB& nodeBounds)
+{
+    struct Bin
+    {
+        AABB bounds {};
+        uint32_t count {};
+    };
+
+    const uint32_t binCount = context.settings.binCount;
+
+    AABB centroidBounds {};
+    for (const auto& reference : references)
+    {
+        centroidBounds.Grow(reference.bounds.Center());
+    }
+
+    Split best {};
+    std::vector<Bin> bins(binCount);
+    std::vector<AABB> rightBounds(binCount);
+    std::vector<uint32_t> rightCounts(binCount);
+
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        const float extent = centroidBounds.max[axis] - centroidBounds.min[axis];
+        if (extent <= 0.0f)
+        {
+            continue;
+        }
+
+        Split candidate {};
+        candidate.axis = axis;
+        candidate.binMin = centroidBounds.min[axis];
+        candidate.binScale = static_cast<float>(binCount) / extent;
+
+        std::fill(bins.begin(), bins.end(), Bin {});
+        for (const auto& reference : references)
+        {
+            Bin& bin = bins[ObjectBin(reference, candidate, binCount)];
+            bin.bounds.Grow(reference.bounds);
+            ++bin.count;
+        }
+
+        AABB accumulatedBounds {};
+        uint32_t accumulatedCount = 0;
+        for (uint32_t i = binCount - 1; i > 0; --i)
+        {
+            accumulatedBounds.Grow(bins[i].bounds);
+            accumulatedCount += bins[i].count;
+            rightBounds[i - 1] = accumulatedBounds;
+            rightCounts[i - 1] = accumulatedCount;
+        }
+
+        accumulatedBounds = {};
+        accumulatedCount = 0;
+        for (uint32_t i = 0; i < binCount - 1; ++i)
+        {
+            accumulatedBounds.Grow(bins[i].bounds);
+            accumulatedCount += bins[i].count;
+
+            if (accumulatedCount == 0 || rightCounts[i] == 0)
+            {
+                continue;
+            }
+
+            const float cost = accumulatedBounds.SurfaceArea() * accumulatedCount + rightBounds[i].SurfaceArea() * rightCounts[i];
+            if (cost < best.cost)
+            {
+                best = candidate;
+                best.cost = cost;
+                best.bin = i;
+                best.leftBounds = accumulatedBounds;
+                best.rightBounds = rightBounds[i];
+            }
+        }
+    }
+
+    if (best.IsValid())
+    {
+        best.cost = context.settings.traversalCost + context.settings.intersectionCost * best.cost / nodeBounds.SurfaceArea();
+    }
+
+    return best;
+}
+
+Split FindSpatialSplit(const BuildContext& context, const std::vector<Reference>& references, const AABB& nodeBounds)
+{
+    struct Bin
+    {
+        AABB bounds {};
+        uint32_t entries {};
+        uint32_t exits {};
+    };
+
+    const uint32_t binCount = context.settings.binCount;
+
+    Split best {};
+    std::vector<Bin> bins(binCount);
+    std::vector<AABB> rightBounds(binCount);
+    std::vector<uint32_t> rightCounts(binCount);
+
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        const float extent = nodeBounds.max[axis] - nodeBounds.min[axis];
+        if (extent <= 0.0f)
+        {
+            continue;
+        }
+
+        const float binWidth = extent / static_cast<float>(binCount);
+        const auto binIndex = [&](float position)
+        { return std::min(binCount - 1, static_cast<uint32_t>(std::max(0.0f, (position - nodeBounds.min[axis]) / binWidth))); };
+
+        std::fill(bins.begin(), bins.end(), Bin {});
+        for (const auto& reference : references)
+        {
+            const uint32_t firstBin = binIndex(reference.bounds.min[axis]);
+            const uint32_t lastBin = binIndex(reference.bounds.max[axis]);
+
+            if (firstBin == lastBin)
+            {
+                bins[firstBin].bounds.Grow(reference.bounds);
+            }
+            else
+            {
+                const BVHTriangle& triangle = context.triangles[reference.triangleIndex];
+                for (uint32_t i = firstBin; i <= lastBin; ++i)
+                {
+                    const float planeMin = nodeBounds.min[axis] + binWidth * static_cast<float>(i);
+                    const float planeMax = i == binCount - 1 ? nodeBounds.max[axis] : planeMin + binWidth;
+
+                    const AABB clipped = AABB::Intersection(ClipTriangle(triangle, axis, planeMin, planeMax), reference.bounds);
+                    if (clipped.IsValid())
+                    {
+                        bins[i].bounds.Grow(clipped);
+                    }
+                }
+            }
+
+            ++bins[firstBin].entries;
+            ++bins[lastBin].exits;
+        }
+
+        AABB accumulatedBounds {};
+        uint32_t accumulatedCount = 0;
+        for (uint32_t i = binCount - 1; i > 0; --i)
+        {
+            accumulatedBounds.Grow(bins[i].bounds);
+            accumulatedCount += bins[i].exits;
+            rightBounds[i - 1] = accumulatedBounds;
+            rightCounts[i - 1] = accumulatedCount;
+        }
+
+        accumulatedBounds = {};
+        accumulatedCount = 0;
+        for (uint32_t i = 0; i < binCount - 1; ++i)
+        {
+            accumulatedBounds.Grow(bins[i].bounds);
+            accumulatedCount += bins[i].entries;
+
+            if (accumulatedCount == 0 || rightCounts[i] == 0)
+            {
+                continue;
+            }
+
+            const float cost = accumulatedBounds.SurfaceArea() * accumulatedCount + rightBounds[i].SurfaceArea() * rightCounts[i];
+            if (cost < best.cost)
+            {
+                best.cost = cost;
+                best.axis = axis;
+                best.spatial = true;
+                best.position = nodeBounds.min[axis] + binWidth * static_cast<float>(i + 1);
+                best.leftBounds = accumulatedBounds;
+                best.rightBounds = rightBounds[i];
+            }
+        }
+    }
+
+    if (best.IsValid())
+    {
+        best.cost = context.settings.traversalCost + context.settings.intersectionCost * best.cost / nodeBounds.SurfaceArea();
+    }
+
+    return best;
+}
+
+void PartitionObject(const BuildContext& context, const std::vector<Reference>& references, const Split& split, std::vector<Reference>& left, std::vector<Reference>& right)
+{
+    for (const auto& reference : references)
+    {
+        if (ObjectBin(reference, split, context.settings.binCount) <= split.bin)
+        {
+            left.push_back(reference);
+        }
+        else
+        {
+            right.push_back(reference);
+        }
+    }
+}
+
+void PartitionSpatial(BuildContext& context, const std::vector<Reference>& references, const Split& split, std::vector<Reference>& left, std::vector<Reference>& right)
+{
+    size_t addedReferences = 0;
+
+    for (const auto& reference : references)
+    {
+        if (reference.bounds.max[split.axis] <= split.position)
+        {
+            left.push_back(reference);
+        }
+        else if (reference.bounds.min[split.axis] >= split.position)
+        {
+            right.push_back(reference);
+        }
+        else
+        {
+            const BVHTriangle& triangle = context.triangles[reference.triangleIndex];
+            const AABB leftBounds = AABB::Intersection(ClipTriangle(triangle, split.axis, std::numeric_limits<float>::lowest(), split.position), reference.bounds);
+            const AABB rightBounds = AABB::Intersection(ClipTriangle(triangle, split.axis, split.position, std::numeric_limits<float>::max()), reference.bounds);
+
+            if (leftBounds.IsValid() && rightBounds.IsValid())
+            {
+                left.push_back({ leftBounds, reference.triangleIndex });
+                right.push_back({ rightBounds, reference.triangleIndex });
+                ++addedReferences;
+            }
+            else if (rightBounds.IsValid())
+            {
+                right.push_back(reference);
+            }
+            else
+            {
+                left.push_back(reference);
+            }
+        }
+    }
+
+    context.referenceCount += addedReferences;
+}
+
+void PartitionMedian(std::vector<Reference>& references, const AABB& nodeBounds, std::vector<Reference>& left, std::vector<Reference>& right)
+{
+    const glm::vec3 extent = nodeBounds.Extent();
+    const uint32_t axis = extent.x > extent.y && extent.x > extent.z ? 0 : (extent.y > extent.z ? 1 : 2);
+    const auto middle = references.begin() + static_cast<std::ptrdiff_t>(references.size() / 2);
+
+    std::nth_element(references.begin(), middle, references.end(), [axis](const Reference& a, const Reference& b)
+        { return a.bounds.Center()[axis] < b.bounds.Center()[axis]; });
+
+    left.assign(references.begin(), middle);
+    right.assign(middle, references.end());
+}
+
+std::unique_ptr<BuildNode> BuildRecursive(BuildContext& context, std::vector<Reference> references, uint32_t depth)
+{
+    const BVHBuildSettings& settings = context.settings;
+    auto node = std::make_unique<BuildNode>();
+
+    for (const auto& reference : references)
+    {
+        node->bounds.Grow(reference.bounds);
+    }
+
+    const auto makeLeaf = [&]()
+    {
+        node->triangleIndices.reserve(references.size());
+        for (const auto& reference : references)
+        {
+            node->triangleIndices.push_back(reference.triangleIndex);
+        }
+        return std::move(node);
+    };
+
+    if (references.size() <= 1 || depth + 1 >= BVHBuilder::MAX_DEPTH)
+    {
+        return makeLeaf();
+    }
+
+    Split split = FindObjectSplit(context, references, node->bounds);
+
+    if (settings.spatialSplits && split.IsValid() && context.referenceCount < context.maxReferences)
+    {
+        const float overlap = AABB::Intersection(split.leftBounds, split.rightBounds).SurfaceArea();
+        if (overlap / context.rootSurfaceArea > settings.spatialSplitOverlapThreshold)
+        {
+            const Split spatialSplit = FindSpatialSplit(context, references, node->bounds);
+            if (spatialSplit.cost < split.cost)
+            {
+                split = spatialSplit;
+            }
+        }
+    }
+
+    const float leafCost = settings.intersectionCost * static_cast<float>(references.size());
+    if (references.size() <= settings.maxLeafSize && split.cost >= leafCost)
+    {
+        return makeLeaf();
+    }
+
+    std::vector<Reference> left {};
+    std::vector<Reference> right {};
+
+    if (split.IsValid())
+    {
+        if (split.spatial)
+        {
+            PartitionSpatial(context, references, split, left, right);
+        }
+        else
+        {
+            PartitionObject(context, references, split, left, right);
+        }
+    }
+
+    if (left.empty() || right.empty())
+    {
+        left.clear();
+        right.clear();
+        PartitionMedian(references, node->bounds, left, right);
+    }
+
+    const size_t referenceCount = references.size();
+    references = {};
+
+    if (settings.threadPool != nullptr && referenceCount >= settings.parallelThreshold)
+    {
+        std::future<void> leftTask = settings.threadPool->Submit([&]()
+            { node->children[0] = BuildRecursive(context, std::move(left), depth + 1); });
+        node->children[1] = BuildRecursive(context, std::move(right), depth + 1);
+
+        settings.threadPool->Wait(leftTask);
+        leftTask.get();
+    }
+    else
+    {
+        node->children[0] = BuildRecursive(context, std::move(left), depth + 1);
+        node->children[1] = BuildRecursive(context, std::move(right), depth + 1);
+    }
+
+    return node;
+}
+
+uint32_t Flatten(const BuildNode& buildNode, BVH& bvh)
+{
+    const auto index = static_cast<uint32_t>(bvh.nodes.size());
+
+    BVHNode& node = bvh.nodes.emplace_back();
+    node.min = buildNode.bounds.min;
+    node.max = buildNode.bounds.max;
+
+    if (buildNode.children[0] == nullptr)
+    {
+        node.offset = static_cast<uint32_t>(bvh.primitiveIndices.size());
+        node.primitiveCount = static_cast<uint32_t>(buildNode.triangleIndices.size());
+        bvh.primitiveIndices.insert(bvh.primitiveIndices.end(), buildNode.triangleIndices.begin(), buildNode.triangleIndices.end());
+        return index;
+    }
+
+    Flatten(*buildNode.children[0], bvh);
+    const uint32_t secondChild = Flatten(*buildNode.children[1], bvh);
+    bvh.nodes[index].offset = secondChild;
+
+    return index;
+}
+}
+
+BVHBuilder::BVHBuilder(const BVHBuildSettings& settings)
+    : _settings(settings)
+{
+    _settings.binCount = std::max(_settings.binCount, 2u);
+    _settings.maxLeafSize = std::max(_settings.maxLeafSize, 1u);
+}
+
+BVH BVHBuilder::Build(std::vector<BVHTriangle> triangles) const
+{
+    const auto buildStart = std::chrono::high_resolution_clock::now();
+
+    BVH bvh {};
+    bvh.triangles = std::move(triangles);
+
+    if (bvh.triangles.empty())
+    {
+        return bvh;
+    }
+
+    std::vector<Reference> references(bvh.triangles.size());
+    AABB rootBounds {};
+    for (uint32_t i = 0; i < bvh.triangles.size(); ++i)
+    {
+        references[i] = { bvh.triangles[i].Bounds(), i };
+        rootBounds.Grow(references[i].bounds);
+    }
+
+    BuildContext context { _settings, bvh.triangles };
+    context.rootSurfaceArea = std::max(rootBounds.SurfaceArea(), std::numeric_limits<float>::min());
+    context.referenceCount = references.size();
+    context.maxReferences = static_cast<size_t>(static_cast<float>(references.size()) * _settings.maxReferenceGrowth);
+
+    const std::unique_ptr<BuildNode> root = BuildRecursive(context, std::move(references), 0);
+
+    bvh.primitiveIndices.reserve(context.referenceCount);
+    Flatten(*root, bvh);
+
+    const std::chrono::duration<double, std::milli> buildDuration = std::chrono::high_resolution_clock::now() - buildStart;
+
+    ComputeMetrics(bvh, _settings.traversalCost, _settings.intersectionCost);
+    bvh.metrics.buildTimeMs = buildDuration.count();
+
+    return bvh;
+}
+
+void BVHBuilder::ComputeMetrics(BVH& bvh, float traversalCost, float intersectionCost)
+{
+    const double buildTimeMs = bvh.metrics.buildTimeMs;
+    bvh.metrics = {};
+    bvh.metrics.buildTimeMs = buildTimeMs;
+
+    if (bvh.nodes.empty())
+    {
+        return;
+    }
+
+    const auto surfaceArea = [](const BVHNode& node)
+    { return AABB { node.min, node.max }.SurfaceArea(); };
+    const float rootSurfaceArea = std::max(surfaceArea(bvh.nodes[0]), std::numeric_limits<float>::min());
+
+    std::vector<std::pair<uint32_t, uint32_t>> stack { { 0, 1 } };
+    while (!stack.empty())
+    {
+        const auto [nodeIndex, depth] = stack.back();
+        stack.pop_back();
+
+        const BVHNode& node = bvh.nodes[nodeIndex];
+        const float relativeArea = surfaceArea(node) / rootSurfaceArea;
+
+        ++bvh.metrics.nodeCount;
+        bvh.metrics.maxDepth = std::max(bvh.metrics.maxDepth, depth);
+
+        if (node.IsLeaf())
+        {
+            ++bvh.metrics.leafCount;
+            bvh.metrics.maxLeafSize = std::max(bvh.metrics.maxLeafSize, node.primitiveCount);
+            bvh.metrics.primitiveReferences += node.primitiveCount;
+            bvh.metrics.sahCost += intersectionCost * static_cast<float>(node.primitiveCount) * relativeArea;
+        }
+        else
+        {
+            bvh.metrics.sahCost += traversalCost * relativeArea;
+            stack.emplace_back(nodeIndex + 1, depth + 1);
+            stack.emplace_back(node.offset, depth + 1);
+        }
+    }
+}
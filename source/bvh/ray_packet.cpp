@@ -0,0 +1,170 @@
+#include "bvh/ray_packet.hpp"
+#include <algorithm>
+#include <array>
+
+namespace
+{
+constexpr uint32_t TRAVERSAL_STACK_SIZE = 64;
+
+struct PacketState
+{
+    SimdVector origin;
+    SimdVector direction;
+    SimdVector inverseDirection;
+    SimdFloat tMin;
+    SimdFloat tMax;
+    SimdFloat u;
+    SimdFloat v;
+};
+
+// Entry distance per lane, lanes that miss the box are set to infinity
+SimdFloat IntersectAABB(const PacketState& state, const BVHNode& node)
+{
+    const SimdVector t0 = { (SimdFloat::Broadcast(node.min.x) - state.origin.x) * state.inverseDirection.x,
+        (SimdFloat::Broadcast(node.min.y) - state.origin.y) * state.inverseDirection.y,
+        (SimdFloat::Broadcast(node.min.z) - state.origin.z) * state.inverseDirection.z };
+    const SimdVector t1 = { (SimdFloat::Broadcast(node.max.x) - state.origin.x) * state.inverseDirection.x,
+        (SimdFloat::Broadcast(node.max.y) - state.origin.y) * state.inverseDirection.y,
+        (SimdFloat::Broadcast(node.max.z) - state.origin.z) * state.inverseDirection.z };
+
+    const SimdFloat entry = Max(Max(Min(t0.x, t1.x), Min(t0.y, t1.y)), Max(Min(t0.z, t1.z), state.tMin));
+    const SimdFloat exit = Min(Min(Max(t0.x, t1.x), Max(t0.y, t1.y)), Min(Max(t0.z, t1.z), state.tMax));
+
+    return Select(entry <= exit, entry, SimdFloat::Broadcast(std::numeric_limits<float>::infinity()));
+}
+
+void IntersectTriangle(PacketState& state, const BVHTriangle& triangle, uint32_t triangleIndex, RayPacketHit& hit)
+{
+    constexpr float EPSILON = 1e-9f;
+
+    const SimdVector v0 = SimdVector::Broadcast(triangle.v0);
+    const SimdVector edge1 = SimdVector::Broadcast(triangle.v1 - triangle.v0);
+    const SimdVector edge2 = SimdVector::Broadcast(triangle.v2 - triangle.v0);
+
+    const SimdVector p = Cross(state.direction, edge2);
+    const SimdFloat determinant = Dot(edge1, p);
+    const SimdFloat inverseDeterminant = SimdFloat::Broadcast(1.0f) / determinant;
+
+    const SimdVector s = state.origin - v0;
+    const SimdFloat u = Dot(s, p) * inverseDeterminant;
+    const SimdVector q = Cross(s, edge1);
+    const SimdFloat v = Dot(state.direction, q) * inverseDeterminant;
+    const SimdFloat t = Dot(edge2, q) * inverseDeterminant;
+
+    const SimdFloat zero = SimdFloat::Broadcast(0.0f);
+    const SimdFloat mask = (Abs(determinant) > SimdFloat::Broadcast(EPSILON)) & (zero <= u) & (zero <= v)
+        & (u + v <= SimdFloat::Broadcast(1.0f)) & (t > state.tMin) & (t < state.tMax);
+
+    uint32_t laneMask = MoveMask(mask);
+    if (laneMask == 0)
+    {
+        return;
+    }
+
+    state.tMax = Select(mask, t, state.tMax);
+    state.u = Select(mask, u, state.u);
+    state.v = Select(mask, v, state.v);
+
+    while (laneMask != 0)
+    {
+        const auto lane = static_cast<uint32_t>(std::countr_zero(laneMask));
+        hit.triangleIndex[lane] = triangleIndex;
+        laneMask &= laneMask - 1;
+    }
+}
+}
+
+void RayPacket::SetRay(uint32_t lane, const glm::vec3& origin, const glm::vec3& direction)
+{
+    originX[lane] = origin.x;
+    originY[lane] = origin.y;
+    originZ[lane] = origin.z;
+    directionX[lane] = direction.x;
+    directionY[lane] = direction.y;
+    directionZ[lane] = direction.z;
+}
+
+void IntersectPacket(const BVH& bvh, const RayPacket& packet, RayPacketHit& hit)
+{
+    std::fill(std::begin(hit.triangleIndex), std::end(hit.triangleIndex), BVH_INVALID_INDEX);
+    std::fill(std::begin(hit.t), std::end(hit.t), packet.tMax);
+
+    if (bvh.nodes.empty())
+    {
+        return;
+    }
+
+    PacketState state {};
+    state.origin = SimdVector::Load(packet.originX, packet.originY, packet.originZ);
+    state.direction = SimdVector::Load(packet.directionX, packet.directionY, packet.directionZ);
+    state.tMin = SimdFloat::Broadcast(packet.tMin);
+    state.tMax = SimdFloat::Broadcast(packet.tMax);
+    state.u = SimdFloat::Broadcast(0.0f);
+    state.v = SimdFloat::Broadcast(0.0f);
+
+    // Keeps zero direction components from producing NaNs in the slab test
+    const auto safeInverse = [](SimdFloat direction)
+    {
+        constexpr float EPSILON = 1e-20f;
+        const SimdFloat small = Abs(direction) < SimdFloat::Broadcast(EPSILON);
+        return SimdFloat::Broadcast(1.0f) / Select(small, SimdFloat::Broadcast(EPSILON), direction);
+    };
+    state.inverseDirection = { safeInverse(state.direction.x), safeInverse(state.direction.y), safeInverse(state.direction.z) };
+
+    std::array<uint32_t, TRAVERSAL_STACK_SIZE> stack {};
+    uint32_t stackSize = 0;
+
+    const SimdFloat infinity = SimdFloat::Broadcast(std::numeric_limits<float>::infinity());
+    uint32_t nodeIndex = MoveMask(IntersectAABB(state, bvh.nodes[0]) < infinity) != 0 ? 0 : BVH_INVALID_INDEX;
+
+    while (nodeIndex != BVH_INVALID_INDEX)
+    {
+        const uint32_t currentIndex = nodeIndex;
+        const BVHNode& node = bvh.nodes[currentIndex];
+        nodeIndex = BVH_INVALID_INDEX;
+
+        if (node.IsLeaf())
+        {
+            for (uint32_t i = node.offset; i < node.offset + node.primitiveCount; ++i)
+            {
+                const uint32_t triangleIndex = bvh.primitiveIndices[i];
+                IntersectTriangle(state, bvh.triangles[triangleIndex], triangleIndex, hit);
+            }
+        }
+        else
+        {
+            uint32_t nearIndex = currentIndex + 1;
+            uint32_t farIndex = node.offset;
+            const SimdFloat nearEntry = IntersectAABB(state, bvh.nodes[nearIndex]);
+            const SimdFloat farEntry = IntersectAABB(state, bvh.nodes[farIndex]);
+
+            // Visit the child the packet reaches first, the other one is only pushed when any lane hits it
+            float nearDistance = HorizontalMin(nearEntry);
+            float farDistance = HorizontalMin(farEntry);
+            if (farDistance < nearDistance)
+            {
+                std::swap(nearIndex, farIndex);
+                std::swap(nearDistance, farDistance);
+            }
+
+            if (nearDistance != std::numeric_limits<float>::infinity())
+            {
+                nodeIndex = nearIndex;
+                if (farDistance != std::numeric_limits<float>::infinity() && stackSize < TRAVERSAL_STACK_SIZE)
+                {
+                    stack[stackSize++] = farIndex;
+                }
+                continue;
+            }
+        }
+
+        if (stackSize > 0)
+        {
+            nodeIndex = stack[--stackSize];
+        }
+    }
+
+    state.tMax.Store(hit.t);
+    state.u.Store(hit.u);
+    state.v.Store(hit.v);
+}
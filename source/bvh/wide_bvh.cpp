@@ -0,0 +1,383 @@
+#include "bvh/wide_bvh.hpp"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+// Every wide node pushes at most WIDTH - 1 siblings, bounded by the depth of the binary BVH
+constexpr uint32_t TRAVERSAL_STACK_SIZE = 64 * (WIDE_BVH_WIDTH - 1);
+
+constexpr int32_t MIN_EXPONENT = -126;
+constexpr int32_t MAX_EXPONENT = 127;
+
+constexpr uint32_t MAX_LEAF_TRIANGLES = WideBVHNode::MAX_LEAF_BLOCKS * WIDE_BVH_WIDTH;
+
+float ExponentToScale(int8_t exponent)
+{
+    return std::bit_cast<float>(static_cast<uint32_t>(exponent + 127) << 23);
+}
+
+AABB NodeBounds(const BVHNode& node)
+{
+    return { node.min, node.max };
+}
+
+AABB PrimitiveBounds(const BVH& bvh, uint32_t firstPrimitive, uint32_t primitiveCount)
+{
+    AABB bounds {};
+    for (uint32_t i = firstPrimitive; i < firstPrimitive + primitiveCount; ++i)
+    {
+        bounds.Grow(bvh.triangles[bvh.primitiveIndices[i]].Bounds());
+    }
+    return bounds;
+}
+
+uint32_t EncodeLeaf(const BVH& bvh, uint32_t firstPrimitive, uint32_t primitiveCount, WideBVH& wide)
+{
+    const auto firstBlock = static_cast<uint32_t>(wide.triangleBlocks.size());
+    const uint32_t blockCount = (primitiveCount + WIDE_BVH_WIDTH - 1) / WIDE_BVH_WIDTH;
+
+    wide.triangleBlocks.resize(firstBlock + blockCount);
+    for (uint32_t i = 0; i < primitiveCount; ++i)
+    {
+        TriangleBlock& block = wide.triangleBlocks[firstBlock + i / WIDE_BVH_WIDTH];
+        const uint32_t lane = i % WIDE_BVH_WIDTH;
+        const uint32_t triangleIndex = bvh.primitiveIndices[firstPrimitive + i];
+        const BVHTriangle& triangle = bvh.triangles[triangleIndex];
+
+        const glm::vec3 edge1 = triangle.v1 - triangle.v0;
+        const glm::vec3 edge2 = triangle.v2 - triangle.v0;
+
+        block.v0X[lane] = triangle.v0.x;
+        block.v0Y[lane] = triangle.v0.y;
+        block.v0Z[lane] = triangle.v0.z;
+        block.edge1X[lane] = edge1.x;
+        block.edge1Y[lane] = edge1.y;
+        block.edge1Z[lane] = edge1.z;
+        block.edge2X[lane] = edge2.x;
+        block.edge2Y[lane] = edge2.y;
+        block.edge2Z[lane] = edge2.z;
+        block.triangleIndex[lane] = triangleIndex;
+    }
+
+    // Block indices past the mask are caught once the whole BVH is collapsed
+    return WideBVHNode::LEAF_FLAG | ((blockCount - 1) << WideBVHNode::LEAF_BLOCK_COUNT_SHIFT) | (firstBlock & WideBVHNode::LEAF_FIRST_BLOCK_MASK);
+}
+
+void QuantizeChild(WideBVHNode& node, uint32_t slot, const AABB& bounds)
+{
+    uint8_t* minimum[3] = { node.minX, node.minY, node.minZ };
+    uint8_t* maximum[3] = { node.maxX, node.maxY, node.maxZ };
+
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        const float scale = ExponentToScale(node.exponent[axis]);
+        const float origin = node.origin[axis];
+
+        auto low = static_cast<int32_t>(std::floor((bounds.min[axis] - origin) / scale));
+        auto high = static_cast<int32_t>(std::ceil((bounds.max[axis] - origin) / scale));
+        low = std::clamp(low, 0, 255);
+        high = std::clamp(high, 0, 255);
+
+        // Guards against the subtraction rounding the quantized box inwards
+        while (low > 0 && origin + static_cast<float>(low) * scale > bounds.min[axis])
+        {
+            --low;
+        }
+        while (high < 255 && origin + static_cast<float>(high) * scale < bounds.max[axis])
+        {
+            ++high;
+        }
+
+        minimum[axis][slot] = static_cast<uint8_t>(low);
+        maximum[axis][slot] = static_cast<uint8_t>(high);
+    }
+}
+
+// Slots past the child count keep empty boxes, traversal masks them out by the child count. Inverted boxes wouldn't do, as the slab
+// test orders every axis' planes by the ray direction and reads them as valid boxes
+void InitializeNode(WideBVHNode& node, const AABB& bounds, uint32_t childCount)
+{
+    node.origin = bounds.min;
+    node.childCount = static_cast<uint8_t>(childCount);
+
+    for (uint32_t axis = 0; axis < 3; ++axis)
+    {
+        const float extent = bounds.max[axis] - bounds.min[axis];
+        const int32_t exponent = extent > 0.0f ? static_cast<int32_t>(std::ceil(std::log2(extent / 255.0f))) : MIN_EXPONENT;
+        node.exponent[axis] = static_cast<int8_t>(std::clamp(exponent, MIN_EXPONENT, MAX_EXPONENT));
+    }
+}
+
+// Leaves with more triangles than a wide leaf holds are split into ranges under a node of their own, each range as large as a full
+// subtree of wide leaves so the nesting stays as shallow as it can. Ranges are bounded by their triangles, clipped to the leaf bounds
+// since spatial splits let triangles reach outside of them
+uint32_t EncodeLargeLeaf(const BVH& bvh, uint32_t firstPrimitive, uint32_t primitiveCount, const AABB& bounds, WideBVH& wide)
+{
+    if (primitiveCount <= MAX_LEAF_TRIANGLES)
+    {
+        return EncodeLeaf(bvh, firstPrimitive, primitiveCount, wide);
+    }
+
+    const auto wideIndex = static_cast<uint32_t>(wide.nodes.size());
+    wide.nodes.emplace_back();
+
+    uint64_t rangeSize = MAX_LEAF_TRIANGLES;
+    while (rangeSize * WIDE_BVH_WIDTH < primitiveCount)
+    {
+        rangeSize *= WIDE_BVH_WIDTH;
+    }
+    const auto childCount = static_cast<uint32_t>((primitiveCount + rangeSize - 1) / rangeSize);
+
+    WideBVHNode node {};
+    InitializeNode(node, bounds, childCount);
+
+    for (uint32_t i = 0; i < childCount; ++i)
+    {
+        const auto rangeFirst = static_cast<uint32_t>(firstPrimitive + i * rangeSize);
+        const auto rangeCount = static_cast<uint32_t>(std::min<uint64_t>(rangeSize, firstPrimitive + primitiveCount - rangeFirst));
+        const AABB rangeBounds = AABB::Intersection(PrimitiveBounds(bvh, rangeFirst, rangeCount), bounds);
+
+        node.children[i] = EncodeLargeLeaf(bvh, rangeFirst, rangeCount, rangeBounds, wide);
+        QuantizeChild(node, i, rangeBounds);
+    }
+
+    wide.nodes[wideIndex] = node;
+    return wideIndex;
+}
+
+uint32_t CollapseNode(const BVH& bvh, uint32_t binaryIndex, WideBVH& wide)
+{
+    const BVHNode& binaryNode = bvh.nodes[binaryIndex];
+    const auto wideIndex = static_cast<uint32_t>(wide.nodes.size());
+    wide.nodes.emplace_back();
+
+    std::array<uint32_t, WIDE_BVH_WIDTH> children {};
+    uint32_t childCount = 0;
+
+    if (binaryNode.IsLeaf())
+    {
+        children[childCount++] = binaryIndex;
+    }
+    else
+    {
+        children[childCount++] = binaryIndex + 1;
+        children[childCount++] = binaryNode.offset;
+    }
+
+    // Greedily open the interior child with the largest surface area until the node is full
+    while (childCount < WIDE_BVH_WIDTH)
+    {
+        int32_t largestChild = -1;
+        float largestArea = -1.0f;
+        for (uint32_t i = 0; i < childCount; ++i)
+        {
+            const BVHNode& child = bvh.nodes[children[i]];
+            const float area = NodeBounds(child).SurfaceArea();
+            if (!child.IsLeaf() && area > largestArea)
+            {
+                largestChild = static_cast<int32_t>(i);
+                largestArea = area;
+            }
+        }
+
+        if (largestChild < 0)
+        {
+            break;
+        }
+
+        const uint32_t opened = children[largestChild];
+        children[largestChild] = opened + 1;
+        children[childCount++] = bvh.nodes[opened].offset;
+    }
+
+    // Filled locally since recursing into the children grows the node array
+    WideBVHNode node {};
+    InitializeNode(node, NodeBounds(binaryNode), childCount);
+
+    for (uint32_t i = 0; i < childCount; ++i)
+    {
+        const BVHNode& child = bvh.nodes[children[i]];
+        node.children[i] = child.IsLeaf() ? EncodeLargeLeaf(bvh, child.offset, child.primitiveCount, NodeBounds(child), wide)
+                                          : CollapseNode(bvh, children[i], wide);
+        QuantizeChild(node, i, NodeBounds(child));
+    }
+
+    wide.nodes[wideIndex] = node;
+    return wideIndex;
+}
+
+struct StackEntry
+{
+    uint32_t child;
+    float distance;
+};
+}
+
+std::optional<WideBVH> CollapseBVH(const BVH& bvh)
+{
+    WideBVH wide {};
+    if (bvh.nodes.empty())
+    {
+        return wide;
+    }
+
+    wide.nodes.reserve(bvh.nodes.size() / (WIDE_BVH_WIDTH - 1) + 1);
+    wide.triangleBlocks.reserve(bvh.metrics.leafCount);
+    CollapseNode(bvh, 0, wide);
+
+    if (wide.triangleBlocks.size() > static_cast<size_t>(WideBVHNode::LEAF_FIRST_BLOCK_MASK) + 1)
+    {
+        spdlog::error("[BVH] {} triangle blocks exceed the {} a wide leaf can address", wide.triangleBlocks.size(), WideBVHNode::LEAF_FIRST_BLOCK_MASK + 1);
+        return std::nullopt;
+    }
+
+    return wide;
+}
+
+bool WideBVH::Intersect(const Ray& ray, RayHit& hit) const
+{
+    if (nodes.empty())
+    {
+        return false;
+    }
+
+    constexpr float EPSILON = 1e-20f;
+    const auto safeInverse = [](float value)
+    { return 1.0f / (std::abs(value) > EPSILON ? value : std::copysign(EPSILON, value)); };
+    const glm::vec3 inverseDirection { safeInverse(ray.direction.x), safeInverse(ray.direction.y), safeInverse(ray.direction.z) };
+
+    const SimdVector rayOrigin = SimdVector::Broadcast(ray.origin);
+    const SimdVector rayDirection = SimdVector::Broadcast(ray.direction);
+    const SimdFloat tMin = SimdFloat::Broadcast(ray.tMin);
+    float tMax = std::min(ray.tMax, hit.t);
+    bool found = false;
+
+    std::array<StackEntry, TRAVERSAL_STACK_SIZE> stack {};
+    uint32_t stackSize = 0;
+    stack[stackSize++] = { 0, ray.tMin };
+
+    alignas(SIMD_ALIGNMENT) float distances[WIDE_BVH_WIDTH];
+    alignas(SIMD_ALIGNMENT) float hitT[WIDE_BVH_WIDTH];
+    alignas(SIMD_ALIGNMENT) float hitU[WIDE_BVH_WIDTH];
+    alignas(SIMD_ALIGNMENT) float hitV[WIDE_BVH_WIDTH];
+
+    while (stackSize > 0)
+    {
+        const StackEntry entry = stack[--stackSize];
+        if (entry.distance > tMax)
+        {
+            continue;
+        }
+
+        if (entry.child & WideBVHNode::LEAF_FLAG)
+        {
+            const uint32_t firstBlock = entry.child & WideBVHNode::LEAF_FIRST_BLOCK_MASK;
+            const uint32_t blockCount = ((entry.child & ~WideBVHNode::LEAF_FLAG) >> WideBVHNode::LEAF_BLOCK_COUNT_SHIFT) + 1;
+
+            for (uint32_t blockIndex = firstBlock; blockIndex < firstBlock + blockCount; ++blockIndex)
+            {
+                const TriangleBlock& block = triangleBlocks[blockIndex];
+
+                // Möller-Trumbore against every triangle in the block at once
+                const SimdVector v0 = SimdVector::Load(block.v0X, block.v0Y, block.v0Z);
+                const SimdVector edge1 = SimdVector::Load(block.edge1X, block.edge1Y, block.edge1Z);
+                const SimdVector edge2 = SimdVector::Load(block.edge2X, block.edge2Y, block.edge2Z);
+
+                const SimdVector p = Cross(rayDirection, edge2);
+                const SimdFloat determinant = Dot(edge1, p);
+                const SimdFloat inverseDeterminant = SimdFloat::Broadcast(1.0f) / determinant;
+
+                const SimdVector s = rayOrigin - v0;
+                const SimdFloat u = Dot(s, p) * inverseDeterminant;
+                const SimdVector q = Cross(s, edge1);
+                const SimdFloat v = Dot(rayDirection, q) * inverseDeterminant;
+                const SimdFloat t = Dot(edge2, q) * inverseDeterminant;
+
+                const SimdFloat zero = SimdFloat::Broadcast(0.0f);
+                const SimdFloat mask = (Abs(determinant) > SimdFloat::Broadcast(1e-9f)) & (zero <= u) & (zero <= v)
+                    & (u + v <= SimdFloat::Broadcast(1.0f)) & (t > tMin) & (t < SimdFloat::Broadcast(tMax));
+
+                uint32_t laneMask = MoveMask(mask);
+                if (laneMask == 0)
+                {
+                    continue;
+                }
+
+                t.Store(hitT);
+                u.Store(hitU);
+                v.Store(hitV);
+                while (laneMask != 0)
+                {
+                    const auto lane = static_cast<uint32_t>(std::countr_zero(laneMask));
+                    laneMask &= laneMask - 1;
+
+                    if (hitT[lane] < tMax)
+                    {
+                        tMax = hitT[lane];
+                        hit.t = hitT[lane];
+                        hit.u = hitU[lane];
+                        hit.v = hitV[lane];
+                        hit.triangleIndex = block.triangleIndex[lane];
+                        found = true;
+                    }
+                }
+            }
+            continue;
+        }
+
+        const WideBVHNode& node = nodes[entry.child];
+
+        // Child planes are q * scale + origin, so the slab distances become q * a + b with a and b shared by all children
+        SimdFloat entryDistance = tMin;
+        SimdFloat exitDistance = SimdFloat::Broadcast(tMax);
+        const uint8_t* minimum[3] = { node.minX, node.minY, node.minZ };
+        const uint8_t* maximum[3] = { node.maxX, node.maxY, node.maxZ };
+
+        for (uint32_t axis = 0; axis < 3; ++axis)
+        {
+            const SimdFloat a = SimdFloat::Broadcast(ExponentToScale(node.exponent[axis]) * inverseDirection[axis]);
+            const SimdFloat b = SimdFloat::Broadcast((node.origin[axis] - ray.origin[axis]) * inverseDirection[axis]);
+
+            const SimdFloat t0 = SimdFloat::LoadBytes(minimum[axis]) * a + b;
+            const SimdFloat t1 = SimdFloat::LoadBytes(maximum[axis]) * a + b;
+            entryDistance = Max(entryDistance, Min(t0, t1));
+            exitDistance = Min(exitDistance, Max(t0, t1));
+        }
+
+        uint32_t hitMask = MoveMask(entryDistance <= exitDistance) & ((1u << node.childCount) - 1);
+        if (hitMask == 0)
+        {
+            continue;
+        }
+
+        entryDistance.Store(distances);
+
+        // Push the hit children far to near so the closest one is popped first
+        std::array<StackEntry, WIDE_BVH_WIDTH> hitChildren {};
+        uint32_t hitCount = 0;
+        while (hitMask != 0)
+        {
+            const auto lane = static_cast<uint32_t>(std::countr_zero(hitMask));
+            hitMask &= hitMask - 1;
+
+            StackEntry child { node.children[lane], distances[lane] };
+            uint32_t position = hitCount++;
+            while (position > 0 && hitChildren[position - 1].distance < child.distance)
+            {
+                hitChildren[position] = hitChildren[position - 1];
+                --position;
+            }
+            hitChildren[position] = child;
+        }
+
+        for (uint32_t i = 0; i < hitCount && stackSize < TRAVERSAL_STACK_SIZE; ++i)
+        {
+            stack[stackSize++] = hitChildren[i];
+        }
+    }
+
+    return found;
+}
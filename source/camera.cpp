@@ -0,0 +1,59 @@
+#include "camera.hpp"
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+namespace
+{
+const float MAX_PITCH = glm::radians(89.0f);
+}
+
+Camera::Camera(const glm::mat4& view)
+{
+    const glm::mat4 viewInverse = glm::inverse(view);
+    _position = glm::vec3(viewInverse[3]);
+
+    // View space looks down negative z
+    const glm::vec3 forward = glm::normalize(-glm::vec3(viewInverse[2]));
+    _pitch = std::clamp(std::asin(std::clamp(glm::dot(forward, WORLD_UP), -1.0f, 1.0f)), -MAX_PITCH, MAX_PITCH);
+    _yaw = std::atan2(forward.z, forward.x);
+}
+
+glm::mat4 Camera::DefaultView()
+{
+    return glm::lookAt(DEFAULT_CAMERA_POSITION, glm::vec3(0.0f), WORLD_UP);
+}
+
+glm::mat4 Camera::OrbitView(float angle)
+{
+    const glm::vec3 position = glm::vec3(glm::rotate(glm::mat4(1.0f), angle, WORLD_UP) * glm::vec4(DEFAULT_CAMERA_POSITION, 1.0f));
+    return glm::lookAt(position, glm::vec3(0.0f), WORLD_UP);
+}
+
+void Camera::Move(const glm::vec3& localOffset)
+{
+    _position += Right() * localOffset.x + WORLD_UP * localOffset.y + Forward() * localOffset.z;
+}
+
+void Camera::Rotate(float yawDelta, float pitchDelta)
+{
+    _yaw = std::remainder(_yaw + yawDelta, glm::two_pi<float>());
+    _pitch = std::clamp(_pitch + pitchDelta, -MAX_PITCH, MAX_PITCH);
+}
+
+glm::mat4 Camera::View() const
+{
+    return glm::lookAt(_position, _position + Forward(), WORLD_UP);
+}
+
+glm::vec3 Camera::Forward() const
+{
+    return std::cos(_pitch) * glm::vec3(std::cos(_yaw), 0.0f, std::sin(_yaw)) + std::sin(_pitch) * WORLD_UP;
+}
+
+glm::vec3 Camera::Right() const
+{
+    return glm::normalize(glm::cross(Forward(), WORLD_UP));
+}
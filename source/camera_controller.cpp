@@ -0,0 +1,143 @@
+#include "camera_controller.hpp"
+
+// SDL throws some weird errors when parsed with clang-analyzer (used in clang-tidy checks)
+// This definition fixes the issues and does not change the final build output
+#define SDL_DISABLE_ANALYZE_MACROS
+
+#include "camera.hpp"
+#include <SDL3/SDL.h>
+#include <algorithm>
+#include <cmath>
+#include <glm/vec3.hpp>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+// World units per second, and the factor holding shift applies
+constexpr float MOVE_SPEED = 3.0f;
+constexpr float FAST_MOVE_FACTOR = 4.0f;
+// Radians per pixel of mouse motion, and per second at full stick deflection
+constexpr float MOUSE_SENSITIVITY = 0.0025f;
+constexpr float GAMEPAD_LOOK_SPEED = 2.0f;
+// Stick deflection below which the stick counts as centered
+constexpr float GAMEPAD_DEAD_ZONE = 0.15f;
+// Frames further apart than this, like after a stall, don't turn into one large jump
+constexpr float MAX_UPDATE_SECONDS = 0.1f;
+
+float GamepadAxis(SDL_Gamepad* gamepad, SDL_GamepadAxis axis)
+{
+    const float value = static_cast<float>(SDL_GetGamepadAxis(gamepad, axis)) / static_cast<float>(SDL_JOYSTICK_AXIS_MAX);
+    return std::abs(value) < GAMEPAD_DEAD_ZONE ? 0.0f : std::clamp(value, -1.0f, 1.0f);
+}
+}
+
+CameraController::CameraController(Camera& camera)
+    : _camera(camera)
+{
+}
+
+CameraController::~CameraController()
+{
+    if (_gamepad != nullptr)
+    {
+        SDL_CloseGamepad(_gamepad);
+    }
+}
+
+void CameraController::ProcessEvent(const SDL_Event& event)
+{
+    switch (event.type)
+    {
+    case SDL_EVENT_MOUSE_BUTTON_DOWN:
+    case SDL_EVENT_MOUSE_BUTTON_UP:
+        if (event.button.button == SDL_BUTTON_RIGHT)
+        {
+            _looking = event.button.down;
+        }
+        break;
+    case SDL_EVENT_MOUSE_MOTION:
+        if (_looking)
+        {
+            _pendingMouseMotion += glm::vec2(event.motion.xrel, event.motion.yrel);
+            RecordInputTimestamp(event.motion.timestamp);
+        }
+        break;
+    case SDL_EVENT_KEY_DOWN:
+        if (!event.key.repeat)
+        {
+            RecordInputTimestamp(event.key.timestamp);
+        }
+        break;
+    case SDL_EVENT_GAMEPAD_AXIS_MOTION:
+        RecordInputTimestamp(event.gaxis.timestamp);
+        break;
+    case SDL_EVENT_GAMEPAD_ADDED:
+        if (_gamepad == nullptr)
+        {
+            _gamepad = SDL_OpenGamepad(event.gdevice.which);
+            if (_gamepad == nullptr)
+            {
+                spdlog::warn("[SDL] Failed opening gamepad: {}", SDL_GetError());
+            }
+        }
+        break;
+    case SDL_EVENT_GAMEPAD_REMOVED:
+        if (_gamepad != nullptr && SDL_GetGamepadID(_gamepad) == event.gdevice.which)
+        {
+            SDL_CloseGamepad(_gamepad);
+            _gamepad = nullptr;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void CameraController::Update()
+{
+    const uint64_t nowNs = SDL_GetTicksNS();
+    const float deltaSeconds = _lastUpdateNs == 0 ? 0.0f : std::min(static_cast<float>(nowNs - _lastUpdateNs) * 1e-9f, MAX_UPDATE_SECONDS);
+    _lastUpdateNs = nowNs;
+
+    const bool* keys = SDL_GetKeyboardState(nullptr);
+    glm::vec3 move {
+        static_cast<float>(keys[SDL_SCANCODE_D]) - static_cast<float>(keys[SDL_SCANCODE_A]),
+        static_cast<float>(keys[SDL_SCANCODE_E]) - static_cast<float>(keys[SDL_SCANCODE_Q]),
+        static_cast<float>(keys[SDL_SCANCODE_W]) - static_cast<float>(keys[SDL_SCANCODE_S]),
+    };
+    const float speed = MOVE_SPEED * (keys[SDL_SCANCODE_LSHIFT] || keys[SDL_SCANCODE_RSHIFT] ? FAST_MOVE_FACTOR : 1.0f);
+
+    glm::vec2 look = -_pendingMouseMotion * MOUSE_SENSITIVITY;
+    _pendingMouseMotion = glm::vec2(0.0f);
+
+    if (_gamepad != nullptr)
+    {
+        move.x += GamepadAxis(_gamepad, SDL_GAMEPAD_AXIS_LEFTX);
+        move.y += GamepadAxis(_gamepad, SDL_GAMEPAD_AXIS_RIGHT_TRIGGER) - GamepadAxis(_gamepad, SDL_GAMEPAD_AXIS_LEFT_TRIGGER);
+        move.z -= GamepadAxis(_gamepad, SDL_GAMEPAD_AXIS_LEFTY);
+        look -= glm::vec2(GamepadAxis(_gamepad, SDL_GAMEPAD_AXIS_RIGHTX), GamepadAxis(_gamepad, SDL_GAMEPAD_AXIS_RIGHTY)) * GAMEPAD_LOOK_SPEED * deltaSeconds;
+    }
+
+    _lastUpdateInputTimestampNs = 0;
+    const bool moving = move != glm::vec3(0.0f) && deltaSeconds > 0.0f;
+    if (!moving && look == glm::vec2(0.0f))
+    {
+        _pendingInputTimestampNs = 0;
+        return;
+    }
+
+    _camera.Rotate(look.x, look.y);
+    if (moving)
+    {
+        _camera.Move(move * speed * deltaSeconds);
+    }
+
+    // Held keys and sticks are sampled right now, unless an event changed them earlier
+    _lastUpdateInputTimestampNs = _pendingInputTimestampNs != 0 ? _pendingInputTimestampNs : nowNs;
+    _pendingInputTimestampNs = 0;
+}
+
+void CameraController::RecordInputTimestamp(uint64_t timestampNs)
+{
+    _pendingInputTimestampNs = _pendingInputTimestampNs == 0 ? timestampNs : std::min(_pendingInputTimestampNs, timestampNs);
+}
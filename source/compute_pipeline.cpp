@@ -0,0 +1,169 @@
+#include "compute_pipeline.hpp"
+#include "shader.hpp"
+#include "vk_common.hpp"
+#include "vulkan_context.hpp"
+#include <algorithm>
+#include <spdlog/spdlog.h>
+
+ComputePipelineCreation& ComputePipelineCreation::SetShaderPath(std::string_view shaderPath)
+{
+    this->shaderPath = shaderPath;
+    return *this;
+}
+
+ComputePipelineCreation& ComputePipelineCreation::AddBinding(uint32_t binding, vk::DescriptorType type, uint32_t count)
+{
+    vk::DescriptorSetLayoutBinding& layoutBinding = bindings.emplace_back();
+    layoutBinding.binding = binding;
+    layoutBinding.descriptorType = type;
+    layoutBinding.descriptorCount = count;
+    layoutBinding.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    return *this;
+}
+
+ComputePipelineCreation& ComputePipelineCreation::SetPushConstantSize(uint32_t pushConstantSize)
+{
+    this->pushConstantSize = pushConstantSize;
+    return *this;
+}
+
+ComputePipelineCreation& ComputePipelineCreation::SetName(std::string_view name)
+{
+    this->name = name;
+    return *this;
+}
+
+ComputePipeline::ComputePipeline(const ComputePipelineCreation& creation, const std::shared_ptr<VulkanContext>& vulkanContext)
+    : _vulkanContext(vulkanContext)
+    , _bindings(creation.bindings)
+    , _pushConstantSize(creation.pushConstantSize)
+{
+    const vk::Device device = _vulkanContext->Device();
+
+    vk::DescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo {};
+    descriptorSetLayoutCreateInfo.bindingCount = static_cast<uint32_t>(_bindings.size());
+    descriptorSetLayoutCreateInfo.pBindings = _bindings.data();
+    _descriptorSetLayout = device.createDescriptorSetLayout(descriptorSetLayoutCreateInfo);
+
+    // One pool size per binding, descriptors of the same type are simply counted more than once
+    std::vector<vk::DescriptorPoolSize> poolSizes {};
+    for (const vk::DescriptorSetLayoutBinding& binding : _bindings)
+    {
+        poolSizes.emplace_back(binding.descriptorType, binding.descriptorCount);
+    }
+
+    if (!poolSizes.empty())
+    {
+        vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo {};
+        descriptorPoolCreateInfo.maxSets = 1;
+        descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+        descriptorPoolCreateInfo.pPoolSizes = poolSizes.data();
+        _descriptorPool = device.createDescriptorPool(descriptorPoolCreateInfo);
+
+        vk::DescriptorSetAllocateInfo descriptorSetAllocateInfo {};
+        descriptorSetAllocateInfo.descriptorPool = _descriptorPool;
+        descriptorSetAllocateInfo.descriptorSetCount = 1;
+        descriptorSetAllocateInfo.pSetLayouts = &_descriptorSetLayout;
+        _descriptorSet = device.allocateDescriptorSets(descriptorSetAllocateInfo).front();
+        VkNameObject(_descriptorSet, creation.name + " Descriptor Set", _vulkanContext);
+    }
+
+    vk::PushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eCompute;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = _pushConstantSize;
+
+    vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
+    pipelineLayoutCreateInfo.setLayoutCount = 1;
+    pipelineLayoutCreateInfo.pSetLayouts = &_descriptorSetLayout;
+    pipelineLayoutCreateInfo.pushConstantRangeCount = _pushConstantSize > 0 ? 1 : 0;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+    _pipelineLayout = device.createPipelineLayout(pipelineLayoutCreateInfo);
+
+    vk::ShaderModule shaderModule = Shader::CreateShaderModule(creation.shaderPath, device);
+
+    vk::ComputePipelineCreateInfo pipelineCreateInfo {};
+    pipelineCreateInfo.stage.stage = vk::ShaderStageFlagBits::eCompute;
+    pipelineCreateInfo.stage.module = shaderModule;
+    pipelineCreateInfo.stage.pName = "main";
+    pipelineCreateInfo.layout = _pipelineLayout;
+
+    const auto result = device.createComputePipeline(nullptr, pipelineCreateInfo);
+    VkCheckResult(result.result, "[VULKAN] Failed creating compute pipeline!");
+    _pipeline = result.value;
+    VkNameObject(_pipeline, creation.name, _vulkanContext);
+
+    device.destroyShaderModule(shaderModule);
+}
+
+ComputePipeline::~ComputePipeline()
+{
+    const vk::Device device = _vulkanContext->Device();
+    device.destroyPipeline(_pipeline);
+    device.destroyPipelineLayout(_pipelineLayout);
+    device.destroyDescriptorSetLayout(_descriptorSetLayout);
+    device.destroyDescriptorPool(_descriptorPool);
+}
+
+void ComputePipeline::WriteDescriptor(uint32_t binding, vk::ImageView imageView, uint32_t arrayElement, vk::ImageLayout layout, vk::Sampler sampler) const
+{
+    vk::DescriptorImageInfo imageInfo {};
+    imageInfo.imageView = imageView;
+    imageInfo.imageLayout = layout;
+    imageInfo.sampler = sampler;
+
+    vk::WriteDescriptorSet descriptorWrite {};
+    descriptorWrite.dstSet = _descriptorSet;
+    descriptorWrite.dstBinding = binding;
+    descriptorWrite.dstArrayElement = arrayElement;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.descriptorType = BindingType(binding);
+    descriptorWrite.pImageInfo = &imageInfo;
+
+    _vulkanContext->Device().updateDescriptorSets(1, &descriptorWrite, 0, nullptr);
+}
+
+void ComputePipeline::WriteDescriptor(uint32_t binding, vk::Buffer buffer, vk::DeviceSize range) const
+{
+    vk::DescriptorBufferInfo bufferInfo {};
+    bufferInfo.buffer = buffer;
+    bufferInfo.offset = 0;
+    bufferInfo.range = range;
+
+    vk::WriteDescriptorSet descriptorWrite {};
+    descriptorWrite.dstSet = _descriptorSet;
+    descriptorWrite.dstBinding = binding;
+    descriptorWrite.dstArrayElement = 0;
+    descriptorWrite.descriptorCount = 1;
+    descriptorWrite.descriptorType = BindingType(binding);
+    descriptorWrite.pBufferInfo = &bufferInfo;
+
+    _vulkanContext->Device().updateDescriptorSets(1, &descriptorWrite, 0, nullptr);
+}
+
+void ComputePipeline::Dispatch(vk::CommandBuffer commandBuffer, uint32_t width, uint32_t height, std::span<const std::byte> pushConstants, uint32_t workgroupSize) const
+{
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, _pipeline);
+    if (_descriptorSet)
+    {
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, _pipelineLayout, 0, _descriptorSet, nullptr);
+    }
+    if (!pushConstants.empty())
+    {
+        commandBuffer.pushConstants(_pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, static_cast<uint32_t>(pushConstants.size()), pushConstants.data());
+    }
+
+    commandBuffer.dispatch((width + workgroupSize - 1) / workgroupSize, (height + workgroupSize - 1) / workgroupSize, 1);
+}
+
+vk::DescriptorType ComputePipeline::BindingType(uint32_t binding) const
+{
+    const auto it = std::find_if(_bindings.begin(), _bindings.end(), [binding](const vk::DescriptorSetLayoutBinding& layoutBinding)
+        { return layoutBinding.binding == binding; });
+    if (it == _bindings.end())
+    {
+        spdlog::error("[VULKAN] Compute pipeline has no binding {}", binding);
+        return vk::DescriptorType::eStorageImage;
+    }
+    return it->descriptorType;
+}
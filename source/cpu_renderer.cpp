@@ -0,0 +1,685 @@
+#include "cpu_renderer.hpp"
+#include "bvh/bvh_builder.hpp"
+#include "bvh/ray_packet.hpp"
+#include "camera.hpp"
+#include "gltf_loader.hpp"
+#include "resources/gpu_resources.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+#include <stb_image_write.h>
+
+namespace
+{
+// Packets cover a block of pixels so neighbouring rays stay coherent
+constexpr uint32_t PACKET_WIDTH = SIMD_WIDTH / 2;
+constexpr uint32_t PACKET_HEIGHT = 2;
+
+// Constants of the shaders the path tracing loop is ported from
+constexpr float PI = 3.14159265f;
+constexpr float RAY_T_MIN = 0.001f;
+constexpr float RAY_T_MAX = 10000.0f;
+constexpr uint32_t NO_LIGHT = 0xFFFFFFFFu;
+const glm::vec3 DEFAULT_ENVIRONMENT_RADIANCE { 0.25f };
+
+// The random sampler of shaders/sampling.glsl, so the same pixel and frame draw the same numbers as on the GPU
+uint32_t PcgHash(uint32_t value)
+{
+    const uint32_t state = value * 747796405u + 2891336453u;
+    const uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+glm::uvec2 SampleUint2D(uint32_t& state)
+{
+    state = PcgHash(state);
+    const uint32_t first = state;
+    state = PcgHash(state);
+    return { first, state };
+}
+
+glm::vec2 Sample2D(uint32_t& state)
+{
+    return glm::vec2(SampleUint2D(state) >> 8u) * (1.0f / 16777216.0f);
+}
+
+float Sample1D(uint32_t& state)
+{
+    return Sample2D(state).x;
+}
+
+float Luminance(const glm::vec3& color)
+{
+    return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+glm::vec3 LinearToSrgb(const glm::vec3& color)
+{
+    return glm::mix(color * 12.92f, 1.055f * glm::pow(color, glm::vec3(1.0f / 2.4f)) - 0.055f, glm::greaterThan(color, glm::vec3(0.0031308f)));
+}
+
+glm::vec3 AcesFitted(const glm::vec3& color)
+{
+    return (color * (2.51f * color + 0.03f)) / (color * (2.43f * color + 0.59f) + 0.14f);
+}
+
+glm::vec3 SampleCosineHemisphere(const glm::vec3& normal, glm::vec2 u)
+{
+    const float radius = std::sqrt(u.x);
+    const float phi = 2.0f * PI * u.y;
+
+    const glm::vec3 helper = std::abs(normal.x) > 0.9f ? glm::vec3(0.0f, 1.0f, 0.0f) : glm::vec3(1.0f, 0.0f, 0.0f);
+    const glm::vec3 tangent = glm::normalize(glm::cross(helper, normal));
+    const glm::vec3 bitangent = glm::cross(normal, tangent);
+
+    return glm::normalize(tangent * radius * std::cos(phi) + bitangent * radius * std::sin(phi) + normal * std::sqrt(std::max(0.0f, 1.0f - u.x)));
+}
+
+float PowerHeuristic(float pdf, float otherPdf)
+{
+    const float pdfSquared = pdf * pdf;
+    const float sum = pdfSquared + otherPdf * otherPdf;
+    return sum > 0.0f ? pdfSquared / sum : 0.0f;
+}
+
+glm::vec3 LightNormal(const TriangleLight& light)
+{
+    return glm::normalize(glm::cross(light.p1 - light.p0, light.p2 - light.p0));
+}
+
+float LightPdf(const TriangleLight& light, float distanceSquared, float lightCosine)
+{
+    return light.selectionPdf * distanceSquared / (light.area * std::max(lightCosine, 1e-6f));
+}
+
+glm::vec2 DirectionToEquirectangular(const glm::vec3& direction)
+{
+    return { std::atan2(direction.z, direction.x) / (2.0f * PI) + 0.5f, std::acos(std::clamp(direction.y, -1.0f, 1.0f)) / PI };
+}
+
+glm::vec3 EquirectangularToDirection(glm::vec2 uv)
+{
+    const float phi = (uv.x - 0.5f) * 2.0f * PI;
+    const float theta = uv.y * PI;
+    return { std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+}
+
+glm::ivec2 EnvironmentTexel(const EnvironmentMap& environmentMap, glm::vec2 uv)
+{
+    const glm::ivec2 size { environmentMap.width, environmentMap.height };
+    return glm::clamp(glm::ivec2(uv * glm::vec2(size)), glm::ivec2(0), size - 1);
+}
+
+glm::vec3 EnvironmentTexelRadiance(const EnvironmentMap& environmentMap, glm::ivec2 texel)
+{
+    return glm::vec3(environmentMap.texels[static_cast<size_t>(texel.y) * environmentMap.width + texel.x]);
+}
+
+float EnvironmentTexelPdf(const EnvironmentMap& environmentMap, float pdfScale, glm::ivec2 texel, const glm::vec3& radiance, float sinTheta)
+{
+    const float rowSinTheta = std::sin(PI * (static_cast<float>(texel.y) + 0.5f) / static_cast<float>(environmentMap.height));
+    return sinTheta > 0.0f ? std::max(Luminance(radiance), 0.0f) * rowSinTheta * pdfScale / sinTheta : 0.0f;
+}
+}
+
+CpuRenderer::CpuRenderer(const RendererSettings& rendererSettings, const std::shared_ptr<ThreadPool>& threadPool, const CpuRendererSettings& settings)
+    : _settings(settings)
+    , _rendererSettings(rendererSettings)
+    , _threadPool(threadPool)
+{
+    _settings.tileSize = std::max(_settings.tileSize, PACKET_HEIGHT);
+    _framebuffer.resize(static_cast<size_t>(_settings.width) * _settings.height);
+    _accumulation.resize(_framebuffer.size());
+
+    SetCameraView(Camera::DefaultView());
+    _projInverse = glm::inverse(glm::perspective(glm::radians(60.0f), static_cast<float>(_settings.width) / static_cast<float>(_settings.height), 0.1f, 512.0f));
+
+    LoadScene(_rendererSettings.scene);
+    LoadEnvironment(_rendererSettings.environmentMap);
+}
+
+CpuRenderer::~CpuRenderer() = default;
+
+void CpuRenderer::SetCameraView(const glm::mat4& view)
+{
+    _viewInverse = glm::inverse(view);
+    _accumulatedSamples = 0;
+}
+
+void CpuRenderer::Render()
+{
+    const auto renderStart = std::chrono::high_resolution_clock::now();
+
+    const uint32_t tilesX = (_settings.width + _settings.tileSize - 1) / _settings.tileSize;
+    const uint32_t tilesY = (_settings.height + _settings.tileSize - 1) / _settings.tileSize;
+    const uint32_t tileCount = tilesX * tilesY;
+
+    _rayCount = 0;
+    std::atomic<uint32_t> nextTile { 0 };
+
+    // Workers pull tiles until none are left, which balances tiles of uneven cost across cores
+    std::vector<std::future<void>> workers {};
+    for (uint32_t i = 0; i < _threadPool->ThreadCount(); ++i)
+    {
+        workers.push_back(_threadPool->Submit([this, &nextTile, tileCount]()
+            {
+                for (uint32_t tile = nextTile++; tile < tileCount; tile = nextTile++)
+                {
+                    RenderTile(tile);
+                } }));
+    }
+
+    for (auto& worker : workers)
+    {
+        _threadPool->Wait(worker);
+        worker.get();
+    }
+
+    const std::chrono::duration<double, std::milli> renderDuration = std::chrono::high_resolution_clock::now() - renderStart;
+    ++_accumulatedSamples;
+    _lastFrameStatistics.rayCount = _rayCount;
+    _lastFrameStatistics.durationMs = renderDuration.count();
+}
+
+bool CpuRenderer::SaveImage(const std::string& path) const
+{
+    const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty())
+    {
+        std::error_code error {};
+        std::filesystem::create_directories(parent, error);
+    }
+
+    const int stride = static_cast<int>(_settings.width * sizeof(uint32_t));
+    if (stbi_write_png(path.c_str(), static_cast<int>(_settings.width), static_cast<int>(_settings.height), 4, _framebuffer.data(), stride) == 0)
+    {
+        spdlog::error("[FILE] Failed writing image to {}", path);
+        return false;
+    }
+
+    spdlog::info("[FILE] Wrote CPU render to {}", path);
+    return true;
+}
+
+void CpuRenderer::LoadScene(const std::vector<std::string>& scene)
+{
+    GLTFLoader loader { nullptr, nullptr };
+    std::vector<BVHTriangle> triangles {};
+    std::vector<EmissiveTriangle> emissiveTriangles {};
+
+    for (const auto& modelPath : scene)
+    {
+        std::shared_ptr<Model> model = loader.LoadFromFile(modelPath);
+        if (model == nullptr)
+        {
+            continue;
+        }
+
+        const auto textureOffset = static_cast<uint32_t>(_textures.size());
+        const auto materialOffset = static_cast<uint32_t>(_materials.size());
+
+        _textures.insert(_textures.end(), model->hostImages.begin(), model->hostImages.end());
+        for (Material material : model->hostMaterials)
+        {
+            if (material.useAlbedoMap)
+            {
+                material.albedoMapIndex += textureOffset;
+            }
+            if (material.useEmissiveMap)
+            {
+                material.emissiveMapIndex += textureOffset;
+            }
+            _materials.push_back(material);
+        }
+
+        ExtractTriangles(*model, triangles, glm::mat4(1.0f), static_cast<uint32_t>(_geometries.size()));
+
+        // Same geometry order as the triangles and the GPU geometry nodes, emissive geometries take their lights in that order too
+        auto nextLightIndex = static_cast<uint32_t>(emissiveTriangles.size());
+        for (const auto& node : model->nodes)
+        {
+            if (!node.meshIndex.has_value())
+            {
+                continue;
+            }
+
+            const Mesh& mesh = model->meshes[node.meshIndex.value()];
+            const uint32_t materialIndex = mesh.material.IsNull() ? NULL_RESOURCE_INDEX_VALUE : materialOffset + mesh.material.handle;
+            _geometries.push_back({ model, mesh.firstIndex, materialIndex, mesh.emissive ? nextLightIndex : NO_LIGHT });
+            if (mesh.emissive)
+            {
+                nextLightIndex += mesh.indexCount / 3;
+            }
+        }
+
+        for (EmissiveTriangle triangle : model->emissiveTriangles)
+        {
+            triangle.material = ResourceHandle<Material> { materialOffset + triangle.material.handle };
+            emissiveTriangles.push_back(triangle);
+        }
+
+        _models.push_back(std::move(model));
+    }
+
+    BVHBuildSettings buildSettings {};
+    buildSettings.threadPool = _threadPool;
+    _bvh = BVHBuilder { buildSettings }.Build(std::move(triangles));
+
+    spdlog::info("[CPU] Built scene BVH over {} triangles in {:.2f} ms, {} nodes, SAH cost {:.2f}",
+        _bvh.triangles.size(), _bvh.metrics.buildTimeMs, _bvh.metrics.nodeCount, _bvh.metrics.sahCost);
+
+    _lights = BuildTriangleLights(emissiveTriangles);
+    spdlog::info("[CPU] {} emissive triangles", _lights.size());
+}
+
+void CpuRenderer::LoadEnvironment(const std::string& path)
+{
+    if (path.empty())
+    {
+        return;
+    }
+
+    _environmentMap = LoadEnvironmentMap(path);
+    if (!_environmentMap.has_value())
+    {
+        return;
+    }
+
+    BuildEnvironmentSampling(*_environmentMap);
+    _environmentPdfScale = _rendererSettings.environmentImportanceSampling ? _environmentMap->pdfScale : 0.0f;
+}
+
+void CpuRenderer::RenderTile(uint32_t tileIndex)
+{
+    const uint32_t tilesX = (_settings.width + _settings.tileSize - 1) / _settings.tileSize;
+    const uint32_t minX = (tileIndex % tilesX) * _settings.tileSize;
+    const uint32_t minY = (tileIndex / tilesX) * _settings.tileSize;
+    const uint32_t maxX = std::min(minX + _settings.tileSize, _settings.width);
+    const uint32_t maxY = std::min(minY + _settings.tileSize, _settings.height);
+
+    _rayCount += _settings.packetTraversal
+        ? RenderTilePackets(minX, minY, maxX, maxY)
+        : RenderTileSingleRays(minX, minY, maxX, maxY);
+}
+
+uint64_t CpuRenderer::RenderTilePackets(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY)
+{
+    uint64_t rayCount = 0;
+
+    for (uint32_t y = minY; y < maxY; y += PACKET_HEIGHT)
+    {
+        for (uint32_t x = minX; x < maxX; x += PACKET_WIDTH)
+        {
+            RayPacket packet {};
+            std::array<Ray, SIMD_WIDTH> rays {};
+            std::array<uint32_t, SIMD_WIDTH> sampleStates {};
+            for (uint32_t lane = 0; lane < SIMD_WIDTH; ++lane)
+            {
+                // Lanes past the edge of the image duplicate the last pixel and are not written back
+                const uint32_t pixelX = std::min(x + lane % PACKET_WIDTH, maxX - 1);
+                const uint32_t pixelY = std::min(y + lane / PACKET_WIDTH, maxY - 1);
+                sampleStates[lane] = InitSampler(pixelX, pixelY);
+                rays[lane] = GenerateCameraRay(pixelX, pixelY, Sample2D(sampleStates[lane]));
+                packet.SetRay(lane, rays[lane].origin, rays[lane].direction);
+                packet.tMin = rays[lane].tMin;
+                packet.tMax = rays[lane].tMax;
+            }
+
+            RayPacketHit packetHit {};
+            IntersectPacket(_bvh, packet, packetHit);
+
+            for (uint32_t lane = 0; lane < SIMD_WIDTH; ++lane)
+            {
+                const uint32_t pixelX = x + lane % PACKET_WIDTH;
+                const uint32_t pixelY = y + lane / PACKET_WIDTH;
+                if (pixelX >= maxX || pixelY >= maxY)
+                {
+                    continue;
+                }
+
+                const RayHit hit { packetHit.t[lane], packetHit.u[lane], packetHit.v[lane], packetHit.triangleIndex[lane] };
+                ++rayCount;
+                AccumulatePixel(pixelX, pixelY, TracePath(rays[lane], hit, sampleStates[lane], rayCount));
+            }
+        }
+    }
+
+    return rayCount;
+}
+
+uint64_t CpuRenderer::RenderTileSingleRays(uint32_t minX, uint32_t minY, uint32_t maxX, uint32_t maxY)
+{
+    uint64_t rayCount = 0;
+
+    for (uint32_t y = minY; y < maxY; ++y)
+    {
+        for (uint32_t x = minX; x < maxX; ++x)
+        {
+            uint32_t sampleState = InitSampler(x, y);
+            const Ray ray = GenerateCameraRay(x, y, Sample2D(sampleState));
+
+            RayHit hit {};
+            static_cast<void>(_bvh.Intersect(ray, hit));
+            ++rayCount;
+            AccumulatePixel(x, y, TracePath(ray, hit, sampleState, rayCount));
+        }
+    }
+
+    return rayCount;
+}
+
+uint32_t CpuRenderer::InitSampler(uint32_t x, uint32_t y) const
+{
+    const uint32_t random = PcgHash(PcgHash(y * _settings.width + x) ^ PcgHash(_accumulatedSamples));
+    return PcgHash(random ^ _rendererSettings.samplerSeed);
+}
+
+Ray CpuRenderer::GenerateCameraRay(uint32_t x, uint32_t y, glm::vec2 jitter) const
+{
+    const glm::vec2 pixelCenter = glm::vec2(x, y) + jitter;
+    const glm::vec2 uv = pixelCenter / glm::vec2(_settings.width, _settings.height);
+    const glm::vec2 d = uv * 2.0f - 1.0f;
+
+    const glm::vec4 origin = _viewInverse * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    const glm::vec4 target = _projInverse * glm::vec4(d.x, d.y, 1.0f, 1.0f);
+    const glm::vec4 direction = _viewInverse * glm::vec4(glm::normalize(glm::vec3(target)), 0.0f);
+
+    Ray ray {};
+    ray.origin = glm::vec3(origin);
+    ray.direction = glm::vec3(direction);
+    ray.tMin = RAY_T_MIN;
+    ray.tMax = RAY_T_MAX;
+    return ray;
+}
+
+glm::vec3 CpuRenderer::TracePath(Ray ray, RayHit hit, uint32_t& sampleState, uint64_t& rayCount) const
+{
+    const bool sampleLights = _rendererSettings.emissiveLightSampling && !_lights.empty();
+    const glm::vec3 sunDirection = glm::normalize(_rendererSettings.sunDirection);
+
+    glm::vec3 radiance { 0.0f };
+    glm::vec3 throughput { 1.0f };
+    // Solid angle density of the bounce that produced the current ray, camera rays can't be light sampled
+    float bouncePdf = 0.0f;
+
+    for (uint32_t depth = 0; depth < _rendererSettings.maxPathDepth; ++depth)
+    {
+        // Camera rays are traced by the caller, which can trace them as packets
+        if (depth > 0)
+        {
+            hit = {};
+            static_cast<void>(_bvh.Intersect(ray, hit));
+            ++rayCount;
+        }
+
+        if (!hit.IsHit())
+        {
+            glm::vec3 emission = EnvironmentRadiance(ray.direction);
+            if (_environmentPdfScale > 0.0f && bouncePdf > 0.0f)
+            {
+                emission *= PowerHeuristic(bouncePdf, EnvironmentPdf(ray.direction));
+            }
+            radiance += throughput * emission;
+            break;
+        }
+
+        const Surface surface = ShadeHit(hit, ray.direction);
+        glm::vec3 emission = surface.emission;
+        if (sampleLights && surface.lightIndex != NO_LIGHT && bouncePdf > 0.0f)
+        {
+            // The previous vertex sampled this light as well, weight both strategies with the power heuristic
+            const TriangleLight& light = _lights[surface.lightIndex];
+            const float lightPdf = LightPdf(light, hit.t * hit.t, std::abs(glm::dot(LightNormal(light), ray.direction)));
+            emission *= PowerHeuristic(bouncePdf, lightPdf);
+        }
+        radiance += throughput * emission;
+
+        const glm::vec3 hitPosition = ray.origin + ray.direction * hit.t + surface.normal * 1e-4f;
+
+        // Next event estimation towards the sun, it can't be hit by bounce rays so there is no double counting
+        const float sunCosine = glm::dot(surface.normal, sunDirection);
+        if (sunCosine > 0.0f)
+        {
+            ++rayCount;
+            if (!_bvh.Occluded({ hitPosition, RAY_T_MIN, sunDirection, RAY_T_MAX }))
+            {
+                radiance += throughput * surface.albedo / PI * _rendererSettings.sunIrradiance * sunCosine;
+            }
+        }
+
+        const bool bounceFollows = depth + 1 < _rendererSettings.maxPathDepth;
+        if (sampleLights)
+        {
+            radiance += throughput * surface.albedo * SampleTriangleLights(hitPosition, surface.normal, bounceFollows, sampleState, rayCount);
+        }
+        if (_environmentPdfScale > 0.0f)
+        {
+            radiance += throughput * surface.albedo * SampleEnvironmentLight(hitPosition, surface.normal, bounceFollows, sampleState, rayCount);
+        }
+
+        // Lambertian bounce, the cosine weighted pdf cancels out everything but the albedo
+        throughput *= surface.albedo;
+
+        if (depth >= _rendererSettings.russianRouletteDepth)
+        {
+            const float survivalProbability = std::min(std::max(throughput.r, std::max(throughput.g, throughput.b)), 0.95f);
+            if (Sample1D(sampleState) >= survivalProbability)
+            {
+                break;
+            }
+            throughput /= survivalProbability;
+        }
+
+        ray.origin = hitPosition;
+        ray.direction = SampleCosineHemisphere(surface.normal, Sample2D(sampleState));
+        bouncePdf = std::max(glm::dot(surface.normal, ray.direction), 0.0f) / PI;
+    }
+
+    return radiance;
+}
+
+CpuRenderer::Surface CpuRenderer::ShadeHit(const RayHit& hit, const glm::vec3& direction) const
+{
+    const BVHTriangle& triangle = _bvh.triangles[hit.triangleIndex];
+    const Geometry& geometry = _geometries[triangle.geometryIndex];
+
+    const uint32_t* indices = geometry.model->indices.data() + geometry.firstIndex + triangle.primitiveIndex * 3;
+    const glm::vec3 barycentrics { 1.0f - hit.u - hit.v, hit.u, hit.v };
+
+    glm::vec3 normal {};
+    glm::vec2 texCoord {};
+    for (uint32_t i = 0; i < 3; ++i)
+    {
+        const Model::Vertex& vertex = geometry.model->vertices[indices[i]];
+        normal += vertex.normal * barycentrics[i];
+        texCoord += vertex.texCoord * barycentrics[i];
+    }
+
+    Surface surface {};
+    surface.normal = glm::normalize(normal);
+    surface.normal = glm::dot(surface.normal, direction) > 0.0f ? -surface.normal : surface.normal;
+    surface.lightIndex = geometry.firstLightIndex == NO_LIGHT ? NO_LIGHT : geometry.firstLightIndex + triangle.primitiveIndex;
+
+    if (geometry.materialIndex == NULL_RESOURCE_INDEX_VALUE)
+    {
+        return surface;
+    }
+
+    // Matches the closest hit shader, textures are linearized before applying the factors
+    const Material& material = _materials[geometry.materialIndex];
+    glm::vec4 albedo { 1.0f };
+    if (material.useAlbedoMap)
+    {
+        albedo = glm::pow(SampleTexture(material.albedoMapIndex, texCoord), glm::vec4(2.2f));
+    }
+    surface.albedo = glm::vec3(albedo * material.albedoFactor);
+
+    surface.emission = material.emissiveFactor;
+    if (material.useEmissiveMap)
+    {
+        surface.emission *= glm::pow(glm::vec3(SampleTexture(material.emissiveMapIndex, texCoord)), glm::vec3(2.2f));
+    }
+
+    return surface;
+}
+
+glm::vec3 CpuRenderer::SampleTriangleLights(const glm::vec3& position, const glm::vec3& normal, bool bounceFollows, uint32_t& sampleState, uint64_t& rayCount) const
+{
+    // Alias table lookup of shaders/lights.glsl
+    const float scaled = Sample1D(sampleState) * static_cast<float>(_lights.size());
+    const uint32_t index = std::min(static_cast<uint32_t>(scaled), static_cast<uint32_t>(_lights.size() - 1));
+    const TriangleLight& light = _lights[scaled - static_cast<float>(index) < _lights[index].aliasProbability ? index : _lights[index].alias];
+
+    // Uniformly distributed point on the triangle, see "Shape Distributions" (Osada et al., 2002)
+    const glm::vec2 u = Sample2D(sampleState);
+    const float root = std::sqrt(u.x);
+    const glm::vec3 barycentrics { 1.0f - root, root * (1.0f - u.y), root * u.y };
+    if (light.selectionPdf <= 0.0f)
+    {
+        return glm::vec3(0.0f);
+    }
+
+    glm::vec3 toLight = light.p0 * barycentrics.x + light.p1 * barycentrics.y + light.p2 * barycentrics.z - position;
+    const float distanceSquared = glm::dot(toLight, toLight);
+    const float distance = std::sqrt(distanceSquared);
+    toLight /= distance;
+
+    const float surfaceCosine = glm::dot(normal, toLight);
+    const float lightCosine = std::abs(glm::dot(LightNormal(light), toLight));
+    if (surfaceCosine <= 0.0f || lightCosine <= 0.0f)
+    {
+        return glm::vec3(0.0f);
+    }
+
+    ++rayCount;
+    if (_bvh.Occluded({ position, RAY_T_MIN, toLight, distance * 0.999f }))
+    {
+        return glm::vec3(0.0f);
+    }
+
+    const float lightPdf = LightPdf(light, distanceSquared, lightCosine);
+    const float misWeight = bounceFollows ? PowerHeuristic(lightPdf, surfaceCosine / PI) : 1.0f;
+    return LightEmission(light, barycentrics) * surfaceCosine / PI / lightPdf * misWeight;
+}
+
+glm::vec3 CpuRenderer::SampleEnvironmentLight(const glm::vec3& position, const glm::vec3& normal, bool bounceFollows, uint32_t& sampleState, uint64_t& rayCount) const
+{
+    const EnvironmentMap& environmentMap = *_environmentMap;
+    const glm::uvec2 texelSample = SampleUint2D(sampleState);
+    const glm::vec2 offset = Sample2D(sampleState);
+
+    // Texel from the alias table and a uniformly distributed point in it, like SampleEnvironment in shaders/environment.glsl
+    const uint32_t index = texelSample.x % (environmentMap.width * environmentMap.height);
+    const AliasTableEntry& entry = environmentMap.aliasTable[index];
+    const uint32_t texelIndex = static_cast<float>(texelSample.y >> 8u) * (1.0f / 16777216.0f) < entry.probability ? index : entry.alias;
+
+    const glm::ivec2 texel { texelIndex % environmentMap.width, texelIndex / environmentMap.width };
+    const glm::vec2 uv = (glm::vec2(texel) + offset) / glm::vec2(environmentMap.width, environmentMap.height);
+    const glm::vec3 toLight = EquirectangularToDirection(uv);
+    const glm::vec3 radiance = EnvironmentTexelRadiance(environmentMap, texel);
+    const float environmentPdf = EnvironmentTexelPdf(environmentMap, _environmentPdfScale, texel, radiance, std::sin(uv.y * PI));
+
+    const float surfaceCosine = glm::dot(normal, toLight);
+    if (environmentPdf <= 0.0f || surfaceCosine <= 0.0f)
+    {
+        return glm::vec3(0.0f);
+    }
+
+    ++rayCount;
+    if (_bvh.Occluded({ position, RAY_T_MIN, toLight, RAY_T_MAX }))
+    {
+        return glm::vec3(0.0f);
+    }
+
+    const float misWeight = bounceFollows ? PowerHeuristic(environmentPdf, surfaceCosine / PI) : 1.0f;
+    return radiance * surfaceCosine / PI / environmentPdf * misWeight;
+}
+
+glm::vec3 CpuRenderer::LightEmission(const TriangleLight& light, const glm::vec3& barycentrics) const
+{
+    const Material& material = _materials[light.materialIndex];
+    const glm::vec2 texCoord = light.uv0 * barycentrics.x + light.uv1 * barycentrics.y + light.uv2 * barycentrics.z;
+
+    glm::vec3 emission = material.emissiveFactor;
+    if (material.useEmissiveMap)
+    {
+        emission *= glm::pow(glm::vec3(SampleTexture(material.emissiveMapIndex, texCoord)), glm::vec3(2.2f));
+    }
+    return emission;
+}
+
+glm::vec3 CpuRenderer::EnvironmentRadiance(const glm::vec3& direction) const
+{
+    if (!_environmentMap.has_value())
+    {
+        return DEFAULT_ENVIRONMENT_RADIANCE;
+    }
+    return EnvironmentTexelRadiance(*_environmentMap, EnvironmentTexel(*_environmentMap, DirectionToEquirectangular(direction)));
+}
+
+float CpuRenderer::EnvironmentPdf(const glm::vec3& direction) const
+{
+    const glm::ivec2 texel = EnvironmentTexel(*_environmentMap, DirectionToEquirectangular(direction));
+    const glm::vec3 radiance = EnvironmentTexelRadiance(*_environmentMap, texel);
+    return EnvironmentTexelPdf(*_environmentMap, _environmentPdfScale, texel, radiance, std::sqrt(std::max(1.0f - direction.y * direction.y, 0.0f)));
+}
+
+glm::vec4 CpuRenderer::SampleTexture(uint32_t textureIndex, glm::vec2 texCoord) const
+{
+    const ImageCreation& texture = _textures[textureIndex];
+    if (texture.data.empty())
+    {
+        return glm::vec4(1.0f);
+    }
+
+    // Bilinear filtering with repeat addressing, like the bindless sampler
+    const glm::vec2 position = (texCoord - glm::floor(texCoord)) * glm::vec2(texture.width, texture.height) - 0.5f;
+    const glm::vec2 fraction = position - glm::floor(position);
+    const auto x0 = static_cast<int32_t>(glm::floor(position.x));
+    const auto y0 = static_cast<int32_t>(glm::floor(position.y));
+
+    const auto texel = [&texture](int32_t x, int32_t y)
+    {
+        const auto width = static_cast<int32_t>(texture.width);
+        const auto height = static_cast<int32_t>(texture.height);
+        x = ((x % width) + width) % width;
+        y = ((y % height) + height) % height;
+
+        const std::byte* data = texture.data.data() + (static_cast<size_t>(y) * texture.width + x) * 4;
+        return glm::vec4(std::to_integer<uint8_t>(data[0]), std::to_integer<uint8_t>(data[1]), std::to_integer<uint8_t>(data[2]), std::to_integer<uint8_t>(data[3])) / 255.0f;
+    };
+
+    const glm::vec4 top = glm::mix(texel(x0, y0), texel(x0 + 1, y0), fraction.x);
+    const glm::vec4 bottom = glm::mix(texel(x0, y0 + 1), texel(x0 + 1, y0 + 1), fraction.x);
+    return glm::mix(top, bottom, fraction.y);
+}
+
+void CpuRenderer::AccumulatePixel(uint32_t x, uint32_t y, const glm::vec3& radiance)
+{
+    const size_t index = static_cast<size_t>(y) * _settings.width + x;
+    const float sampleCount = static_cast<float>(_accumulatedSamples) + 1.0f;
+    glm::vec4& accumulated = _accumulation[index];
+    accumulated = glm::vec4(glm::mix(glm::vec3(accumulated), radiance, 1.0f / sampleCount), sampleCount);
+
+    // Display transform of shaders/tonemap.comp, the framebuffer holds display values so it always encodes sRGB
+    glm::vec3 color = glm::max(glm::vec3(accumulated) * std::exp2(_rendererSettings.exposure), glm::vec3(0.0f));
+    if (_rendererSettings.tonemapOperator == TonemapOperator::eReinhard)
+    {
+        color /= 1.0f + Luminance(color);
+    }
+    else if (_rendererSettings.tonemapOperator == TonemapOperator::eAces)
+    {
+        color = AcesFitted(color);
+    }
+    color = LinearToSrgb(glm::clamp(color, 0.0f, 1.0f));
+
+    const glm::uvec3 rgb = glm::uvec3(color * 255.0f + 0.5f);
+    _framebuffer[index] = rgb.r | (rgb.g << 8) | (rgb.b << 16) | (0xFFu << 24);
+}
@@ -0,0 +1,65 @@
+#include "environment_map.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <glm/geometric.hpp>
+#include <numbers>
+#include <spdlog/spdlog.h>
+#include <stb_image.h>
+#include <string>
+
+std::optional<EnvironmentMap> LoadEnvironmentMap(std::string_view path)
+{
+    if (path.ends_with(".exr"))
+    {
+        spdlog::error("[ENVIRONMENT] OpenEXR is not supported, convert [{}] to Radiance .hdr", path);
+        return std::nullopt;
+    }
+
+    const std::string pathString { path };
+    int width {};
+    int height {};
+    int channels {};
+    float* stbiData = stbi_loadf(pathString.c_str(), &width, &height, &channels, 4);
+    if (!stbiData)
+    {
+        spdlog::error("[ENVIRONMENT] Failed loading environment map from path [{}]: {}", path, stbi_failure_reason());
+        return std::nullopt;
+    }
+
+    EnvironmentMap environmentMap {};
+    environmentMap.width = static_cast<uint32_t>(width);
+    environmentMap.height = static_cast<uint32_t>(height);
+    environmentMap.texels.resize(environmentMap.width * environmentMap.height);
+    std::memcpy(environmentMap.texels.data(), stbiData, environmentMap.texels.size() * sizeof(glm::vec4));
+    stbi_image_free(stbiData);
+
+    return environmentMap;
+}
+
+void BuildEnvironmentSampling(EnvironmentMap& environmentMap)
+{
+    const uint32_t width = environmentMap.width;
+    const uint32_t height = environmentMap.height;
+
+    // Texels near the poles cover less solid angle, the sine of the row center accounts for it
+    std::vector<float> weights(environmentMap.texels.size());
+    double totalWeight = 0.0;
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const float sinTheta = std::sin(std::numbers::pi_v<float> * (static_cast<float>(y) + 0.5f) / static_cast<float>(height));
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const size_t index = static_cast<size_t>(y) * width + x;
+            const float luminance = glm::dot(glm::vec3(environmentMap.texels[index]), glm::vec3(0.2126f, 0.7152f, 0.0722f));
+            weights[index] = std::max(luminance, 0.0f) * sinTheta;
+            totalWeight += weights[index];
+        }
+    }
+
+    environmentMap.aliasTable = BuildAliasTable(weights);
+
+    // A texel spans 2 pi / width by pi / height in spherical coordinates, its solid angle is that area times the sine
+    constexpr double twoPiSquared = 2.0 * std::numbers::pi * std::numbers::pi;
+    environmentMap.pdfScale = totalWeight > 0.0 ? static_cast<float>(static_cast<double>(width) * height / (twoPiSquared * totalWeight)) : 0.0f;
+}
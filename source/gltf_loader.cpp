@@ -1,15 +1,20 @@
 #include "gltf_loader.hpp"
+#include "hash.hpp"
 #include "resources/bindless_resources.hpp"
 #include "resources/gpu_resources.hpp"
 #include "single_time_commands.hpp"
 #include "vk_common.hpp"
 #include <fastgltf/glm_element_traits.hpp>
 #include <fastgltf/tools.hpp>
+#include <functional>
 #include <glm/gtc/type_ptr.hpp>
 #include <spdlog/spdlog.h>
 #include <stb_image.h>
 
-ResourceHandle<Image> ProcessImage(const fastgltf::Asset& gltf, const fastgltf::Image& gltfImage, const std::shared_ptr<BindlessResources>& resources, const std::string_view directory)
+using CreateImageFunction = std::function<ResourceHandle<Image>(const ImageCreation&)>;
+using CreateMaterialFunction = std::function<ResourceHandle<Material>(const MaterialCreation&)>;
+
+ResourceHandle<Image> ProcessImage(const fastgltf::Asset& gltf, const fastgltf::Image& gltfImage, const CreateImageFunction& createImage, const std::string_view directory)
 {
     ImageCreation imageCreation {};
     imageCreation.SetName(gltfImage.name)
@@ -58,7 +63,7 @@ ResourceHandle<Image> ProcessImage(const fastgltf::Asset& gltf, const fastgltf::
                 imageCreation.SetSize(width, height)
                     .SetData(data);
 
-                return resources->Images().Create(imageCreation);
+                return createImage(imageCreation);
             },
             [&](const fastgltf::sources::Array& array)
             {
@@ -78,7 +83,7 @@ ResourceHandle<Image> ProcessImage(const fastgltf::Asset& gltf, const fastgltf::
                 imageCreation.SetSize(width, height)
                     .SetData(data);
 
-                return resources->Images().Create(imageCreation);
+                return createImage(imageCreation);
             },
             [&](fastgltf::sources::BufferView& view)
             {
@@ -104,7 +109,7 @@ ResourceHandle<Image> ProcessImage(const fastgltf::Asset& gltf, const fastgltf::
                                    imageCreation.SetSize(width, height)
                                        .SetData(data);
 
-                                   return resources->Images().Create(imageCreation);
+                                   return createImage(imageCreation);
                                },
                                failedImageLoad },
                     buffer.data);
@@ -113,7 +118,7 @@ ResourceHandle<Image> ProcessImage(const fastgltf::Asset& gltf, const fastgltf::
         gltfImage.data);
 }
 
-ResourceHandle<Material> ProcessMaterial(const fastgltf::Material& gltfMaterial, const std::vector<fastgltf::Texture>& gltfTextures, const std::vector<ResourceHandle<Image>>& textures, const std::shared_ptr<BindlessResources>& resources)
+ResourceHandle<Material> ProcessMaterial(const fastgltf::Material& gltfMaterial, const std::vector<fastgltf::Texture>& gltfTextures, const std::vector<ResourceHandle<Image>>& textures, const CreateMaterialFunction& createMaterial, MaterialFeatures& features)
 {
     auto MapTextureIndexToImageIndex = [](uint32_t textureIndex, const std::vector<fastgltf::Texture>& gltfTextures) -> uint32_t
     {
@@ -159,12 +164,15 @@ ResourceHandle<Material> ProcessMaterial(const fastgltf::Material& gltfMaterial,
         .SetEmissiveFactor(glm::vec3(gltfMaterial.emissiveFactor.x(), gltfMaterial.emissiveFactor.y(), gltfMaterial.emissiveFactor.z()))
         .SetOcclusionStrength(gltfMaterial.occlusionTexture.has_value()
                 ? gltfMaterial.occlusionTexture.value().strength
-                : 1.0f);
+                : 1.0f)
+        .SetAlphaMask(gltfMaterial.alphaMode == fastgltf::AlphaMode::Mask)
+        .SetAlphaCutoff(gltfMaterial.alphaCutoff);
 
-    return resources->Materials().Create(materialCreation);
+    features = materialCreation.Features();
+    return createMaterial(materialCreation);
 }
 
-Mesh ProcessMesh(const fastgltf::Asset& gltf, const fastgltf::Mesh& gltfMesh, const std::vector<ResourceHandle<Material>>& materials, std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices)
+Mesh ProcessMesh(const fastgltf::Asset& gltf, const fastgltf::Mesh& gltfMesh, const std::vector<ResourceHandle<Material>>& materials, const std::vector<MaterialFeatures>& materialFeatures, std::vector<Model::Vertex>& vertices, std::vector<uint32_t>& indices)
 {
     Mesh mesh {};
     mesh.firstIndex = indices.size();
@@ -236,6 +244,7 @@ Mesh ProcessMesh(const fastgltf::Asset& gltf, const fastgltf::Mesh& gltfMesh, co
             if (mesh.material.IsNull())
             {
                 mesh.material = materials[primitive.materialIndex.value()];
+                mesh.materialFeatures = materialFeatures[primitive.materialIndex.value()];
             }
             else
             {
@@ -331,15 +340,37 @@ std::shared_ptr<Model> GLTFLoader::LoadFromFile(std::string_view path)
 std::shared_ptr<Model> GLTFLoader::ProcessModel(const fastgltf::Asset& gltf, const std::string_view directory)
 {
     std::shared_ptr<Model> model = std::make_shared<Model>();
+    const bool hostOnly = _vulkanContext == nullptr;
+
+    CreateImageFunction createImage = [this](const ImageCreation& creation)
+    { return _bindlessResources->Images().Create(creation); };
+    CreateMaterialFunction createMaterial = [this](const MaterialCreation& creation)
+    { return _bindlessResources->Materials().Create(creation); };
+
+    if (hostOnly)
+    {
+        createImage = [&model](const ImageCreation& creation)
+        {
+            model->hostImages.push_back(creation);
+            return ResourceHandle<Image> { static_cast<uint32_t>(model->hostImages.size() - 1) };
+        };
+        createMaterial = [&model](const MaterialCreation& creation)
+        {
+            model->hostMaterials.emplace_back(creation);
+            return ResourceHandle<Material> { static_cast<uint32_t>(model->hostMaterials.size() - 1) };
+        };
+    }
 
     for (const fastgltf::Image& gltfImage : gltf.images)
     {
-        model->textures.push_back(ProcessImage(gltf, gltfImage, _bindlessResources, directory));
+        model->textures.push_back(ProcessImage(gltf, gltfImage, createImage, directory));
     }
 
-    for (const fastgltf::Material& gltfMaterial : gltf.materials)
+    // Materials are classified by the maps they sample, so geometries can be shaded by a matching specialized hit group
+    std::vector<MaterialFeatures> materialFeatures(gltf.materials.size());
+    for (size_t i = 0; i < gltf.materials.size(); ++i)
     {
-        model->materials.push_back(ProcessMaterial(gltfMaterial, gltf.textures, model->textures, _bindlessResources));
+        model->materials.push_back(ProcessMaterial(gltf.materials[i], gltf.textures, model->textures, createMaterial, materialFeatures[i]));
     }
 
     std::vector<Model::Vertex> vertices {};
@@ -347,14 +378,15 @@ std::shared_ptr<Model> GLTFLoader::ProcessModel(const fastgltf::Asset& gltf, con
 
     for (const fastgltf::Mesh& gltfMesh : gltf.meshes)
     {
-        model->meshes.push_back(ProcessMesh(gltf, gltfMesh, model->materials, vertices, indices));
+        model->meshes.push_back(ProcessMesh(gltf, gltfMesh, model->materials, materialFeatures, vertices, indices));
     }
 
+    model->verticesCount = vertices.size();
+    model->indexCount = indices.size();
+
     // Process vertex and index data
+    if (!hostOnly)
     {
-        model->verticesCount = vertices.size();
-        model->indexCount = indices.size();
-
         // Staging buffers
         BufferCreation vertexStagingBufferCreation {};
         vertexStagingBufferCreation.SetName(gltf.nodes[0].name + " - Vertex Staging Buffer")
@@ -393,15 +425,71 @@ std::shared_ptr<Model> GLTFLoader::ProcessModel(const fastgltf::Asset& gltf, con
             .SetSize(sizeof(uint32_t) * indices.size());
         model->indexBuffer = std::make_unique<Buffer>(indexBufferCreation, _vulkanContext);
 
-        SingleTimeCommands commands(_vulkanContext);
+        SingleTimeCommands commands(_vulkanContext, QueueType::eTransfer);
         commands.Record([&](vk::CommandBuffer commandBuffer)
             {
                 VkCopyBufferToBuffer(commandBuffer, vertexStagingBuffer.buffer, model->vertexBuffer->buffer, sizeof(Model::Vertex) * vertices.size());
                 VkCopyBufferToBuffer(commandBuffer, indexStagingBuffer.buffer, model->indexBuffer->buffer, sizeof(uint32_t) * indices.size()); });
-        commands.Submit();
+        model->uploadTimelineValue = commands.Submit();
     }
 
     model->nodes = ProcessNodes(gltf);
 
+    // Every triangle of an emissive mesh becomes a light, the BLAS assigns light offsets to its geometries in the same node order
+    for (Mesh& mesh : model->meshes)
+    {
+        if (!mesh.material.IsNull())
+        {
+            const Material& material = hostOnly ? model->hostMaterials[mesh.material.handle] : _bindlessResources->Materials().Get(mesh.material);
+            mesh.emissive = glm::any(glm::greaterThan(material.emissiveFactor, glm::vec3(0.0f)));
+        }
+    }
+
+    for (const auto& node : model->nodes)
+    {
+        if (!node.meshIndex.has_value() || !model->meshes[node.meshIndex.value()].emissive)
+        {
+            continue;
+        }
+
+        const Mesh& mesh = model->meshes[node.meshIndex.value()];
+        const Material& material = hostOnly ? model->hostMaterials[mesh.material.handle] : _bindlessResources->Materials().Get(mesh.material);
+        const glm::mat4 worldMatrix = node.GetWorldMatrix();
+
+        for (uint32_t i = 0; i < mesh.indexCount; i += 3)
+        {
+            EmissiveTriangle& triangle = model->emissiveTriangles.emplace_back();
+            for (uint32_t j = 0; j < 3; ++j)
+            {
+                const Model::Vertex& vertex = vertices[indices[mesh.firstIndex + i + j]];
+                triangle.positions[j] = glm::vec3(worldMatrix * glm::vec4(vertex.position, 1.0f));
+                triangle.texCoords[j] = vertex.texCoord;
+            }
+            triangle.material = mesh.material;
+            triangle.emission = material.emissiveFactor;
+        }
+    }
+
+    uint64_t contentHash = HashBytes(vertices.data(), vertices.size() * sizeof(Model::Vertex));
+    contentHash = HashBytes(indices.data(), indices.size() * sizeof(uint32_t), contentHash);
+    for (const auto& node : model->nodes)
+    {
+        if (!node.meshIndex.has_value())
+        {
+            continue;
+        }
+
+        const Mesh& mesh = model->meshes[node.meshIndex.value()];
+        contentHash = HashValue(mesh.firstIndex, contentHash);
+        contentHash = HashValue(mesh.indexCount, contentHash);
+        contentHash = HashValue(node.GetWorldMatrix(), contentHash);
+        // Opacity ends up in the geometry flags of the BLAS
+        contentHash = HashValue(HasMaterialFeature(mesh.materialFeatures, MaterialFeatures::eAlphaMask), contentHash);
+    }
+    model->contentHash = contentHash;
+
+    model->vertices = std::move(vertices);
+    model->indices = std::move(indices);
+
     return model;
 }
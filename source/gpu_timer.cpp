@@ -0,0 +1,139 @@
+#include "gpu_timer.hpp"
+#include "vulkan_context.hpp"
+#include <spdlog/spdlog.h>
+
+GpuTimer::GpuTimer(const std::shared_ptr<VulkanContext>& vulkanContext, uint32_t maxSectionsPerFrame)
+    : _vulkanContext(vulkanContext)
+    , _maxSectionsPerFrame(maxSectionsPerFrame)
+{
+    const vk::PhysicalDeviceLimits limits = _vulkanContext->PhysicalDevice().getProperties().limits;
+    _timestampPeriod = limits.timestampPeriod;
+    _supported = limits.timestampComputeAndGraphics;
+
+    if (!_supported)
+    {
+        spdlog::warn("[VULKAN] Timestamp queries are not supported, GPU timings will not be available");
+        return;
+    }
+
+    vk::QueryPoolCreateInfo queryPoolCreateInfo {};
+    queryPoolCreateInfo.queryType = vk::QueryType::eTimestamp;
+    queryPoolCreateInfo.queryCount = QueriesPerFrame() * MAX_FRAMES_IN_FLIGHT;
+    _queryPool = _vulkanContext->Device().createQueryPool(queryPoolCreateInfo);
+}
+
+GpuTimer::~GpuTimer()
+{
+    _vulkanContext->Device().destroyQueryPool(_queryPool);
+}
+
+void GpuTimer::ResolveFrame(uint32_t frameIndex)
+{
+    const std::vector<std::string>& sections = _frameSections.at(frameIndex);
+    if (!_supported || sections.empty())
+    {
+        return;
+    }
+
+    const uint32_t firstQuery = frameIndex * QueriesPerFrame();
+    std::vector<uint64_t> timestamps(sections.size() * 2);
+    const vk::Result result = _vulkanContext->Device().getQueryPoolResults(_queryPool, firstQuery, static_cast<uint32_t>(timestamps.size()),
+        timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+
+    if (result == vk::Result::eSuccess)
+    {
+        _resolvedSections.clear();
+        for (size_t i = 0; i < sections.size(); ++i)
+        {
+            const double ticks = static_cast<double>(timestamps[i * 2 + 1] - timestamps[i * 2]);
+            _resolvedSections.emplace_back(Section { sections[i], ticks * _timestampPeriod / 1e6 });
+        }
+    }
+
+    std::array<uint64_t, 2> frameBounds {};
+    const vk::Result boundsResult = _vulkanContext->Device().getQueryPoolResults(_queryPool, firstQuery + _maxSectionsPerFrame * 2, static_cast<uint32_t>(frameBounds.size()),
+        sizeof(frameBounds), frameBounds.data(), sizeof(uint64_t), vk::QueryResultFlagBits::e64);
+
+    if (boundsResult == vk::Result::eSuccess)
+    {
+        // Frames resolve in submission order, a start before the previous end means they overlapped rather than left a gap
+        const bool hasPreviousFrame = _previousFrameEndTicks != 0;
+        _idleBeforeFrameMs = hasPreviousFrame && frameBounds[0] > _previousFrameEndTicks
+            ? static_cast<double>(frameBounds[0] - _previousFrameEndTicks) * _timestampPeriod / 1e6
+            : 0.0;
+        _previousFrameEndTicks = frameBounds[1];
+    }
+}
+
+void GpuTimer::BeginFrame(vk::CommandBuffer commandBuffer, uint32_t frameIndex)
+{
+    _currentFrame = frameIndex;
+    if (!_supported)
+    {
+        return;
+    }
+
+    _frameSections.at(_currentFrame).clear();
+    const uint32_t firstQuery = _currentFrame * QueriesPerFrame();
+    commandBuffer.resetQueryPool(_queryPool, firstQuery, QueriesPerFrame());
+    commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, _queryPool, firstQuery + _maxSectionsPerFrame * 2);
+}
+
+void GpuTimer::EndFrame(vk::CommandBuffer commandBuffer)
+{
+    if (!_supported)
+    {
+        return;
+    }
+
+    commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, _queryPool, _currentFrame * QueriesPerFrame() + _maxSectionsPerFrame * 2 + 1);
+}
+
+void GpuTimer::BeginSection(vk::CommandBuffer commandBuffer, std::string_view name)
+{
+    std::vector<std::string>& sections = _frameSections.at(_currentFrame);
+    if (!_supported || sections.size() >= _maxSectionsPerFrame)
+    {
+        return;
+    }
+
+    const uint32_t query = _currentFrame * QueriesPerFrame() + static_cast<uint32_t>(sections.size()) * 2;
+    commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, _queryPool, query);
+    sections.emplace_back(name);
+}
+
+void GpuTimer::EndSection(vk::CommandBuffer commandBuffer)
+{
+    const std::vector<std::string>& sections = _frameSections.at(_currentFrame);
+    if (!_supported || sections.empty())
+    {
+        return;
+    }
+
+    const uint32_t query = _currentFrame * QueriesPerFrame() + (static_cast<uint32_t>(sections.size()) - 1) * 2 + 1;
+    commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, _queryPool, query);
+}
+
+double GpuTimer::SectionDurationMs(std::string_view name) const
+{
+    for (const Section& section : _resolvedSections)
+    {
+        if (section.name == name)
+        {
+            return section.durationMs;
+        }
+    }
+
+    return 0.0;
+}
+
+double GpuTimer::TotalDurationMs() const
+{
+    double totalMs = 0.0;
+    for (const Section& section : _resolvedSections)
+    {
+        totalMs += section.durationMs;
+    }
+
+    return totalMs;
+}
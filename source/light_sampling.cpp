@@ -0,0 +1,91 @@
+#include "light_sampling.hpp"
+#include <glm/geometric.hpp>
+#include <numeric>
+
+std::vector<AliasTableEntry> BuildAliasTable(std::span<const float> weights)
+{
+    std::vector<AliasTableEntry> table(weights.size());
+    const double totalWeight = std::accumulate(weights.begin(), weights.end(), 0.0);
+    if (totalWeight <= 0.0)
+    {
+        // Nothing to prefer, every entry keeps itself and is sampled uniformly
+        for (uint32_t i = 0; i < table.size(); ++i)
+        {
+            table[i].alias = i;
+        }
+        return table;
+    }
+
+    // Weights scaled to an average of one, entries below it are topped up by an alias from the entries above it
+    std::vector<double> scaledWeights(weights.size());
+    std::vector<uint32_t> small {};
+    std::vector<uint32_t> large {};
+    for (uint32_t i = 0; i < weights.size(); ++i)
+    {
+        scaledWeights[i] = weights[i] * static_cast<double>(weights.size()) / totalWeight;
+        (scaledWeights[i] < 1.0 ? small : large).push_back(i);
+    }
+
+    while (!small.empty() && !large.empty())
+    {
+        const uint32_t lower = small.back();
+        small.pop_back();
+        const uint32_t upper = large.back();
+
+        table[lower].probability = static_cast<float>(scaledWeights[lower]);
+        table[lower].alias = upper;
+
+        scaledWeights[upper] -= 1.0 - scaledWeights[lower];
+        if (scaledWeights[upper] < 1.0)
+        {
+            large.pop_back();
+            small.push_back(upper);
+        }
+    }
+
+    // Leftovers are one up to rounding errors
+    for (const uint32_t index : small)
+    {
+        table[index] = { 1.0f, index };
+    }
+    for (const uint32_t index : large)
+    {
+        table[index] = { 1.0f, index };
+    }
+
+    return table;
+}
+
+std::vector<TriangleLight> BuildTriangleLights(std::span<const EmissiveTriangle> triangles)
+{
+    std::vector<TriangleLight> lights(triangles.size());
+    std::vector<float> powers(triangles.size());
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        const EmissiveTriangle& triangle = triangles[i];
+        TriangleLight& light = lights[i];
+
+        light.p0 = triangle.positions[0];
+        light.p1 = triangle.positions[1];
+        light.p2 = triangle.positions[2];
+        light.uv0 = triangle.texCoords[0];
+        light.uv1 = triangle.texCoords[1];
+        light.uv2 = triangle.texCoords[2];
+        light.materialIndex = triangle.material.handle;
+        light.area = 0.5f * glm::length(glm::cross(light.p1 - light.p0, light.p2 - light.p0));
+
+        const float luminance = glm::dot(triangle.emission, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+        powers[i] = luminance * light.area;
+    }
+
+    const double totalPower = std::accumulate(powers.begin(), powers.end(), 0.0);
+    const std::vector<AliasTableEntry> aliasTable = BuildAliasTable(powers);
+    for (size_t i = 0; i < lights.size(); ++i)
+    {
+        lights[i].selectionPdf = totalPower > 0.0 ? static_cast<float>(powers[i] / totalPower) : 1.0f / static_cast<float>(lights.size());
+        lights[i].alias = aliasTable[i].alias;
+        lights[i].aliasProbability = aliasTable[i].probability;
+    }
+
+    return lights;
+}
@@ -0,0 +1,303 @@
+#include "offline_denoiser.hpp"
+#include "thread_pool.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+#include <stb_image_write.h>
+
+#ifdef ENABLE_OIDN
+#include <OpenImageDenoise/oidn.hpp>
+#endif
+
+namespace
+{
+// Same edge-stopping constants as the interactive filter in shaders/svgf.glsl
+constexpr float MIN_DEMODULATION_ALBEDO = 0.01f;
+constexpr float NORMAL_PHI = 128.0f;
+constexpr float DEPTH_PHI = 0.05f;
+constexpr float LUMINANCE_PHI = 4.0f;
+
+// B3 spline weights by distance from the center tap
+constexpr std::array<float, 3> ATROUS_KERNEL { 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+constexpr std::array<float, 2> VARIANCE_KERNEL { 1.0f / 2.0f, 1.0f / 4.0f };
+
+constexpr uint32_t ROWS_PER_TASK = 16;
+
+// First hit features the filter weights neighbours by, a negative depth marks pixels where every sample escaped the scene
+struct Guide
+{
+    glm::vec3 normal {};
+    float depth {};
+    glm::vec2 objectIds {};
+};
+
+float Luminance(const glm::vec3& color)
+{
+    return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+glm::vec3 DemodulationAlbedo(const glm::vec4& albedo)
+{
+    return glm::max(glm::vec3(albedo), glm::vec3(MIN_DEMODULATION_ALBEDO));
+}
+
+void ParallelForRows(ThreadPool& threadPool, uint32_t height, const std::function<void(uint32_t, uint32_t)>& function)
+{
+    std::vector<std::future<void>> tasks {};
+    for (uint32_t begin = 0; begin < height; begin += ROWS_PER_TASK)
+    {
+        const uint32_t end = std::min(begin + ROWS_PER_TASK, height);
+        tasks.push_back(threadPool.Submit([&function, begin, end]()
+            { function(begin, end); }));
+    }
+
+    for (std::future<void>& task : tasks)
+    {
+        threadPool.Wait(task);
+        task.get();
+    }
+}
+
+// Lighting divided by the albedo in rgb and the variance of its mean luminance in alpha, the a-trous passes filter both
+std::vector<glm::vec4> Demodulate(const RenderOutputs& outputs, ThreadPool& threadPool)
+{
+    std::vector<glm::vec4> illumination(outputs.color.size());
+    ParallelForRows(threadPool, outputs.height, [&](uint32_t begin, uint32_t end)
+        {
+            for (size_t i = static_cast<size_t>(begin) * outputs.width; i < static_cast<size_t>(end) * outputs.width; ++i)
+            {
+                const glm::vec4& color = outputs.color[i];
+                const glm::vec3 albedo = DemodulationAlbedo(outputs.albedo[i]);
+
+                // The moment is a plain mean, so its variance is corrected for the sample count before dividing by it
+                const float luminance = Luminance(glm::vec3(color));
+                const float variance = std::max(outputs.luminanceMoment[i] - luminance * luminance, 0.0f) / std::max(color.a - 1.0f, 1.0f);
+                const float albedoLuminance = Luminance(albedo);
+                illumination[i] = glm::vec4(glm::vec3(color) / albedo, variance / (albedoLuminance * albedoLuminance));
+            }
+        });
+    return illumination;
+}
+
+std::vector<Guide> BuildGuides(const RenderOutputs& outputs)
+{
+    std::vector<Guide> guides(outputs.color.size());
+    for (size_t i = 0; i < guides.size(); ++i)
+    {
+        const glm::vec4& normalDepth = outputs.normalDepth[i];
+        const float coverage = outputs.albedo[i].a;
+        const float normalLength = glm::length(glm::vec3(normalDepth));
+
+        guides[i].normal = normalLength > 0.0f ? glm::vec3(normalDepth) / normalLength : glm::vec3(0.0f);
+        guides[i].depth = coverage > 0.0f ? normalDepth.w / coverage : -1.0f;
+        guides[i].objectIds = outputs.objectIds[i];
+    }
+    return guides;
+}
+
+float FilteredVariance(std::span<const glm::vec4> illumination, uint32_t width, uint32_t height, int32_t x, int32_t y)
+{
+    float variance = 0.0f;
+    float weightSum = 0.0f;
+    for (int32_t offsetY = -1; offsetY <= 1; ++offsetY)
+    {
+        for (int32_t offsetX = -1; offsetX <= 1; ++offsetX)
+        {
+            const int32_t sampleX = x + offsetX;
+            const int32_t sampleY = y + offsetY;
+            if (sampleX < 0 || sampleY < 0 || sampleX >= static_cast<int32_t>(width) || sampleY >= static_cast<int32_t>(height))
+            {
+                continue;
+            }
+
+            const float weight = VARIANCE_KERNEL[std::abs(offsetX)] * VARIANCE_KERNEL[std::abs(offsetY)];
+            variance += weight * illumination[static_cast<size_t>(sampleY) * width + sampleX].a;
+            weightSum += weight;
+        }
+    }
+    return variance / weightSum;
+}
+
+// One edge-avoiding a-trous pass with taps stepSize pixels apart, as in "Edge-Avoiding A-Trous Wavelet Transform for
+// fast Global Illumination Filtering" (Dammertz et al., 2010). Luminance is compared relative to the remaining standard deviation
+void AtrousPass(std::span<const glm::vec4> source, std::span<glm::vec4> destination, std::span<const Guide> guides, uint32_t width, uint32_t height,
+    int32_t stepSize, uint32_t beginRow, uint32_t endRow)
+{
+    for (uint32_t y = beginRow; y < endRow; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            const size_t index = static_cast<size_t>(y) * width + x;
+            const Guide& guide = guides[index];
+            if (guide.depth < 0.0f)
+            {
+                destination[index] = source[index];
+                continue;
+            }
+
+            const float luminance = Luminance(glm::vec3(source[index]));
+            const float luminanceSigma = LUMINANCE_PHI * std::sqrt(std::max(FilteredVariance(source, width, height, static_cast<int32_t>(x), static_cast<int32_t>(y)), 1e-10f));
+
+            glm::vec3 illumination { 0.0f };
+            float variance = 0.0f;
+            float weightSum = 0.0f;
+            for (int32_t offsetY = -2; offsetY <= 2; ++offsetY)
+            {
+                for (int32_t offsetX = -2; offsetX <= 2; ++offsetX)
+                {
+                    const int32_t sampleX = static_cast<int32_t>(x) + offsetX * stepSize;
+                    const int32_t sampleY = static_cast<int32_t>(y) + offsetY * stepSize;
+                    if (sampleX < 0 || sampleY < 0 || sampleX >= static_cast<int32_t>(width) || sampleY >= static_cast<int32_t>(height))
+                    {
+                        continue;
+                    }
+
+                    const size_t sampleIndex = static_cast<size_t>(sampleY) * width + sampleX;
+                    const Guide& sampleGuide = guides[sampleIndex];
+                    if (sampleGuide.depth < 0.0f || sampleGuide.objectIds != guide.objectIds)
+                    {
+                        continue;
+                    }
+
+                    const glm::vec4& sample = source[sampleIndex];
+                    const float pixelDistance = static_cast<float>(stepSize) * std::sqrt(static_cast<float>(offsetX * offsetX + offsetY * offsetY));
+                    const float normalWeight = std::pow(std::max(glm::dot(guide.normal, sampleGuide.normal), 0.0f), NORMAL_PHI);
+                    const float depthWeight = std::exp(-std::abs(guide.depth - sampleGuide.depth) / (DEPTH_PHI * guide.depth * pixelDistance + 1e-4f));
+                    const float luminanceWeight = std::exp(-std::abs(luminance - Luminance(glm::vec3(sample))) / luminanceSigma);
+                    const float weight = ATROUS_KERNEL[std::abs(offsetX)] * ATROUS_KERNEL[std::abs(offsetY)] * normalWeight * depthWeight * luminanceWeight;
+
+                    illumination += weight * glm::vec3(sample);
+                    variance += weight * weight * sample.a;
+                    weightSum += weight;
+                }
+            }
+
+            destination[index] = weightSum > 0.0f ? glm::vec4(illumination / weightSum, variance / (weightSum * weightSum)) : source[index];
+        }
+    }
+}
+
+std::vector<glm::vec4> DenoiseWithAtrousFilter(const RenderOutputs& outputs, ThreadPool& threadPool, uint32_t filterIterations)
+{
+    const std::vector<Guide> guides = BuildGuides(outputs);
+    std::vector<glm::vec4> illumination = Demodulate(outputs, threadPool);
+    std::vector<glm::vec4> filtered(illumination.size());
+
+    for (uint32_t iteration = 0; iteration < filterIterations; ++iteration)
+    {
+        const int32_t stepSize = 1 << iteration;
+        ParallelForRows(threadPool, outputs.height, [&](uint32_t begin, uint32_t end)
+            { AtrousPass(illumination, filtered, guides, outputs.width, outputs.height, stepSize, begin, end); });
+        std::swap(illumination, filtered);
+    }
+
+    std::vector<glm::vec4> result(outputs.color.size());
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+        result[i] = guides[i].depth < 0.0f ? outputs.color[i] : glm::vec4(glm::vec3(illumination[i]) * DemodulationAlbedo(outputs.albedo[i]), outputs.color[i].a);
+    }
+    return result;
+}
+
+#ifdef ENABLE_OIDN
+std::vector<glm::vec4> DenoiseWithOpenImageDenoise(const RenderOutputs& outputs, uint32_t threadCount)
+{
+    oidn::DeviceRef device = oidn::newDevice(oidn::DeviceType::CPU);
+    device.set("numThreads", static_cast<int>(threadCount));
+    device.commit();
+
+    std::vector<glm::vec4> result(outputs.color.size());
+
+    // The images are read in place, only their first three channels. Averaged normals are passed without normalizing, as the filter expects
+    oidn::FilterRef filter = device.newFilter("RT");
+    const auto setImage = [&](const char* name, const glm::vec4* pixels)
+    { filter.setImage(name, const_cast<glm::vec4*>(pixels), oidn::Format::Float3, outputs.width, outputs.height, 0, sizeof(glm::vec4)); };
+    setImage("color", outputs.color.data());
+    setImage("albedo", outputs.albedo.data());
+    setImage("normal", outputs.normalDepth.data());
+    setImage("output", result.data());
+    filter.set("hdr", true);
+    filter.commit();
+    filter.execute();
+
+    const char* errorMessage = nullptr;
+    if (device.getError(errorMessage) != oidn::Error::None)
+    {
+        spdlog::error("[DENOISER] Open Image Denoise failed, keeping the noisy render: {}", errorMessage);
+        return outputs.color;
+    }
+
+    for (size_t i = 0; i < result.size(); ++i)
+    {
+        result[i].a = outputs.color[i].a;
+    }
+    return result;
+}
+#endif
+}
+
+std::vector<glm::vec4> DenoiseRender(const RenderOutputs& outputs, ThreadPool& threadPool, const OfflineDenoiserSettings& settings)
+{
+    if (outputs.albedo.size() != outputs.color.size())
+    {
+        spdlog::warn("[DENOISER] Render has no auxiliary outputs to guide the filter, keeping it noisy");
+        return outputs.color;
+    }
+
+#ifdef ENABLE_OIDN
+    (void)settings;
+    return DenoiseWithOpenImageDenoise(outputs, threadPool.ThreadCount());
+#else
+    return DenoiseWithAtrousFilter(outputs, threadPool, settings.filterIterations);
+#endif
+}
+
+bool WriteRenderImage(const std::string& path, std::span<const glm::vec4> pixels, uint32_t width, uint32_t height)
+{
+    const std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty())
+    {
+        std::error_code error {};
+        std::filesystem::create_directories(parent, error);
+    }
+
+    int written = 0;
+    if (path.ends_with(".hdr"))
+    {
+        std::vector<float> texels {};
+        texels.reserve(pixels.size() * 3);
+        for (const glm::vec4& pixel : pixels)
+        {
+            texels.insert(texels.end(), { pixel.r, pixel.g, pixel.b });
+        }
+        written = stbi_write_hdr(path.c_str(), static_cast<int>(width), static_cast<int>(height), 3, texels.data());
+    }
+    else
+    {
+        // Plain gamma without tonemapping, so written renders stay comparable to their linear values
+        std::vector<uint8_t> texels(pixels.size() * 4, 255);
+        for (size_t i = 0; i < pixels.size(); ++i)
+        {
+            const glm::vec3 display = glm::clamp(glm::pow(glm::max(glm::vec3(pixels[i]), glm::vec3(0.0f)), glm::vec3(1.0f / 2.2f)), 0.0f, 1.0f);
+            for (glm::length_t channel = 0; channel < 3; ++channel)
+            {
+                texels[i * 4 + channel] = static_cast<uint8_t>(std::lround(display[channel] * 255.0f));
+            }
+        }
+        written = stbi_write_png(path.c_str(), static_cast<int>(width), static_cast<int>(height), 4, texels.data(), static_cast<int>(width * 4));
+    }
+
+    if (written == 0)
+    {
+        spdlog::error("[FILE] Failed writing image to {}", path);
+        return false;
+    }
+
+    spdlog::info("[FILE] Wrote render to {}", path);
+    return true;
+}
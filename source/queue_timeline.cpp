@@ -0,0 +1,63 @@
+#include "queue_timeline.hpp"
+#include "vk_common.hpp"
+#include <limits>
+#include <vector>
+
+QueueTimeline::QueueTimeline(vk::Device device, vk::Queue queue)
+    : _device(device)
+    , _queue(queue)
+{
+    vk::StructureChain<vk::SemaphoreCreateInfo, vk::SemaphoreTypeCreateInfo> structureChain {};
+    auto& typeCreateInfo = structureChain.get<vk::SemaphoreTypeCreateInfo>();
+    typeCreateInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+    typeCreateInfo.initialValue = _lastSubmittedValue;
+
+    VkCheckResult(_device.createSemaphore(&structureChain.get<vk::SemaphoreCreateInfo>(), nullptr, &_semaphore), "[VULKAN] Failed creating timeline semaphore!");
+}
+
+QueueTimeline::~QueueTimeline()
+{
+    _device.destroy(_semaphore);
+}
+
+uint64_t QueueTimeline::Submit(vk::CommandBuffer commandBuffer, std::span<const vk::SemaphoreSubmitInfo> waits, std::span<const vk::SemaphoreSubmitInfo> signals)
+{
+    const uint64_t value = _lastSubmittedValue + 1;
+
+    std::vector<vk::SemaphoreSubmitInfo> signalInfos { signals.begin(), signals.end() };
+    vk::SemaphoreSubmitInfo& timelineSignal = signalInfos.emplace_back();
+    timelineSignal.semaphore = _semaphore;
+    timelineSignal.value = value;
+    timelineSignal.stageMask = vk::PipelineStageFlagBits2::eAllCommands;
+
+    vk::CommandBufferSubmitInfo commandBufferInfo {};
+    commandBufferInfo.commandBuffer = commandBuffer;
+
+    vk::SubmitInfo2 submitInfo {};
+    submitInfo.waitSemaphoreInfoCount = static_cast<uint32_t>(waits.size());
+    submitInfo.pWaitSemaphoreInfos = waits.data();
+    submitInfo.commandBufferInfoCount = 1;
+    submitInfo.pCommandBufferInfos = &commandBufferInfo;
+    submitInfo.signalSemaphoreInfoCount = static_cast<uint32_t>(signalInfos.size());
+    submitInfo.pSignalSemaphoreInfos = signalInfos.data();
+    VkCheckResult(_queue.submit2(1, &submitInfo, nullptr), "[VULKAN] Failed submitting to queue!");
+
+    _lastSubmittedValue = value;
+    return value;
+}
+
+void QueueTimeline::Wait(uint64_t value) const
+{
+    vk::SemaphoreWaitInfo waitInfo {};
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &_semaphore;
+    waitInfo.pValues = &value;
+    VkCheckResult(_device.waitSemaphores(&waitInfo, std::numeric_limits<uint64_t>::max()), "[VULKAN] Failed waiting on timeline semaphore!");
+}
+
+uint64_t QueueTimeline::CompletedValue() const
+{
+    uint64_t value = 0;
+    VkCheckResult(_device.getSemaphoreCounterValue(_semaphore, &value), "[VULKAN] Failed reading timeline semaphore value!");
+    return value;
+}
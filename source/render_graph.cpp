@@ -0,0 +1,424 @@
+#include "render_graph.hpp"
+#include "gpu_timer.hpp"
+#include "vk_common.hpp"
+#include "vulkan_context.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr vk::AccessFlags2 WRITE_ACCESS = vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eTransferWrite
+    | vk::AccessFlagBits2::eColorAttachmentWrite | vk::AccessFlagBits2::eHostWrite | vk::AccessFlagBits2::eMemoryWrite;
+constexpr vk::PipelineStageFlags2 TRANSFER_STAGES = vk::PipelineStageFlagBits2::eAllTransfer | vk::PipelineStageFlagBits2::eCopy
+    | vk::PipelineStageFlagBits2::eBlit | vk::PipelineStageFlagBits2::eClear;
+
+bool IsTransfer(vk::PipelineStageFlags2 stages)
+{
+    return static_cast<bool>(stages & TRANSFER_STAGES);
+}
+
+void AddMemoryBarrier(vk::MemoryBarrier2& barrier, vk::PipelineStageFlags2 srcStages, vk::AccessFlags2 srcAccess, vk::PipelineStageFlags2 dstStages, vk::AccessFlags2 dstAccess)
+{
+    barrier.srcStageMask |= srcStages;
+    barrier.srcAccessMask |= srcAccess;
+    barrier.dstStageMask |= dstStages;
+    barrier.dstAccessMask |= dstAccess;
+}
+}
+
+RenderGraph::Access RenderGraph::Read(ResourceId resource, vk::PipelineStageFlags2 stages, vk::ImageLayout layout)
+{
+    return Access { resource, stages, IsTransfer(stages) ? vk::AccessFlagBits2::eTransferRead : vk::AccessFlagBits2::eShaderStorageRead, layout };
+}
+
+RenderGraph::Access RenderGraph::Write(ResourceId resource, vk::PipelineStageFlags2 stages, vk::ImageLayout layout)
+{
+    return Access { resource, stages, IsTransfer(stages) ? vk::AccessFlagBits2::eTransferWrite : vk::AccessFlagBits2::eShaderStorageWrite, layout };
+}
+
+RenderGraph::Access RenderGraph::ReadWrite(ResourceId resource, vk::PipelineStageFlags2 stages, vk::ImageLayout layout)
+{
+    Access access = Read(resource, stages, layout);
+    access.access |= Write(resource, stages, layout).access;
+    return access;
+}
+
+RenderGraph::RenderGraph(const std::shared_ptr<VulkanContext>& vulkanContext)
+    : _vulkanContext(vulkanContext)
+{
+}
+
+RenderGraph::~RenderGraph()
+{
+    for (uint32_t i = 0; i < _transientCount; ++i)
+    {
+        _vulkanContext->Device().destroy(_resources.at(i).view);
+        _vulkanContext->Device().destroy(_resources.at(i).image);
+    }
+    for (const MemorySlot& slot : _memorySlots)
+    {
+        vmaFreeMemory(_vulkanContext->MemoryAllocator(), slot.allocation);
+    }
+}
+
+RenderGraph::ResourceId RenderGraph::CreateTransientImage(const TransientImageCreation& creation)
+{
+    Resource resource {};
+    resource.name = creation.name;
+    resource.format = creation.format;
+    resource.transient = creation;
+    ++_transientCount;
+    return AddResource(std::move(resource));
+}
+
+vk::Image RenderGraph::Image(ResourceId resource) const
+{
+    return _resources.at(resource).image;
+}
+
+vk::ImageView RenderGraph::View(ResourceId resource) const
+{
+    return _resources.at(resource).view;
+}
+
+void RenderGraph::Reset()
+{
+    _resources.resize(_transientCount);
+    _passes.clear();
+    _finalBarriers = {};
+}
+
+RenderGraph::ResourceId RenderGraph::ImportImage(std::string_view name, vk::Image image, vk::Format format)
+{
+    Resource resource {};
+    resource.name = name;
+    resource.image = image;
+    resource.format = format;
+    return AddResource(std::move(resource));
+}
+
+RenderGraph::ResourceId RenderGraph::ImportImage(std::string_view name, vk::Image image, vk::Format format, vk::ImageLayout initialLayout,
+    vk::PipelineStageFlags2 initialStages, vk::ImageLayout finalLayout)
+{
+    const ResourceId id = ImportImage(name, image, format);
+    Resource& resource = _resources.at(id);
+    resource.initialLayout = initialLayout;
+    resource.initialStages = initialStages;
+    // Nothing later in the queue touches the image, presentation waits on a semaphore instead
+    resource.finalAccess = Access { id, vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone, finalLayout };
+    return id;
+}
+
+RenderGraph::ResourceId RenderGraph::ImportBuffer(std::string_view name, vk::Buffer buffer)
+{
+    Resource resource {};
+    resource.name = name;
+    resource.buffer = buffer;
+    return AddResource(std::move(resource));
+}
+
+RenderGraph::ResourceId RenderGraph::ImportBuffer(std::string_view name, vk::Buffer buffer, vk::PipelineStageFlags2 finalStages, vk::AccessFlags2 finalAccess)
+{
+    const ResourceId id = ImportBuffer(name, buffer);
+    _resources.at(id).finalAccess = Access { id, finalStages, finalAccess };
+    return id;
+}
+
+void RenderGraph::AddPass(std::string_view name, std::vector<Access> accesses, RecordFunction record, bool timed)
+{
+    Pass& pass = _passes.emplace_back();
+    pass.name = name;
+    pass.accesses = std::move(accesses);
+    pass.record = std::move(record);
+    pass.timed = timed;
+}
+
+void RenderGraph::Compile()
+{
+    if (_memorySlots.empty() && _transientCount > 0)
+    {
+        AllocateTransientImages();
+    }
+
+    // The first walk only finds the state every resource ends the frame in, which is what the next frame starts from
+    std::vector<ResourceState> states(_resources.size());
+    std::vector<MemorySlot> slots = _memorySlots;
+    PlaceBarriers(states, slots, false);
+    PlaceBarriers(states, slots, true);
+
+    _barrierCount = _finalBarriers.Count();
+    for (const Pass& pass : _passes)
+    {
+        _barrierCount += pass.barriers.Count();
+    }
+}
+
+void RenderGraph::Execute(vk::CommandBuffer commandBuffer, GpuTimer& gpuTimer) const
+{
+    for (const Pass& pass : _passes)
+    {
+        pass.barriers.Record(commandBuffer);
+
+        if (pass.timed)
+        {
+            gpuTimer.BeginSection(commandBuffer, pass.name);
+        }
+        pass.record(commandBuffer);
+        if (pass.timed)
+        {
+            gpuTimer.EndSection(commandBuffer);
+        }
+    }
+    _finalBarriers.Record(commandBuffer);
+}
+
+void RenderGraph::PlaceBarriers(std::vector<ResourceState>& states, std::vector<MemorySlot>& slots, bool placeBarriers)
+{
+    for (size_t i = 0; i < _resources.size(); ++i)
+    {
+        const Resource& resource = _resources.at(i);
+        ResourceState& state = states.at(i);
+        state.used = false;
+        if (resource.initialLayout.has_value())
+        {
+            state = ResourceState {};
+            state.writeStages = resource.initialStages;
+            state.layout = resource.initialLayout;
+        }
+    }
+
+    for (Pass& pass : _passes)
+    {
+        pass.barriers = {};
+        for (const Access& access : pass.accesses)
+        {
+            Synchronize(access.resource, states.at(access.resource), slots, access, placeBarriers ? &pass.barriers : nullptr);
+        }
+    }
+
+    _finalBarriers = {};
+    for (size_t i = 0; i < _resources.size(); ++i)
+    {
+        const std::optional<Access>& finalAccess = _resources.at(i).finalAccess;
+        if (finalAccess.has_value() && states.at(i).used)
+        {
+            Synchronize(finalAccess->resource, states.at(i), slots, *finalAccess, placeBarriers ? &_finalBarriers : nullptr);
+        }
+    }
+}
+
+void RenderGraph::Synchronize(ResourceId resourceId, ResourceState& state, std::vector<MemorySlot>& slots, const Access& access, Barriers* barriers) const
+{
+    const Resource& resource = _resources.at(resourceId);
+    const bool isImage = static_cast<bool>(resource.image);
+    const vk::AccessFlags2 writeAccess = access.access & WRITE_ACCESS;
+
+    if (!state.used)
+    {
+        state.used = true;
+        if (resource.transient.has_value())
+        {
+            // Nothing is kept from the previous frame, but whatever used the memory last has to be done with it
+            MemorySlot& slot = slots.at(resource.memorySlot);
+            state = ResourceState {};
+            state.writeStages = slot.lastStages;
+            state.writeAccess = slot.lastWriteAccess;
+            state.layout = vk::ImageLayout::eUndefined;
+            state.used = true;
+            slot.lastStages = {};
+            slot.lastWriteAccess = {};
+        }
+        else if (isImage && !state.layout.has_value())
+        {
+            state.layout = access.layout;
+        }
+    }
+
+    if (resource.transient.has_value())
+    {
+        MemorySlot& slot = slots.at(resource.memorySlot);
+        slot.lastStages |= access.stages;
+        slot.lastWriteAccess |= writeAccess;
+    }
+
+    const vk::PipelineStageFlags2 previousStages = state.writeStages | state.readStages;
+    if (isImage && *state.layout != access.layout)
+    {
+        // Layout transitions write the whole image, so they wait for reads as well and count as the image's latest write
+        if (barriers)
+        {
+            vk::ImageMemoryBarrier2& barrier = barriers->imageBarriers.emplace_back();
+            VkInitializeImageMemoryBarrier(barrier, resource.image, resource.format, *state.layout, access.layout);
+            barrier.srcStageMask = previousStages;
+            barrier.srcAccessMask = state.writeAccess;
+            barrier.dstStageMask = access.stages;
+            barrier.dstAccessMask = access.access;
+        }
+
+        const bool writes = static_cast<bool>(writeAccess);
+        state.writeStages = access.stages;
+        state.writeAccess = writeAccess;
+        state.readStages = {};
+        state.visibleStages = writes ? vk::PipelineStageFlags2 {} : access.stages;
+        state.visibleAccess = writes ? vk::AccessFlags2 {} : access.access;
+        state.layout = access.layout;
+        return;
+    }
+
+    if (writeAccess)
+    {
+        if (barriers && previousStages)
+        {
+            AddMemoryBarrier(barriers->memoryBarrier, previousStages, state.writeAccess, access.stages, access.access);
+        }
+        state.writeStages = access.stages;
+        state.writeAccess = writeAccess;
+        state.readStages = {};
+        state.visibleStages = {};
+        state.visibleAccess = {};
+        return;
+    }
+
+    const bool visible = !(access.stages & ~state.visibleStages) && !(access.access & ~state.visibleAccess);
+    if (state.writeStages && !visible)
+    {
+        if (barriers)
+        {
+            AddMemoryBarrier(barriers->memoryBarrier, state.writeStages, state.writeAccess, access.stages, access.access);
+        }
+        state.visibleStages |= access.stages;
+        state.visibleAccess |= access.access;
+    }
+    state.readStages |= access.stages;
+}
+
+void RenderGraph::AllocateTransientImages()
+{
+    const vk::Device device = _vulkanContext->Device();
+    const VmaAllocator allocator = _vulkanContext->MemoryAllocator();
+
+    // First and last pass using every transient image, images no pass uses get an empty range and overlap with nothing
+    std::vector<std::pair<size_t, size_t>> lifetimes(_transientCount, { std::numeric_limits<size_t>::max(), 0 });
+    for (size_t i = 0; i < _passes.size(); ++i)
+    {
+        for (const Access& access : _passes.at(i).accesses)
+        {
+            if (access.resource < _transientCount)
+            {
+                lifetimes.at(access.resource).first = std::min(lifetimes.at(access.resource).first, i);
+                lifetimes.at(access.resource).second = std::max(lifetimes.at(access.resource).second, i);
+            }
+        }
+    }
+
+    std::vector<vk::MemoryRequirements> requirements(_transientCount);
+    for (uint32_t i = 0; i < _transientCount; ++i)
+    {
+        Resource& resource = _resources.at(i);
+
+        vk::ImageCreateInfo imageCreateInfo {};
+        imageCreateInfo.imageType = vk::ImageType::e2D;
+        imageCreateInfo.extent = vk::Extent3D { resource.transient->width, resource.transient->height, 1 };
+        imageCreateInfo.mipLevels = 1;
+        imageCreateInfo.arrayLayers = 1;
+        imageCreateInfo.format = resource.format;
+        imageCreateInfo.tiling = vk::ImageTiling::eOptimal;
+        imageCreateInfo.initialLayout = vk::ImageLayout::eUndefined;
+        imageCreateInfo.sharingMode = vk::SharingMode::eExclusive;
+        imageCreateInfo.samples = vk::SampleCountFlagBits::e1;
+        imageCreateInfo.usage = resource.transient->usage;
+        VkCheckResult(device.createImage(&imageCreateInfo, nullptr, &resource.image), "[VULKAN] Failed creating transient image!");
+        VkNameObject(resource.image, resource.name, _vulkanContext);
+        requirements.at(i) = device.getImageMemoryRequirements(resource.image);
+    }
+
+    // Largest images first, each goes into the first memory slot none of whose images is alive at the same time
+    struct SlotLayout
+    {
+        vk::MemoryRequirements requirements {};
+        std::vector<ResourceId> images {};
+    };
+    std::vector<ResourceId> order(_transientCount);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](ResourceId a, ResourceId b)
+        { return requirements.at(a).size > requirements.at(b).size; });
+
+    std::vector<SlotLayout> slotLayouts {};
+    vk::DeviceSize unaliasedSize = 0;
+    for (const ResourceId id : order)
+    {
+        const auto overlaps = [&](ResourceId other)
+        { return lifetimes.at(id).first <= lifetimes.at(other).second && lifetimes.at(other).first <= lifetimes.at(id).second; };
+
+        auto slot = std::find_if(slotLayouts.begin(), slotLayouts.end(), [&](const SlotLayout& layout)
+            { return (layout.requirements.memoryTypeBits & requirements.at(id).memoryTypeBits) && std::none_of(layout.images.begin(), layout.images.end(), overlaps); });
+        if (slot == slotLayouts.end())
+        {
+            slot = slotLayouts.insert(slotLayouts.end(), SlotLayout { requirements.at(id), {} });
+        }
+
+        slot->requirements.size = std::max(slot->requirements.size, requirements.at(id).size);
+        slot->requirements.alignment = std::max(slot->requirements.alignment, requirements.at(id).alignment);
+        slot->requirements.memoryTypeBits &= requirements.at(id).memoryTypeBits;
+        slot->images.push_back(id);
+        _resources.at(id).memorySlot = static_cast<uint32_t>(std::distance(slotLayouts.begin(), slot));
+        unaliasedSize += requirements.at(id).size;
+    }
+
+    VmaAllocationCreateInfo allocCreateInfo {};
+    allocCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+    _memorySlots.resize(slotLayouts.size());
+    for (size_t i = 0; i < slotLayouts.size(); ++i)
+    {
+        const SlotLayout& layout = slotLayouts.at(i);
+        MemorySlot& slot = _memorySlots.at(i);
+        VkCheckResult(vmaAllocateMemory(allocator, reinterpret_cast<const VkMemoryRequirements*>(&layout.requirements), &allocCreateInfo, &slot.allocation, nullptr),
+            "[VULKAN] Failed allocating transient image memory!");
+
+        std::string allocName = "Render Graph Transient " + std::to_string(i) + " allocation";
+        vmaSetAllocationName(allocator, slot.allocation, allocName.c_str());
+        _transientMemorySize += layout.requirements.size;
+
+        for (const ResourceId id : layout.images)
+        {
+            Resource& resource = _resources.at(id);
+            VkCheckResult(vmaBindImageMemory(allocator, slot.allocation, resource.image), "[VULKAN] Failed binding transient image memory!");
+
+            vk::ImageViewCreateInfo viewCreateInfo {};
+            viewCreateInfo.image = resource.image;
+            viewCreateInfo.viewType = vk::ImageViewType::e2D;
+            viewCreateInfo.format = resource.format;
+            viewCreateInfo.subresourceRange = vk::ImageSubresourceRange { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 };
+            resource.view = device.createImageView(viewCreateInfo);
+        }
+    }
+    _transientMemorySaved = unaliasedSize - _transientMemorySize;
+
+    spdlog::info("[VULKAN] Render graph placed {} transient images in {} allocations, {} bytes instead of {}",
+        _transientCount, _memorySlots.size(), _transientMemorySize, unaliasedSize);
+}
+
+RenderGraph::ResourceId RenderGraph::AddResource(Resource resource)
+{
+    _resources.push_back(std::move(resource));
+    return static_cast<ResourceId>(_resources.size() - 1);
+}
+
+void RenderGraph::Barriers::Record(vk::CommandBuffer commandBuffer) const
+{
+    const bool hasMemoryBarrier = static_cast<bool>(memoryBarrier.srcStageMask);
+    if (!hasMemoryBarrier && imageBarriers.empty())
+    {
+        return;
+    }
+
+    vk::DependencyInfo dependencyInfo {};
+    dependencyInfo.memoryBarrierCount = hasMemoryBarrier ? 1 : 0;
+    dependencyInfo.pMemoryBarriers = &memoryBarrier;
+    dependencyInfo.imageMemoryBarrierCount = static_cast<uint32_t>(imageBarriers.size());
+    dependencyInfo.pImageMemoryBarriers = imageBarriers.data();
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+}
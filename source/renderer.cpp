@@ -1,48 +1,203 @@
 #include "renderer.hpp"
+#include "acceleration_structure_cache.hpp"
+#include "blue_noise.hpp"
 #include "bottom_level_acceleration_structure.hpp"
+#include "camera.hpp"
+#include "compute_pipeline.hpp"
+#include "environment_map.hpp"
 #include "gltf_loader.hpp"
+#include "gpu_timer.hpp"
+#include "light_sampling.hpp"
+#include "offline_denoiser.hpp"
 #include "resources/bindless_resources.hpp"
 #include "shader.hpp"
+#include "shader_binding_table.hpp"
 #include "single_time_commands.hpp"
+#include "svgf_denoiser.hpp"
 #include "swap_chain.hpp"
+#include "thread_pool.hpp"
 #include "top_level_acceleration_structure.hpp"
 #include "vulkan_context.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/matrix_decompose.hpp>
+#include <spdlog/spdlog.h>
+#include <utility>
 
-Renderer::Renderer(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext)
-    : _vulkanContext(vulkanContext)
+namespace
+{
+// Shader groups are ordered ray gen, miss, hit in the pipeline and the shader binding table alike
+constexpr uint32_t RAYGEN_GROUP_INDEX = 0;
+constexpr uint32_t MISS_GROUP_INDEX = 1;
+constexpr uint32_t SHADOW_MISS_GROUP_INDEX = 2;
+constexpr uint32_t HIT_GROUP_INDEX = 3;
+
+// One hit group per material feature combination, indexed by the feature bits
+constexpr uint32_t HIT_GROUP_COUNT = MATERIAL_FEATURE_COMBINATIONS;
+// The uber variant keeps every shading feature, masked geometry still needs the group with the alpha test attached
+constexpr MaterialFeatures UBER_MATERIAL_FEATURES = MaterialFeatures::eAlbedoMap | MaterialFeatures::eEmissiveMap;
+
+// ReSTIR passes are extra ray gen groups, traced through their own ray gen records
+constexpr uint32_t RESTIR_CANDIDATES_GROUP_INDEX = HIT_GROUP_INDEX + HIT_GROUP_COUNT;
+constexpr uint32_t RESTIR_SPATIAL_GROUP_INDEX = RESTIR_CANDIDATES_GROUP_INDEX + 1;
+constexpr uint32_t SHADER_GROUP_COUNT = RESTIR_SPATIAL_GROUP_INDEX + 1;
+constexpr uint32_t RESTIR_CANDIDATES_RAYGEN_INDEX = 1;
+constexpr uint32_t RESTIR_SPATIAL_RAYGEN_INDEX = 2;
+
+constexpr uint32_t CLOSEST_HIT_STAGE_INDEX = 3;
+constexpr uint32_t ANY_HIT_STAGE_INDEX = CLOSEST_HIT_STAGE_INDEX + HIT_GROUP_COUNT;
+constexpr uint32_t RESTIR_CANDIDATES_STAGE_INDEX = ANY_HIT_STAGE_INDEX + 1;
+constexpr uint32_t RESTIR_SPATIAL_STAGE_INDEX = RESTIR_CANDIDATES_STAGE_INDEX + 1;
+
+// Side of the blue noise tiles, BLUE_NOISE_SIZE in shaders/sampling.glsl
+constexpr uint32_t BLUE_NOISE_SIZE = 64;
+
+// Sizes of Surface and Reservoir in shaders/restir.glsl
+constexpr vk::DeviceSize RESTIR_SURFACE_SIZE = 32;
+constexpr vk::DeviceSize RESTIR_RESERVOIR_SIZE = 32;
+
+// The active pixel list starts with a vk::TraceRaysIndirectCommandKHR padded to 16 bytes, see shaders/adaptive_mask.comp
+constexpr vk::DeviceSize ACTIVE_PIXEL_HEADER_SIZE = 16;
+// Swap chain images the tonemap pass can address, see shaders/tonemap.comp
+constexpr uint32_t TONEMAP_OUTPUT_COUNT = 8;
+
+// Dynamic resolution changes the scale at most this often, in steps of RESOLUTION_SCALE_STEP
+constexpr uint32_t RESOLUTION_UPDATE_INTERVAL = 16;
+constexpr float RESOLUTION_SCALE_STEP = 1.0f / 32.0f;
+// Blend factor of new frame times into the smoothed one
+constexpr double FRAME_TIME_SMOOTHING = 0.2;
+// Ratios of target to measured frame time that keep the current scale, so it settles instead of oscillating around the target
+constexpr double MIN_KEPT_BUDGET_RATIO = 0.95;
+constexpr double MAX_KEPT_BUDGET_RATIO = 1.15;
+constexpr vk::ShaderStageFlags PUSH_CONSTANT_STAGES = vk::ShaderStageFlagBits::eRaygenKHR | vk::ShaderStageFlagBits::eMissKHR | vk::ShaderStageFlagBits::eAnyHitKHR;
+
+constexpr vk::PipelineStageFlags2 RAY_TRACING_STAGE = vk::PipelineStageFlagBits2::eRayTracingShaderKHR;
+constexpr vk::PipelineStageFlags2 COMPUTE_STAGE = vk::PipelineStageFlagBits2::eComputeShader;
+constexpr vk::PipelineStageFlags2 TRANSFER_STAGE = vk::PipelineStageFlagBits2::eTransfer;
+
+struct ClosestHitSpecialization
+{
+    vk::Bool32 useAlbedoMap {};
+    vk::Bool32 useEmissiveMap {};
+};
+
+bool IsSrgbFormat(vk::Format format)
+{
+    return format == vk::Format::eB8G8R8A8Srgb || format == vk::Format::eR8G8B8A8Srgb || format == vk::Format::eA8B8G8R8SrgbPack32;
+}
+}
+
+Renderer::Renderer(const VulkanInitInfo& initInfo, const std::shared_ptr<VulkanContext>& vulkanContext, const RendererSettings& settings)
+    : _settings(settings)
+    , _vulkanContext(vulkanContext)
+    , _renderWidth(initInfo.width)
+    , _renderHeight(initInfo.height)
+    , _accumulationExtent(initInfo.width, initInfo.height)
     , _windowWidth(initInfo.width)
     , _windowHeight(initInfo.height)
 {
+    if (_settings.adaptiveSampling && !_vulkanContext->RayTracingIndirectSupported())
+    {
+        spdlog::warn("[VULKAN] Adaptive sampling needs indirect trace rays, every pixel is sampled instead");
+        _settings.adaptiveSampling = false;
+    }
+    if (_settings.adaptiveSampling && _settings.denoising)
+    {
+        spdlog::warn("[VULKAN] Adaptive sampling is disabled while denoising, the denoiser needs a new sample for every pixel");
+        _settings.adaptiveSampling = false;
+    }
+    if (_settings.temporalReprojection && _settings.reprojectionHistoryLimit == 0)
+    {
+        spdlog::warn("[VULKAN] Temporal reprojection is disabled, its history limit is zero");
+        _settings.temporalReprojection = false;
+    }
+    if (_settings.adaptiveSampling && _settings.dynamicResolution)
+    {
+        spdlog::warn("[VULKAN] Adaptive sampling is disabled with dynamic resolution, every scale change restarts accumulation");
+        _settings.adaptiveSampling = false;
+    }
+    _settings.minResolutionScale = std::clamp(_settings.minResolutionScale, RESOLUTION_SCALE_STEP, 1.0f);
+    if (_settings.framesInFlight == 0 || _settings.framesInFlight > MAX_FRAMES_IN_FLIGHT)
+    {
+        spdlog::warn("[VULKAN] {} frames in flight are not supported, using {}", _settings.framesInFlight, std::clamp(_settings.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT));
+        _settings.framesInFlight = std::clamp(_settings.framesInFlight, 1u, MAX_FRAMES_IN_FLIGHT);
+    }
+
     _swapChain = std::make_unique<SwapChain>(vulkanContext, glm::uvec2 { initInfo.width, initInfo.height });
     InitializeCommandBuffers();
     InitializeSynchronizationObjects();
+    InitializeStatistics();
+    _renderGraph = std::make_unique<RenderGraph>(_vulkanContext);
     InitializeRenderTarget();
+    _gpuTimer = std::make_unique<GpuTimer>(_vulkanContext);
 
     _bindlessResources = std::make_shared<BindlessResources>(_vulkanContext);
     _gltfLoader = std::make_unique<GLTFLoader>(_bindlessResources, _vulkanContext);
+    _accelerationStructureCache = std::make_shared<AccelerationStructureCache>(_vulkanContext, "cache/acceleration_structures");
+    _threadPool = std::make_shared<ThreadPool>();
 
-    const std::vector<std::string> scene = {
-        // "assets/helmet/FlightHelmet.gltf",
-        "assets/dragon/DragonAttenuation.gltf",
-        "assets/cube/Cube.gltf",
-    };
+    BLASBuildOptions blasBuildOptions {};
+    blasBuildOptions.cache = _accelerationStructureCache;
+    blasBuildOptions.preferHostBuild = _settings.hostAccelerationStructureBuilds;
+    blasBuildOptions.threadPool = _threadPool;
+
+    const std::vector<std::string>& scene = _settings.scene;
     _blases.reserve(scene.size());
+    std::chrono::duration<double, std::milli> blasDuration {};
+    std::vector<EmissiveTriangle> emissiveTriangles {};
     for (const auto& modelPath : scene)
     {
         std::shared_ptr<Model> model = _gltfLoader->LoadFromFile(modelPath);
-        _blases.emplace_back(model, _bindlessResources, _vulkanContext);
+        if (model == nullptr)
+        {
+            spdlog::warn("[VULKAN] Skipping model {}, it failed to load", modelPath);
+            continue;
+        }
+
+        const auto blasStart = std::chrono::high_resolution_clock::now();
+        const BottomLevelAccelerationStructure& blas = _blases.emplace_back(model, _bindlessResources, _vulkanContext, blasBuildOptions);
+        blasDuration += std::chrono::high_resolution_clock::now() - blasStart;
+        // Host copies of the geometry are only read by host builds, the device buffers hold it from here on
+        model->vertices = {};
+        model->indices = {};
+        _pendingFrameWaits.push_back(_vulkanContext->TimelineWait(QueueType::eTransfer, model->uploadTimelineValue));
+
+        // Lights are appended in BLAS order, matching the first light index of the TLAS instances
+        for (EmissiveTriangle triangle : model->emissiveTriangles)
+        {
+            for (glm::vec3& position : triangle.positions)
+            {
+                position = glm::vec3(blas.Transform() * glm::vec4(position, 1.0f));
+            }
+            emissiveTriangles.push_back(triangle);
+        }
     }
 
+    const size_t cachedBlasCount = std::count_if(_blases.begin(), _blases.end(), [](const auto& blas)
+        { return blas.LoadedFromCache(); });
+    spdlog::info("[BLAS] {} loaded from cache, {} built, took {:.2f} ms", cachedBlasCount, _blases.size() - cachedBlasCount, blasDuration.count());
+
     _tlas = std::make_unique<TopLevelAccelerationStructure>(_blases, _bindlessResources, _vulkanContext);
+    _pendingFrameWaits.push_back(_vulkanContext->TimelineWait(QueueType::eCompute, _tlas->BuildTimelineValue()));
+    InitializeEnvironment();
     _bindlessResources->UpdateDescriptorSet();
-
+    _pendingFrameWaits.push_back(_vulkanContext->TimelineWait(QueueType::eTransfer, _bindlessResources->UploadTimelineValue()));
+
+    InitializeLights(emissiveTriangles);
+    InitializeRestirResources();
+    InitializeBlueNoise();
+    InitializeAdaptiveSampling();
+    InitializeDenoiser();
+    InitializeUpscaler();
+    InitializeTonemap();
+    InitializeRenderGraph();
     InitializeDescriptorSets();
     InitializePipeline();
-    InitializeShaderBindingTable();
+    InitializePipelineStackSize();
 }
 
 Renderer::~Renderer()
@@ -55,7 +210,6 @@ Renderer::~Renderer()
 
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
     {
-        _vulkanContext->Device().destroy(_inFlightFences.at(i));
         _vulkanContext->Device().destroy(_renderFinishedSemaphores.at(i));
         _vulkanContext->Device().destroy(_imageAvailableSemaphores.at(i));
     }
@@ -63,38 +217,88 @@ Renderer::~Renderer()
 
 void Renderer::Render()
 {
-    VkCheckResult(_vulkanContext->Device().waitForFences(1, &_inFlightFences.at(_currentResourcesFrame), vk::True,
-                      std::numeric_limits<uint64_t>::max()),
-        "[VULKAN] Failed waiting on in flight fence!");
+    QueueTimeline& graphicsTimeline = _vulkanContext->Timeline(QueueType::eGraphics);
+    const auto waitStart = std::chrono::steady_clock::now();
+    graphicsTimeline.Wait(_frameTimelineValues.at(_currentResourcesFrame));
+    UpdateFrameLatency();
 
     uint32_t swapChainImageIndex {};
     VkCheckResult(_vulkanContext->Device().acquireNextImageKHR(_swapChain->GetSwapChain(), std::numeric_limits<uint64_t>::max(),
                       _imageAvailableSemaphores.at(_currentResourcesFrame), nullptr, &swapChainImageIndex),
         "[VULKAN] Failed to acquire swap chain image!");
+    _framePacing.cpuWaitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - waitStart).count();
+
+    // Readback memory may not be host coherent, the GPU's writes have to be invalidated before reading and the reset flushed after
+    const vk::DeviceSize statisticsOffset = sizeof(uint32_t) * _currentResourcesFrame;
+    VkCheckResult(vmaInvalidateAllocation(_vulkanContext->MemoryAllocator(), _statisticsBuffer->allocation, statisticsOffset, sizeof(uint32_t)),
+        "[VULKAN] Failed invalidating statistics buffer!");
+    uint32_t* anyHitInvocations = static_cast<uint32_t*>(_statisticsBuffer->mappedPtr) + _currentResourcesFrame;
+    _lastFrameAnyHitInvocations = *anyHitInvocations;
+    *anyHitInvocations = 0;
+    VkCheckResult(vmaFlushAllocation(_vulkanContext->MemoryAllocator(), _statisticsBuffer->allocation, statisticsOffset, sizeof(uint32_t)),
+        "[VULKAN] Failed flushing statistics buffer!");
+
+    if (AdaptiveSamplingEnabled())
+    {
+        const vk::DeviceSize readbackOffset = sizeof(uint32_t) * _currentResourcesFrame;
+        VkCheckResult(vmaInvalidateAllocation(_vulkanContext->MemoryAllocator(), _activePixelReadbackBuffer->allocation, readbackOffset, sizeof(uint32_t)),
+            "[VULKAN] Failed invalidating active pixel readback buffer!");
+        uint32_t* activePixels = static_cast<uint32_t*>(_activePixelReadbackBuffer->mappedPtr) + _currentResourcesFrame;
+        _lastFrameActivePixels = *activePixels;
+        _tracedSamples += *activePixels;
+        *activePixels = 0;
+        VkCheckResult(vmaFlushAllocation(_vulkanContext->MemoryAllocator(), _activePixelReadbackBuffer->allocation, readbackOffset, sizeof(uint32_t)),
+            "[VULKAN] Failed flushing active pixel readback buffer!");
+    }
+    else
+    {
+        _lastFrameActivePixels = _renderWidth * _renderHeight;
+        _tracedSamples += _lastFrameActivePixels;
+    }
 
-    VkCheckResult(_vulkanContext->Device().resetFences(1, &_inFlightFences.at(_currentResourcesFrame)), "[VULKAN] Failed resetting fences!");
-
-    vk::CommandBuffer commandBuffer = _commandBuffers.at(_currentResourcesFrame);
-    commandBuffer.reset();
-
-    vk::CommandBufferBeginInfo commandBufferBeginInfo {};
-    VkCheckResult(commandBuffer.begin(&commandBufferBeginInfo), "[VULKAN] Failed to begin recording command buffer!");
-    RecordCommands(commandBuffer, swapChainImageIndex);
-    commandBuffer.end();
+    const auto latchStart = std::chrono::steady_clock::now();
+    if (_cameraLatch)
+    {
+        _view = _cameraLatch();
+    }
 
-    vk::Semaphore waitSemaphore = _imageAvailableSemaphores.at(_currentResourcesFrame);
-    vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eColorAttachmentOutput;
+    FrameUniformData frameData = FrameData();
+    const bool cameraMoved = frameData.viewProjection != _previousViewProjection;
+    if (cameraMoved && (!_settings.temporalReprojection || AdaptiveSamplingEnabled()))
+    {
+        _accumulatedFrames = 0;
+    }
+    frameData.frameIndex = _accumulatedFrames;
+    frameData.cameraMoved = cameraMoved;
+
+    const auto recordingStart = std::chrono::steady_clock::now();
+    _gpuTimer->ResolveFrame(_currentResourcesFrame);
+    _framePacing.gpuIdleMs = _gpuTimer->IdleBeforeFrameMs();
+    vk::CommandBuffer commandBuffer = FrameCommandBuffer(swapChainImageIndex, cameraMoved);
+    _commandRecordingMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - recordingStart).count();
+
+    // The timeline value waited on above guarantees the GPU is done with this frame's slice. Device local mappable memory may not be
+    // host coherent, so the slice is flushed before the submit
+    const vk::DeviceSize uniformOffset = _currentResourcesFrame * _uniformBufferStride;
+    memcpy(static_cast<std::byte*>(_uniformBuffer->mappedPtr) + uniformOffset, &frameData, sizeof(FrameUniformData));
+    VkCheckResult(vmaFlushAllocation(_vulkanContext->MemoryAllocator(), _uniformBuffer->allocation, uniformOffset, sizeof(FrameUniformData)),
+        "[VULKAN] Failed flushing frame uniform buffer!");
+    _previousViewProjection = frameData.viewProjection;
+
+    // Swap chains only take binary semaphores, they are waited on and signaled next to the timeline
     vk::Semaphore signalSemaphore = _renderFinishedSemaphores.at(_currentResourcesFrame);
-
-    vk::SubmitInfo submitInfo {};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = &waitSemaphore;
-    submitInfo.pWaitDstStageMask = &waitStage;
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &commandBuffer;
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = &signalSemaphore;
-    VkCheckResult(_vulkanContext->GraphicsQueue().submit(1, &submitInfo, _inFlightFences.at(_currentResourcesFrame)), "[VULKAN] Failed submitting to graphics queue!");
+    // Only the first frame after uploads or builds on the other queues waits on them, later frames follow it on the graphics queue
+    std::vector<vk::SemaphoreSubmitInfo> waits = std::exchange(_pendingFrameWaits, {});
+    vk::SemaphoreSubmitInfo& imageAvailableWait = waits.emplace_back();
+    imageAvailableWait.semaphore = _imageAvailableSemaphores.at(_currentResourcesFrame);
+    imageAvailableWait.stageMask = vk::PipelineStageFlagBits2::eColorAttachmentOutput;
+    vk::SemaphoreSubmitInfo signalInfo {};
+    signalInfo.semaphore = signalSemaphore;
+    signalInfo.stageMask = vk::PipelineStageFlagBits2::eAllCommands;
+
+    _frameTimelineValues.at(_currentResourcesFrame) = graphicsTimeline.Submit(commandBuffer, waits, { &signalInfo, 1 });
+    _frameLatchTimes.at(_currentResourcesFrame) = latchStart;
+    _latchToSubmitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - latchStart).count();
 
     vk::SwapchainKHR swapchain = _swapChain->GetSwapChain();
     vk::PresentInfoKHR presentInfo {};
@@ -105,31 +309,452 @@ void Renderer::Render()
     presentInfo.pImageIndices = &swapChainImageIndex;
     VkCheckResult(_vulkanContext->PresentQueue().presentKHR(&presentInfo), "[VULKAN] Failed to present swap chain image!");
 
-    _currentResourcesFrame = (_currentResourcesFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    _currentResourcesFrame = (_currentResourcesFrame + 1) % _settings.framesInFlight;
+    ++_accumulatedFrames;
+    _accumulationExtent = vk::Extent2D { _renderWidth, _renderHeight };
+
+    if (_settings.dynamicResolution)
+    {
+        UpdateResolutionScale();
+    }
 }
 
-void Renderer::RecordCommands(const vk::CommandBuffer& commandBuffer, uint32_t swapChainImageIndex)
+void Renderer::UpdateResolutionScale()
 {
-    VkTransitionImageLayout(commandBuffer, _renderTarget->image, _renderTarget->format,
-        vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
+    // Timings resolve a few frames late, frames traced before the last change must not drive the next one
+    const double frameTimeMs = _gpuTimer->TotalDurationMs();
+    if (++_framesSinceResolutionChange <= _settings.framesInFlight || frameTimeMs <= 0.0)
+    {
+        return;
+    }
 
-    commandBuffer.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, _pipeline);
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, _pipelineLayout, 0, _bindlessResources->DescriptorSet(), nullptr);
-    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, _pipelineLayout, 1, _descriptorSet, nullptr);
+    _smoothedFrameTimeMs = _smoothedFrameTimeMs > 0.0 ? std::lerp(_smoothedFrameTimeMs, frameTimeMs, FRAME_TIME_SMOOTHING) : frameTimeMs;
+    if (_framesSinceResolutionChange < RESOLUTION_UPDATE_INTERVAL)
+    {
+        return;
+    }
+
+    const double budgetRatio = _settings.targetFrameTimeMs / _smoothedFrameTimeMs;
+    if (budgetRatio > MIN_KEPT_BUDGET_RATIO && budgetRatio < MAX_KEPT_BUDGET_RATIO)
+    {
+        return;
+    }
+
+    // Tracing cost follows the pixel count, which grows with the square of the scale
+    const float idealScale = _resolutionScale * static_cast<float>(std::sqrt(budgetRatio));
+    const float scale = std::clamp(std::round(idealScale / RESOLUTION_SCALE_STEP) * RESOLUTION_SCALE_STEP, _settings.minResolutionScale, 1.0f);
+    if (scale == _resolutionScale)
+    {
+        return;
+    }
+
+    _resolutionScale = scale;
+    _renderWidth = std::max(static_cast<uint32_t>(std::lround(static_cast<float>(_windowWidth) * scale)), 1u);
+    _renderHeight = std::max(static_cast<uint32_t>(std::lround(static_cast<float>(_windowHeight) * scale)), 1u);
+    _smoothedFrameTimeMs = 0.0;
+    _framesSinceResolutionChange = 0;
+    _accumulatedFrames = 0;
+}
+
+void Renderer::UpdateFrameLatency()
+{
+    const uint64_t completedValue = _vulkanContext->Timeline(QueueType::eGraphics).CompletedValue();
+    const auto now = std::chrono::steady_clock::now();
+
+    // The current slot holds the oldest frame, so the newest completed frame is reported last
+    for (uint32_t i = 0; i < _settings.framesInFlight; ++i)
+    {
+        const uint32_t frame = (_currentResourcesFrame + i) % _settings.framesInFlight;
+        std::optional<std::chrono::steady_clock::time_point>& latchTime = _frameLatchTimes.at(frame);
+        if (latchTime && _frameTimelineValues.at(frame) <= completedValue)
+        {
+            _framePacing.latencyMs = std::chrono::duration<double, std::milli>(now - *latchTime).count();
+            latchTime.reset();
+        }
+    }
+}
+
+std::vector<glm::vec4> Renderer::ReadAccumulation() const
+{
+    _vulkanContext->Device().waitIdle();
+
+    std::vector<glm::vec4> pixels(static_cast<size_t>(_accumulationExtent.width) * _accumulationExtent.height);
+    ReadTarget(*_accumulationTarget, std::as_writable_bytes(std::span { pixels }));
+    return pixels;
+}
+
+RenderOutputs Renderer::ReadOutputs() const
+{
+    _vulkanContext->Device().waitIdle();
+
+    const size_t pixelCount = static_cast<size_t>(_accumulationExtent.width) * _accumulationExtent.height;
+    RenderOutputs outputs {};
+    outputs.width = _accumulationExtent.width;
+    outputs.height = _accumulationExtent.height;
+    outputs.color.resize(pixelCount);
+    outputs.luminanceMoment.resize(pixelCount);
+    ReadTarget(*_accumulationTarget, std::as_writable_bytes(std::span { outputs.color }));
+    ReadTarget(*_luminanceMomentTarget, std::as_writable_bytes(std::span { outputs.luminanceMoment }));
+
+    if (_settings.auxiliaryOutputs)
+    {
+        outputs.albedo.resize(pixelCount);
+        outputs.normalDepth.resize(pixelCount);
+        outputs.objectIds.resize(pixelCount);
+        ReadTarget(*_albedoOutputTarget, std::as_writable_bytes(std::span { outputs.albedo }));
+        ReadTarget(*_normalDepthOutputTarget, std::as_writable_bytes(std::span { outputs.normalDepth }));
+        ReadTarget(*_objectIdOutputTarget, std::as_writable_bytes(std::span { outputs.objectIds }));
+    }
+    return outputs;
+}
+
+void Renderer::ReadTarget(const Image& target, std::span<std::byte> pixels) const
+{
+    BufferCreation readbackCreation {};
+    readbackCreation.SetName("Target Readback Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eTransferDst)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_TO_CPU)
+        .SetIsMappable(true)
+        .SetIsReadback(true)
+        .SetSize(pixels.size());
+    Buffer readbackBuffer { readbackCreation, _vulkanContext };
+
+    // Accumulated targets never leave the general layout, so they are copied from there
+    SingleTimeCommands commands { _vulkanContext };
+    commands.Record([&](vk::CommandBuffer commandBuffer)
+        {
+            VkCopyImageToBuffer(commandBuffer, target.image, readbackBuffer.buffer, _accumulationExtent.width, _accumulationExtent.height, vk::ImageLayout::eGeneral);
+            VkMemoryBarrier(commandBuffer, vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferWrite, vk::PipelineStageFlagBits2::eHost,
+                vk::AccessFlagBits2::eHostRead);
+        });
+    commands.Submit();
+
+    VkCheckResult(vmaInvalidateAllocation(_vulkanContext->MemoryAllocator(), readbackBuffer.allocation, 0, VK_WHOLE_SIZE), "[VULKAN] Failed invalidating target readback buffer!");
+    memcpy(pixels.data(), readbackBuffer.mappedPtr, pixels.size());
+}
+
+uint64_t Renderer::TracedSamples() const
+{
+    _vulkanContext->Device().waitIdle();
+
+    // Frames still in flight when the last frame was submitted haven't been added yet
+    uint64_t tracedSamples = _tracedSamples;
+    if (AdaptiveSamplingEnabled())
+    {
+        VkCheckResult(vmaInvalidateAllocation(_vulkanContext->MemoryAllocator(), _activePixelReadbackBuffer->allocation, 0, VK_WHOLE_SIZE),
+            "[VULKAN] Failed invalidating active pixel readback buffer!");
+        const uint32_t* activePixels = static_cast<const uint32_t*>(_activePixelReadbackBuffer->mappedPtr);
+        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+        {
+            tracedSamples += activePixels[i];
+        }
+    }
+    return tracedSamples;
+}
+
+vk::CommandBuffer Renderer::FrameCommandBuffer(uint32_t swapChainImageIndex, bool cameraMoved)
+{
+    if (!CommandReuseEnabled())
+    {
+        const vk::CommandBuffer commandBuffer = _commandBuffers.at(_currentResourcesFrame);
+        RecordCommandBuffer(commandBuffer, swapChainImageIndex, cameraMoved);
+        return commandBuffer;
+    }
+
+    // Only the flags change here, command buffers still in flight are recorded again once their frame slot comes around
+    const RecordedCommandsKey key { _renderWidth, _renderHeight, _pipeline, _tlas->Structure() };
+    if (key != _recordedCommandsKey)
+    {
+        for (RecordedCommands& recordedCommands : _recordedCommands)
+        {
+            recordedCommands.recorded = false;
+        }
+        _recordedCommandsKey = key;
+    }
+
+    const size_t index = (static_cast<size_t>(_currentResourcesFrame) * _swapChain->GetImageCount() + swapChainImageIndex) * 2 + (cameraMoved ? 1 : 0);
+    RecordedCommands& recordedCommands = _recordedCommands.at(index);
+    if (recordedCommands.recorded)
+    {
+        _gpuTimer->SetFrameSections(_currentResourcesFrame, recordedCommands.sections);
+        return recordedCommands.commandBuffer;
+    }
+
+    RecordCommandBuffer(recordedCommands.commandBuffer, swapChainImageIndex, cameraMoved);
+    recordedCommands.sections = _gpuTimer->FrameSections(_currentResourcesFrame);
+    recordedCommands.recorded = true;
+    return recordedCommands.commandBuffer;
+}
+
+void Renderer::RecordCommandBuffer(vk::CommandBuffer commandBuffer, uint32_t swapChainImageIndex, bool cameraMoved)
+{
+    commandBuffer.reset();
+
+    vk::CommandBufferBeginInfo commandBufferBeginInfo {};
+    VkCheckResult(commandBuffer.begin(&commandBufferBeginInfo), "[VULKAN] Failed to begin recording command buffer!");
+    RecordCommands(commandBuffer, swapChainImageIndex, cameraMoved);
+    commandBuffer.end();
+}
 
-    vk::StridedDeviceAddressRegionKHR callableShaderSbtEntry {};
-    commandBuffer.traceRaysKHR(_raygenAddressRegion, _missAddressRegion, _hitAddressRegion, callableShaderSbtEntry, _windowWidth, _windowHeight, 1, _vulkanContext->Dldi());
+void Renderer::RecordCommands(const vk::CommandBuffer& commandBuffer, uint32_t swapChainImageIndex, bool cameraMoved)
+{
+    _gpuTimer->BeginFrame(commandBuffer, _currentResourcesFrame);
+
+    DescribeFrame(swapChainImageIndex, cameraMoved);
+    _renderGraph->Compile();
+    _renderGraph->Execute(commandBuffer, *_gpuTimer);
 
-    VkTransitionImageLayout(commandBuffer, _swapChain->GetImage(swapChainImageIndex), _swapChain->GetFormat(),
-        vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
-    VkTransitionImageLayout(commandBuffer, _renderTarget->image, _renderTarget->format,
-        vk::ImageLayout::eGeneral, vk::ImageLayout::eTransferSrcOptimal);
+    _gpuTimer->EndFrame(commandBuffer);
+}
 
-    vk::Extent2D extent = { _windowWidth, _windowHeight };
-    VkCopyImageToImage(commandBuffer, _renderTarget->image, _swapChain->GetImage(swapChainImageIndex), extent, extent);
+void Renderer::DescribeFrame(uint32_t swapChainImageIndex, bool cameraMoved)
+{
+    RenderGraph& graph = *_renderGraph;
+    graph.Reset();
+
+    const auto importImage = [&](const Image& image, std::string_view name)
+    { return graph.ImportImage(name, image.image, image.format); };
+    const RenderGraph::ResourceId renderTarget = importImage(*_renderTarget, "Render Target");
+    const RenderGraph::ResourceId accumulation = importImage(*_accumulationTarget, "Accumulation Target");
+    const RenderGraph::ResourceId directLighting = importImage(*_directLightingTarget, "Direct Lighting Target");
+    const RenderGraph::ResourceId luminanceMoment = importImage(*_luminanceMomentTarget, "Luminance Moment Target");
+    const RenderGraph::ResourceId albedoOutput = importImage(*_albedoOutputTarget, "Albedo Output Target");
+    const RenderGraph::ResourceId normalDepthOutput = importImage(*_normalDepthOutputTarget, "Normal Depth Output Target");
+    const RenderGraph::ResourceId objectIdOutput = importImage(*_objectIdOutputTarget, "Object Id Output Target");
+    const RenderGraph::ResourceId depth = importImage(*_depthTarget, "Depth Target");
+    const RenderGraph::ResourceId depthHistory = importImage(*_depthHistory, "Depth History");
+    const RenderGraph::ResourceId accumulationHistory = importImage(*_accumulationHistory, "Accumulation History");
+    const RenderGraph::ResourceId luminanceMomentHistory = importImage(*_luminanceMomentHistory, "Luminance Moment History");
+    // Its previous contents are never read, the acquire semaphore is waited on at the color attachment output stage, see Render
+    const RenderGraph::ResourceId swapChainImage = graph.ImportImage("Swap Chain Image", _swapChain->GetImage(swapChainImageIndex), _swapChain->GetFormat(),
+        vk::ImageLayout::eUndefined, vk::PipelineStageFlagBits2::eColorAttachmentOutput, vk::ImageLayout::ePresentSrcKHR);
+
+    // Both counters are read on the host once the frame's timeline value is reached
+    const RenderGraph::ResourceId statistics = graph.ImportBuffer("Statistics Buffer", _statisticsBuffer->buffer, vk::PipelineStageFlagBits2::eHost, vk::AccessFlagBits2::eHostRead);
+    const RenderGraph::ResourceId activePixelReadback = graph.ImportBuffer("Active Pixel Readback Buffer", _activePixelReadbackBuffer->buffer,
+        vk::PipelineStageFlagBits2::eHost, vk::AccessFlagBits2::eHostRead);
+    const RenderGraph::ResourceId activePixels = graph.ImportBuffer("Active Pixel Buffer", _activePixelBuffer->buffer);
+    const RenderGraph::ResourceId restirSurfaces = graph.ImportBuffer("ReSTIR Surface Buffer", _restirSurfaceBuffer->buffer);
+    const RenderGraph::ResourceId restirReservoirs = graph.ImportBuffer("ReSTIR Reservoir Buffer", _restirReservoirBuffer->buffer);
+
+    // Copying on the very first frame is harmless, the shaders ignore the history then
+    if (cameraMoved && _settings.temporalReprojection && !AdaptiveSamplingEnabled())
+    {
+        graph.AddPass("Reprojection History",
+            {
+                RenderGraph::Read(depth, TRANSFER_STAGE),
+                RenderGraph::Read(accumulation, TRANSFER_STAGE),
+                RenderGraph::Read(luminanceMoment, TRANSFER_STAGE),
+                RenderGraph::Write(depthHistory, TRANSFER_STAGE),
+                RenderGraph::Write(accumulationHistory, TRANSFER_STAGE),
+                RenderGraph::Write(luminanceMomentHistory, TRANSFER_STAGE),
+            },
+            [this](vk::CommandBuffer commandBuffer)
+            { RecordHistoryCopies(commandBuffer); });
+    }
+
+    if (AdaptiveSamplingEnabled())
+    {
+        // Resets the list to an empty launch of width zero, one row and one layer
+        graph.AddPass("Active Pixel Reset", { RenderGraph::Write(activePixels, TRANSFER_STAGE) }, [this](vk::CommandBuffer commandBuffer)
+            {
+                const std::array<uint32_t, 4> emptyLaunch { 0, 1, 1, 0 };
+                commandBuffer.updateBuffer(_activePixelBuffer->buffer, 0, sizeof(emptyLaunch), emptyLaunch.data()); },
+            false);
+
+        AdaptiveSamplingPushConstants adaptivePushConstants {};
+        adaptivePushConstants.frameIndex = _accumulatedFrames;
+        adaptivePushConstants.minSamples = _settings.adaptiveMinSamples;
+        adaptivePushConstants.maxSamples = _settings.adaptiveMaxSamples;
+        adaptivePushConstants.errorThreshold = _settings.adaptiveErrorThreshold;
+
+        graph.AddPass("Adaptive Mask",
+            {
+                RenderGraph::Read(accumulation, COMPUTE_STAGE),
+                RenderGraph::Read(luminanceMoment, COMPUTE_STAGE),
+                RenderGraph::ReadWrite(activePixels, COMPUTE_STAGE),
+            },
+            [this, adaptivePushConstants](vk::CommandBuffer commandBuffer)
+            { _adaptiveMaskPipeline->Dispatch(commandBuffer, _windowWidth, _windowHeight, adaptivePushConstants); });
+
+        const uint32_t readbackOffset = _currentResourcesFrame * static_cast<uint32_t>(sizeof(uint32_t));
+        graph.AddPass("Active Pixel Readback",
+            {
+                RenderGraph::Read(activePixels, TRANSFER_STAGE),
+                RenderGraph::Write(activePixelReadback, TRANSFER_STAGE),
+            },
+            [this, readbackOffset](vk::CommandBuffer commandBuffer)
+            { VkCopyBufferToBuffer(commandBuffer, _activePixelBuffer->buffer, _activePixelReadbackBuffer->buffer, sizeof(uint32_t), readbackOffset); },
+            false);
+    }
 
-    VkTransitionImageLayout(commandBuffer, _swapChain->GetImage(swapChainImageIndex), _swapChain->GetFormat(),
-        vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::ePresentSrcKHR);
+    if (RestirEnabled())
+    {
+        graph.AddPass("ReSTIR Candidates",
+            {
+                RenderGraph::ReadWrite(restirSurfaces, RAY_TRACING_STAGE),
+                RenderGraph::ReadWrite(restirReservoirs, RAY_TRACING_STAGE),
+                RenderGraph::ReadWrite(statistics, RAY_TRACING_STAGE),
+            },
+            [this](vk::CommandBuffer commandBuffer)
+            {
+                BindRayTracingState(commandBuffer);
+                commandBuffer.traceRaysKHR(_shaderBindingTable->RaygenRegion(RESTIR_CANDIDATES_RAYGEN_INDEX), _shaderBindingTable->MissRegion(), _shaderBindingTable->HitRegion(),
+                    _shaderBindingTable->CallableRegion(), _renderWidth, _renderHeight, 1, _vulkanContext->Dldi()); });
+
+        graph.AddPass("ReSTIR Spatial",
+            {
+                RenderGraph::ReadWrite(restirSurfaces, RAY_TRACING_STAGE),
+                RenderGraph::ReadWrite(restirReservoirs, RAY_TRACING_STAGE),
+                RenderGraph::ReadWrite(statistics, RAY_TRACING_STAGE),
+                RenderGraph::Write(directLighting, RAY_TRACING_STAGE),
+            },
+            [this](vk::CommandBuffer commandBuffer)
+            {
+                BindRayTracingState(commandBuffer);
+                commandBuffer.traceRaysKHR(_shaderBindingTable->RaygenRegion(RESTIR_SPATIAL_RAYGEN_INDEX), _shaderBindingTable->MissRegion(), _shaderBindingTable->HitRegion(),
+                    _shaderBindingTable->CallableRegion(), _renderWidth, _renderHeight, 1, _vulkanContext->Dldi()); });
+    }
+
+    std::vector<RenderGraph::Access> pathTracingAccesses {
+        RenderGraph::Write(renderTarget, RAY_TRACING_STAGE),
+        RenderGraph::ReadWrite(accumulation, RAY_TRACING_STAGE),
+        RenderGraph::ReadWrite(luminanceMoment, RAY_TRACING_STAGE),
+        RenderGraph::Write(_illuminationTarget, RAY_TRACING_STAGE),
+        RenderGraph::Write(_albedoTarget, RAY_TRACING_STAGE),
+        RenderGraph::Write(_normalDepthTarget, RAY_TRACING_STAGE),
+        RenderGraph::Write(_motionTarget, RAY_TRACING_STAGE),
+        RenderGraph::ReadWrite(albedoOutput, RAY_TRACING_STAGE),
+        RenderGraph::ReadWrite(normalDepthOutput, RAY_TRACING_STAGE),
+        RenderGraph::Write(objectIdOutput, RAY_TRACING_STAGE),
+        RenderGraph::Write(depth, RAY_TRACING_STAGE),
+        RenderGraph::Read(depthHistory, RAY_TRACING_STAGE),
+        RenderGraph::Read(accumulationHistory, RAY_TRACING_STAGE),
+        RenderGraph::Read(luminanceMomentHistory, RAY_TRACING_STAGE),
+        RenderGraph::ReadWrite(statistics, RAY_TRACING_STAGE),
+    };
+    if (RestirEnabled())
+    {
+        pathTracingAccesses.push_back(RenderGraph::Read(directLighting, RAY_TRACING_STAGE));
+    }
+    if (AdaptiveSamplingEnabled())
+    {
+        // The launch size is read from the list's header, the pixel coordinates by the shader
+        pathTracingAccesses.push_back(RenderGraph::Access { activePixels, vk::PipelineStageFlagBits2::eDrawIndirect | RAY_TRACING_STAGE,
+            vk::AccessFlagBits2::eIndirectCommandRead | vk::AccessFlagBits2::eShaderStorageRead });
+    }
+    graph.AddPass("Path Tracing", std::move(pathTracingAccesses), [this](vk::CommandBuffer commandBuffer)
+        {
+            BindRayTracingState(commandBuffer);
+            if (AdaptiveSamplingEnabled())
+            {
+                commandBuffer.traceRaysIndirectKHR(_shaderBindingTable->RaygenRegion(), _shaderBindingTable->MissRegion(), _shaderBindingTable->HitRegion(), _shaderBindingTable->CallableRegion(),
+                    _vulkanContext->GetBufferDeviceAddress(_activePixelBuffer->buffer), _vulkanContext->Dldi());
+            }
+            else
+            {
+                commandBuffer.traceRaysKHR(_shaderBindingTable->RaygenRegion(), _shaderBindingTable->MissRegion(), _shaderBindingTable->HitRegion(), _shaderBindingTable->CallableRegion(),
+                    _renderWidth, _renderHeight, 1, _vulkanContext->Dldi());
+            } });
+
+    if (_denoiser)
+    {
+        _denoiser->AddPasses(graph, renderTarget, vk::Extent2D { _renderWidth, _renderHeight });
+    }
+
+    RenderGraph::ResourceId tonemapInput = renderTarget;
+    if (_upscalePipeline)
+    {
+        const UpscalePushConstants upscalePushConstants { _renderWidth, _renderHeight };
+        graph.AddPass("Upscale", { RenderGraph::Read(renderTarget, COMPUTE_STAGE), RenderGraph::Write(*_upscaledTarget, COMPUTE_STAGE) },
+            [this, upscalePushConstants](vk::CommandBuffer commandBuffer)
+            { _upscalePipeline->Dispatch(commandBuffer, _windowWidth, _windowHeight, upscalePushConstants); });
+        tonemapInput = *_upscaledTarget;
+    }
+
+    TonemapPushConstants tonemapPushConstants {};
+    tonemapPushConstants.exposure = std::exp2(_settings.exposure);
+    tonemapPushConstants.tonemapOperator = static_cast<uint32_t>(_settings.tonemapOperator);
+    // Storage writes never encode, only blits into sRGB formats do
+    tonemapPushConstants.encodeSrgb = !_displayTarget || !IsSrgbFormat(_swapChain->GetFormat());
+    tonemapPushConstants.outputIndex = _displayTarget ? 0 : swapChainImageIndex;
+
+    graph.AddPass("Tonemap", { RenderGraph::Read(tonemapInput, COMPUTE_STAGE), RenderGraph::Write(_displayTarget.value_or(swapChainImage), COMPUTE_STAGE) },
+        [this, tonemapPushConstants](vk::CommandBuffer commandBuffer)
+        { _tonemapPipeline->Dispatch(commandBuffer, _windowWidth, _windowHeight, tonemapPushConstants); });
+
+    if (_displayTarget)
+    {
+        graph.AddPass("Display Blit",
+            {
+                RenderGraph::Read(*_displayTarget, TRANSFER_STAGE, vk::ImageLayout::eTransferSrcOptimal),
+                RenderGraph::Write(swapChainImage, TRANSFER_STAGE, vk::ImageLayout::eTransferDstOptimal),
+            },
+            [this, swapChainImageIndex](vk::CommandBuffer commandBuffer)
+            {
+                const vk::Extent2D extent = { _windowWidth, _windowHeight };
+                VkCopyImageToImage(commandBuffer, _renderGraph->Image(*_displayTarget), _swapChain->GetImage(swapChainImageIndex), extent, extent); },
+            false);
+    }
+}
+
+void Renderer::BindRayTracingState(vk::CommandBuffer commandBuffer) const
+{
+    commandBuffer.bindPipeline(vk::PipelineBindPoint::eRayTracingKHR, _pipeline);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, _pipelineLayout, 0, _bindlessResources->DescriptorSet(), nullptr);
+    const auto cameraOffset = static_cast<uint32_t>(_currentResourcesFrame * _uniformBufferStride);
+    commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eRayTracingKHR, _pipelineLayout, 1, _descriptorSet, cameraOffset);
+
+    PathTracingPushConstants pushConstants {};
+    pushConstants.maxPathDepth = _settings.maxPathDepth;
+    pushConstants.russianRouletteDepth = _settings.russianRouletteDepth;
+    pushConstants.resourcesFrame = _currentResourcesFrame;
+    pushConstants.lightCount = _settings.emissiveLightSampling ? _lightCount : 0;
+    pushConstants.restirCandidateCount = RestirEnabled() ? _settings.restirCandidateCount : 0;
+    pushConstants.restirSpatialSampleCount = _settings.restirSpatialSampleCount;
+    pushConstants.restirSpatialRadius = _settings.restirSpatialRadius;
+    pushConstants.restirHistoryLimit = _settings.restirHistoryLimit;
+    pushConstants.environmentMapIndex = _environmentMap.handle;
+    pushConstants.environmentPdfScale = _settings.environmentImportanceSampling ? _environmentPdfScale : 0.0f;
+    pushConstants.samplerType = static_cast<uint32_t>(_settings.sampler);
+    pushConstants.samplerSeed = _settings.samplerSeed;
+    pushConstants.adaptiveSampling = AdaptiveSamplingEnabled();
+    pushConstants.denoising = _settings.denoising;
+    pushConstants.auxiliaryOutputs = _settings.auxiliaryOutputs;
+    pushConstants.renderWidth = _renderWidth;
+    pushConstants.renderHeight = _renderHeight;
+    pushConstants.reprojectionHistoryLimit = _settings.temporalReprojection ? _settings.reprojectionHistoryLimit : 0;
+    pushConstants.sunDirection = glm::vec4(glm::normalize(_settings.sunDirection), 0.0f);
+    pushConstants.sunIrradiance = glm::vec4(_settings.sunIrradiance, 0.0f);
+    commandBuffer.pushConstants(_pipelineLayout, PUSH_CONSTANT_STAGES, 0, sizeof(PathTracingPushConstants), &pushConstants);
+
+    if (_settings.boundedRayRecursion)
+    {
+        commandBuffer.setRayTracingPipelineStackSizeKHR(static_cast<uint32_t>(_pipelineStackSize), _vulkanContext->Dldi());
+    }
+}
+
+void Renderer::RecordHistoryCopies(const vk::CommandBuffer& commandBuffer)
+{
+    // The path tracing pass reprojects from these while it overwrites the targets, only the traced region holds anything
+    vk::ImageCopy region {};
+    region.srcSubresource = vk::ImageSubresourceLayers { vk::ImageAspectFlagBits::eColor, 0, 0, 1 };
+    region.dstSubresource = region.srcSubresource;
+    region.extent = vk::Extent3D { _renderWidth, _renderHeight, 1 };
+
+    commandBuffer.copyImage(_depthTarget->image, vk::ImageLayout::eGeneral, _depthHistory->image, vk::ImageLayout::eGeneral, 1, &region);
+    commandBuffer.copyImage(_accumulationTarget->image, vk::ImageLayout::eGeneral, _accumulationHistory->image, vk::ImageLayout::eGeneral, 1, &region);
+    commandBuffer.copyImage(_luminanceMomentTarget->image, vk::ImageLayout::eGeneral, _luminanceMomentHistory->image, vk::ImageLayout::eGeneral, 1, &region);
+}
+
+Renderer::FrameUniformData Renderer::FrameData() const
+{
+    FrameUniformData frameData {};
+    frameData.viewInverse = glm::inverse(_view);
+    frameData.projInverse = glm::inverse(_projection);
+    frameData.viewProjection = _projection * _view;
+    frameData.previousViewProjection = _previousViewProjection;
+    return frameData;
 }
 
 void Renderer::InitializeCommandBuffers()
@@ -140,51 +765,436 @@ void Renderer::InitializeCommandBuffers()
     commandBufferAllocateInfo.commandBufferCount = _commandBuffers.size();
 
     VkCheckResult(_vulkanContext->Device().allocateCommandBuffers(&commandBufferAllocateInfo, _commandBuffers.data()), "[VULKAN] Failed allocating command buffer!");
+
+    if (!_settings.reuseCommandBuffers)
+    {
+        return;
+    }
+
+    std::vector<vk::CommandBuffer> recordedCommandBuffers(static_cast<size_t>(_settings.framesInFlight) * _swapChain->GetImageCount() * 2);
+    commandBufferAllocateInfo.commandBufferCount = static_cast<uint32_t>(recordedCommandBuffers.size());
+    VkCheckResult(_vulkanContext->Device().allocateCommandBuffers(&commandBufferAllocateInfo, recordedCommandBuffers.data()), "[VULKAN] Failed allocating command buffer!");
+
+    _recordedCommands.resize(recordedCommandBuffers.size());
+    for (size_t i = 0; i < recordedCommandBuffers.size(); ++i)
+    {
+        _recordedCommands.at(i).commandBuffer = recordedCommandBuffers.at(i);
+    }
 }
 
 void Renderer::InitializeSynchronizationObjects()
 {
     vk::SemaphoreCreateInfo semaphoreCreateInfo {};
-    vk::FenceCreateInfo fenceCreateInfo {};
-    fenceCreateInfo.flags = vk::FenceCreateFlagBits::eSignaled;
 
     std::string errorMsg { "[VULKAN] Failed creating sync object!" };
     for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
     {
         VkCheckResult(_vulkanContext->Device().createSemaphore(&semaphoreCreateInfo, nullptr, &_imageAvailableSemaphores.at(i)), errorMsg);
         VkCheckResult(_vulkanContext->Device().createSemaphore(&semaphoreCreateInfo, nullptr, &_renderFinishedSemaphores.at(i)), errorMsg);
-        VkCheckResult(_vulkanContext->Device().createFence(&fenceCreateInfo, nullptr, &_inFlightFences.at(i)), errorMsg);
     }
 }
 
+void Renderer::InitializeStatistics()
+{
+    constexpr vk::DeviceSize statisticsBufferSize = sizeof(uint32_t) * MAX_FRAMES_IN_FLIGHT;
+    BufferCreation statisticsBufferCreation {};
+    statisticsBufferCreation.SetName("Statistics Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eStorageBuffer)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_TO_CPU)
+        .SetIsMappable(true)
+        .SetIsReadback(true)
+        .SetSize(statisticsBufferSize);
+    _statisticsBuffer = std::make_unique<Buffer>(statisticsBufferCreation, _vulkanContext);
+    memset(_statisticsBuffer->mappedPtr, 0, statisticsBufferSize);
+    VkCheckResult(vmaFlushAllocation(_vulkanContext->MemoryAllocator(), _statisticsBuffer->allocation, 0, VK_WHOLE_SIZE), "[VULKAN] Failed flushing statistics buffer!");
+}
+
 void Renderer::InitializeRenderTarget()
 {
     ImageCreation imageCreation {};
     imageCreation.SetName("Render Target")
         .SetSize(_windowWidth, _windowHeight)
-        .SetFormat(_swapChain->GetFormat())
-        .SetUsageFlags(vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eStorage);
+        .SetFormat(vk::Format::eR16G16B16A16Sfloat)
+        .SetUsageFlags(vk::ImageUsageFlagBits::eStorage);
 
     _renderTarget = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    imageCreation.SetName("Accumulation Target")
+        .SetFormat(vk::Format::eR32G32B32A32Sfloat)
+        .SetUsageFlags(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc);
+
+    _accumulationTarget = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    imageCreation.SetName("Direct Lighting Target");
+    _directLightingTarget = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    imageCreation.SetName("Luminance Moment Target")
+        .SetFormat(vk::Format::eR32Sfloat);
+    _luminanceMomentTarget = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    // The ray generation shader only writes the denoiser inputs when denoising, otherwise they just have to be bindable.
+    // The denoiser reads them within the same frame, so their memory is shared with other transient images
+    const uint32_t denoiserWidth = _settings.denoising ? _windowWidth : 1;
+    const uint32_t denoiserHeight = _settings.denoising ? _windowHeight : 1;
+    _illuminationTarget = _renderGraph->CreateTransientImage({ "Illumination Target", denoiserWidth, denoiserHeight, vk::Format::eR16G16B16A16Sfloat, vk::ImageUsageFlagBits::eStorage });
+    _albedoTarget = _renderGraph->CreateTransientImage({ "Albedo Target", denoiserWidth, denoiserHeight, vk::Format::eR16G16B16A16Sfloat, vk::ImageUsageFlagBits::eStorage });
+    _normalDepthTarget = _renderGraph->CreateTransientImage({ "Normal Depth Target", denoiserWidth, denoiserHeight, vk::Format::eR32G32B32A32Sfloat, vk::ImageUsageFlagBits::eStorage });
+
+    // Reprojection needs the motion vectors as well
+    const uint32_t motionWidth = _settings.denoising || _settings.temporalReprojection ? _windowWidth : 1;
+    const uint32_t motionHeight = _settings.denoising || _settings.temporalReprojection ? _windowHeight : 1;
+    _motionTarget = _renderGraph->CreateTransientImage({ "Motion Target", motionWidth, motionHeight, vk::Format::eR32G32Sfloat, vk::ImageUsageFlagBits::eStorage });
+
+    const uint32_t historyWidth = _settings.temporalReprojection ? _windowWidth : 1;
+    const uint32_t historyHeight = _settings.temporalReprojection ? _windowHeight : 1;
+    imageCreation.SetName("Depth Target")
+        .SetSize(historyWidth, historyHeight)
+        .SetFormat(vk::Format::eR32Sfloat)
+        .SetUsageFlags(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc);
+    _depthTarget = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    imageCreation.SetName("Depth History")
+        .SetUsageFlags(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferDst);
+    _depthHistory = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    imageCreation.SetName("Luminance Moment History");
+    _luminanceMomentHistory = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    imageCreation.SetName("Accumulation History")
+        .SetFormat(vk::Format::eR32G32B32A32Sfloat);
+    _accumulationHistory = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    const uint32_t auxiliaryWidth = _settings.auxiliaryOutputs ? _windowWidth : 1;
+    const uint32_t auxiliaryHeight = _settings.auxiliaryOutputs ? _windowHeight : 1;
+    imageCreation.SetName("Albedo Output Target")
+        .SetSize(auxiliaryWidth, auxiliaryHeight)
+        .SetFormat(vk::Format::eR32G32B32A32Sfloat)
+        .SetUsageFlags(vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc);
+    _albedoOutputTarget = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    imageCreation.SetName("Normal Depth Output Target");
+    _normalDepthOutputTarget = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    imageCreation.SetName("Object Id Output Target")
+        .SetFormat(vk::Format::eR32G32Sfloat);
+    _objectIdOutputTarget = std::make_unique<Image>(imageCreation, _vulkanContext);
+
+    // Samples are accumulated across frames, so these targets stay in the general layout for their whole lifetime.
+    // The render target is only ever written by shaders and read by the tonemap pass, so it does as well
+    SingleTimeCommands commands { _vulkanContext };
+    commands.Record([&](vk::CommandBuffer commandBuffer)
+        {
+            VkTransitionImageLayout(commandBuffer, _renderTarget->image, _renderTarget->format, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
+            VkTransitionImageLayout(commandBuffer, _accumulationTarget->image, _accumulationTarget->format, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
+            VkTransitionImageLayout(commandBuffer, _directLightingTarget->image, _directLightingTarget->format, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
+            VkTransitionImageLayout(commandBuffer, _luminanceMomentTarget->image, _luminanceMomentTarget->format, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
+            for (const Image* target : { _albedoOutputTarget.get(), _normalDepthOutputTarget.get(), _objectIdOutputTarget.get(), _depthTarget.get(), _depthHistory.get(),
+                     _accumulationHistory.get(), _luminanceMomentHistory.get() })
+            {
+                VkTransitionImageLayout(commandBuffer, target->image, target->format, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
+            } });
+    commands.Submit();
+}
+
+void Renderer::InitializeRestirResources()
+{
+    // Two surfaces and two reservoirs per pixel, see shaders/restir.glsl. Only allocated in full when the passes run
+    const vk::DeviceSize pixelCount = RestirEnabled() ? static_cast<vk::DeviceSize>(_windowWidth) * _windowHeight : 1;
+
+    BufferCreation bufferCreation {};
+    bufferCreation.SetName("ReSTIR Surface Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+        .SetIsMappable(false)
+        .SetSize(2 * pixelCount * RESTIR_SURFACE_SIZE);
+    _restirSurfaceBuffer = std::make_unique<Buffer>(bufferCreation, _vulkanContext);
+
+    bufferCreation.SetName("ReSTIR Reservoir Buffer")
+        .SetSize(2 * pixelCount * RESTIR_RESERVOIR_SIZE);
+    _restirReservoirBuffer = std::make_unique<Buffer>(bufferCreation, _vulkanContext);
+
+    // Zeroed history never passes the surface similarity test, so the first frame starts without temporal reuse
+    SingleTimeCommands commands { _vulkanContext, QueueType::eTransfer };
+    commands.Record([&](vk::CommandBuffer commandBuffer)
+        {
+            commandBuffer.fillBuffer(_restirSurfaceBuffer->buffer, 0, vk::WholeSize, 0);
+            commandBuffer.fillBuffer(_restirReservoirBuffer->buffer, 0, vk::WholeSize, 0); });
+    _pendingFrameWaits.push_back(_vulkanContext->TimelineWait(QueueType::eTransfer, commands.Submit()));
+}
+
+void Renderer::InitializeLights(std::span<const EmissiveTriangle> emissiveTriangles)
+{
+    const std::vector<TriangleLight> lights = BuildTriangleLights(emissiveTriangles);
+    _lightCount = static_cast<uint32_t>(lights.size());
+    spdlog::info("[LIGHTS] {} emissive triangles", _lightCount);
+
+    // Scenes without emissive geometry still need a valid buffer to bind
+    const vk::DeviceSize bufferSize = std::max<size_t>(lights.size(), 1) * sizeof(TriangleLight);
+
+    BufferCreation stagingBufferCreation {};
+    stagingBufferCreation.SetName("Light Staging Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
+        .SetIsMappable(true)
+        .SetSize(bufferSize);
+    Buffer stagingBuffer(stagingBufferCreation, _vulkanContext);
+    memcpy(stagingBuffer.mappedPtr, lights.data(), lights.size() * sizeof(TriangleLight));
+
+    BufferCreation lightBufferCreation {};
+    lightBufferCreation.SetName("Light Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+        .SetIsMappable(false)
+        .SetSize(bufferSize);
+    _lightBuffer = std::make_unique<Buffer>(lightBufferCreation, _vulkanContext);
+
+    SingleTimeCommands commands { _vulkanContext, QueueType::eTransfer };
+    commands.Record([&](vk::CommandBuffer commandBuffer)
+        { VkCopyBufferToBuffer(commandBuffer, stagingBuffer.buffer, _lightBuffer->buffer, bufferSize); });
+    _pendingFrameWaits.push_back(_vulkanContext->TimelineWait(QueueType::eTransfer, commands.Submit()));
+}
+
+void Renderer::InitializeEnvironment()
+{
+    std::optional<EnvironmentMap> environmentMap {};
+    if (!_settings.environmentMap.empty())
+    {
+        environmentMap = LoadEnvironmentMap(_settings.environmentMap);
+    }
+
+    if (environmentMap.has_value())
+    {
+        const auto samplingStart = std::chrono::high_resolution_clock::now();
+        BuildEnvironmentSampling(*environmentMap);
+        const std::chrono::duration<double, std::milli> samplingDuration = std::chrono::high_resolution_clock::now() - samplingStart;
+        spdlog::info("[ENVIRONMENT] {}x{} sampling table built in {:.2f} ms", environmentMap->width, environmentMap->height, samplingDuration.count());
+
+        std::vector<std::byte> data(environmentMap->texels.size() * sizeof(glm::vec4));
+        memcpy(data.data(), environmentMap->texels.data(), data.size());
+
+        ImageCreation imageCreation {};
+        imageCreation.SetName("Environment Map")
+            .SetSize(environmentMap->width, environmentMap->height)
+            .SetFormat(vk::Format::eR32G32B32A32Sfloat)
+            .SetUsageFlags(vk::ImageUsageFlagBits::eSampled)
+            .SetData(data);
+        _environmentMap = _bindlessResources->Images().Create(imageCreation);
+        _environmentPdfScale = environmentMap->pdfScale;
+    }
+
+    // Without an environment map the shaders fall back to a constant sky and never read the table, it only has to be bindable
+    const std::span<const AliasTableEntry> aliasTable = environmentMap.has_value() ? std::span<const AliasTableEntry> { environmentMap->aliasTable } : std::span<const AliasTableEntry> {};
+    const vk::DeviceSize bufferSize = std::max<size_t>(aliasTable.size(), 1) * sizeof(AliasTableEntry);
+
+    BufferCreation stagingBufferCreation {};
+    stagingBufferCreation.SetName("Environment Alias Table Staging Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
+        .SetIsMappable(true)
+        .SetSize(bufferSize);
+    Buffer stagingBuffer(stagingBufferCreation, _vulkanContext);
+    memcpy(stagingBuffer.mappedPtr, aliasTable.data(), aliasTable.size_bytes());
+
+    BufferCreation aliasTableBufferCreation {};
+    aliasTableBufferCreation.SetName("Environment Alias Table Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+        .SetIsMappable(false)
+        .SetSize(bufferSize);
+    _environmentAliasTableBuffer = std::make_unique<Buffer>(aliasTableBufferCreation, _vulkanContext);
+
+    SingleTimeCommands commands { _vulkanContext, QueueType::eTransfer };
+    commands.Record([&](vk::CommandBuffer commandBuffer)
+        { VkCopyBufferToBuffer(commandBuffer, stagingBuffer.buffer, _environmentAliasTableBuffer->buffer, bufferSize); });
+    _pendingFrameWaits.push_back(_vulkanContext->TimelineWait(QueueType::eTransfer, commands.Submit()));
+}
+
+void Renderer::InitializeBlueNoise()
+{
+    const auto generationStart = std::chrono::high_resolution_clock::now();
+    const std::vector<float> firstTile = GenerateBlueNoise(BLUE_NOISE_SIZE, 1);
+    const std::vector<float> secondTile = GenerateBlueNoise(BLUE_NOISE_SIZE, 2);
+    const std::chrono::duration<double, std::milli> generationDuration = std::chrono::high_resolution_clock::now() - generationStart;
+    spdlog::info("[SAMPLING] Generated {0}x{0} blue noise in {1:.2f} ms", BLUE_NOISE_SIZE, generationDuration.count());
+
+    std::vector<glm::vec2> blueNoise(firstTile.size());
+    for (size_t i = 0; i < blueNoise.size(); ++i)
+    {
+        blueNoise[i] = glm::vec2 { firstTile[i], secondTile[i] };
+    }
+    const vk::DeviceSize bufferSize = blueNoise.size() * sizeof(glm::vec2);
+
+    BufferCreation stagingBufferCreation {};
+    stagingBufferCreation.SetName("Blue Noise Staging Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eTransferSrc)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_CPU_ONLY)
+        .SetIsMappable(true)
+        .SetSize(bufferSize);
+    Buffer stagingBuffer(stagingBufferCreation, _vulkanContext);
+    memcpy(stagingBuffer.mappedPtr, blueNoise.data(), bufferSize);
+
+    BufferCreation blueNoiseBufferCreation {};
+    blueNoiseBufferCreation.SetName("Blue Noise Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+        .SetIsMappable(false)
+        .SetSize(bufferSize);
+    _blueNoiseBuffer = std::make_unique<Buffer>(blueNoiseBufferCreation, _vulkanContext);
+
+    SingleTimeCommands commands { _vulkanContext, QueueType::eTransfer };
+    commands.Record([&](vk::CommandBuffer commandBuffer)
+        { VkCopyBufferToBuffer(commandBuffer, stagingBuffer.buffer, _blueNoiseBuffer->buffer, bufferSize); });
+    _pendingFrameWaits.push_back(_vulkanContext->TimelineWait(QueueType::eTransfer, commands.Submit()));
+}
+
+void Renderer::InitializeAdaptiveSampling()
+{
+    // Without adaptive sampling the list is never filled, it only has to be bindable
+    const vk::DeviceSize pixelCount = AdaptiveSamplingEnabled() ? static_cast<vk::DeviceSize>(_windowWidth) * _windowHeight : 1;
+
+    BufferCreation activePixelBufferCreation {};
+    activePixelBufferCreation.SetName("Active Pixel Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eShaderDeviceAddress
+            | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_ONLY)
+        .SetIsMappable(false)
+        .SetSize(ACTIVE_PIXEL_HEADER_SIZE + pixelCount * sizeof(uint32_t));
+    _activePixelBuffer = std::make_unique<Buffer>(activePixelBufferCreation, _vulkanContext);
+
+    constexpr vk::DeviceSize readbackBufferSize = sizeof(uint32_t) * MAX_FRAMES_IN_FLIGHT;
+    BufferCreation readbackBufferCreation {};
+    readbackBufferCreation.SetName("Active Pixel Readback Buffer")
+        .SetUsageFlags(vk::BufferUsageFlagBits::eTransferDst)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_GPU_TO_CPU)
+        .SetIsMappable(true)
+        .SetIsReadback(true)
+        .SetSize(readbackBufferSize);
+    _activePixelReadbackBuffer = std::make_unique<Buffer>(readbackBufferCreation, _vulkanContext);
+    memset(_activePixelReadbackBuffer->mappedPtr, 0, readbackBufferSize);
+    VkCheckResult(vmaFlushAllocation(_vulkanContext->MemoryAllocator(), _activePixelReadbackBuffer->allocation, 0, VK_WHOLE_SIZE),
+        "[VULKAN] Failed flushing active pixel readback buffer!");
+
+    if (!AdaptiveSamplingEnabled())
+    {
+        return;
+    }
+
+    ComputePipelineCreation pipelineCreation {};
+    pipelineCreation.SetName("Adaptive Mask Pipeline")
+        .SetShaderPath("shaders/bin/adaptive_mask.comp.spv")
+        .AddBinding(0, vk::DescriptorType::eStorageImage)
+        .AddBinding(1, vk::DescriptorType::eStorageImage)
+        .AddBinding(2, vk::DescriptorType::eStorageBuffer)
+        .SetPushConstantSize(sizeof(AdaptiveSamplingPushConstants));
+    _adaptiveMaskPipeline = std::make_unique<ComputePipeline>(pipelineCreation, _vulkanContext);
+
+    _adaptiveMaskPipeline->WriteDescriptor(0, _accumulationTarget->view);
+    _adaptiveMaskPipeline->WriteDescriptor(1, _luminanceMomentTarget->view);
+    _adaptiveMaskPipeline->WriteDescriptor(2, _activePixelBuffer->buffer);
+}
+
+void Renderer::InitializeDenoiser()
+{
+    if (!_settings.denoising)
+    {
+        return;
+    }
+
+    SvgfInputs inputs {};
+    inputs.illumination = _illuminationTarget;
+    inputs.albedo = _albedoTarget;
+    inputs.normalDepth = _normalDepthTarget;
+    inputs.motion = _motionTarget;
+    _denoiser = std::make_unique<SvgfDenoiser>(inputs, _windowWidth, _windowHeight, _settings.denoiserFilterIterations, *_renderGraph, _vulkanContext);
+}
+
+void Renderer::InitializeUpscaler()
+{
+    if (!_settings.dynamicResolution)
+    {
+        return;
+    }
+
+    _upscaledTarget = _renderGraph->CreateTransientImage({ "Upscaled Target", _windowWidth, _windowHeight, vk::Format::eR16G16B16A16Sfloat, vk::ImageUsageFlagBits::eStorage });
+
+    ComputePipelineCreation pipelineCreation {};
+    pipelineCreation.SetName("Upscale Pipeline")
+        .SetShaderPath("shaders/bin/upscale.comp.spv")
+        .AddBinding(0, vk::DescriptorType::eStorageImage)
+        .AddBinding(1, vk::DescriptorType::eStorageImage)
+        .SetPushConstantSize(sizeof(UpscalePushConstants));
+    _upscalePipeline = std::make_unique<ComputePipeline>(pipelineCreation, _vulkanContext);
+}
+
+void Renderer::InitializeTonemap()
+{
+    if (!_swapChain->StorageSupported() || _swapChain->GetImageCount() > TONEMAP_OUTPUT_COUNT)
+    {
+        spdlog::warn("[VULKAN] Swap chain images can't be written by the tonemap pass, frames are blitted to them from a display target");
+
+        // Blits convert from float to whatever the swap chain stores, including the sRGB encoding of sRGB formats
+        _displayTarget = _renderGraph->CreateTransientImage({ "Display Target", _windowWidth, _windowHeight, vk::Format::eR16G16B16A16Sfloat,
+            vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc });
+    }
+
+    ComputePipelineCreation pipelineCreation {};
+    pipelineCreation.SetName("Tonemap Pipeline")
+        .SetShaderPath("shaders/bin/tonemap.comp.spv")
+        .AddBinding(0, vk::DescriptorType::eStorageImage)
+        .AddBinding(1, vk::DescriptorType::eStorageImage, TONEMAP_OUTPUT_COUNT)
+        .SetPushConstantSize(sizeof(TonemapPushConstants));
+    _tonemapPipeline = std::make_unique<ComputePipeline>(pipelineCreation, _vulkanContext);
+}
+
+void Renderer::InitializeRenderGraph()
+{
+    // A frame with camera motion describes every pass the renderer ever records
+    DescribeFrame(0, true);
+    _renderGraph->Compile();
+
+    if (_denoiser)
+    {
+        _denoiser->WriteDescriptors(*_renderGraph, *_renderTarget);
+    }
+
+    if (_upscalePipeline)
+    {
+        _upscalePipeline->WriteDescriptor(0, _renderTarget->view);
+        _upscalePipeline->WriteDescriptor(1, _renderGraph->View(*_upscaledTarget));
+    }
+
+    // Every output element needs a valid image, swap chains with fewer images repeat their first one
+    _tonemapPipeline->WriteDescriptor(0, _upscaledTarget ? _renderGraph->View(*_upscaledTarget) : _renderTarget->view);
+    for (uint32_t i = 0; i < TONEMAP_OUTPUT_COUNT; ++i)
+    {
+        const vk::ImageView output = _displayTarget ? _renderGraph->View(*_displayTarget) : _swapChain->GetImageView(i < _swapChain->GetImageCount() ? i : 0);
+        _tonemapPipeline->WriteDescriptor(1, output, i);
+    }
 }
 
 void Renderer::InitializeDescriptorSets()
 {
-    CameraUniformData cameraData {};
-    cameraData.viewInverse = glm::inverse(glm::lookAt(glm::vec3(-8.0f, 3.2f, 1.5f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f)));
-    cameraData.projInverse = glm::inverse(glm::perspective(glm::radians(60.0f), static_cast<float>(_windowWidth) / static_cast<float>(_windowHeight), 0.1f, 512.0f));
+    _view = Camera::DefaultView();
+    _projection = glm::perspective(glm::radians(60.0f), static_cast<float>(_windowWidth) / static_cast<float>(_windowHeight), 0.1f, 512.0f);
+    _previousViewProjection = _projection * _view;
+    const FrameUniformData frameData = FrameData();
 
-    constexpr vk::DeviceSize uniformBufferSize = sizeof(CameraUniformData);
+    const vk::DeviceSize uniformAlignment = _vulkanContext->Limits().minUniformBufferOffsetAlignment;
+    _uniformBufferStride = (sizeof(FrameUniformData) + uniformAlignment - 1) / uniformAlignment * uniformAlignment;
     BufferCreation uniformBufferCreation {};
-    uniformBufferCreation.SetName("Camera Uniform Buffer")
+    uniformBufferCreation.SetName("Frame Uniform Buffer")
         .SetUsageFlags(vk::BufferUsageFlagBits::eUniformBuffer)
         .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
         .SetIsMappable(true)
-        .SetSize(uniformBufferSize);
+        .SetSize(_uniformBufferStride * MAX_FRAMES_IN_FLIGHT);
     _uniformBuffer = std::make_unique<Buffer>(uniformBufferCreation, _vulkanContext);
-    memcpy(_uniformBuffer->mappedPtr, &cameraData, uniformBufferSize);
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+    {
+        memcpy(static_cast<std::byte*>(_uniformBuffer->mappedPtr) + i * _uniformBufferStride, &frameData, sizeof(FrameUniformData));
+    }
+    VkCheckResult(vmaFlushAllocation(_vulkanContext->MemoryAllocator(), _uniformBuffer->allocation, 0, VK_WHOLE_SIZE), "[VULKAN] Failed flushing frame uniform buffer!");
 
-    std::array<vk::DescriptorSetLayoutBinding, 3> bindingLayouts {};
+    std::array<vk::DescriptorSetLayoutBinding, 24> bindingLayouts {};
 
     vk::DescriptorSetLayoutBinding& imageLayout = bindingLayouts.at(0);
     imageLayout.binding = 0;
@@ -200,29 +1210,105 @@ void Renderer::InitializeDescriptorSets()
 
     vk::DescriptorSetLayoutBinding& cameraLayout = bindingLayouts.at(2);
     cameraLayout.binding = 2;
-    cameraLayout.descriptorType = vk::DescriptorType::eUniformBuffer;
+    cameraLayout.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
     cameraLayout.descriptorCount = 1;
     cameraLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
 
+    vk::DescriptorSetLayoutBinding& accumulationLayout = bindingLayouts.at(3);
+    accumulationLayout.binding = 3;
+    accumulationLayout.descriptorType = vk::DescriptorType::eStorageImage;
+    accumulationLayout.descriptorCount = 1;
+    accumulationLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
+
+    vk::DescriptorSetLayoutBinding& statisticsLayout = bindingLayouts.at(4);
+    statisticsLayout.binding = 4;
+    statisticsLayout.descriptorType = vk::DescriptorType::eStorageBuffer;
+    statisticsLayout.descriptorCount = 1;
+    statisticsLayout.stageFlags = vk::ShaderStageFlagBits::eAnyHitKHR;
+
+    vk::DescriptorSetLayoutBinding& lightLayout = bindingLayouts.at(5);
+    lightLayout.binding = 5;
+    lightLayout.descriptorType = vk::DescriptorType::eStorageBuffer;
+    lightLayout.descriptorCount = 1;
+    lightLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
+
+    vk::DescriptorSetLayoutBinding& restirSurfaceLayout = bindingLayouts.at(6);
+    restirSurfaceLayout.binding = 6;
+    restirSurfaceLayout.descriptorType = vk::DescriptorType::eStorageBuffer;
+    restirSurfaceLayout.descriptorCount = 1;
+    restirSurfaceLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
+
+    vk::DescriptorSetLayoutBinding& restirReservoirLayout = bindingLayouts.at(7);
+    restirReservoirLayout.binding = 7;
+    restirReservoirLayout.descriptorType = vk::DescriptorType::eStorageBuffer;
+    restirReservoirLayout.descriptorCount = 1;
+    restirReservoirLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
+
+    vk::DescriptorSetLayoutBinding& directLightingLayout = bindingLayouts.at(8);
+    directLightingLayout.binding = 8;
+    directLightingLayout.descriptorType = vk::DescriptorType::eStorageImage;
+    directLightingLayout.descriptorCount = 1;
+    directLightingLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
+
+    vk::DescriptorSetLayoutBinding& environmentAliasTableLayout = bindingLayouts.at(9);
+    environmentAliasTableLayout.binding = 9;
+    environmentAliasTableLayout.descriptorType = vk::DescriptorType::eStorageBuffer;
+    environmentAliasTableLayout.descriptorCount = 1;
+    environmentAliasTableLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
+
+    vk::DescriptorSetLayoutBinding& blueNoiseLayout = bindingLayouts.at(10);
+    blueNoiseLayout.binding = 10;
+    blueNoiseLayout.descriptorType = vk::DescriptorType::eStorageBuffer;
+    blueNoiseLayout.descriptorCount = 1;
+    blueNoiseLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
+
+    vk::DescriptorSetLayoutBinding& luminanceMomentLayout = bindingLayouts.at(11);
+    luminanceMomentLayout.binding = 11;
+    luminanceMomentLayout.descriptorType = vk::DescriptorType::eStorageImage;
+    luminanceMomentLayout.descriptorCount = 1;
+    luminanceMomentLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
+
+    vk::DescriptorSetLayoutBinding& activePixelLayout = bindingLayouts.at(12);
+    activePixelLayout.binding = 12;
+    activePixelLayout.descriptorType = vk::DescriptorType::eStorageBuffer;
+    activePixelLayout.descriptorCount = 1;
+    activePixelLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
+
+    // Denoiser inputs: illumination, albedo, normal and depth, motion. Followed by the auxiliary outputs: albedo, normal and depth, object ids.
+    // Then the reprojection images: depth, and the history of depth, accumulation and luminance moment
+    for (uint32_t binding = 13; binding <= 23; ++binding)
+    {
+        vk::DescriptorSetLayoutBinding& auxiliaryImageLayout = bindingLayouts.at(binding);
+        auxiliaryImageLayout.binding = binding;
+        auxiliaryImageLayout.descriptorType = vk::DescriptorType::eStorageImage;
+        auxiliaryImageLayout.descriptorCount = 1;
+        auxiliaryImageLayout.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR;
+    }
+
     vk::DescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo {};
     descriptorSetLayoutCreateInfo.bindingCount = bindingLayouts.size();
     descriptorSetLayoutCreateInfo.pBindings = bindingLayouts.data();
     _descriptorSetLayout = _vulkanContext->Device().createDescriptorSetLayout(descriptorSetLayoutCreateInfo);
 
-    std::array<vk::DescriptorPoolSize, 3> poolSizes {};
+    std::array<vk::DescriptorPoolSize, 4> poolSizes {};
 
     vk::DescriptorPoolSize& imagePoolSize = poolSizes.at(0);
     imagePoolSize.type = vk::DescriptorType::eStorageImage;
-    imagePoolSize.descriptorCount = 1;
+    imagePoolSize.descriptorCount = 15;
 
     vk::DescriptorPoolSize& accelerationStructureSize = poolSizes.at(1);
     accelerationStructureSize.type = vk::DescriptorType::eAccelerationStructureKHR;
     accelerationStructureSize.descriptorCount = 1;
 
     vk::DescriptorPoolSize& cameraSize = poolSizes.at(2);
-    cameraSize.type = vk::DescriptorType::eUniformBuffer;
+    cameraSize.type = vk::DescriptorType::eUniformBufferDynamic;
     cameraSize.descriptorCount = 1;
 
+    // Statistics, lights, ReSTIR surfaces and reservoirs, the environment alias table, blue noise and active pixels
+    vk::DescriptorPoolSize& storageBufferSize = poolSizes.at(3);
+    storageBufferSize.type = vk::DescriptorType::eStorageBuffer;
+    storageBufferSize.descriptorCount = 7;
+
     vk::DescriptorPoolCreateInfo descriptorPoolCreateInfo {};
     descriptorPoolCreateInfo.maxSets = 1;
     descriptorPoolCreateInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
@@ -239,6 +1325,10 @@ void Renderer::InitializeDescriptorSets()
     descriptorImageInfo.imageView = _renderTarget->view;
     descriptorImageInfo.imageLayout = vk::ImageLayout::eGeneral;
 
+    vk::DescriptorImageInfo accumulationImageInfo {};
+    accumulationImageInfo.imageView = _accumulationTarget->view;
+    accumulationImageInfo.imageLayout = vk::ImageLayout::eGeneral;
+
     vk::WriteDescriptorSetAccelerationStructureKHR descriptorAccelerationStructureInfo {};
     descriptorAccelerationStructureInfo.accelerationStructureCount = 1;
     const vk::AccelerationStructureKHR tlas = _tlas->Structure();
@@ -247,9 +1337,52 @@ void Renderer::InitializeDescriptorSets()
     vk::DescriptorBufferInfo descriptorBufferInfo {};
     descriptorBufferInfo.buffer = _uniformBuffer->buffer;
     descriptorBufferInfo.offset = 0;
-    descriptorBufferInfo.range = uniformBufferSize;
+    descriptorBufferInfo.range = sizeof(FrameUniformData);
+
+    vk::DescriptorBufferInfo statisticsBufferInfo {};
+    statisticsBufferInfo.buffer = _statisticsBuffer->buffer;
+    statisticsBufferInfo.offset = 0;
+    statisticsBufferInfo.range = vk::WholeSize;
+
+    vk::DescriptorBufferInfo lightBufferInfo {};
+    lightBufferInfo.buffer = _lightBuffer->buffer;
+    lightBufferInfo.offset = 0;
+    lightBufferInfo.range = vk::WholeSize;
+
+    vk::DescriptorBufferInfo restirSurfaceBufferInfo {};
+    restirSurfaceBufferInfo.buffer = _restirSurfaceBuffer->buffer;
+    restirSurfaceBufferInfo.offset = 0;
+    restirSurfaceBufferInfo.range = vk::WholeSize;
+
+    vk::DescriptorBufferInfo restirReservoirBufferInfo {};
+    restirReservoirBufferInfo.buffer = _restirReservoirBuffer->buffer;
+    restirReservoirBufferInfo.offset = 0;
+    restirReservoirBufferInfo.range = vk::WholeSize;
+
+    vk::DescriptorImageInfo directLightingImageInfo {};
+    directLightingImageInfo.imageView = _directLightingTarget->view;
+    directLightingImageInfo.imageLayout = vk::ImageLayout::eGeneral;
+
+    vk::DescriptorBufferInfo environmentAliasTableBufferInfo {};
+    environmentAliasTableBufferInfo.buffer = _environmentAliasTableBuffer->buffer;
+    environmentAliasTableBufferInfo.offset = 0;
+    environmentAliasTableBufferInfo.range = vk::WholeSize;
 
-    std::array<vk::WriteDescriptorSet, 3> descriptorWrites {};
+    vk::DescriptorBufferInfo blueNoiseBufferInfo {};
+    blueNoiseBufferInfo.buffer = _blueNoiseBuffer->buffer;
+    blueNoiseBufferInfo.offset = 0;
+    blueNoiseBufferInfo.range = vk::WholeSize;
+
+    vk::DescriptorImageInfo luminanceMomentImageInfo {};
+    luminanceMomentImageInfo.imageView = _luminanceMomentTarget->view;
+    luminanceMomentImageInfo.imageLayout = vk::ImageLayout::eGeneral;
+
+    vk::DescriptorBufferInfo activePixelBufferInfo {};
+    activePixelBufferInfo.buffer = _activePixelBuffer->buffer;
+    activePixelBufferInfo.offset = 0;
+    activePixelBufferInfo.range = vk::WholeSize;
+
+    std::array<vk::WriteDescriptorSet, 24> descriptorWrites {};
 
     vk::WriteDescriptorSet& imageWrite = descriptorWrites.at(0);
     imageWrite.dstSet = _descriptorSet;
@@ -272,9 +1405,107 @@ void Renderer::InitializeDescriptorSets()
     uniformBufferWrite.dstBinding = 2;
     uniformBufferWrite.dstArrayElement = 0;
     uniformBufferWrite.descriptorCount = 1;
-    uniformBufferWrite.descriptorType = vk::DescriptorType::eUniformBuffer;
+    uniformBufferWrite.descriptorType = vk::DescriptorType::eUniformBufferDynamic;
     uniformBufferWrite.pBufferInfo = &descriptorBufferInfo;
 
+    vk::WriteDescriptorSet& accumulationWrite = descriptorWrites.at(3);
+    accumulationWrite.dstSet = _descriptorSet;
+    accumulationWrite.dstBinding = 3;
+    accumulationWrite.dstArrayElement = 0;
+    accumulationWrite.descriptorCount = 1;
+    accumulationWrite.descriptorType = vk::DescriptorType::eStorageImage;
+    accumulationWrite.pImageInfo = &accumulationImageInfo;
+
+    vk::WriteDescriptorSet& statisticsWrite = descriptorWrites.at(4);
+    statisticsWrite.dstSet = _descriptorSet;
+    statisticsWrite.dstBinding = 4;
+    statisticsWrite.dstArrayElement = 0;
+    statisticsWrite.descriptorCount = 1;
+    statisticsWrite.descriptorType = vk::DescriptorType::eStorageBuffer;
+    statisticsWrite.pBufferInfo = &statisticsBufferInfo;
+
+    vk::WriteDescriptorSet& lightWrite = descriptorWrites.at(5);
+    lightWrite.dstSet = _descriptorSet;
+    lightWrite.dstBinding = 5;
+    lightWrite.dstArrayElement = 0;
+    lightWrite.descriptorCount = 1;
+    lightWrite.descriptorType = vk::DescriptorType::eStorageBuffer;
+    lightWrite.pBufferInfo = &lightBufferInfo;
+
+    vk::WriteDescriptorSet& restirSurfaceWrite = descriptorWrites.at(6);
+    restirSurfaceWrite.dstSet = _descriptorSet;
+    restirSurfaceWrite.dstBinding = 6;
+    restirSurfaceWrite.dstArrayElement = 0;
+    restirSurfaceWrite.descriptorCount = 1;
+    restirSurfaceWrite.descriptorType = vk::DescriptorType::eStorageBuffer;
+    restirSurfaceWrite.pBufferInfo = &restirSurfaceBufferInfo;
+
+    vk::WriteDescriptorSet& restirReservoirWrite = descriptorWrites.at(7);
+    restirReservoirWrite.dstSet = _descriptorSet;
+    restirReservoirWrite.dstBinding = 7;
+    restirReservoirWrite.dstArrayElement = 0;
+    restirReservoirWrite.descriptorCount = 1;
+    restirReservoirWrite.descriptorType = vk::DescriptorType::eStorageBuffer;
+    restirReservoirWrite.pBufferInfo = &restirReservoirBufferInfo;
+
+    vk::WriteDescriptorSet& directLightingWrite = descriptorWrites.at(8);
+    directLightingWrite.dstSet = _descriptorSet;
+    directLightingWrite.dstBinding = 8;
+    directLightingWrite.dstArrayElement = 0;
+    directLightingWrite.descriptorCount = 1;
+    directLightingWrite.descriptorType = vk::DescriptorType::eStorageImage;
+    directLightingWrite.pImageInfo = &directLightingImageInfo;
+
+    vk::WriteDescriptorSet& environmentAliasTableWrite = descriptorWrites.at(9);
+    environmentAliasTableWrite.dstSet = _descriptorSet;
+    environmentAliasTableWrite.dstBinding = 9;
+    environmentAliasTableWrite.dstArrayElement = 0;
+    environmentAliasTableWrite.descriptorCount = 1;
+    environmentAliasTableWrite.descriptorType = vk::DescriptorType::eStorageBuffer;
+    environmentAliasTableWrite.pBufferInfo = &environmentAliasTableBufferInfo;
+
+    vk::WriteDescriptorSet& blueNoiseWrite = descriptorWrites.at(10);
+    blueNoiseWrite.dstSet = _descriptorSet;
+    blueNoiseWrite.dstBinding = 10;
+    blueNoiseWrite.dstArrayElement = 0;
+    blueNoiseWrite.descriptorCount = 1;
+    blueNoiseWrite.descriptorType = vk::DescriptorType::eStorageBuffer;
+    blueNoiseWrite.pBufferInfo = &blueNoiseBufferInfo;
+
+    vk::WriteDescriptorSet& luminanceMomentWrite = descriptorWrites.at(11);
+    luminanceMomentWrite.dstSet = _descriptorSet;
+    luminanceMomentWrite.dstBinding = 11;
+    luminanceMomentWrite.dstArrayElement = 0;
+    luminanceMomentWrite.descriptorCount = 1;
+    luminanceMomentWrite.descriptorType = vk::DescriptorType::eStorageImage;
+    luminanceMomentWrite.pImageInfo = &luminanceMomentImageInfo;
+
+    vk::WriteDescriptorSet& activePixelWrite = descriptorWrites.at(12);
+    activePixelWrite.dstSet = _descriptorSet;
+    activePixelWrite.dstBinding = 12;
+    activePixelWrite.dstArrayElement = 0;
+    activePixelWrite.descriptorCount = 1;
+    activePixelWrite.descriptorType = vk::DescriptorType::eStorageBuffer;
+    activePixelWrite.pBufferInfo = &activePixelBufferInfo;
+
+    const std::array<vk::ImageView, 11> auxiliaryImages { _renderGraph->View(_illuminationTarget), _renderGraph->View(_albedoTarget),
+        _renderGraph->View(_normalDepthTarget), _renderGraph->View(_motionTarget), _albedoOutputTarget->view, _normalDepthOutputTarget->view,
+        _objectIdOutputTarget->view, _depthTarget->view, _depthHistory->view, _accumulationHistory->view, _luminanceMomentHistory->view };
+    std::array<vk::DescriptorImageInfo, 11> auxiliaryImageInfos {};
+    for (uint32_t i = 0; i < auxiliaryImages.size(); ++i)
+    {
+        auxiliaryImageInfos.at(i).imageView = auxiliaryImages.at(i);
+        auxiliaryImageInfos.at(i).imageLayout = vk::ImageLayout::eGeneral;
+
+        vk::WriteDescriptorSet& auxiliaryImageWrite = descriptorWrites.at(13 + i);
+        auxiliaryImageWrite.dstSet = _descriptorSet;
+        auxiliaryImageWrite.dstBinding = 13 + i;
+        auxiliaryImageWrite.dstArrayElement = 0;
+        auxiliaryImageWrite.descriptorCount = 1;
+        auxiliaryImageWrite.descriptorType = vk::DescriptorType::eStorageImage;
+        auxiliaryImageWrite.pImageInfo = &auxiliaryImageInfos.at(i);
+    }
+
     _vulkanContext->Device().updateDescriptorSets(static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
 }
 
@@ -282,9 +1513,13 @@ void Renderer::InitializePipeline()
 {
     vk::ShaderModule raygenModule = Shader::CreateShaderModule("shaders/bin/ray_gen.rgen.spv", _vulkanContext->Device());
     vk::ShaderModule missModule = Shader::CreateShaderModule("shaders/bin/miss.rmiss.spv", _vulkanContext->Device());
+    vk::ShaderModule shadowMissModule = Shader::CreateShaderModule("shaders/bin/shadow_miss.rmiss.spv", _vulkanContext->Device());
     vk::ShaderModule chitModule = Shader::CreateShaderModule("shaders/bin/closest_hit.rchit.spv", _vulkanContext->Device());
+    vk::ShaderModule alphaMaskModule = Shader::CreateShaderModule("shaders/bin/alpha_mask.rahit.spv", _vulkanContext->Device());
+    vk::ShaderModule restirCandidatesModule = Shader::CreateShaderModule("shaders/bin/restir_candidates.rgen.spv", _vulkanContext->Device());
+    vk::ShaderModule restirSpatialModule = Shader::CreateShaderModule("shaders/bin/restir_spatial.rgen.spv", _vulkanContext->Device());
 
-    std::array<vk::PipelineShaderStageCreateInfo, 3> shaderStagesCreateInfo {};
+    std::array<vk::PipelineShaderStageCreateInfo, RESTIR_SPATIAL_STAGE_INDEX + 1> shaderStagesCreateInfo {};
 
     vk::PipelineShaderStageCreateInfo& raygenStage = shaderStagesCreateInfo.at(0);
     raygenStage.stage = vk::ShaderStageFlagBits::eRaygenKHR;
@@ -296,52 +1531,129 @@ void Renderer::InitializePipeline()
     missStage.module = missModule;
     missStage.pName = "main";
 
-    vk::PipelineShaderStageCreateInfo& chitStage = shaderStagesCreateInfo.at(2);
-    chitStage.stage = vk::ShaderStageFlagBits::eClosestHitKHR;
-    chitStage.module = chitModule;
-    chitStage.pName = "main";
+    vk::PipelineShaderStageCreateInfo& shadowMissStage = shaderStagesCreateInfo.at(2);
+    shadowMissStage.stage = vk::ShaderStageFlagBits::eMissKHR;
+    shadowMissStage.module = shadowMissModule;
+    shadowMissStage.pName = "main";
+
+    const std::array<vk::SpecializationMapEntry, 2> specializationMapEntries {
+        vk::SpecializationMapEntry { 0, offsetof(ClosestHitSpecialization, useAlbedoMap), sizeof(vk::Bool32) },
+        vk::SpecializationMapEntry { 1, offsetof(ClosestHitSpecialization, useEmissiveMap), sizeof(vk::Bool32) },
+    };
+
+    std::array<ClosestHitSpecialization, HIT_GROUP_COUNT> specializations {};
+    std::array<vk::SpecializationInfo, HIT_GROUP_COUNT> specializationInfos {};
+    for (uint32_t i = 0; i < HIT_GROUP_COUNT; ++i)
+    {
+        const auto features = static_cast<MaterialFeatures>(i);
+        specializations.at(i).useAlbedoMap = HasMaterialFeature(features, MaterialFeatures::eAlbedoMap);
+        specializations.at(i).useEmissiveMap = HasMaterialFeature(features, MaterialFeatures::eEmissiveMap);
+
+        vk::SpecializationInfo& specializationInfo = specializationInfos.at(i);
+        specializationInfo.mapEntryCount = static_cast<uint32_t>(specializationMapEntries.size());
+        specializationInfo.pMapEntries = specializationMapEntries.data();
+        specializationInfo.dataSize = sizeof(ClosestHitSpecialization);
+        specializationInfo.pData = &specializations.at(i);
+
+        vk::PipelineShaderStageCreateInfo& chitStage = shaderStagesCreateInfo.at(CLOSEST_HIT_STAGE_INDEX + i);
+        chitStage.stage = vk::ShaderStageFlagBits::eClosestHitKHR;
+        chitStage.module = chitModule;
+        chitStage.pName = "main";
+        chitStage.pSpecializationInfo = &specializationInfo;
+    }
+
+    vk::PipelineShaderStageCreateInfo& alphaMaskStage = shaderStagesCreateInfo.at(ANY_HIT_STAGE_INDEX);
+    alphaMaskStage.stage = vk::ShaderStageFlagBits::eAnyHitKHR;
+    alphaMaskStage.module = alphaMaskModule;
+    alphaMaskStage.pName = "main";
 
-    std::array<vk::RayTracingShaderGroupCreateInfoKHR, 3> shaderGroupsCreateInfo {};
+    vk::PipelineShaderStageCreateInfo& restirCandidatesStage = shaderStagesCreateInfo.at(RESTIR_CANDIDATES_STAGE_INDEX);
+    restirCandidatesStage.stage = vk::ShaderStageFlagBits::eRaygenKHR;
+    restirCandidatesStage.module = restirCandidatesModule;
+    restirCandidatesStage.pName = "main";
 
-    vk::RayTracingShaderGroupCreateInfoKHR& group1 = shaderGroupsCreateInfo.at(0);
+    vk::PipelineShaderStageCreateInfo& restirSpatialStage = shaderStagesCreateInfo.at(RESTIR_SPATIAL_STAGE_INDEX);
+    restirSpatialStage.stage = vk::ShaderStageFlagBits::eRaygenKHR;
+    restirSpatialStage.module = restirSpatialModule;
+    restirSpatialStage.pName = "main";
+
+    std::array<vk::RayTracingShaderGroupCreateInfoKHR, SHADER_GROUP_COUNT> shaderGroupsCreateInfo {};
+
+    vk::RayTracingShaderGroupCreateInfoKHR& group1 = shaderGroupsCreateInfo.at(RAYGEN_GROUP_INDEX);
     group1.type = vk::RayTracingShaderGroupTypeKHR::eGeneral;
     group1.generalShader = 0;
     group1.closestHitShader = vk::ShaderUnusedKHR;
     group1.anyHitShader = vk::ShaderUnusedKHR;
     group1.intersectionShader = vk::ShaderUnusedKHR;
 
-    vk::RayTracingShaderGroupCreateInfoKHR& group2 = shaderGroupsCreateInfo.at(1);
+    vk::RayTracingShaderGroupCreateInfoKHR& group2 = shaderGroupsCreateInfo.at(MISS_GROUP_INDEX);
     group2.type = vk::RayTracingShaderGroupTypeKHR::eGeneral;
     group2.generalShader = 1;
     group2.closestHitShader = vk::ShaderUnusedKHR;
     group2.anyHitShader = vk::ShaderUnusedKHR;
     group2.intersectionShader = vk::ShaderUnusedKHR;
 
-    vk::RayTracingShaderGroupCreateInfoKHR& group3 = shaderGroupsCreateInfo.at(2);
-    group3.type = vk::RayTracingShaderGroupTypeKHR::eTrianglesHitGroup;
-    group3.generalShader = vk::ShaderUnusedKHR;
-    group3.closestHitShader = 2;
+    vk::RayTracingShaderGroupCreateInfoKHR& group3 = shaderGroupsCreateInfo.at(SHADOW_MISS_GROUP_INDEX);
+    group3.type = vk::RayTracingShaderGroupTypeKHR::eGeneral;
+    group3.generalShader = 2;
+    group3.closestHitShader = vk::ShaderUnusedKHR;
     group3.anyHitShader = vk::ShaderUnusedKHR;
     group3.intersectionShader = vk::ShaderUnusedKHR;
 
+    for (uint32_t i = 0; i < HIT_GROUP_COUNT; ++i)
+    {
+        vk::RayTracingShaderGroupCreateInfoKHR& hitGroup = shaderGroupsCreateInfo.at(HIT_GROUP_INDEX + i);
+        hitGroup.type = vk::RayTracingShaderGroupTypeKHR::eTrianglesHitGroup;
+        hitGroup.generalShader = vk::ShaderUnusedKHR;
+        hitGroup.closestHitShader = CLOSEST_HIT_STAGE_INDEX + i;
+        hitGroup.anyHitShader = HasMaterialFeature(static_cast<MaterialFeatures>(i), MaterialFeatures::eAlphaMask) ? ANY_HIT_STAGE_INDEX : vk::ShaderUnusedKHR;
+        hitGroup.intersectionShader = vk::ShaderUnusedKHR;
+    }
+
+    vk::RayTracingShaderGroupCreateInfoKHR& restirCandidatesGroup = shaderGroupsCreateInfo.at(RESTIR_CANDIDATES_GROUP_INDEX);
+    restirCandidatesGroup.type = vk::RayTracingShaderGroupTypeKHR::eGeneral;
+    restirCandidatesGroup.generalShader = RESTIR_CANDIDATES_STAGE_INDEX;
+    restirCandidatesGroup.closestHitShader = vk::ShaderUnusedKHR;
+    restirCandidatesGroup.anyHitShader = vk::ShaderUnusedKHR;
+    restirCandidatesGroup.intersectionShader = vk::ShaderUnusedKHR;
+
+    vk::RayTracingShaderGroupCreateInfoKHR& restirSpatialGroup = shaderGroupsCreateInfo.at(RESTIR_SPATIAL_GROUP_INDEX);
+    restirSpatialGroup.type = vk::RayTracingShaderGroupTypeKHR::eGeneral;
+    restirSpatialGroup.generalShader = RESTIR_SPATIAL_STAGE_INDEX;
+    restirSpatialGroup.closestHitShader = vk::ShaderUnusedKHR;
+    restirSpatialGroup.anyHitShader = vk::ShaderUnusedKHR;
+    restirSpatialGroup.intersectionShader = vk::ShaderUnusedKHR;
+
     std::array<vk::DescriptorSetLayout, 2> descriptorSetLayouts { _bindlessResources->DescriptorSetLayout(), _descriptorSetLayout };
 
     vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo {};
     pipelineLayoutCreateInfo.setLayoutCount = descriptorSetLayouts.size();
     pipelineLayoutCreateInfo.pSetLayouts = descriptorSetLayouts.data();
-    pipelineLayoutCreateInfo.pushConstantRangeCount = 0;
-    pipelineLayoutCreateInfo.pPushConstantRanges = nullptr;
+    vk::PushConstantRange pushConstantRange {};
+    pushConstantRange.stageFlags = PUSH_CONSTANT_STAGES;
+    pushConstantRange.offset = 0;
+    pushConstantRange.size = sizeof(PathTracingPushConstants);
+
+    pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+    pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
     _pipelineLayout = _vulkanContext->Device().createPipelineLayout(pipelineLayoutCreateInfo);
 
     vk::PipelineLibraryCreateInfoKHR libraryCreateInfo {};
     libraryCreateInfo.libraryCount = 0;
 
+    // Bounces are traced iteratively from the ray generation shader, so hit and miss shaders never trace rays themselves
+    const vk::DynamicState stackSizeState = vk::DynamicState::eRayTracingPipelineStackSizeKHR;
+    vk::PipelineDynamicStateCreateInfo dynamicStateCreateInfo {};
+    dynamicStateCreateInfo.dynamicStateCount = _settings.boundedRayRecursion ? 1 : 0;
+    dynamicStateCreateInfo.pDynamicStates = &stackSizeState;
+
     vk::RayTracingPipelineCreateInfoKHR pipelineCreateInfo {};
     pipelineCreateInfo.stageCount = static_cast<uint32_t>(shaderStagesCreateInfo.size());
     pipelineCreateInfo.pStages = shaderStagesCreateInfo.data();
     pipelineCreateInfo.groupCount = static_cast<uint32_t>(shaderGroupsCreateInfo.size());
     pipelineCreateInfo.pGroups = shaderGroupsCreateInfo.data();
-    pipelineCreateInfo.maxPipelineRayRecursionDepth = _vulkanContext->RayTracingPipelineProperties().maxRayRecursionDepth;
+    pipelineCreateInfo.maxPipelineRayRecursionDepth = _settings.boundedRayRecursion ? 1 : _vulkanContext->RayTracingPipelineProperties().maxRayRecursionDepth;
+    pipelineCreateInfo.pDynamicState = &dynamicStateCreateInfo;
     pipelineCreateInfo.pLibraryInfo = &libraryCreateInfo;
     pipelineCreateInfo.pLibraryInterface = nullptr;
     pipelineCreateInfo.layout = _pipelineLayout;
@@ -349,52 +1661,63 @@ void Renderer::InitializePipeline()
     pipelineCreateInfo.basePipelineIndex = 0;
 
     _pipeline = _vulkanContext->Device().createRayTracingPipelineKHR(nullptr, nullptr, pipelineCreateInfo, nullptr, _vulkanContext->Dldi()).value;
+    InitializeShaderBindingTable(pipelineCreateInfo);
 
     _vulkanContext->Device().destroyShaderModule(raygenModule);
     _vulkanContext->Device().destroyShaderModule(missModule);
+    _vulkanContext->Device().destroyShaderModule(shadowMissModule);
     _vulkanContext->Device().destroyShaderModule(chitModule);
+    _vulkanContext->Device().destroyShaderModule(alphaMaskModule);
+    _vulkanContext->Device().destroyShaderModule(restirCandidatesModule);
+    _vulkanContext->Device().destroyShaderModule(restirSpatialModule);
 }
 
-void Renderer::InitializeShaderBindingTable()
+void Renderer::InitializePipelineStackSize()
 {
-    auto AlignedSize = [](uint32_t value, uint32_t alignment)
-    { return (value + alignment - 1) & ~(alignment - 1); };
-
-    const vk::PhysicalDeviceRayTracingPipelinePropertiesKHR rayTracingPipelineProperties = _vulkanContext->RayTracingPipelineProperties();
-    const uint32_t handleSize = rayTracingPipelineProperties.shaderGroupHandleSize;
-    const uint32_t handleSizeAligned = AlignedSize(rayTracingPipelineProperties.shaderGroupHandleSize, rayTracingPipelineProperties.shaderGroupHandleAlignment);
-    const uint32_t shaderGroupCount = 3; // TODO: Get this from somewhere
-    vk::DeviceSize sbtSize = shaderGroupCount * handleSizeAligned;
-
-    BufferCreation shaderBindingTableBufferCreation {};
-    shaderBindingTableBufferCreation.SetName("Ray Gen Shader Binding Table")
-        .SetSize(sbtSize)
-        .SetUsageFlags(vk::BufferUsageFlagBits::eShaderBindingTableKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress)
-        .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
-        .SetIsMappable(true);
-    _raygenSBT = std::make_unique<Buffer>(shaderBindingTableBufferCreation, _vulkanContext);
-
-    shaderBindingTableBufferCreation.SetName("Miss Shader Binding Table");
-    _missSBT = std::make_unique<Buffer>(shaderBindingTableBufferCreation, _vulkanContext);
-
-    shaderBindingTableBufferCreation.SetName("Hit Shader Binding Table");
-    _hitSBT = std::make_unique<Buffer>(shaderBindingTableBufferCreation, _vulkanContext);
+    const auto groupStackSize = [this](uint32_t group, vk::ShaderGroupShaderKHR shader)
+    { return _vulkanContext->Device().getRayTracingShaderGroupStackSizeKHR(_pipeline, group, shader, _vulkanContext->Dldi()); };
+
+    const vk::DeviceSize raygenStackSize = std::max({ groupStackSize(RAYGEN_GROUP_INDEX, vk::ShaderGroupShaderKHR::eGeneral),
+        groupStackSize(RESTIR_CANDIDATES_GROUP_INDEX, vk::ShaderGroupShaderKHR::eGeneral),
+        groupStackSize(RESTIR_SPATIAL_GROUP_INDEX, vk::ShaderGroupShaderKHR::eGeneral) });
+    const vk::DeviceSize missStackSize = std::max(groupStackSize(MISS_GROUP_INDEX, vk::ShaderGroupShaderKHR::eGeneral),
+        groupStackSize(SHADOW_MISS_GROUP_INDEX, vk::ShaderGroupShaderKHR::eGeneral));
+    // Any-hit runs while traversal is still active, so it competes with the closest hit of the same group for the stack
+    vk::DeviceSize hitStackSize = 0;
+    for (uint32_t i = 0; i < HIT_GROUP_COUNT; ++i)
+    {
+        hitStackSize = std::max(hitStackSize, groupStackSize(HIT_GROUP_INDEX + i, vk::ShaderGroupShaderKHR::eClosestHit));
+        hitStackSize = std::max(hitStackSize, groupStackSize(HIT_GROUP_INDEX + i, vk::ShaderGroupShaderKHR::eAnyHit));
+    }
+    const vk::DeviceSize hitOrMissStackSize = std::max(missStackSize, hitStackSize);
 
-    std::vector<uint8_t> handles = _vulkanContext->Device().getRayTracingShaderGroupHandlesKHR<uint8_t>(_pipeline, 0, shaderGroupCount, sbtSize, _vulkanContext->Dldi());
+    // Default stack size from the spec, which drivers reserve when the pipeline does not set one explicitly
+    const uint32_t maxRecursionDepth = _vulkanContext->RayTracingPipelineProperties().maxRayRecursionDepth;
+    const vk::DeviceSize worstCaseStackSize = raygenStackSize + maxRecursionDepth * hitOrMissStackSize;
 
-    memcpy(_raygenSBT->mappedPtr, handles.data(), handleSize);
-    memcpy(_missSBT->mappedPtr, handles.data() + handleSizeAligned, handleSize);
-    memcpy(_hitSBT->mappedPtr, handles.data() + handleSizeAligned * 2, handleSize);
+    _pipelineStackSize = _settings.boundedRayRecursion ? raygenStackSize + hitOrMissStackSize : worstCaseStackSize;
+    spdlog::info("[VULKAN] Ray tracing pipeline stack size {} bytes per ray, {} bytes at the device recursion limit of {}",
+        _pipelineStackSize, worstCaseStackSize, maxRecursionDepth);
+}
 
-    _raygenAddressRegion.deviceAddress = _vulkanContext->GetBufferDeviceAddress(_raygenSBT->buffer);
-    _raygenAddressRegion.stride = handleSizeAligned;
-    _raygenAddressRegion.size = handleSizeAligned;
+void Renderer::InitializeShaderBindingTable(const vk::RayTracingPipelineCreateInfoKHR& pipelineCreateInfo)
+{
+    ShaderBindingTableCreation shaderBindingTableCreation {};
+    shaderBindingTableCreation.SetName("Shader Binding Table")
+        .SetShaderGroups(pipelineCreateInfo);
 
-    _missAddressRegion.deviceAddress = _vulkanContext->GetBufferDeviceAddress(_missSBT->buffer);
-    _missAddressRegion.stride = handleSizeAligned;
-    _missAddressRegion.size = handleSizeAligned;
+    // One hit record per geometry, in the same order as the geometry nodes, so instances use their first geometry index as record offset.
+    // Each record points at the closest hit variant specialized for the feature set of its material
+    for (const GeometryNode& geometryNode : _bindlessResources->GeometryNodes().GetAll())
+    {
+        uint32_t hitGroupIndex = HIT_GROUP_INDEX + static_cast<uint32_t>(geometryNode.materialFeatures);
+        if (!_settings.specializedHitGroups)
+        {
+            const MaterialFeatures opacity = HasMaterialFeature(geometryNode.materialFeatures, MaterialFeatures::eAlphaMask) ? MaterialFeatures::eAlphaMask : MaterialFeatures::eNone;
+            hitGroupIndex = HIT_GROUP_INDEX + static_cast<uint32_t>(UBER_MATERIAL_FEATURES | opacity);
+        }
+        shaderBindingTableCreation.AddHitRecord(hitGroupIndex, geometryNode);
+    }
 
-    _hitAddressRegion.deviceAddress = _vulkanContext->GetBufferDeviceAddress(_hitSBT->buffer);
-    _hitAddressRegion.stride = handleSizeAligned;
-    _hitAddressRegion.size = handleSizeAligned;
+    _shaderBindingTable = std::make_unique<ShaderBindingTable>(shaderBindingTableCreation, _pipeline, _vulkanContext);
 }
@@ -167,10 +167,10 @@ void BindlessResources::UploadGeometryNodes()
     Buffer stagingBuffer(stagingBufferCreation, _vulkanContext);
     std::memcpy(stagingBuffer.mappedPtr, _geometryNodeResources.GetAll().data(), bufferSize);
 
-    SingleTimeCommands commands(_vulkanContext);
+    SingleTimeCommands commands(_vulkanContext, QueueType::eTransfer);
     commands.Record([&](vk::CommandBuffer commandBuffer)
         { VkCopyBufferToBuffer(commandBuffer, stagingBuffer.buffer, _geometryNodeBuffer->buffer, bufferSize); });
-    commands.Submit();
+    _uploadTimelineValue = commands.Submit();
 
     vk::DescriptorBufferInfo bufferInfo {};
     bufferInfo.buffer = _geometryNodeBuffer->buffer;
@@ -211,10 +211,10 @@ void BindlessResources::UploadBLASInstances()
     Buffer stagingBuffer(stagingBufferCreation, _vulkanContext);
     std::memcpy(stagingBuffer.mappedPtr, _blasInstanceResources.GetAll().data(), bufferSize);
 
-    SingleTimeCommands commands(_vulkanContext);
+    SingleTimeCommands commands(_vulkanContext, QueueType::eTransfer);
     commands.Record([&](vk::CommandBuffer commandBuffer)
         { VkCopyBufferToBuffer(commandBuffer, stagingBuffer.buffer, _blasInstanceBuffer->buffer, bufferSize); });
-    commands.Submit();
+    _uploadTimelineValue = commands.Submit();
 
     vk::DescriptorBufferInfo bufferInfo {};
     bufferInfo.buffer = _blasInstanceBuffer->buffer;
@@ -253,13 +253,13 @@ void BindlessResources::InitializeSet()
     combinedImageSampler.descriptorType = vk::DescriptorType::eCombinedImageSampler;
     combinedImageSampler.descriptorCount = MAX_RESOURCES;
     combinedImageSampler.binding = static_cast<uint32_t>(BindlessBinding::eImages);
-    combinedImageSampler.stageFlags = vk::ShaderStageFlagBits::eClosestHitKHR;
+    combinedImageSampler.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR | vk::ShaderStageFlagBits::eMissKHR | vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eAnyHitKHR;
 
     vk::DescriptorSetLayoutBinding& materialBinding = bindings[1];
     materialBinding.descriptorType = vk::DescriptorType::eUniformBuffer;
     materialBinding.descriptorCount = 1;
     materialBinding.binding = static_cast<uint32_t>(BindlessBinding::eMaterials);
-    materialBinding.stageFlags = vk::ShaderStageFlagBits::eClosestHitKHR;
+    materialBinding.stageFlags = vk::ShaderStageFlagBits::eRaygenKHR | vk::ShaderStageFlagBits::eClosestHitKHR | vk::ShaderStageFlagBits::eAnyHitKHR;
 
     vk::DescriptorSetLayoutBinding& geometryNodeBinding = bindings[2];
     geometryNodeBinding.descriptorType = vk::DescriptorType::eStorageBuffer;
@@ -20,12 +20,24 @@ BufferCreation& BufferCreation::SetIsMappable(bool isMappable)
     return *this;
 }
 
+BufferCreation& BufferCreation::SetIsReadback(bool isReadback)
+{
+    this->isReadback = isReadback;
+    return *this;
+}
+
 BufferCreation& BufferCreation::SetMemoryUsage(VmaMemoryUsage memoryUsage)
 {
     this->memoryUsage = memoryUsage;
     return *this;
 }
 
+BufferCreation& BufferCreation::SetAlignment(vk::DeviceSize alignment)
+{
+    this->alignment = alignment;
+    return *this;
+}
+
 BufferCreation& BufferCreation::SetName(std::string_view name)
 {
     this->name = name;
@@ -38,18 +50,28 @@ Buffer::Buffer(const BufferCreation& creation, const std::shared_ptr<VulkanConte
     vk::BufferCreateInfo bufferInfo {};
     bufferInfo.size = creation.size;
     bufferInfo.usage = creation.usage;
-    bufferInfo.sharingMode = vk::SharingMode::eExclusive;
-    bufferInfo.queueFamilyIndexCount = 1;
-    bufferInfo.pQueueFamilyIndices = &_vulkanContext->QueueFamilies().graphicsFamily.value();
+    // Uploads and acceleration structure builds may run on the transfer and compute queues, concurrent sharing costs buffers next to nothing
+    const std::vector<uint32_t>& queueFamilies = _vulkanContext->BufferQueueFamilies();
+    bufferInfo.sharingMode = queueFamilies.size() > 1 ? vk::SharingMode::eConcurrent : vk::SharingMode::eExclusive;
+    bufferInfo.queueFamilyIndexCount = static_cast<uint32_t>(queueFamilies.size());
+    bufferInfo.pQueueFamilyIndices = queueFamilies.data();
 
     VmaAllocationCreateInfo allocationInfo {};
     allocationInfo.usage = creation.memoryUsage;
     if (creation.isMappable)
     {
-        allocationInfo.flags |= VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+        // Sequential write memory may be uncached, which makes reading it back very slow
+        allocationInfo.flags |= creation.isReadback ? VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT : VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
     }
 
-    VkCheckResult(vmaCreateBuffer(_vulkanContext->MemoryAllocator(), reinterpret_cast<VkBufferCreateInfo*>(&bufferInfo), &allocationInfo, reinterpret_cast<VkBuffer*>(&buffer), &allocation, nullptr), "Failed creating buffer!");
+    if (creation.alignment > 0)
+    {
+        VkCheckResult(vmaCreateBufferWithAlignment(_vulkanContext->MemoryAllocator(), reinterpret_cast<VkBufferCreateInfo*>(&bufferInfo), &allocationInfo, creation.alignment, reinterpret_cast<VkBuffer*>(&buffer), &allocation, nullptr), "Failed creating buffer!");
+    }
+    else
+    {
+        VkCheckResult(vmaCreateBuffer(_vulkanContext->MemoryAllocator(), reinterpret_cast<VkBufferCreateInfo*>(&bufferInfo), &allocationInfo, reinterpret_cast<VkBuffer*>(&buffer), &allocation, nullptr), "Failed creating buffer!");
+    }
     vmaSetAllocationName(_vulkanContext->MemoryAllocator(), allocation, creation.name.data());
     VkNameObject(buffer, creation.name, _vulkanContext);
 
@@ -247,7 +269,8 @@ Image::Image(const ImageCreation& creation, const std::shared_ptr<VulkanContext>
 
     if (!creation.data.empty())
     {
-        vk::DeviceSize imageSize = creation.width * creation.height * 4;
+        // Sized by the data, so formats other than 8 bit RGBA upload completely
+        const vk::DeviceSize imageSize = creation.data.size();
 
         BufferCreation stagingBufferCreation {};
         stagingBufferCreation.SetName("Image staging buffer")
@@ -258,13 +281,26 @@ Image::Image(const ImageCreation& creation, const std::shared_ptr<VulkanContext>
         Buffer stagingBuffer(stagingBufferCreation, _vulkanContext);
         memcpy(stagingBuffer.mappedPtr, creation.data.data(), imageSize);
 
-        SingleTimeCommands commands(_vulkanContext);
+        // Images stay exclusive to the graphics queue, a copy on the transfer queue hands the image over once it's done
+        const uint32_t transferFamily = _vulkanContext->QueueFamily(QueueType::eTransfer);
+        const uint32_t graphicsFamily = _vulkanContext->QueueFamily(QueueType::eGraphics);
+
+        SingleTimeCommands commands(_vulkanContext, QueueType::eTransfer);
         commands.Record([&](vk::CommandBuffer commandBuffer)
             {
             VkTransitionImageLayout(commandBuffer, image, format, vk::ImageLayout::eUndefined, vk::ImageLayout::eTransferDstOptimal);
             VkCopyBufferToImage(commandBuffer, stagingBuffer.buffer, image, creation.width, creation.height);
-            VkTransitionImageLayout(commandBuffer, image, format, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal); });
-        commands.Submit();
+            VkTransferImageOwnership(commandBuffer, image, format, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, transferFamily, graphicsFamily, true); });
+        const uint64_t copyValue = commands.Submit();
+
+        if (transferFamily != graphicsFamily)
+        {
+            SingleTimeCommands acquireCommands(_vulkanContext, QueueType::eGraphics);
+            acquireCommands.Record([&](vk::CommandBuffer commandBuffer)
+                { VkTransferImageOwnership(commandBuffer, image, format, vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal, transferFamily, graphicsFamily, false); });
+            const vk::SemaphoreSubmitInfo releaseWait = _vulkanContext->TimelineWait(QueueType::eTransfer, copyValue);
+            acquireCommands.Submit({ &releaseWait, 1 });
+        }
     }
 
     VkNameObject(image, creation.name, _vulkanContext);
@@ -411,6 +447,36 @@ MaterialCreation& MaterialCreation::SetEmissiveUVChannel(uint32_t emissiveUVChan
     return *this;
 }
 
+MaterialCreation& MaterialCreation::SetAlphaMask(bool alphaMask)
+{
+    this->alphaMask = alphaMask;
+    return *this;
+}
+
+MaterialCreation& MaterialCreation::SetAlphaCutoff(float alphaCutoff)
+{
+    this->alphaCutoff = alphaCutoff;
+    return *this;
+}
+
+MaterialFeatures MaterialCreation::Features() const
+{
+    MaterialFeatures features = MaterialFeatures::eNone;
+    if (!albedoMap.IsNull())
+    {
+        features = features | MaterialFeatures::eAlbedoMap;
+    }
+    if (!emissiveMap.IsNull())
+    {
+        features = features | MaterialFeatures::eEmissiveMap;
+    }
+    if (alphaMask)
+    {
+        features = features | MaterialFeatures::eAlphaMask;
+    }
+    return features;
+}
+
 Material::Material(const MaterialCreation& creation)
 {
     useAlbedoMap = !creation.albedoMap.IsNull();
@@ -431,6 +497,7 @@ Material::Material(const MaterialCreation& creation)
     normalScale = creation.normalScale;
     occlusionStrength = creation.occlusionStrength;
     emissiveFactor = creation.emissiveFactor;
+    alphaCutoff = creation.alphaCutoff;
 }
 
 GeometryNode::GeometryNode(const GeometryNodeCreation& creation)
@@ -438,4 +505,6 @@ GeometryNode::GeometryNode(const GeometryNodeCreation& creation)
     vertexBufferDeviceAddress = creation.vertexBufferDeviceAddress;
     indexBufferDeviceAddress = creation.indexBufferDeviceAddress;
     materialIndex = creation.material.handle;
+    materialFeatures = creation.materialFeatures;
+    lightOffset = creation.lightOffset;
 }
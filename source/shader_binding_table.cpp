@@ -0,0 +1,171 @@
+#include "shader_binding_table.hpp"
+#include "resources/gpu_resources.hpp"
+#include "vk_common.hpp"
+#include "vulkan_context.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <spdlog/spdlog.h>
+
+namespace
+{
+constexpr size_t REGION_COUNT = 4;
+
+vk::DeviceSize AlignedSize(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+}
+
+ShaderBindingTableCreation& ShaderBindingTableCreation::SetShaderGroups(const vk::RayTracingPipelineCreateInfoKHR& pipelineCreateInfo)
+{
+    groupRegions.clear();
+    for (uint32_t i = 0; i < pipelineCreateInfo.groupCount; ++i)
+    {
+        const vk::RayTracingShaderGroupCreateInfoKHR& group = pipelineCreateInfo.pGroups[i];
+        if (group.type != vk::RayTracingShaderGroupTypeKHR::eGeneral)
+        {
+            groupRegions.emplace_back(ShaderGroupRegion::eHit);
+            continue;
+        }
+
+        switch (pipelineCreateInfo.pStages[group.generalShader].stage)
+        {
+        case vk::ShaderStageFlagBits::eRaygenKHR:
+            groupRegions.emplace_back(ShaderGroupRegion::eRaygen);
+            break;
+        case vk::ShaderStageFlagBits::eMissKHR:
+            groupRegions.emplace_back(ShaderGroupRegion::eMiss);
+            break;
+        default:
+            groupRegions.emplace_back(ShaderGroupRegion::eCallable);
+            break;
+        }
+    }
+
+    return *this;
+}
+
+ShaderBindingTableCreation& ShaderBindingTableCreation::AddHitRecord(uint32_t groupIndex, std::span<const std::byte> data)
+{
+    hitRecords.emplace_back(Record { groupIndex, std::vector<std::byte>(data.begin(), data.end()) });
+    return *this;
+}
+
+ShaderBindingTableCreation& ShaderBindingTableCreation::SetName(std::string_view name)
+{
+    this->name = name;
+    return *this;
+}
+
+ShaderBindingTable::ShaderBindingTable(const ShaderBindingTableCreation& creation, vk::Pipeline pipeline, const std::shared_ptr<VulkanContext>& vulkanContext)
+    : _vulkanContext(vulkanContext)
+{
+    const vk::PhysicalDeviceRayTracingPipelinePropertiesKHR properties = _vulkanContext->RayTracingPipelineProperties();
+    const uint32_t handleSize = properties.shaderGroupHandleSize;
+    const uint32_t groupCount = static_cast<uint32_t>(creation.groupRegions.size());
+
+    std::array<std::vector<ShaderBindingTableCreation::Record>, REGION_COUNT> regionRecords {};
+    for (uint32_t i = 0; i < groupCount; ++i)
+    {
+        const ShaderGroupRegion region = creation.groupRegions[i];
+        if (region != ShaderGroupRegion::eHit || creation.hitRecords.empty())
+        {
+            regionRecords.at(static_cast<size_t>(region)).emplace_back(ShaderBindingTableCreation::Record { i, {} });
+        }
+    }
+
+    for (const ShaderBindingTableCreation::Record& record : creation.hitRecords)
+    {
+        if (record.groupIndex >= groupCount || creation.groupRegions[record.groupIndex] != ShaderGroupRegion::eHit)
+        {
+            spdlog::error("[VULKAN] Shader group {} of hit record is not a hit group", record.groupIndex);
+            continue;
+        }
+        regionRecords.at(static_cast<size_t>(ShaderGroupRegion::eHit)).emplace_back(record);
+    }
+
+    // Records of a region share one stride, large enough for the handle and the biggest inline data
+    std::array<vk::DeviceSize, REGION_COUNT> regionOffsets {};
+    vk::DeviceSize tableSize = 0;
+    for (size_t region = 0; region < REGION_COUNT; ++region)
+    {
+        const std::vector<ShaderBindingTableCreation::Record>& records = regionRecords.at(region);
+        if (records.empty())
+        {
+            continue;
+        }
+
+        size_t maxDataSize = 0;
+        for (const auto& record : records)
+        {
+            maxDataSize = std::max(maxDataSize, record.data.size());
+        }
+
+        // A traced ray gen region holds exactly one record, which has to start at the base alignment
+        const vk::DeviceSize recordAlignment = region == static_cast<size_t>(ShaderGroupRegion::eRaygen) ? properties.shaderGroupBaseAlignment : properties.shaderGroupHandleAlignment;
+        const vk::DeviceSize stride = AlignedSize(handleSize + maxDataSize, recordAlignment);
+        if (stride > properties.maxShaderGroupStride)
+        {
+            // Tracing with a stride above the limit is invalid usage, there is no table to fall back to
+            spdlog::error("[VULKAN] Shader binding table stride {} exceeds the device limit of {}", stride, properties.maxShaderGroupStride);
+            abort();
+        }
+
+        regionOffsets.at(region) = AlignedSize(tableSize, properties.shaderGroupBaseAlignment);
+        _regions.at(region).stride = stride;
+        _regions.at(region).size = stride * records.size();
+        tableSize = regionOffsets.at(region) + _regions.at(region).size;
+    }
+
+    BufferCreation bufferCreation {};
+    bufferCreation.SetName(creation.name.empty() ? "Shader Binding Table" : creation.name)
+        .SetSize(tableSize)
+        .SetUsageFlags(vk::BufferUsageFlagBits::eShaderBindingTableKHR | vk::BufferUsageFlagBits::eShaderDeviceAddress)
+        .SetMemoryUsage(VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE)
+        .SetIsMappable(true)
+        .SetAlignment(properties.shaderGroupBaseAlignment);
+    _buffer = std::make_unique<Buffer>(bufferCreation, _vulkanContext);
+
+    // Handles are returned tightly packed, records in the table are spaced by the region stride
+    const std::vector<uint8_t> handles = _vulkanContext->Device().getRayTracingShaderGroupHandlesKHR<uint8_t>(pipeline, 0, groupCount, groupCount * handleSize, _vulkanContext->Dldi());
+    const vk::DeviceAddress bufferAddress = _vulkanContext->GetBufferDeviceAddress(_buffer->buffer);
+    std::byte* mappedTable = static_cast<std::byte*>(_buffer->mappedPtr);
+
+    for (size_t region = 0; region < REGION_COUNT; ++region)
+    {
+        const std::vector<ShaderBindingTableCreation::Record>& records = regionRecords.at(region);
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            std::byte* recordPtr = mappedTable + regionOffsets.at(region) + i * _regions.at(region).stride;
+            memcpy(recordPtr, handles.data() + records[i].groupIndex * handleSize, handleSize);
+            if (!records[i].data.empty())
+            {
+                memcpy(recordPtr + handleSize, records[i].data.data(), records[i].data.size());
+            }
+        }
+
+        if (!records.empty())
+        {
+            _regions.at(region).deviceAddress = bufferAddress + regionOffsets.at(region);
+        }
+    }
+
+    // Memory preferring the device isn't necessarily coherent when mapped
+    VkCheckResult(vmaFlushAllocation(_vulkanContext->MemoryAllocator(), _buffer->allocation, 0, VK_WHOLE_SIZE), "[VULKAN] Failed flushing shader binding table!");
+
+    spdlog::info("[VULKAN] Shader binding table with {} miss and {} hit records, {} bytes",
+        regionRecords.at(static_cast<size_t>(ShaderGroupRegion::eMiss)).size(), regionRecords.at(static_cast<size_t>(ShaderGroupRegion::eHit)).size(), tableSize);
+}
+
+ShaderBindingTable::~ShaderBindingTable() = default;
+
+vk::StridedDeviceAddressRegionKHR ShaderBindingTable::RaygenRegion(uint32_t raygenIndex) const
+{
+    const vk::StridedDeviceAddressRegionKHR& raygenRegion = Region(ShaderGroupRegion::eRaygen);
+
+    vk::StridedDeviceAddressRegionKHR region {};
+    region.deviceAddress = raygenRegion.deviceAddress + raygenIndex * raygenRegion.stride;
+    region.stride = raygenRegion.stride;
+    region.size = raygenRegion.stride;
+    return region;
+}
@@ -3,18 +3,21 @@
 #include "vulkan_context.hpp"
 
 SingleTimeCommands::SingleTimeCommands(std::shared_ptr<VulkanContext> context)
+    : SingleTimeCommands(std::move(context), QueueType::eGraphics)
+{
+}
+
+SingleTimeCommands::SingleTimeCommands(std::shared_ptr<VulkanContext> context, QueueType queueType)
     : _vulkanContext(context)
+    , _queueType(queueType)
 {
     vk::CommandBufferAllocateInfo allocateInfo {};
     allocateInfo.level = vk::CommandBufferLevel::ePrimary;
-    allocateInfo.commandPool = _vulkanContext->CommandPool();
+    allocateInfo.commandPool = _vulkanContext->CommandPool(_queueType);
     allocateInfo.commandBufferCount = 1;
 
     VkCheckResult(_vulkanContext->Device().allocateCommandBuffers(&allocateInfo, &_commandBuffer), "[VULKAN] Failed allocating one time command buffer!");
 
-    vk::FenceCreateInfo fenceInfo {};
-    VkCheckResult(_vulkanContext->Device().createFence(&fenceInfo, nullptr, &_fence), "[VULKAN] Failed creating single time command fence!");
-
     vk::CommandBufferBeginInfo beginInfo {};
     beginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
 
@@ -25,8 +28,7 @@ SingleTimeCommands::~SingleTimeCommands()
 {
     Submit();
 
-    _vulkanContext->Device().free(_vulkanContext->CommandPool(), _commandBuffer);
-    _vulkanContext->Device().destroy(_fence);
+    _vulkanContext->Device().free(_vulkanContext->CommandPool(_queueType), _commandBuffer);
 }
 
 void SingleTimeCommands::Record(const std::function<void(vk::CommandBuffer)>& commands) const
@@ -34,20 +36,18 @@ void SingleTimeCommands::Record(const std::function<void(vk::CommandBuffer)>& co
     commands(_commandBuffer);
 }
 
-void SingleTimeCommands::Submit()
+uint64_t SingleTimeCommands::Submit(std::span<const vk::SemaphoreSubmitInfo> waits)
 {
-    if (_submitted)
+    if (_signalValue.has_value())
     {
-        return;
+        return _signalValue.value();
     }
-    _submitted = true;
 
     _commandBuffer.end();
 
-    vk::SubmitInfo submitInfo {};
-    submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &_commandBuffer;
-
-    VkCheckResult(_vulkanContext->GraphicsQueue().submit(1, &submitInfo, _fence), "[VULKAN] Failed submitting one time buffer to queue!");
-    VkCheckResult(_vulkanContext->Device().waitForFences(1, &_fence, vk::True, std::numeric_limits<uint64_t>::max()), "[VULKAN] Failed waiting for fence!");
-}
\ No newline at end of file
+    // Uploads and acceleration structure builds take their values on the same timelines as the frames
+    QueueTimeline& timeline = _vulkanContext->Timeline(_queueType);
+    _signalValue = timeline.Submit(_commandBuffer, waits);
+    timeline.Wait(_signalValue.value());
+    return _signalValue.value();
+}
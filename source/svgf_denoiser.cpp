@@ -0,0 +1,216 @@
+#include "svgf_denoiser.hpp"
+#include "compute_pipeline.hpp"
+#include "resources/gpu_resources.hpp"
+#include "single_time_commands.hpp"
+#include "vk_common.hpp"
+#include "vulkan_context.hpp"
+#include <algorithm>
+#include <string>
+
+namespace
+{
+struct FramePushConstants
+{
+    uint32_t frameIndex {};
+    uint32_t width {};
+    uint32_t height {};
+    uint32_t historyValid {};
+};
+
+struct AtrousPushConstants
+{
+    uint32_t frameIndex {};
+    uint32_t iteration {};
+    uint32_t lastIteration {};
+    uint32_t width {};
+    uint32_t height {};
+};
+
+constexpr vk::PipelineStageFlags2 COMPUTE_STAGE = vk::PipelineStageFlagBits2::eComputeShader;
+}
+
+SvgfDenoiser::SvgfDenoiser(const SvgfInputs& inputs, uint32_t width, uint32_t height, uint32_t filterIterations, RenderGraph& renderGraph, const std::shared_ptr<VulkanContext>& vulkanContext)
+    : _vulkanContext(vulkanContext)
+    , _width(width)
+    , _height(height)
+    , _filterIterations(std::clamp(filterIterations, 1u, MAX_FILTER_ITERATIONS))
+    , _inputs(inputs)
+{
+    const auto createImages = [&](std::array<std::unique_ptr<Image>, 2>& images, std::string_view name, vk::Format format)
+    {
+        for (size_t i = 0; i < images.size(); ++i)
+        {
+            ImageCreation imageCreation {};
+            imageCreation.SetName(std::string { name } + " " + std::to_string(i))
+                .SetSize(_width, _height)
+                .SetFormat(format)
+                .SetUsageFlags(vk::ImageUsageFlagBits::eStorage);
+            images.at(i) = std::make_unique<Image>(imageCreation, _vulkanContext);
+        }
+    };
+    createImages(_normalDepthHistory, "SVGF Normal Depth History", vk::Format::eR32G32B32A32Sfloat);
+    createImages(_colorHistory, "SVGF Color History", vk::Format::eR16G16B16A16Sfloat);
+    createImages(_momentsHistory, "SVGF Moments History", vk::Format::eR32G32B32A32Sfloat);
+    for (size_t i = 0; i < _filterImages.size(); ++i)
+    {
+        _filterImages.at(i) = renderGraph.CreateTransientImage({ "SVGF Filter " + std::to_string(i), _width, _height, vk::Format::eR16G16B16A16Sfloat, vk::ImageUsageFlagBits::eStorage });
+    }
+
+    // History carries over between frames, so it stays in the general layout for its whole lifetime
+    SingleTimeCommands commands { _vulkanContext };
+    commands.Record([&](vk::CommandBuffer commandBuffer)
+        {
+            for (const auto* images : { &_normalDepthHistory, &_colorHistory, &_momentsHistory })
+            {
+                for (const std::unique_ptr<Image>& image : *images)
+                {
+                    VkTransitionImageLayout(commandBuffer, image->image, image->format, vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral);
+                }
+            } });
+    commands.Submit();
+
+    ComputePipelineCreation temporalCreation {};
+    temporalCreation.SetName("SVGF Temporal Pipeline")
+        .SetShaderPath("shaders/bin/svgf_temporal.comp.spv")
+        .AddBinding(0, vk::DescriptorType::eStorageImage)
+        .AddBinding(1, vk::DescriptorType::eStorageImage)
+        .AddBinding(2, vk::DescriptorType::eStorageImage)
+        .AddBinding(3, vk::DescriptorType::eStorageImage, 2)
+        .AddBinding(4, vk::DescriptorType::eStorageImage, 2)
+        .AddBinding(5, vk::DescriptorType::eStorageImage, 2)
+        .AddBinding(6, vk::DescriptorType::eStorageImage, 2)
+        .SetPushConstantSize(sizeof(FramePushConstants));
+    _temporalPipeline = std::make_unique<ComputePipeline>(temporalCreation, _vulkanContext);
+
+    ComputePipelineCreation varianceCreation {};
+    varianceCreation.SetName("SVGF Variance Pipeline")
+        .SetShaderPath("shaders/bin/svgf_variance.comp.spv")
+        .AddBinding(0, vk::DescriptorType::eStorageImage, 2)
+        .AddBinding(1, vk::DescriptorType::eStorageImage)
+        .AddBinding(2, vk::DescriptorType::eStorageImage, 2)
+        .SetPushConstantSize(sizeof(FramePushConstants));
+    _variancePipeline = std::make_unique<ComputePipeline>(varianceCreation, _vulkanContext);
+
+    ComputePipelineCreation atrousCreation {};
+    atrousCreation.SetName("SVGF A-Trous Pipeline")
+        .SetShaderPath("shaders/bin/svgf_atrous.comp.spv")
+        .AddBinding(0, vk::DescriptorType::eStorageImage, 2)
+        .AddBinding(1, vk::DescriptorType::eStorageImage)
+        .AddBinding(2, vk::DescriptorType::eStorageImage, 2)
+        .AddBinding(3, vk::DescriptorType::eStorageImage)
+        .AddBinding(4, vk::DescriptorType::eStorageImage)
+        .SetPushConstantSize(sizeof(AtrousPushConstants));
+    _atrousPipeline = std::make_unique<ComputePipeline>(atrousCreation, _vulkanContext);
+
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        _temporalPipeline->WriteDescriptor(3, _normalDepthHistory.at(i)->view, i);
+        _temporalPipeline->WriteDescriptor(4, _colorHistory.at(i)->view, i);
+        _temporalPipeline->WriteDescriptor(5, _momentsHistory.at(i)->view, i);
+        _variancePipeline->WriteDescriptor(2, _momentsHistory.at(i)->view, i);
+        _atrousPipeline->WriteDescriptor(2, _colorHistory.at(i)->view, i);
+    }
+}
+
+SvgfDenoiser::~SvgfDenoiser() = default;
+
+void SvgfDenoiser::WriteDescriptors(const RenderGraph& renderGraph, const Image& output)
+{
+    _temporalPipeline->WriteDescriptor(0, renderGraph.View(_inputs.illumination));
+    _temporalPipeline->WriteDescriptor(1, renderGraph.View(_inputs.motion));
+    _temporalPipeline->WriteDescriptor(2, renderGraph.View(_inputs.normalDepth));
+    _variancePipeline->WriteDescriptor(1, renderGraph.View(_inputs.normalDepth));
+    _atrousPipeline->WriteDescriptor(1, renderGraph.View(_inputs.normalDepth));
+    _atrousPipeline->WriteDescriptor(3, renderGraph.View(_inputs.albedo));
+    _atrousPipeline->WriteDescriptor(4, output.view);
+    for (uint32_t i = 0; i < 2; ++i)
+    {
+        _temporalPipeline->WriteDescriptor(6, renderGraph.View(_filterImages.at(i)), i);
+        _variancePipeline->WriteDescriptor(0, renderGraph.View(_filterImages.at(i)), i);
+        _atrousPipeline->WriteDescriptor(0, renderGraph.View(_filterImages.at(i)), i);
+    }
+}
+
+void SvgfDenoiser::AddPasses(RenderGraph& renderGraph, RenderGraph::ResourceId output, vk::Extent2D extent)
+{
+    const uint32_t frameIndex = _frameIndex++;
+    const bool historyValid = _historyValid && extent == _historyExtent;
+    _historyValid = true;
+    _historyExtent = extent;
+
+    const auto importImages = [&](const std::array<std::unique_ptr<Image>, 2>& images, std::string_view name)
+    {
+        std::array<RenderGraph::ResourceId, 2> ids {};
+        for (size_t i = 0; i < images.size(); ++i)
+        {
+            ids.at(i) = renderGraph.ImportImage(std::string { name } + " " + std::to_string(i), images.at(i)->image, images.at(i)->format);
+        }
+        return ids;
+    };
+    const std::array<RenderGraph::ResourceId, 2> normalDepthHistory = importImages(_normalDepthHistory, "SVGF Normal Depth History");
+    const std::array<RenderGraph::ResourceId, 2> colorHistory = importImages(_colorHistory, "SVGF Color History");
+    const std::array<RenderGraph::ResourceId, 2> momentsHistory = importImages(_momentsHistory, "SVGF Moments History");
+    const uint32_t current = frameIndex & 1u;
+
+    const FramePushConstants framePushConstants { frameIndex, extent.width, extent.height, historyValid };
+
+    // Both halves of the history are declared, the one read this frame was written by the previous one, so the next frame waits for it
+    std::vector<RenderGraph::Access> temporalAccesses {
+        RenderGraph::Read(_inputs.illumination, COMPUTE_STAGE),
+        RenderGraph::Read(_inputs.motion, COMPUTE_STAGE),
+        RenderGraph::Read(_inputs.normalDepth, COMPUTE_STAGE),
+        RenderGraph::Write(_filterImages.at(0), COMPUTE_STAGE),
+    };
+    for (const auto* history : { &normalDepthHistory, &colorHistory, &momentsHistory })
+    {
+        for (const RenderGraph::ResourceId id : *history)
+        {
+            temporalAccesses.push_back(RenderGraph::ReadWrite(id, COMPUTE_STAGE));
+        }
+    }
+    renderGraph.AddPass("SVGF Temporal", std::move(temporalAccesses), [this, extent, framePushConstants](vk::CommandBuffer commandBuffer)
+        { _temporalPipeline->Dispatch(commandBuffer, extent.width, extent.height, framePushConstants); });
+
+    renderGraph.AddPass("SVGF Variance",
+        {
+            RenderGraph::Read(_filterImages.at(0), COMPUTE_STAGE),
+            RenderGraph::Write(_filterImages.at(1), COMPUTE_STAGE),
+            RenderGraph::Read(_inputs.normalDepth, COMPUTE_STAGE),
+            RenderGraph::Read(momentsHistory.at(current), COMPUTE_STAGE),
+        },
+        [this, extent, framePushConstants](vk::CommandBuffer commandBuffer)
+        { _variancePipeline->Dispatch(commandBuffer, extent.width, extent.height, framePushConstants); });
+
+    for (uint32_t i = 0; i < _filterIterations; ++i)
+    {
+        AtrousPushConstants atrousPushConstants {};
+        atrousPushConstants.frameIndex = frameIndex;
+        atrousPushConstants.iteration = i;
+        atrousPushConstants.lastIteration = i + 1 == _filterIterations;
+        atrousPushConstants.width = extent.width;
+        atrousPushConstants.height = extent.height;
+
+        // The variance pass writes the second image, iterations alternate from there, see shaders/svgf_atrous.comp
+        const uint32_t source = (i & 1u) ^ 1u;
+        std::vector<RenderGraph::Access> accesses {
+            RenderGraph::Read(_filterImages.at(source), COMPUTE_STAGE),
+            RenderGraph::Read(_inputs.normalDepth, COMPUTE_STAGE),
+        };
+        if (i == 0)
+        {
+            accesses.push_back(RenderGraph::Write(colorHistory.at(current), COMPUTE_STAGE));
+        }
+        if (atrousPushConstants.lastIteration)
+        {
+            accesses.push_back(RenderGraph::Read(_inputs.albedo, COMPUTE_STAGE));
+            accesses.push_back(RenderGraph::Write(output, COMPUTE_STAGE));
+        }
+        else
+        {
+            accesses.push_back(RenderGraph::Write(_filterImages.at(source ^ 1u), COMPUTE_STAGE));
+        }
+
+        renderGraph.AddPass("SVGF A-Trous " + std::to_string(i), std::move(accesses), [this, extent, atrousPushConstants](vk::CommandBuffer commandBuffer)
+            { _atrousPipeline->Dispatch(commandBuffer, extent.width, extent.height, atrousPushConstants); });
+    }
+}
@@ -56,6 +56,16 @@ void SwapChain::InitializeSwapChain(glm::uvec2 screenSize)
         createInfo.imageUsage |= vk::ImageUsageFlagBits::eTransferDst;
     }
 
+    // The tonemap pass writes straight into the images when their format allows storage, sRGB formats usually don't
+    const vk::FormatProperties formatProperties = _vulkanContext->PhysicalDevice().getFormatProperties(surfaceFormat.format);
+    _storageSupported = (swapChainSupport.capabilities.supportedUsageFlags & vk::ImageUsageFlagBits::eStorage)
+        && (formatProperties.optimalTilingFeatures & vk::FormatFeatureFlagBits::eStorageImage)
+        && _vulkanContext->StorageImageWriteWithoutFormatSupported();
+    if (_storageSupported)
+    {
+        createInfo.imageUsage |= vk::ImageUsageFlagBits::eStorage;
+    }
+
     uint32_t queueFamilyIndices[] = { _vulkanContext->QueueFamilies().graphicsFamily.value(), _vulkanContext->QueueFamilies().presentFamily.value() };
     if (_vulkanContext->QueueFamilies().graphicsFamily != _vulkanContext->QueueFamilies().presentFamily)
     {
@@ -82,6 +92,8 @@ void SwapChain::InitializeSwapChain(glm::uvec2 screenSize)
     _images = _vulkanContext->Device().getSwapchainImagesKHR(_swapChain);
     _format = surfaceFormat.format;
     _extent = extent;
+
+    InitializeImageViews();
 }
 
 void SwapChain::CleanUp()
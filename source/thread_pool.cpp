@@ -0,0 +1,95 @@
+#include "thread_pool.hpp"
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+    threadCount = std::max(threadCount, 1u);
+    _workers.reserve(threadCount);
+    for (uint32_t i = 0; i < threadCount; ++i)
+    {
+        _workers.emplace_back([this]()
+            { WorkerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::scoped_lock lock { _mutex };
+        _stopping = true;
+    }
+    _condition.notify_all();
+
+    for (auto& worker : _workers)
+    {
+        worker.join();
+    }
+}
+
+std::future<void> ThreadPool::Submit(std::function<void()> task)
+{
+    std::packaged_task<void()> packagedTask { std::move(task) };
+    std::future<void> future = packagedTask.get_future();
+
+    {
+        std::scoped_lock lock { _mutex };
+        _tasks.push(std::move(packagedTask));
+    }
+    _condition.notify_one();
+
+    return future;
+}
+
+void ThreadPool::Wait(const std::future<void>& future)
+{
+    while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+    {
+        if (!TryRunPendingTask())
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ThreadPool::WorkerLoop()
+{
+    while (true)
+    {
+        std::packaged_task<void()> task {};
+
+        {
+            std::unique_lock lock { _mutex };
+            _condition.wait(lock, [this]()
+                { return _stopping || !_tasks.empty(); });
+
+            if (_stopping && _tasks.empty())
+            {
+                return;
+            }
+
+            task = std::move(_tasks.front());
+            _tasks.pop();
+        }
+
+        task();
+    }
+}
+
+bool ThreadPool::TryRunPendingTask()
+{
+    std::packaged_task<void()> task {};
+
+    {
+        std::scoped_lock lock { _mutex };
+        if (_tasks.empty())
+        {
+            return false;
+        }
+
+        task = std::move(_tasks.front());
+        _tasks.pop();
+    }
+
+    task();
+    return true;
+}
@@ -18,6 +18,7 @@ TopLevelAccelerationStructure::~TopLevelAccelerationStructure()
 void TopLevelAccelerationStructure::InitializeStructure(const std::vector<BottomLevelAccelerationStructure>& blases, const std::shared_ptr<BindlessResources>& resources)
 {
     uint32_t firstGeometryNodeIndex = 0;
+    uint32_t firstLightIndex = 0;
     std::vector<vk::AccelerationStructureInstanceKHR> accelerationStructureInstances {};
     for (const auto& blas : blases)
     {
@@ -30,7 +31,7 @@ void TopLevelAccelerationStructure::InitializeStructure(const std::vector<Bottom
         accelerationStructureInstance.transform = transform;
         accelerationStructureInstance.instanceCustomIndex = accelerationStructureInstances.size() - 1;
         accelerationStructureInstance.mask = 0xFF;
-        accelerationStructureInstance.instanceShaderBindingTableRecordOffset = 0;
+        accelerationStructureInstance.instanceShaderBindingTableRecordOffset = firstGeometryNodeIndex;
 
         vk::AccelerationStructureDeviceAddressInfoKHR blasDeviceAddress {};
         blasDeviceAddress.accelerationStructure = blas.Structure();
@@ -38,9 +39,11 @@ void TopLevelAccelerationStructure::InitializeStructure(const std::vector<Bottom
 
         BLASInstanceCreation blasInstanceCreation {};
         blasInstanceCreation.firstGeometryIndex = firstGeometryNodeIndex;
+        blasInstanceCreation.firstLightIndex = firstLightIndex;
         resources->BLASInstances().Create(blasInstanceCreation);
 
         firstGeometryNodeIndex += blas.GeometryCount();
+        firstLightIndex += blas.LightCount();
     }
 
     BufferCreation instancesBufferCreation {};
@@ -56,7 +59,8 @@ void TopLevelAccelerationStructure::InitializeStructure(const std::vector<Bottom
     instanceDataDeviceAddress.deviceAddress = _vulkanContext->GetBufferDeviceAddress(_instancesBuffer->buffer);
 
     vk::AccelerationStructureGeometryKHR accelerationStructureGeometry {};
-    accelerationStructureGeometry.flags = vk::GeometryFlagBitsKHR::eOpaque;
+    // Opacity comes from the geometry flags of each BLAS, an opaque instance geometry would skip the alpha test
+    accelerationStructureGeometry.flags = {};
     accelerationStructureGeometry.geometryType = vk::GeometryTypeKHR::eInstances;
     accelerationStructureGeometry.geometry.instances = vk::AccelerationStructureGeometryInstancesDataKHR {};
     accelerationStructureGeometry.geometry.instances.arrayOfPointers = false;
@@ -107,8 +111,8 @@ void TopLevelAccelerationStructure::InitializeStructure(const std::vector<Bottom
     buildRangeInfo.transformOffset = 0;
     std::vector<vk::AccelerationStructureBuildRangeInfoKHR*> pBuildRangeInfos = { &buildRangeInfo };
 
-    SingleTimeCommands singleTimeCommands { _vulkanContext };
+    SingleTimeCommands singleTimeCommands { _vulkanContext, QueueType::eCompute };
     singleTimeCommands.Record([&](vk::CommandBuffer commandBuffer)
         { commandBuffer.buildAccelerationStructuresKHR(1, &buildGeometryInfo, pBuildRangeInfos.data(), _vulkanContext->Dldi()); });
-    singleTimeCommands.Submit();
+    _buildTimelineValue = singleTimeCommands.Submit();
 }
@@ -46,7 +46,7 @@ ImageLayoutTransitionState VkGetImageLayoutTransitionSourceState(vk::ImageLayout
             { .pipelineStage = vk::PipelineStageFlagBits2::eLateFragmentTests,
                 .accessFlags = vk::AccessFlagBits2::eDepthStencilAttachmentWrite } },
         { vk::ImageLayout::eGeneral,
-            { .pipelineStage = vk::PipelineStageFlagBits2::eRayTracingShaderKHR,
+            { .pipelineStage = vk::PipelineStageFlagBits2::eRayTracingShaderKHR | vk::PipelineStageFlagBits2::eComputeShader,
                 .accessFlags = vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eMemoryWrite } }
     };
 
@@ -85,8 +85,8 @@ ImageLayoutTransitionState VkGetImageLayoutTransitionDestinationState(vk::ImageL
             { .pipelineStage = vk::PipelineStageFlagBits2::eEarlyFragmentTests,
                 .accessFlags = vk::AccessFlagBits2::eDepthStencilAttachmentRead } },
         { vk::ImageLayout::eGeneral,
-            { .pipelineStage = vk::PipelineStageFlagBits2::eRayTracingShaderKHR,
-                .accessFlags = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eMemoryRead } },
+            { .pipelineStage = vk::PipelineStageFlagBits2::eRayTracingShaderKHR | vk::PipelineStageFlagBits2::eComputeShader,
+                .accessFlags = vk::AccessFlagBits2::eShaderRead | vk::AccessFlagBits2::eShaderWrite | vk::AccessFlagBits2::eMemoryRead } },
     };
 
     auto it = destinationStateMap.find(destinationLayout);
@@ -193,6 +193,56 @@ void VkCopyBufferToImage(vk::CommandBuffer commandBuffer, vk::Buffer buffer, vk:
     commandBuffer.copyBufferToImage(buffer, image, vk::ImageLayout::eTransferDstOptimal, 1, &region);
 }
 
+void VkCopyImageToBuffer(vk::CommandBuffer commandBuffer, vk::Image image, vk::Buffer buffer, uint32_t width, uint32_t height, vk::ImageLayout layout)
+{
+    vk::BufferImageCopy region {};
+    region.bufferOffset = 0;
+    region.bufferRowLength = 0;
+    region.bufferImageHeight = 0;
+    region.imageSubresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+    region.imageSubresource.mipLevel = 0;
+    region.imageSubresource.baseArrayLayer = 0;
+    region.imageSubresource.layerCount = 1;
+    region.imageOffset = vk::Offset3D { 0, 0, 0 };
+    region.imageExtent = vk::Extent3D { width, height, 1 };
+
+    commandBuffer.copyImageToBuffer(image, layout, buffer, 1, &region);
+}
+
+void VkTransferImageOwnership(vk::CommandBuffer commandBuffer, vk::Image image, vk::Format format, vk::ImageLayout oldLayout, vk::ImageLayout newLayout, uint32_t srcFamily, uint32_t dstFamily, bool release)
+{
+    if (srcFamily == dstFamily)
+    {
+        if (release)
+        {
+            VkTransitionImageLayout(commandBuffer, image, format, oldLayout, newLayout);
+        }
+        return;
+    }
+
+    // Both halves carry the same layouts and families, each only synchronizes with the work of its own queue
+    vk::ImageMemoryBarrier2 barrier {};
+    VkInitializeImageMemoryBarrier(barrier, image, format, oldLayout, newLayout);
+    barrier.srcQueueFamilyIndex = srcFamily;
+    barrier.dstQueueFamilyIndex = dstFamily;
+    if (release)
+    {
+        barrier.dstStageMask = vk::PipelineStageFlagBits2::eNone;
+        barrier.dstAccessMask = vk::AccessFlags2 { 0 };
+    }
+    else
+    {
+        barrier.srcStageMask = vk::PipelineStageFlagBits2::eNone;
+        barrier.srcAccessMask = vk::AccessFlags2 { 0 };
+    }
+
+    vk::DependencyInfo dependencyInfo {};
+    dependencyInfo.setImageMemoryBarrierCount(1)
+        .setPImageMemoryBarriers(&barrier);
+
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+}
+
 void VkCopyBufferToBuffer(vk::CommandBuffer commandBuffer, vk::Buffer srcBuffer, vk::Buffer dstBuffer, vk::DeviceSize size, uint32_t offset)
 {
     vk::BufferCopy copyRegion {};
@@ -201,3 +251,48 @@ void VkCopyBufferToBuffer(vk::CommandBuffer commandBuffer, vk::Buffer srcBuffer,
     copyRegion.size = size;
     commandBuffer.copyBuffer(srcBuffer, dstBuffer, 1, &copyRegion);
 }
+
+void VkAccelerationStructureBuildBarrier(vk::CommandBuffer commandBuffer)
+{
+    vk::MemoryBarrier2 barrier {};
+    barrier.srcStageMask = vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR;
+    barrier.srcAccessMask = vk::AccessFlagBits2::eAccelerationStructureWriteKHR;
+    barrier.dstStageMask = vk::PipelineStageFlagBits2::eAccelerationStructureBuildKHR;
+    barrier.dstAccessMask = vk::AccessFlagBits2::eAccelerationStructureReadKHR;
+
+    vk::DependencyInfo dependencyInfo {};
+    dependencyInfo.setMemoryBarrierCount(1)
+        .setPMemoryBarriers(&barrier);
+
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+}
+
+void VkRayTracingShaderBarrier(vk::CommandBuffer commandBuffer)
+{
+    vk::MemoryBarrier2 barrier {};
+    barrier.srcStageMask = vk::PipelineStageFlagBits2::eRayTracingShaderKHR;
+    barrier.srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite;
+    barrier.dstStageMask = vk::PipelineStageFlagBits2::eRayTracingShaderKHR;
+    barrier.dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite;
+
+    vk::DependencyInfo dependencyInfo {};
+    dependencyInfo.setMemoryBarrierCount(1)
+        .setPMemoryBarriers(&barrier);
+
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+}
+
+void VkMemoryBarrier(vk::CommandBuffer commandBuffer, vk::PipelineStageFlags2 srcStage, vk::AccessFlags2 srcAccess, vk::PipelineStageFlags2 dstStage, vk::AccessFlags2 dstAccess)
+{
+    vk::MemoryBarrier2 barrier {};
+    barrier.srcStageMask = srcStage;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstStageMask = dstStage;
+    barrier.dstAccessMask = dstAccess;
+
+    vk::DependencyInfo dependencyInfo {};
+    dependencyInfo.setMemoryBarrierCount(1)
+        .setPMemoryBarriers(&barrier);
+
+    commandBuffer.pipelineBarrier2(dependencyInfo);
+}
@@ -71,9 +71,27 @@ QueueFamilyIndices QueueFamilyIndices::FindQueueFamilies(vk::PhysicalDevice devi
 
     for (size_t i = 0; i < queueFamilies.size(); ++i)
     {
-        if (queueFamilies[i].queueFlags & vk::QueueFlagBits::eGraphics)
+        const vk::QueueFlags flags = queueFamilies[i].queueFlags;
+        if (flags & vk::QueueFlagBits::eGraphics)
         {
-            indices.graphicsFamily = i;
+            if (!indices.graphicsFamily.has_value())
+            {
+                indices.graphicsFamily = i;
+            }
+        }
+        else if (flags & vk::QueueFlagBits::eCompute)
+        {
+            if (!indices.computeFamily.has_value())
+            {
+                indices.computeFamily = i;
+            }
+        }
+        else if (flags & vk::QueueFlagBits::eTransfer)
+        {
+            if (!indices.transferFamily.has_value())
+            {
+                indices.transferFamily = i;
+            }
         }
 
         if (!indices.presentFamily.has_value())
@@ -87,10 +105,6 @@ QueueFamilyIndices QueueFamilyIndices::FindQueueFamilies(vk::PhysicalDevice devi
             }
         }
 
-        if (indices.IsComplete())
-        {
-            break;
-        }
     }
 
     return indices;
@@ -107,8 +121,13 @@ VulkanContext::VulkanContext(const VulkanInitInfo& initInfo)
     _surface = initInfo.retrieveSurface(_instance);
 
     InitializePhysicalDevice();
+    if (!HasRayTracingDevice())
+    {
+        return;
+    }
+
     InitializeDevice();
-    InitializeCommandPool();
+    InitializeCommandPools();
     InitializeVMA();
 }
 
@@ -119,6 +138,16 @@ VulkanContext::~VulkanContext()
         _instance.destroyDebugUtilsMessengerEXT(_debugMessenger, nullptr, _dldi);
     }
 
+    _graphicsTimeline.reset();
+    _computeTimeline.reset();
+    _transferTimeline.reset();
+    if (_device)
+    {
+        for (const vk::CommandPool commandPool : { _commandPool, _computeCommandPool, _transferCommandPool })
+        {
+            _device.destroy(commandPool);
+        }
+    }
     vmaDestroyAllocator(_vmaAllocator);
     _instance.destroy(_surface);
     _device.destroy();
@@ -134,6 +163,11 @@ vk::PhysicalDeviceRayTracingPipelinePropertiesKHR VulkanContext::RayTracingPipel
     return rayTracingPipelineProperties;
 }
 
+vk::PhysicalDeviceLimits VulkanContext::Limits() const
+{
+    return _physicalDevice.getProperties().limits;
+}
+
 uint64_t VulkanContext::GetBufferDeviceAddress(vk::Buffer buffer) const
 {
     vk::BufferDeviceAddressInfoKHR bufferDeviceAI {};
@@ -209,7 +243,8 @@ void VulkanContext::InitializePhysicalDevice()
 
     if (candidates.empty())
     {
-        spdlog::error("[VULKAN] Failed finding suitable device!");
+        spdlog::error("[VULKAN] Failed finding suitable device with ray tracing support!");
+        return;
     }
 
     _physicalDevice = candidates.rbegin()->second;
@@ -220,6 +255,13 @@ void VulkanContext::InitializeDevice()
     _queueFamilyIndices = QueueFamilyIndices::FindQueueFamilies(_physicalDevice, _surface);
     std::vector<vk::DeviceQueueCreateInfo> queueCreateInfos {};
     std::set<uint32_t> uniqueQueueFamilies = { _queueFamilyIndices.graphicsFamily.value(), _queueFamilyIndices.presentFamily.value() };
+    for (const std::optional<uint32_t>& family : { _queueFamilyIndices.computeFamily, _queueFamilyIndices.transferFamily })
+    {
+        if (family.has_value())
+        {
+            uniqueQueueFamilies.insert(family.value());
+        }
+    }
     float queuePriority = 1.0f;
 
     for (uint32_t familyQueueIndex : uniqueQueueFamilies)
@@ -232,8 +274,8 @@ void VulkanContext::InitializeDevice()
         queueCreateInfos.push_back(queueCreateInfo);
     }
 
-    vk::StructureChain<vk::DeviceCreateInfo, vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceSynchronization2Features, vk::PhysicalDeviceDescriptorIndexingFeatures,
-        vk::PhysicalDeviceScalarBlockLayoutFeatures, vk::PhysicalDeviceBufferDeviceAddressFeatures, vk::PhysicalDeviceAccelerationStructureFeaturesKHR,
+    vk::StructureChain<vk::DeviceCreateInfo, vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceSynchronization2Features, vk::PhysicalDeviceTimelineSemaphoreFeatures,
+        vk::PhysicalDeviceDescriptorIndexingFeatures, vk::PhysicalDeviceScalarBlockLayoutFeatures, vk::PhysicalDeviceBufferDeviceAddressFeatures, vk::PhysicalDeviceAccelerationStructureFeaturesKHR,
         vk::PhysicalDeviceRayTracingPipelineFeaturesKHR>
         structureChain;
 
@@ -255,8 +297,14 @@ void VulkanContext::InitializeDevice()
     auto& synchronization2Features = structureChain.get<vk::PhysicalDeviceSynchronization2Features>();
     synchronization2Features.synchronization2 = true;
 
+    auto& timelineSemaphoreFeatures = structureChain.get<vk::PhysicalDeviceTimelineSemaphoreFeatures>();
+    timelineSemaphoreFeatures.timelineSemaphore = true;
+
     auto& deviceFeatures = structureChain.get<vk::PhysicalDeviceFeatures2>();
     _physicalDevice.getFeatures2(&deviceFeatures);
+    _accelerationStructureHostCommandsSupported = accelerationStructuresFeatures.accelerationStructureHostCommands;
+    _rayTracingIndirectSupported = rayTracingPipelineFeatures.rayTracingPipelineTraceRaysIndirect;
+    _storageImageWriteWithoutFormatSupported = deviceFeatures.features.shaderStorageImageWriteWithoutFormat;
 
     auto& createInfo = structureChain.get<vk::DeviceCreateInfo>();
     createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
@@ -280,15 +328,91 @@ void VulkanContext::InitializeDevice()
 
     _device.getQueue(_queueFamilyIndices.graphicsFamily.value(), 0, &_graphicsQueue);
     _device.getQueue(_queueFamilyIndices.presentFamily.value(), 0, &_presentQueue);
+    _graphicsTimeline = std::make_unique<QueueTimeline>(_device, _graphicsQueue);
+    _bufferQueueFamilies = { _queueFamilyIndices.graphicsFamily.value() };
+
+    if (_queueFamilyIndices.computeFamily.has_value())
+    {
+        _device.getQueue(_queueFamilyIndices.computeFamily.value(), 0, &_computeQueue);
+        _computeTimeline = std::make_unique<QueueTimeline>(_device, _computeQueue);
+        _bufferQueueFamilies.push_back(_queueFamilyIndices.computeFamily.value());
+    }
+    if (_queueFamilyIndices.transferFamily.has_value())
+    {
+        _device.getQueue(_queueFamilyIndices.transferFamily.value(), 0, &_transferQueue);
+        _transferTimeline = std::make_unique<QueueTimeline>(_device, _transferQueue);
+        _bufferQueueFamilies.push_back(_queueFamilyIndices.transferFamily.value());
+    }
+
+    spdlog::info("[VULKAN] Dedicated compute queue: {}, dedicated transfer queue: {}", _computeTimeline != nullptr, _transferTimeline != nullptr);
 }
 
-void VulkanContext::InitializeCommandPool()
+void VulkanContext::InitializeCommandPools()
 {
     vk::CommandPoolCreateInfo commandPoolCreateInfo {};
     commandPoolCreateInfo.flags = vk::CommandPoolCreateFlagBits::eResetCommandBuffer;
     commandPoolCreateInfo.queueFamilyIndex = _queueFamilyIndices.graphicsFamily.value();
 
     VkCheckResult(_device.createCommandPool(&commandPoolCreateInfo, nullptr, &_commandPool), "[VULKAN] Failed creating command pool!");
+
+    if (_queueFamilyIndices.computeFamily.has_value())
+    {
+        commandPoolCreateInfo.queueFamilyIndex = _queueFamilyIndices.computeFamily.value();
+        VkCheckResult(_device.createCommandPool(&commandPoolCreateInfo, nullptr, &_computeCommandPool), "[VULKAN] Failed creating compute command pool!");
+    }
+    if (_queueFamilyIndices.transferFamily.has_value())
+    {
+        commandPoolCreateInfo.queueFamilyIndex = _queueFamilyIndices.transferFamily.value();
+        VkCheckResult(_device.createCommandPool(&commandPoolCreateInfo, nullptr, &_transferCommandPool), "[VULKAN] Failed creating transfer command pool!");
+    }
+}
+
+QueueTimeline& VulkanContext::Timeline(QueueType type) const
+{
+    if (type == QueueType::eCompute && _computeTimeline)
+    {
+        return *_computeTimeline;
+    }
+    if (type == QueueType::eTransfer && _transferTimeline)
+    {
+        return *_transferTimeline;
+    }
+    return *_graphicsTimeline;
+}
+
+vk::SemaphoreSubmitInfo VulkanContext::TimelineWait(QueueType type, uint64_t value) const
+{
+    vk::SemaphoreSubmitInfo wait {};
+    wait.semaphore = Timeline(type).Semaphore();
+    wait.value = value;
+    wait.stageMask = vk::PipelineStageFlagBits2::eAllCommands;
+    return wait;
+}
+
+uint32_t VulkanContext::QueueFamily(QueueType type) const
+{
+    if (type == QueueType::eCompute && _queueFamilyIndices.computeFamily.has_value())
+    {
+        return _queueFamilyIndices.computeFamily.value();
+    }
+    if (type == QueueType::eTransfer && _queueFamilyIndices.transferFamily.has_value())
+    {
+        return _queueFamilyIndices.transferFamily.value();
+    }
+    return _queueFamilyIndices.graphicsFamily.value();
+}
+
+vk::CommandPool VulkanContext::CommandPool(QueueType type) const
+{
+    if (type == QueueType::eCompute && _computeCommandPool)
+    {
+        return _computeCommandPool;
+    }
+    if (type == QueueType::eTransfer && _transferCommandPool)
+    {
+        return _transferCommandPool;
+    }
+    return _commandPool;
 }
 
 void VulkanContext::InitializeVMA()